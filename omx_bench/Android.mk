@@ -0,0 +1,177 @@
+LOCAL_PATH:= $(call my-dir)
+
+# =============================================================================
+# End-to-end component benchmark
+
+include $(CLEAR_VARS)
+include $(MFX_OMX_HOME)/mfx_omx_defs.mk
+
+LOCAL_SRC_FILES := \
+    src/mfx_omx_bench.cpp \
+    src/mfx_omx_bench_client.cpp \
+    src/mfx_omx_bench_stream.cpp
+
+LOCAL_C_INCLUDES := \
+    $(MFX_OMX_INCLUDES) \
+    $(MFX_OMX_HOME)/openmax/intel
+
+LOCAL_CFLAGS := \
+    $(MFX_OMX_CFLAGS)
+
+LOCAL_LDFLAGS := \
+    $(MFX_OMX_LDFLAGS)
+
+LOCAL_SHARED_LIBRARIES := libmfx_omx_core libcutils liblog
+LOCAL_HEADER_LIBRARIES := $(MFX_OMX_HEADER_LIBRARIES)
+
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := mfx_omx_bench
+
+include $(BUILD_EXECUTABLE)
+
+# =============================================================================
+# Frame constructor micro-benchmark
+
+include $(CLEAR_VARS)
+include $(MFX_OMX_HOME)/mfx_omx_defs.mk
+
+LOCAL_SRC_FILES := \
+    src/mfx_omx_fc_bench.cpp \
+    src/mfx_omx_bench_stream.cpp \
+    src/mfx_omx_bench_utils.cpp
+
+LOCAL_C_INCLUDES := \
+    $(MFX_OMX_INCLUDES) \
+    $(MFX_OMX_INCLUDES_LIBVA) \
+    $(MFX_OMX_HOME)/openmax/intel \
+    $(MFX_OMX_HOME)/omx_utils/include \
+    $(MFX_OMX_HOME)/omx_buffers/include
+
+LOCAL_CFLAGS := \
+    $(MFX_OMX_CFLAGS) \
+    $(MFX_OMX_CFLAGS_LIBVA)
+
+LOCAL_LDFLAGS := \
+    $(MFX_OMX_LDFLAGS)
+
+LOCAL_SHARED_LIBRARIES := \
+    libdl liblog \
+    libva libva-android \
+    libcutils \
+    libui \
+    libutils
+
+LOCAL_SHARED_LIBRARIES_32 := libmfxhw32
+LOCAL_SHARED_LIBRARIES_64 := libmfxhw64
+
+LOCAL_STATIC_LIBRARIES := libmfx_omx_buffers libmfx_omx_utils
+LOCAL_HEADER_LIBRARIES := $(MFX_OMX_HEADER_LIBRARIES)
+
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := mfx_omx_fc_bench
+
+include $(BUILD_EXECUTABLE)
+
+# =============================================================================
+# Replay of recorded client sessions
+
+include $(CLEAR_VARS)
+include $(MFX_OMX_HOME)/mfx_omx_defs.mk
+
+LOCAL_SRC_FILES := \
+    src/mfx_omx_replay.cpp
+
+LOCAL_C_INCLUDES := \
+    $(MFX_OMX_INCLUDES) \
+    $(MFX_OMX_HOME)/openmax/intel \
+    $(MFX_OMX_HOME)/omx_utils/include
+
+LOCAL_CFLAGS := \
+    $(MFX_OMX_CFLAGS)
+
+LOCAL_LDFLAGS := \
+    $(MFX_OMX_LDFLAGS)
+
+LOCAL_SHARED_LIBRARIES := libmfx_omx_core libcutils liblog
+LOCAL_HEADER_LIBRARIES := $(MFX_OMX_HEADER_LIBRARIES)
+
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := mfx_omx_replay
+
+include $(BUILD_EXECUTABLE)
+
+# =============================================================================
+# Synchronization primitives micro-benchmark
+
+include $(CLEAR_VARS)
+include $(MFX_OMX_HOME)/mfx_omx_defs.mk
+
+LOCAL_SRC_FILES := \
+    src/mfx_omx_sync_bench.cpp \
+    src/mfx_omx_bench_utils.cpp
+
+LOCAL_C_INCLUDES := \
+    $(MFX_OMX_INCLUDES) \
+    $(MFX_OMX_INCLUDES_LIBVA) \
+    $(MFX_OMX_HOME)/openmax/intel \
+    $(MFX_OMX_HOME)/omx_utils/include
+
+LOCAL_CFLAGS := \
+    $(MFX_OMX_CFLAGS) \
+    $(MFX_OMX_CFLAGS_LIBVA)
+
+LOCAL_LDFLAGS := \
+    $(MFX_OMX_LDFLAGS)
+
+LOCAL_SHARED_LIBRARIES := \
+    libdl liblog \
+    libva libva-android \
+    libcutils \
+    libui \
+    libutils
+
+LOCAL_STATIC_LIBRARIES := libmfx_omx_utils
+LOCAL_HEADER_LIBRARIES := $(MFX_OMX_HEADER_LIBRARIES)
+
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := mfx_omx_sync_bench
+
+include $(BUILD_EXECUTABLE)
+
+# =============================================================================
+# Trace overhead micro-benchmark
+
+include $(CLEAR_VARS)
+include $(MFX_OMX_HOME)/mfx_omx_defs.mk
+
+LOCAL_SRC_FILES := \
+    src/mfx_omx_trace_bench.cpp \
+    src/mfx_omx_bench_utils.cpp
+
+LOCAL_C_INCLUDES := \
+    $(MFX_OMX_INCLUDES) \
+    $(MFX_OMX_INCLUDES_LIBVA) \
+    $(MFX_OMX_HOME)/openmax/intel \
+    $(MFX_OMX_HOME)/omx_utils/include
+
+LOCAL_CFLAGS := \
+    $(MFX_OMX_CFLAGS) \
+    $(MFX_OMX_CFLAGS_LIBVA)
+
+LOCAL_LDFLAGS := \
+    $(MFX_OMX_LDFLAGS)
+
+LOCAL_SHARED_LIBRARIES := \
+    libdl liblog \
+    libva libva-android \
+    libcutils \
+    libui \
+    libutils
+
+LOCAL_STATIC_LIBRARIES := libmfx_omx_utils
+LOCAL_HEADER_LIBRARIES := $(MFX_OMX_HEADER_LIBRARIES)
+
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE := mfx_omx_trace_bench
+
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,244 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __MFX_OMX_BENCH_H__
+#define __MFX_OMX_BENCH_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <OMX_Core.h>
+#include <OMX_Component.h>
+#include <OMX_Video.h>
+#include "OMX_IntelVideoExt.h"
+
+/*------------------------------------------------------------------------------*/
+
+#define MFX_OMX_BENCH_INPUT_PORT 0
+#define MFX_OMX_BENCH_OUTPUT_PORT 1
+#define MFX_OMX_BENCH_PORTS_NUM 2
+
+typedef std::chrono::steady_clock MfxOmxBenchClock;
+
+// number of operator new calls made by the process (components included)
+extern std::atomic<uint64_t> g_OmxBenchAllocs;
+
+/*------------------------------------------------------------------------------*/
+
+template<typename T>
+inline void mfx_omx_bench_init_struct(T* s)
+{
+    memset(s, 0, sizeof(T));
+    s->nSize = sizeof(T);
+    s->nVersion.s.nVersionMajor = 1;
+    s->nVersion.s.nVersionMinor = 0;
+}
+
+/*------------------------------------------------------------------------------*/
+
+// parses comma separated names into their indices in names, false on unknown name
+extern bool mfx_omx_bench_parse_names(const char* str, const char* const* names, size_t count, std::vector<size_t>& list);
+
+/*------------------------------------------------------------------------------*/
+
+struct MfxOmxBenchSample
+{
+    size_t offset;
+    size_t size;
+};
+
+// Memory mapped input file split into samples (access units or raw frames)
+class MfxOmxBenchStream
+{
+public:
+    MfxOmxBenchStream(void);
+    ~MfxOmxBenchStream(void);
+
+    bool Open(const char* filename);
+
+    bool IsIvf(void) const;
+    // splits H.264 or H.265 Annex B stream into access units
+    void SplitAnnexB(bool bHevc);
+    // splits IVF container (VP8, VP9) into frames
+    void SplitIvf(void);
+    // splits raw video into frames of the given size
+    void SplitFrames(size_t frameSize);
+
+    const uint8_t* GetData(void) const { return m_pData; }
+    const std::vector<MfxOmxBenchSample>& GetSamples(void) const { return m_Samples; }
+
+protected:
+    uint8_t* m_pData;
+    size_t m_nSize;
+    std::vector<MfxOmxBenchSample> m_Samples;
+
+private:
+    MfxOmxBenchStream(const MfxOmxBenchStream&);
+    MfxOmxBenchStream& operator=(const MfxOmxBenchStream&);
+};
+
+/*------------------------------------------------------------------------------*/
+
+struct MfxOmxBenchConfig
+{
+    std::string component;
+    bool bEncoder;
+    uint32_t width;      // encoders only
+    uint32_t height;     // encoders only
+    uint32_t frames;     // encoders: frames to encode
+    uint32_t loops;      // decoders: times to play the stream
+    uint32_t bitrate;    // encoders, kbps
+    uint32_t framerate;
+    uint32_t timeout;    // ms to wait for any callback
+    uint32_t asyncDepth; // 0 - component default
+    uint32_t ratePeriod; // encoders: frames between bitrate and framerate changes, 0 - no changes
+};
+
+struct MfxOmxBenchResult
+{
+    bool bOk;
+    std::string error;
+    // async depth was accepted by the component
+    bool bAsyncDepthSet;
+
+    uint32_t frames;
+    uint64_t bytes;
+    uint32_t reconfigs;
+    uint32_t rateChanges;
+    // EmptyThisBuffer to FillBufferDone, us
+    std::vector<uint32_t> latencies;
+
+    bool bStats;
+    OMX_VIDEO_CONFIG_INTEL_RUNTIME_STATS stats;
+    bool bStages;
+    OMX_VIDEO_CONFIG_INTEL_LATENCY_STATS stages[OMX_VIDEO_IntelLatencyMax];
+};
+
+/*------------------------------------------------------------------------------*/
+
+// In-process OMX IL client running one component thru the stream
+class MfxOmxBenchClient
+{
+public:
+    MfxOmxBenchClient(const MfxOmxBenchConfig& config, const MfxOmxBenchStream* pStream);
+    ~MfxOmxBenchClient(void);
+
+    // creates the component and moves it to executing state
+    bool Init(void);
+    // processes the stream until end of stream is returned
+    bool Run(void);
+    // collects component statistics and destroys the component
+    void Close(void);
+
+    const MfxOmxBenchResult& GetResult(void) const { return m_Result; }
+
+protected:
+    enum MessageType
+    {
+        MESSAGE_EVENT,
+        MESSAGE_EMPTY_BUFFER_DONE,
+        MESSAGE_FILL_BUFFER_DONE
+    };
+
+    struct Message
+    {
+        MessageType type;
+        OMX_EVENTTYPE event;
+        OMX_U32 data1;
+        OMX_U32 data2;
+        OMX_BUFFERHEADERTYPE* pBuffer;
+    };
+
+    static OMX_ERRORTYPE EventHandler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
+                                      OMX_EVENTTYPE eEvent, OMX_U32 nData1, OMX_U32 nData2,
+                                      OMX_PTR pEventData);
+    static OMX_ERRORTYPE EmptyBufferDone(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
+                                         OMX_BUFFERHEADERTYPE* pBuffer);
+    static OMX_ERRORTYPE FillBufferDone(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
+                                        OMX_BUFFERHEADERTYPE* pBuffer);
+
+    void Post(const Message& message);
+    bool WaitMessage(Message* pMessage);
+    bool ProcessMessage(const Message& message);
+    bool SendCommand(OMX_COMMANDTYPE cmd, OMX_U32 data);
+    bool WaitCommand(void);
+
+    bool SetAsyncDepth(void);
+    bool ConfigurePorts(void);
+    bool AllocateBuffers(OMX_U32 port);
+    void FreeBuffers(OMX_U32 port);
+    bool ChangeRates(void);
+    bool FillInput(OMX_BUFFERHEADERTYPE* pBuffer);
+    bool SubmitInputs(void);
+    bool SubmitOutputs(void);
+    void QueryStats(void);
+    bool Fail(const char* format, ...);
+
+    const MfxOmxBenchConfig& m_Config;
+    const MfxOmxBenchStream* m_pStream;
+    OMX_HANDLETYPE m_hComponent;
+    OMX_CALLBACKTYPE m_Callbacks;
+    OMX_STATETYPE m_State;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Cond;
+    std::deque<Message> m_Messages;
+
+    // command waited for by WaitCommand
+    OMX_COMMANDTYPE m_PendingCmd;
+    OMX_U32 m_PendingData;
+    bool m_bPendingDone;
+
+    OMX_PARAM_PORTDEFINITIONTYPE m_PortDef[MFX_OMX_BENCH_PORTS_NUM];
+    std::vector<OMX_BUFFERHEADERTYPE*> m_Buffers[MFX_OMX_BENCH_PORTS_NUM];
+    // buffers owned by the client
+    std::vector<OMX_BUFFERHEADERTYPE*> m_FreeBuffers[MFX_OMX_BENCH_PORTS_NUM];
+
+    bool m_bOutputReconfig;
+    bool m_bStopping;
+    bool m_bEosSent;
+    bool m_bEosReceived;
+
+    size_t m_nSample;
+    size_t m_nSampleOffset;
+    uint32_t m_nLoop;
+    uint32_t m_nFrame;
+    // synthetic encoder input used when no file is given
+    std::vector<uint8_t> m_Frame;
+    // submission time of frames in flight by timestamp
+    std::map<OMX_TICKS, MfxOmxBenchClock::time_point> m_InFlight;
+
+    MfxOmxBenchResult m_Result;
+
+private:
+    MfxOmxBenchClient(const MfxOmxBenchClient&);
+    MfxOmxBenchClient& operator=(const MfxOmxBenchClient&);
+};
+
+#endif // #ifndef __MFX_OMX_BENCH_H__
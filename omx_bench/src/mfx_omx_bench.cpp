@@ -0,0 +1,526 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mfx_omx_bench.h"
+
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+
+/*------------------------------------------------------------------------------*/
+
+std::atomic<uint64_t> g_OmxBenchAllocs(0);
+
+// Allocations are counted for the whole process, so components loaded
+// into it are counted as well; malloc calls made by C code are not seen.
+
+void* operator new(size_t size)
+{
+    ++g_OmxBenchAllocs;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    ++g_OmxBenchAllocs;
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { free(p); }
+
+/*------------------------------------------------------------------------------*/
+
+struct MfxOmxBenchResolution
+{
+    uint32_t width;
+    uint32_t height;
+};
+
+struct MfxOmxBenchOptions
+{
+    MfxOmxBenchConfig config;
+    const char* input;
+    const char* output;
+    std::vector<MfxOmxBenchResolution> resolutions;
+    std::vector<uint32_t> asyncDepths; // 0 - component default
+    std::vector<uint32_t> instances;
+};
+
+/*------------------------------------------------------------------------------*/
+
+static void usage(const char* app)
+{
+    printf("Usage: %s -c component [options]\n"
+           "  -c name     OMX component, e.g. OMX.Intel.hw_vd.h264\n"
+           "  -i file     input: Annex B or IVF stream for decoders, raw NV12 for encoders\n"
+           "  -r WxH,...  encoder resolutions (default 1920x1080)\n"
+           "  -d N,...    async depths, 0 is component default (default 0)\n"
+           "  -j N,...    concurrent instances (default 1)\n"
+           "  -n N        frames to encode (default 300)\n"
+           "  -l N        times to decode the stream (default 1)\n"
+           "  -b kbps     encoder bitrate (default 4000)\n"
+           "  -f fps      frame rate (default 30)\n"
+           "  -R N        change encoder bitrate and frame rate every N frames, fails if\n"
+           "              frames in flight are drained for it (default 0 - no changes)\n"
+           "  -t ms       timeout for any component callback (default 5000)\n"
+           "  -o file     append results to file instead of stdout\n"
+           "Each configuration prints one JSON object per line.\n", app);
+}
+
+/*------------------------------------------------------------------------------*/
+
+static bool parse_list(const char* str, std::vector<uint32_t>& list)
+{
+    char* end = NULL;
+
+    list.clear();
+    do
+    {
+        if (!strcmp(str, "default"))
+        {
+            list.push_back(0);
+            end = (char*)str + strlen(str);
+        }
+        else
+        {
+            list.push_back((uint32_t)strtoul(str, &end, 10));
+            if (end == str) return false;
+        }
+        str = end + 1;
+    } while (',' == *end);
+
+    return !*end;
+}
+
+/*------------------------------------------------------------------------------*/
+
+static bool parse_resolutions(const char* str, std::vector<MfxOmxBenchResolution>& list)
+{
+    char* end = NULL;
+
+    list.clear();
+    do
+    {
+        MfxOmxBenchResolution res;
+
+        res.width = (uint32_t)strtoul(str, &end, 10);
+        if ((end == str) || ('x' != *end)) return false;
+        str = end + 1;
+        res.height = (uint32_t)strtoul(str, &end, 10);
+        if ((end == str) || !res.width || !res.height) return false;
+        list.push_back(res);
+        str = end + 1;
+    } while (',' == *end);
+
+    return !*end;
+}
+
+/*------------------------------------------------------------------------------*/
+
+static bool parse_options(int argc, char** argv, MfxOmxBenchOptions& options)
+{
+    MfxOmxBenchResolution res = { 1920, 1080 };
+    bool bOk = true;
+    int opt = 0;
+
+    options.config.bEncoder = false;
+    options.config.width = 0;
+    options.config.height = 0;
+    options.config.frames = 300;
+    options.config.loops = 1;
+    options.config.bitrate = 4000;
+    options.config.framerate = 30;
+    options.config.timeout = 5000;
+    options.config.asyncDepth = 0;
+    options.config.ratePeriod = 0;
+    options.input = NULL;
+    options.output = NULL;
+    options.resolutions.assign(1, res);
+    options.asyncDepths.assign(1, 0);
+    options.instances.assign(1, 1);
+
+    while (bOk && (-1 != (opt = getopt(argc, argv, "c:i:r:d:j:n:l:b:f:R:t:o:h"))))
+    {
+        switch (opt)
+        {
+        case 'c': options.config.component = optarg; break;
+        case 'i': options.input = optarg; break;
+        case 'r': bOk = parse_resolutions(optarg, options.resolutions); break;
+        case 'd': bOk = parse_list(optarg, options.asyncDepths); break;
+        case 'j': bOk = parse_list(optarg, options.instances); break;
+        case 'n': options.config.frames = (uint32_t)atoi(optarg); break;
+        case 'l': options.config.loops = (uint32_t)atoi(optarg); break;
+        case 'b': options.config.bitrate = (uint32_t)atoi(optarg); break;
+        case 'f': options.config.framerate = (uint32_t)atoi(optarg); break;
+        case 'R': options.config.ratePeriod = (uint32_t)atoi(optarg); break;
+        case 't': options.config.timeout = (uint32_t)atoi(optarg); break;
+        case 'o': options.output = optarg; break;
+        default: bOk = false; break;
+        }
+    }
+    if (!bOk || options.config.component.empty() || !options.config.framerate || !options.config.loops) return false;
+
+    for (size_t i = 0; i < options.instances.size(); ++i)
+    {
+        if (!options.instances[i]) return false;
+    }
+    for (size_t i = 0; i < options.asyncDepths.size(); ++i)
+    {
+        if (options.asyncDepths[i] > OMX_VIDEO_INTEL_MAX_ASYNC_DEPTH) return false;
+    }
+    options.config.bEncoder = (std::string::npos != options.config.component.find(".hw_ve."));
+
+    // decoders need a stream, resolution comes from it
+    if (!options.config.bEncoder && !options.input) return false;
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+static bool open_stream(const MfxOmxBenchOptions& options, const MfxOmxBenchResolution& res,
+                        MfxOmxBenchStream& stream)
+{
+    if (!stream.Open(options.input))
+    {
+        fprintf(stderr, "failed to open %s\n", options.input);
+        return false;
+    }
+    if (options.config.bEncoder)
+    {
+        stream.SplitFrames((size_t)res.width * res.height * 3 / 2);
+    }
+    else if (stream.IsIvf())
+    {
+        stream.SplitIvf();
+    }
+    else
+    {
+        const std::string& name = options.config.component;
+        stream.SplitAnnexB(std::string::npos != name.find("h265") || std::string::npos != name.find("hevc"));
+    }
+    if (stream.GetSamples().empty())
+    {
+        fprintf(stderr, "no frames found in %s\n", options.input);
+        return false;
+    }
+    return true;
+}
+
+
+/*------------------------------------------------------------------------------*/
+
+static uint64_t get_cpu_time_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*------------------------------------------------------------------------------*/
+
+static uint32_t percentile(const std::vector<uint32_t>& sorted, uint32_t p)
+{
+    if (sorted.empty()) return 0;
+    return sorted[std::min(sorted.size() - 1, sorted.size() * p / 100)];
+}
+
+/*------------------------------------------------------------------------------*/
+
+// Measures the interval where all instances stream: it starts when the last
+// instance reaches executing state and stops when the last one gets end of
+// stream, so component creation and destruction are not counted.
+class MfxOmxBenchWindow
+{
+public:
+    MfxOmxBenchWindow(uint32_t count):
+        m_nCount(count), m_nStarted(0), m_nStopped(0),
+        m_Wall(0), m_nCpu(0), m_nAllocs(0)
+    {
+    }
+
+    // waits for all instances to start
+    void Start(void)
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+
+        if (++m_nStarted == m_nCount)
+        {
+            m_nAllocs = g_OmxBenchAllocs.load();
+            m_nCpu = get_cpu_time_us();
+            m_Start = MfxOmxBenchClock::now();
+            m_Cond.notify_all();
+        }
+        else m_Cond.wait(lock, [this] { return m_nStarted == m_nCount; });
+    }
+
+    // waits for all instances to stop, so none is closed while others stream
+    void Stop(void)
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+
+        if (++m_nStopped == m_nCount)
+        {
+            m_Wall = std::chrono::duration<double, std::micro>(MfxOmxBenchClock::now() - m_Start).count();
+            m_nCpu = get_cpu_time_us() - m_nCpu;
+            m_nAllocs = g_OmxBenchAllocs.load() - m_nAllocs;
+            m_Cond.notify_all();
+        }
+        else m_Cond.wait(lock, [this] { return m_nStopped == m_nCount; });
+    }
+
+    double GetWall(void) const { return m_Wall; }     // us
+    uint64_t GetCpu(void) const { return m_nCpu; }    // us
+    uint64_t GetAllocs(void) const { return m_nAllocs; }
+
+protected:
+    std::mutex m_Mutex;
+    std::condition_variable m_Cond;
+    uint32_t m_nCount;
+    uint32_t m_nStarted;
+    uint32_t m_nStopped;
+
+    MfxOmxBenchClock::time_point m_Start;
+    double m_Wall;
+    uint64_t m_nCpu;
+    uint64_t m_nAllocs;
+
+private:
+    MfxOmxBenchWindow(const MfxOmxBenchWindow&);
+    MfxOmxBenchWindow& operator=(const MfxOmxBenchWindow&);
+};
+
+/*------------------------------------------------------------------------------*/
+
+static void run_instance(MfxOmxBenchClient* pClient, MfxOmxBenchWindow* pWindow)
+{
+    bool bOk = pClient->Init();
+
+    // all instances start streaming together
+    pWindow->Start();
+    if (bOk) pClient->Run();
+    pWindow->Stop();
+
+    pClient->Close();
+}
+
+/*------------------------------------------------------------------------------*/
+
+static void print_stage(FILE* f, const char* name, const OMX_VIDEO_CONFIG_INTEL_LATENCY_STATS& s)
+{
+    fprintf(f, "\"%s\":{\"frames\":%u,\"mean\":%u,\"p50\":%u,\"p90\":%u,\"p99\":%u,\"max\":%u}",
+            name, s.nFrames, s.nMean, s.nP50, s.nP90, s.nP99, s.nMax);
+}
+
+/*------------------------------------------------------------------------------*/
+
+static void print_instance(FILE* f, const MfxOmxBenchResult& r)
+{
+    static const char* stages[OMX_VIDEO_IntelLatencyMax] = { "parse", "queue", "gpu", "output", "total" };
+
+    fprintf(f, "{\"ok\":%s,\"frames\":%u,\"bytes\":%llu,\"reconfigs\":%u,\"rate_changes\":%u",
+            r.bOk ? "true" : "false", r.frames, (unsigned long long)r.bytes, r.reconfigs, r.rateChanges);
+    if (!r.bOk) fprintf(f, ",\"error\":\"%s\"", r.error.c_str());
+    if (r.bStats)
+    {
+        fprintf(f, ",\"stats\":{\"version\":%u,\"input_buffers\":%u,\"output_buffers\":%u,\"processed\":%u,"
+                "\"bytes_copied\":%u,\"buffer_reallocs\":%u,\"device_busy\":%u,\"resets\":%u,"
+                "\"reinits\":%u,\"errors\":%u,\"drains\":%u,\"config_resets\":%u,"
+                "\"config_resets_idr\":%u,\"config_reinits\":%u,\"callbacks\":%u,"
+                "\"callback_mean_us\":%u,\"callback_max_us\":%u,\"callback_queue_waits\":%u}",
+                r.stats.nStatsVersion, r.stats.nInputBuffers, r.stats.nOutputBuffers, r.stats.nProcessedFrames,
+                r.stats.nBytesCopied, r.stats.nBufferReallocs, r.stats.nDeviceBusy, r.stats.nResets,
+                r.stats.nReinits, r.stats.nErrors, r.stats.nDrains, r.stats.nConfigResets,
+                r.stats.nConfigResetsIdr, r.stats.nConfigReinits, r.stats.nCallbacks,
+                r.stats.nCallbackMeanTime, r.stats.nCallbackMaxTime, r.stats.nCallbackQueueWaits);
+    }
+    if (r.bStages)
+    {
+        fprintf(f, ",\"stages\":{");
+        for (uint32_t i = 0; i < OMX_VIDEO_IntelLatencyMax; ++i)
+        {
+            if (i) fprintf(f, ",");
+            print_stage(f, stages[i], r.stages[i]);
+        }
+        fprintf(f, "}");
+    }
+    fprintf(f, "}");
+}
+
+/*------------------------------------------------------------------------------*/
+
+static bool run_config(const MfxOmxBenchOptions& options, const MfxOmxBenchStream* pStream,
+                       const MfxOmxBenchResolution& res, uint32_t asyncDepth, uint32_t count, FILE* f)
+{
+    MfxOmxBenchConfig config = options.config;
+    std::vector<MfxOmxBenchClient*> clients;
+    std::vector<std::thread> threads;
+    MfxOmxBenchWindow window(count);
+
+    config.width = res.width;
+    config.height = res.height;
+    config.asyncDepth = asyncDepth;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        clients.push_back(new MfxOmxBenchClient(config, pStream));
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        threads.push_back(std::thread(run_instance, clients[i], &window));
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        threads[i].join();
+    }
+
+    double wall = window.GetWall();
+    uint64_t cpu = window.GetCpu();
+    uint64_t allocs = window.GetAllocs();
+
+    std::vector<uint32_t> latencies;
+    uint64_t frames = 0;
+    uint32_t errors = 0;
+    bool bAsyncDepthSet = true;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const MfxOmxBenchResult& r = clients[i]->GetResult();
+
+        frames += r.frames;
+        if (!r.bOk) ++errors;
+        if (!r.bAsyncDepthSet) bAsyncDepthSet = false;
+        latencies.insert(latencies.end(), r.latencies.begin(), r.latencies.end());
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    double fps = wall > 0 ? frames * 1000000.0 / wall : 0;
+
+    fprintf(f, "{\"component\":\"%s\",\"mode\":\"%s\",", config.component.c_str(),
+            config.bEncoder ? "encode" : "decode");
+    if (config.bEncoder) fprintf(f, "\"width\":%u,\"height\":%u,", res.width, res.height);
+    fprintf(f, "\"async_depth\":%u,\"async_depth_applied\":%s,\"instances\":%u,"
+            "\"frames\":%llu,\"wall_ms\":%.3f,\"fps\":%.2f,\"fps_per_instance\":%.2f,"
+            "\"cpu_us_per_frame\":%.1f,\"allocs\":%llu,\"allocs_per_frame\":%.2f,",
+            asyncDepth, bAsyncDepthSet ? "true" : "false", count,
+            (unsigned long long)frames, wall / 1000, fps, fps / count,
+            frames ? (double)cpu / frames : 0.0, (unsigned long long)allocs,
+            frames ? (double)allocs / frames : 0.0);
+    fprintf(f, "\"latency_us\":{\"count\":%zu,\"p50\":%u,\"p90\":%u,\"p99\":%u,\"max\":%u},",
+            latencies.size(), percentile(latencies, 50), percentile(latencies, 90),
+            percentile(latencies, 99), latencies.empty() ? 0 : latencies.back());
+    fprintf(f, "\"errors\":%u,\"instance\":[", errors);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (i) fprintf(f, ",");
+        print_instance(f, clients[i]->GetResult());
+    }
+    fprintf(f, "]}\n");
+    fflush(f);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        delete clients[i];
+    }
+    return !errors;
+}
+
+/*------------------------------------------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+    MfxOmxBenchOptions options;
+
+    if (!parse_options(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    FILE* f = stdout;
+    if (options.output && !(f = fopen(options.output, "a")))
+    {
+        fprintf(stderr, "failed to open %s\n", options.output);
+        return 1;
+    }
+    if (OMX_ErrorNone != OMX_Init())
+    {
+        fprintf(stderr, "OMX_Init failed\n");
+        if (stdout != f) fclose(f);
+        return 1;
+    }
+
+    // decoders take resolution from the stream
+    std::vector<MfxOmxBenchResolution> resolutions(options.resolutions);
+    if (!options.config.bEncoder) resolutions.resize(1);
+
+    bool bOk = true;
+    for (size_t r = 0; bOk && (r < resolutions.size()); ++r)
+    {
+        MfxOmxBenchStream stream;
+        const MfxOmxBenchStream* pStream = NULL;
+
+        if (options.input)
+        {
+            if (!open_stream(options, resolutions[r], stream))
+            {
+                bOk = false;
+                break;
+            }
+            pStream = &stream;
+        }
+        for (size_t d = 0; d < options.asyncDepths.size(); ++d)
+        {
+            for (size_t j = 0; j < options.instances.size(); ++j)
+            {
+                if (!run_config(options, pStream, resolutions[r], options.asyncDepths[d],
+                                options.instances[j], f))
+                {
+                    bOk = false;
+                }
+            }
+        }
+    }
+
+    OMX_Deinit();
+    if (stdout != f) fclose(f);
+    return bOk ? 0 : 2;
+}
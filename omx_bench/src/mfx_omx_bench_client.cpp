@@ -0,0 +1,644 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mfx_omx_bench.h"
+
+#include <stdarg.h>
+
+/*------------------------------------------------------------------------------*/
+
+#define MFX_OMX_BENCH_STRING_SIZE 256
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxBenchClient::MfxOmxBenchClient(const MfxOmxBenchConfig& config, const MfxOmxBenchStream* pStream):
+    m_Config(config),
+    m_pStream(pStream),
+    m_hComponent(NULL),
+    m_State(OMX_StateLoaded),
+    m_PendingCmd(OMX_CommandStateSet),
+    m_PendingData(0),
+    m_bPendingDone(true),
+    m_bOutputReconfig(false),
+    m_bStopping(false),
+    m_bEosSent(false),
+    m_bEosReceived(false),
+    m_nSample(0),
+    m_nSampleOffset(0),
+    m_nLoop(0),
+    m_nFrame(0)
+{
+    m_Callbacks.EventHandler = EventHandler;
+    m_Callbacks.EmptyBufferDone = EmptyBufferDone;
+    m_Callbacks.FillBufferDone = FillBufferDone;
+
+    for (OMX_U32 i = 0; i < MFX_OMX_BENCH_PORTS_NUM; ++i)
+    {
+        mfx_omx_bench_init_struct(&m_PortDef[i]);
+    }
+
+    m_Result.bOk = true;
+    m_Result.bAsyncDepthSet = false;
+    m_Result.frames = 0;
+    m_Result.bytes = 0;
+    m_Result.reconfigs = 0;
+    m_Result.rateChanges = 0;
+    m_Result.bStats = false;
+    m_Result.bStages = false;
+    mfx_omx_bench_init_struct(&m_Result.stats);
+    for (OMX_U32 i = 0; i < OMX_VIDEO_IntelLatencyMax; ++i)
+    {
+        mfx_omx_bench_init_struct(&m_Result.stages[i]);
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxBenchClient::~MfxOmxBenchClient(void)
+{
+    Close();
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxBenchClient::Fail(const char* format, ...)
+{
+    char str[MFX_OMX_BENCH_STRING_SIZE];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(str, sizeof(str), format, args);
+    va_end(args);
+
+    // the first error is the reason, others are consequences
+    if (m_Result.bOk) m_Result.error = str;
+    m_Result.bOk = false;
+    return false;
+}
+
+/*------------------------------------------------------------------------------*/
+
+OMX_ERRORTYPE MfxOmxBenchClient::EventHandler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
+                                              OMX_EVENTTYPE eEvent, OMX_U32 nData1, OMX_U32 nData2,
+                                              OMX_PTR pEventData)
+{
+    Message message = { MESSAGE_EVENT, eEvent, nData1, nData2, NULL };
+
+    (void)hComponent;
+    (void)pEventData;
+    static_cast<MfxOmxBenchClient*>(pAppData)->Post(message);
+    return OMX_ErrorNone;
+}
+
+/*------------------------------------------------------------------------------*/
+
+OMX_ERRORTYPE MfxOmxBenchClient::EmptyBufferDone(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
+                                                 OMX_BUFFERHEADERTYPE* pBuffer)
+{
+    Message message = { MESSAGE_EMPTY_BUFFER_DONE, OMX_EventMax, 0, 0, pBuffer };
+
+    (void)hComponent;
+    static_cast<MfxOmxBenchClient*>(pAppData)->Post(message);
+    return OMX_ErrorNone;
+}
+
+/*------------------------------------------------------------------------------*/
+
+OMX_ERRORTYPE MfxOmxBenchClient::FillBufferDone(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
+                                                OMX_BUFFERHEADERTYPE* pBuffer)
+{
+    Message message = { MESSAGE_FILL_BUFFER_DONE, OMX_EventMax, 0, 0, pBuffer };
+
+    (void)hComponent;
+    // latency is measured at the callback, not when the client gets to it
+    if (pBuffer->nFilledLen && !(pBuffer->nFlags & OMX_BUFFERFLAG_CODECCONFIG))
+    {
+        MfxOmxBenchClient* pClient = static_cast<MfxOmxBenchClient*>(pAppData);
+        MfxOmxBenchClock::time_point now = MfxOmxBenchClock::now();
+        std::lock_guard<std::mutex> lock(pClient->m_Mutex);
+        std::map<OMX_TICKS, MfxOmxBenchClock::time_point>::iterator it = pClient->m_InFlight.find(pBuffer->nTimeStamp);
+
+        if (pClient->m_InFlight.end() != it)
+        {
+            pClient->m_Result.latencies.push_back((uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(now - it->second).count());
+            pClient->m_InFlight.erase(it);
+        }
+    }
+    static_cast<MfxOmxBenchClient*>(pAppData)->Post(message);
+    return OMX_ErrorNone;
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxBenchClient::Post(const Message& message)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Messages.push_back(message);
+    m_Cond.notify_one();
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxBenchClient::WaitMessage(Message* pMessage)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    if (!m_Cond.wait_for(lock, std::chrono::milliseconds(m_Config.timeout),
+                         [this] { return !m_Messages.empty(); }))
+    {
+        return Fail("no callbacks for %u ms", m_Config.timeout);
+    }
+    *pMessage = m_Messages.front();
+    m_Messages.pop_front();
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxBenchClient::SendCommand(OMX_COMMANDTYPE cmd, OMX_U32 data)
+{
+    m_PendingCmd = cmd;
+    m_PendingData = data;
+    m_bPendingDone = false;
+
+    OMX_ERRORTYPE omx_res = OMX_SendCommand(m_hComponent, cmd, data, NULL);
+    if (OMX_ErrorNone != omx_res)
+    {
+        m_bPendingDone = true;
+        return Fail("SendCommand(%d, %u) failed with 0x%x", cmd, data, omx_res);
+    }
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxBenchClient::WaitCommand(void)
+{
+    Message message;
+
+    while (!m_bPendingDone)
+    {
+        if (!WaitMessage(&message) || !ProcessMessage(message)) return false;
+    }
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxBenchClient::SetAsyncDepth(void)
+{
+    OMX_VIDEO_PARAM_INTEL_ASYNC_DEPTH param;
+    OMX_INDEXTYPE index;
+
+    m_Result.bAsyncDepthSet = !m_Config.asyncDepth;
+    if (!m_Config.asyncDepth) return true;
+
+    // components without the extension run with their own value, results are marked then
+    if (OMX_ErrorNone != OMX_GetExtensionIndex(m_hComponent, (OMX_STRING)"OMX.intel.index.asyncdepth", &index)) return true;
+
+    mfx_omx_bench_init_struct(&param);
+    param.nPortIndex = MFX_OMX_BENCH_OUTPUT_PORT;
+    param.nAsyncDepth = m_Config.asyncDepth;
+
+    OMX_ERRORTYPE omx_res = OMX_SetParameter(m_hComponent, index, &param);
+    if (OMX_ErrorNone != omx_res) return Fail("SetParameter(asyncdepth %u) failed with 0x%x", m_Config.asyncDepth, omx_res);
+
+    m_Result.bAsyncDepthSet = true;
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxBenchClient::ConfigurePorts(void)
+{
+    OMX_ERRORTYPE omx_res = OMX_ErrorNone;
+
+    for (OMX_U32 i = 0; (OMX_ErrorNone == omx_res) && (i < MFX_OMX_BENCH_PORTS_NUM); ++i)
+    {
+        m_PortDef[i].nPortIndex = i;
+        omx_res = OMX_GetParameter(m_hComponent, OMX_IndexParamPortDefinition, &m_PortDef[i]);
+    }
+    if (OMX_ErrorNone != omx_res) return Fail("GetParameter(PortDefinition) failed with 0x%x", omx_res);
+
+    if (!m_Config.bEncoder) return true;
+
+    OMX_PARAM_PORTDEFINITIONTYPE& in = m_PortDef[MFX_OMX_BENCH_INPUT_PORT];
+    OMX_PARAM_PORTDEFINITIONTYPE& out = m_PortDef[MFX_OMX_BENCH_OUTPUT_PORT];
+
+    in.format.video.nFrameWidth = m_Config.width;
+    in.format.video.nFrameHeight = m_Config.height;
+    in.format.video.nStride = m_Config.width;
+    in.format.video.nSliceHeight = m_Config.height;
+    in.format.video.xFramerate = m_Config.framerate << 16;
+    in.format.video.eColorFormat = OMX_COLOR_FormatYUV420SemiPlanar;
+    in.nBufferSize = m_Config.width * m_Config.height * 3 / 2;
+    omx_res = OMX_SetParameter(m_hComponent, OMX_IndexParamPortDefinition, &in);
+
+    if (OMX_ErrorNone == omx_res)
+    {
+        out.format.video.nFrameWidth = m_Config.width;
+        out.format.video.nFrameHeight = m_Config.height;
+        out.format.video.xFramerate = m_Config.framerate << 16;
+        out.format.video.nBitrate = m_Config.bitrate * 1000;
+        omx_res = OMX_SetParameter(m_hComponent, OMX_IndexParamPortDefinition, &out);
+    }
+    if (OMX_ErrorNone == omx_res)
+    {
+        OMX_VIDEO_PARAM_BITRATETYPE bitrate;
+
+        mfx_omx_bench_init_struct(&bitrate);
+        bitrate.nPortIndex = MFX_OMX_BENCH_OUTPUT_PORT;
+        bitrate.eControlRate = OMX_Video_ControlRateVariable;
+        bitrate.nTargetBitrate = m_Config.bitrate * 1000;
+        omx_res = OMX_SetParameter(m_hComponent, OMX_IndexParamVideoBitrate, &bitrate);
+    }
+    if (OMX_ErrorNone != omx_res) return Fail("encoder configuration failed with 0x%x", omx_res);
+
+    if (!m_pStream)
+    {
+        // mid gray NV12 frame
+        m_Frame.assign(m_Config.width * m_Config.height * 3 / 2, 0x80);
+    }
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxBenchClient::AllocateBuffers(OMX_U32 port)
+{
+    OMX_PARAM_PORTDEFINITIONTYPE& def = m_PortDef[port];
+    OMX_ERRORTYPE omx_res = OMX_ErrorNone;
+
+    def.nPortIndex = port;
+    omx_res = OMX_GetParameter(m_hComponent, OMX_IndexParamPortDefinition, &def);
+
+    for (OMX_U32 i = 0; (OMX_ErrorNone == omx_res) && (i < def.nBufferCountActual); ++i)
+    {
+        OMX_BUFFERHEADERTYPE* pBuffer = NULL;
+
+        omx_res = OMX_AllocateBuffer(m_hComponent, &pBuffer, port, NULL, def.nBufferSize);
+        if (OMX_ErrorNone == omx_res)
+        {
+            m_Buffers[port].push_back(pBuffer);
+            m_FreeBuffers[port].push_back(pBuffer);
+        }
+    }
+    if (OMX_ErrorNone != omx_res) return Fail("AllocateBuffer(%u) failed with 0x%x", port, omx_res);
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxBenchClient::FreeBuffers(OMX_U32 port)
+{
+    for (size_t i = 0; i < m_FreeBuffers[port].size(); ++i)
+    {
+        OMX_BUFFERHEADERTYPE* pBuffer = m_FreeBuffers[port][i];
+
+        OMX_FreeBuffer(m_hComponent, port, pBuffer);
+        for (size_t j = 0; j < m_Buffers[port].size(); ++j)
+        {
+            if (m_Buffers[port][j] == pBuffer)
+            {
+                m_Buffers[port].erase(m_Buffers[port].begin() + j);
+                break;
+            }
+        }
+    }
+    m_FreeBuffers[port].clear();
+}
+
+/*------------------------------------------------------------------------------*/
+
+// Switches between configured and halved bitrate and between configured and
+// doubled framerate, encoder applies both with the next frame.
+bool MfxOmxBenchClient::ChangeRates(void)
+{
+    bool bAlternate = !(m_Result.rateChanges % 2);
+    OMX_VIDEO_CONFIG_BITRATETYPE bitrate;
+    OMX_CONFIG_FRAMERATETYPE framerate;
+
+    mfx_omx_bench_init_struct(&bitrate);
+    bitrate.nPortIndex = MFX_OMX_BENCH_OUTPUT_PORT;
+    bitrate.nEncodeBitrate = (bAlternate ? m_Config.bitrate / 2 : m_Config.bitrate) * 1000;
+
+    OMX_ERRORTYPE omx_res = OMX_SetConfig(m_hComponent, OMX_IndexConfigVideoBitrate, &bitrate);
+    if (OMX_ErrorNone != omx_res) return Fail("SetConfig(VideoBitrate) failed with 0x%x", omx_res);
+
+    mfx_omx_bench_init_struct(&framerate);
+    framerate.nPortIndex = MFX_OMX_BENCH_OUTPUT_PORT;
+    framerate.xEncodeFramerate = (bAlternate ? m_Config.framerate * 2 : m_Config.framerate) << 16;
+
+    omx_res = OMX_SetConfig(m_hComponent, OMX_IndexConfigVideoFramerate, &framerate);
+    if (OMX_ErrorNone != omx_res) return Fail("SetConfig(VideoFramerate) failed with 0x%x", omx_res);
+
+    ++m_Result.rateChanges;
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxBenchClient::FillInput(OMX_BUFFERHEADERTYPE* pBuffer)
+{
+    const OMX_TICKS duration = 1000000 / m_Config.framerate;
+    const uint8_t* pData = NULL;
+    size_t size = 0;
+
+    if (m_bEosSent) return false;
+
+    pBuffer->nOffset = 0;
+    pBuffer->nFlags = 0;
+    pBuffer->nTimeStamp = m_nFrame * duration;
+
+    if (m_Config.bEncoder)
+    {
+        if (m_nFrame < m_Config.frames)
+        {
+            if (m_pStream)
+            {
+                const std::vector<MfxOmxBenchSample>& samples = m_pStream->GetSamples();
+                const MfxOmxBenchSample& sample = samples[m_nFrame % samples.size()];
+
+                pData = m_pStream->GetData() + sample.offset;
+                size = sample.size;
+            }
+            else
+            {
+                pData = m_Frame.data();
+                size = m_Frame.size();
+            }
+            if (size > pBuffer->nAllocLen) return Fail("input frame of %zu bytes exceeds buffer of %u bytes", size, pBuffer->nAllocLen);
+            if (m_Config.ratePeriod && m_nFrame && !(m_nFrame % m_Config.ratePeriod) && !ChangeRates()) return false;
+        }
+    }
+    else
+    {
+        const std::vector<MfxOmxBenchSample>& samples = m_pStream->GetSamples();
+
+        if ((m_nSample == samples.size()) && (m_nLoop + 1 < m_Config.loops))
+        {
+            m_nSample = 0;
+            ++m_nLoop;
+        }
+        if (m_nSample < samples.size())
+        {
+            const MfxOmxBenchSample& sample = samples[m_nSample];
+
+            pData = m_pStream->GetData() + sample.offset + m_nSampleOffset;
+            size = sample.size - m_nSampleOffset;
+            // sample is split if it does not fit
+            if (size > pBuffer->nAllocLen) size = pBuffer->nAllocLen;
+        }
+    }
+
+    if (!pData)
+    {
+        pBuffer->nFilledLen = 0;
+        pBuffer->nFlags = OMX_BUFFERFLAG_EOS;
+        m_bEosSent = true;
+        return true;
+    }
+
+    memcpy(pBuffer->pBuffer, pData, size);
+    pBuffer->nFilledLen = (OMX_U32)size;
+
+    if (!m_nSampleOffset)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_InFlight[pBuffer->nTimeStamp] = MfxOmxBenchClock::now();
+    }
+    if (m_Config.bEncoder)
+    {
+        pBuffer->nFlags = OMX_BUFFERFLAG_ENDOFFRAME;
+        ++m_nFrame;
+    }
+    else
+    {
+        m_nSampleOffset += size;
+        if (m_nSampleOffset == m_pStream->GetSamples()[m_nSample].size)
+        {
+            pBuffer->nFlags = OMX_BUFFERFLAG_ENDOFFRAME;
+            m_nSampleOffset = 0;
+            ++m_nSample;
+            ++m_nFrame;
+        }
+    }
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxBenchClient::SubmitInputs(void)
+{
+    std::vector<OMX_BUFFERHEADERTYPE*>& buffers = m_FreeBuffers[MFX_OMX_BENCH_INPUT_PORT];
+
+    while (!buffers.empty() && !m_bStopping)
+    {
+        OMX_BUFFERHEADERTYPE* pBuffer = buffers.back();
+
+        if (!FillInput(pBuffer)) break;
+        buffers.pop_back();
+
+        OMX_ERRORTYPE omx_res = OMX_EmptyThisBuffer(m_hComponent, pBuffer);
+        if (OMX_ErrorNone != omx_res) return Fail("EmptyThisBuffer failed with 0x%x", omx_res);
+    }
+    return m_Result.bOk;
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxBenchClient::SubmitOutputs(void)
+{
+    std::vector<OMX_BUFFERHEADERTYPE*>& buffers = m_FreeBuffers[MFX_OMX_BENCH_OUTPUT_PORT];
+
+    while (!buffers.empty() && !m_bStopping && !m_bOutputReconfig && !m_bEosReceived)
+    {
+        OMX_BUFFERHEADERTYPE* pBuffer = buffers.back();
+
+        buffers.pop_back();
+        pBuffer->nOffset = 0;
+        pBuffer->nFilledLen = 0;
+        pBuffer->nFlags = 0;
+
+        OMX_ERRORTYPE omx_res = OMX_FillThisBuffer(m_hComponent, pBuffer);
+        if (OMX_ErrorNone != omx_res) return Fail("FillThisBuffer failed with 0x%x", omx_res);
+    }
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxBenchClient::ProcessMessage(const Message& message)
+{
+    const OMX_U32 out = MFX_OMX_BENCH_OUTPUT_PORT;
+
+    switch (message.type)
+    {
+    case MESSAGE_EMPTY_BUFFER_DONE:
+        m_FreeBuffers[MFX_OMX_BENCH_INPUT_PORT].push_back(message.pBuffer);
+        return SubmitInputs();
+
+    case MESSAGE_FILL_BUFFER_DONE:
+        {
+            OMX_BUFFERHEADERTYPE* pBuffer = message.pBuffer;
+
+            if (pBuffer->nFilledLen && !(pBuffer->nFlags & OMX_BUFFERFLAG_CODECCONFIG))
+            {
+                ++m_Result.frames;
+                m_Result.bytes += pBuffer->nFilledLen;
+            }
+            if (pBuffer->nFlags & OMX_BUFFERFLAG_EOS) m_bEosReceived = true;
+
+            m_FreeBuffers[out].push_back(pBuffer);
+            // buffers of the disabled port are freed as soon as they return
+            if (m_bOutputReconfig) FreeBuffers(out);
+            return SubmitOutputs();
+        }
+
+    case MESSAGE_EVENT:
+        switch (message.event)
+        {
+        case OMX_EventCmdComplete:
+            if ((OMX_CommandPortDisable == message.data1) && (out == message.data2) && m_bOutputReconfig)
+            {
+                // new buffers are allocated after the port is enabled
+                if (!SendCommand(OMX_CommandPortEnable, out) || !AllocateBuffers(out)) return false;
+                break;
+            }
+            if ((OMX_CommandPortEnable == message.data1) && (out == message.data2) && m_bOutputReconfig)
+            {
+                m_bOutputReconfig = false;
+                ++m_Result.reconfigs;
+                m_bPendingDone = true;
+                return SubmitOutputs();
+            }
+            if (OMX_CommandStateSet == message.data1) m_State = (OMX_STATETYPE)message.data2;
+            if ((m_PendingCmd == (OMX_COMMANDTYPE)message.data1) && (m_PendingData == message.data2))
+                m_bPendingDone = true;
+            break;
+        case OMX_EventPortSettingsChanged:
+            if ((out == message.data1) && (!message.data2 || (OMX_IndexParamPortDefinition == message.data2)) &&
+                !m_bOutputReconfig && !m_bStopping)
+            {
+                m_bOutputReconfig = true;
+                if (!SendCommand(OMX_CommandPortDisable, out)) return false;
+                FreeBuffers(out);
+            }
+            break;
+        case OMX_EventError:
+            if (OMX_ErrorPortUnresponsiveDuringDeallocation != (OMX_ERRORTYPE)message.data1)
+                return Fail("component error 0x%x", message.data1);
+            break;
+        default:
+            break;
+        }
+        break;
+    }
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxBenchClient::Init(void)
+{
+    OMX_ERRORTYPE omx_res = OMX_GetHandle(&m_hComponent, (OMX_STRING)m_Config.component.c_str(), this, &m_Callbacks);
+
+    if (OMX_ErrorNone != omx_res)
+    {
+        m_hComponent = NULL;
+        return Fail("GetHandle(%s) failed with 0x%x", m_Config.component.c_str(), omx_res);
+    }
+    if (!SetAsyncDepth() || !ConfigurePorts()) return false;
+
+    if (!SendCommand(OMX_CommandStateSet, OMX_StateIdle)) return false;
+    if (!AllocateBuffers(MFX_OMX_BENCH_INPUT_PORT) || !AllocateBuffers(MFX_OMX_BENCH_OUTPUT_PORT)) return false;
+    if (!WaitCommand()) return false;
+
+    return SendCommand(OMX_CommandStateSet, OMX_StateExecuting) && WaitCommand();
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxBenchClient::Run(void)
+{
+    Message message;
+
+    if (!SubmitOutputs() || !SubmitInputs()) return false;
+    while (!m_bEosReceived)
+    {
+        if (!WaitMessage(&message) || !ProcessMessage(message)) return false;
+    }
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxBenchClient::QueryStats(void)
+{
+    OMX_INDEXTYPE index;
+
+    if (OMX_ErrorNone == OMX_GetExtensionIndex(m_hComponent, (OMX_STRING)"OMX.intel.index.runtimestats", &index))
+    {
+        m_Result.stats.nPortIndex = MFX_OMX_BENCH_OUTPUT_PORT;
+        m_Result.bStats = (OMX_ErrorNone == OMX_GetConfig(m_hComponent, index, &m_Result.stats));
+    }
+    if (OMX_ErrorNone == OMX_GetExtensionIndex(m_hComponent, (OMX_STRING)"OMX.intel.index.latencystats", &index))
+    {
+        m_Result.bStages = true;
+        for (OMX_U32 i = 0; m_Result.bStages && (i < OMX_VIDEO_IntelLatencyMax); ++i)
+        {
+            m_Result.stages[i].nPortIndex = MFX_OMX_BENCH_OUTPUT_PORT;
+            m_Result.stages[i].eStage = (OMX_VIDEO_INTEL_LATENCY_STAGE)i;
+            m_Result.bStages = (OMX_ErrorNone == OMX_GetConfig(m_hComponent, index, &m_Result.stages[i]));
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxBenchClient::Close(void)
+{
+    if (!m_hComponent) return;
+
+    QueryStats();
+    // rate changes are applied by Reset continuing the sequence, frames in flight are not waited for
+    if (m_Result.rateChanges && m_Result.bStats && m_Result.stats.nDrains)
+    {
+        Fail("%u drains while changing rates %u times", m_Result.stats.nDrains, m_Result.rateChanges);
+    }
+
+    // unwinding continues after failures to release the component anyway
+    m_bStopping = true;
+    if ((OMX_StateExecuting == m_State) || (OMX_StatePause == m_State))
+    {
+        if (SendCommand(OMX_CommandStateSet, OMX_StateIdle)) WaitCommand();
+    }
+    if (OMX_StateIdle == m_State)
+    {
+        if (SendCommand(OMX_CommandStateSet, OMX_StateLoaded))
+        {
+            FreeBuffers(MFX_OMX_BENCH_INPUT_PORT);
+            FreeBuffers(MFX_OMX_BENCH_OUTPUT_PORT);
+            WaitCommand();
+        }
+    }
+    OMX_FreeHandle(m_hComponent);
+    m_hComponent = NULL;
+}
@@ -0,0 +1,181 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mfx_omx_bench.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*------------------------------------------------------------------------------*/
+
+#define MFX_OMX_BENCH_IVF_HEADER_SIZE 32
+#define MFX_OMX_BENCH_IVF_FRAME_HEADER_SIZE 12
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxBenchStream::MfxOmxBenchStream(void):
+    m_pData(NULL),
+    m_nSize(0)
+{
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxBenchStream::~MfxOmxBenchStream(void)
+{
+    if (m_pData) munmap(m_pData, m_nSize);
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxBenchStream::Open(const char* filename)
+{
+    struct stat st;
+    int fd = open(filename, O_RDONLY);
+
+    if (fd < 0) return false;
+    if (!fstat(fd, &st) && (st.st_size > 0))
+    {
+        void* pData = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (MAP_FAILED != pData)
+        {
+            m_pData = (uint8_t*)pData;
+            m_nSize = (size_t)st.st_size;
+            // samples are read once per loop in order
+            madvise(m_pData, m_nSize, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+    return (NULL != m_pData);
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxBenchStream::IsIvf(void) const
+{
+    return (m_nSize >= MFX_OMX_BENCH_IVF_HEADER_SIZE) && !memcmp(m_pData, "DKIF", 4);
+}
+
+/*------------------------------------------------------------------------------*/
+
+// Returns true if NAL unit starts a new access unit provided that a picture
+// was already seen in the current one
+static bool mfx_omx_bench_is_au_start(const uint8_t* pNal, size_t size, bool bHevc)
+{
+    if (bHevc)
+    {
+        if (size < 3) return false;
+        uint8_t type = (pNal[0] >> 1) & 0x3F;
+        // VCL NAL units: first_slice_segment_in_pic_flag
+        if (type < 32) return (pNal[2] & 0x80) != 0;
+        // VPS, SPS, PPS, AUD, prefix SEI and reserved types 41..44, 48..55
+        return ((type >= 32) && (type <= 35)) || (39 == type) ||
+               ((type >= 41) && (type <= 44)) || ((type >= 48) && (type <= 55));
+    }
+    if (size < 2) return false;
+    uint8_t type = pNal[0] & 0x1F;
+    // slices: first_mb_in_slice == 0 is coded as a single '1' bit
+    if ((1 == type) || (5 == type)) return (pNal[1] & 0x80) != 0;
+    // SEI, SPS, PPS, AUD and reserved types 14..18
+    return ((type >= 6) && (type <= 9)) || ((type >= 14) && (type <= 18));
+}
+
+/*------------------------------------------------------------------------------*/
+
+static bool mfx_omx_bench_is_vcl(const uint8_t* pNal, bool bHevc)
+{
+    if (bHevc) return ((pNal[0] >> 1) & 0x3F) < 32;
+
+    uint8_t type = pNal[0] & 0x1F;
+    return (type >= 1) && (type <= 5);
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxBenchStream::SplitAnnexB(bool bHevc)
+{
+    size_t auStart = 0;
+    bool bPicture = false;
+    size_t i = 0;
+
+    m_Samples.clear();
+    while (i + 3 <= m_nSize)
+    {
+        if (m_pData[i] || m_pData[i + 1] || (1 != m_pData[i + 2]))
+        {
+            ++i;
+            continue;
+        }
+        // 4-byte start code belongs to the NAL unit which follows
+        size_t scStart = (i && !m_pData[i - 1]) ? i - 1 : i;
+        const uint8_t* pNal = m_pData + i + 3;
+        size_t left = m_nSize - i - 3;
+
+        if (left && bPicture && mfx_omx_bench_is_au_start(pNal, left, bHevc))
+        {
+            MfxOmxBenchSample sample = { auStart, scStart - auStart };
+            m_Samples.push_back(sample);
+            auStart = scStart;
+            bPicture = false;
+        }
+        if (left && mfx_omx_bench_is_vcl(pNal, bHevc)) bPicture = true;
+        i += 3;
+    }
+    if (auStart < m_nSize)
+    {
+        MfxOmxBenchSample sample = { auStart, m_nSize - auStart };
+        m_Samples.push_back(sample);
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxBenchStream::SplitIvf(void)
+{
+    size_t pos = MFX_OMX_BENCH_IVF_HEADER_SIZE;
+
+    m_Samples.clear();
+    while (pos + MFX_OMX_BENCH_IVF_FRAME_HEADER_SIZE <= m_nSize)
+    {
+        const uint8_t* p = m_pData + pos;
+        size_t size = (size_t)p[0] | ((size_t)p[1] << 8) | ((size_t)p[2] << 16) | ((size_t)p[3] << 24);
+
+        pos += MFX_OMX_BENCH_IVF_FRAME_HEADER_SIZE;
+        if (pos + size > m_nSize) break;
+
+        MfxOmxBenchSample sample = { pos, size };
+        m_Samples.push_back(sample);
+        pos += size;
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxBenchStream::SplitFrames(size_t frameSize)
+{
+    m_Samples.clear();
+    for (size_t pos = 0; frameSize && (pos + frameSize <= m_nSize); pos += frameSize)
+    {
+        MfxOmxBenchSample sample = { pos, frameSize };
+        m_Samples.push_back(sample);
+    }
+}
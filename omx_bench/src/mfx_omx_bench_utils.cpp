@@ -0,0 +1,47 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mfx_omx_bench.h"
+
+/*------------------------------------------------------------------------------*/
+
+bool mfx_omx_bench_parse_names(const char* str, const char* const* names, size_t count, std::vector<size_t>& list)
+{
+    std::string s(str);
+    size_t pos = 0;
+
+    list.clear();
+    while (pos <= s.size())
+    {
+        size_t end = s.find(',', pos);
+        std::string name = s.substr(pos, (std::string::npos == end) ? std::string::npos : end - pos);
+        size_t i = 0;
+
+        for (i = 0; i < count; ++i)
+        {
+            if (name == names[i]) break;
+        }
+        if (i == count) return false;
+        list.push_back(i);
+        if (std::string::npos == end) break;
+        pos = end + 1;
+    }
+    return true;
+}
@@ -0,0 +1,563 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Frame constructor micro-benchmark: feeds IMfxOmxFrameConstructor the way
+// the decoder component does (Load, decoder consumption, Sync) and reports
+// time and internal buffer statistics per input byte and per frame.
+
+#include "mfx_omx_bst_ibuf.h"
+#include "mfx_omx_bench.h"
+
+#include <unistd.h>
+#include <random>
+
+/*------------------------------------------------------------------------------*/
+
+enum MfxOmxFcBenchPacketization
+{
+    MFX_OMX_FC_BENCH_FRAME, // one frame per buffer
+    MFX_OMX_FC_BENCH_NAL,   // one NAL unit per buffer, frame halves for codecs without NAL units
+    MFX_OMX_FC_BENCH_CHUNK  // fixed size buffers ignoring frame boundaries
+};
+
+struct MfxOmxFcBenchCodec
+{
+    const char* name;
+    MfxOmxFrameConstructorType type;
+};
+
+static const MfxOmxFcBenchCodec g_FcBenchCodecs[] =
+{
+    { "none", MfxOmxFC_None },
+    { "avc",  MfxOmxFC_AVC },
+    { "hevc", MfxOmxFC_HEVC },
+    { "vc1",  MfxOmxFC_VC1 },
+    { "vp8",  MfxOmxFC_VP8 },
+    { "vp9",  MfxOmxFC_VP9 }
+};
+
+static const char* g_FcBenchPacketizations[] = { "frame", "nal", "chunk" };
+
+// buffer handed to the frame constructor
+struct MfxOmxFcBenchPacket
+{
+    size_t offset;
+    size_t size;
+    bool bHeader;
+    bool bEndOfFrame;
+    // bytes of the incomplete frame loaded so far, decoder leaves them in the bitstream
+    size_t pending;
+};
+
+struct MfxOmxFcBenchOptions
+{
+    std::vector<MfxOmxFcBenchCodec> codecs;
+    std::vector<MfxOmxFcBenchPacketization> packetizations;
+    std::vector<bool> outOfBand;
+    const char* input;
+    const char* output;
+    uint32_t frames;    // synthetic stream
+    uint32_t frameSize; // synthetic stream, average bytes per frame
+    uint32_t chunkSize;
+    uint32_t loops;
+};
+
+/*------------------------------------------------------------------------------*/
+
+static void usage(const char* app)
+{
+    printf("Usage: %s [options]\n"
+           "  -c codec,... none, avc, hevc, vc1, vp8, vp9 (default all)\n"
+           "  -p type,...  frame, nal, chunk (default all)\n"
+           "  -m mode,...  codec config: inband, outband (default both)\n"
+           "  -i file      real stream: Annex B for avc/hevc, IVF for vp8/vp9 (default synthetic)\n"
+           "  -n N         synthetic stream frames (default 300)\n"
+           "  -z bytes     synthetic stream average frame size (default 20000)\n"
+           "  -s bytes     chunk size (default 1024)\n"
+           "  -l N         times to feed the stream, frame constructor is reset between loops (default 3)\n"
+           "  -o file      append results to file instead of stdout\n"
+           "Each run prints one JSON object per line.\n", app);
+}
+
+/*------------------------------------------------------------------------------*/
+
+static bool parse_options(int argc, char** argv, MfxOmxFcBenchOptions& options)
+{
+    static const char* modes[] = { "inband", "outband" };
+    const char* codecNames[MFX_OMX_GET_ARRAY_SIZE(g_FcBenchCodecs)];
+    std::vector<size_t> list;
+    bool bOk = true;
+    int opt = 0;
+
+    for (size_t i = 0; i < MFX_OMX_GET_ARRAY_SIZE(g_FcBenchCodecs); ++i)
+    {
+        codecNames[i] = g_FcBenchCodecs[i].name;
+    }
+
+    options.codecs.assign(g_FcBenchCodecs, g_FcBenchCodecs + MFX_OMX_GET_ARRAY_SIZE(g_FcBenchCodecs));
+    options.packetizations.clear();
+    options.packetizations.push_back(MFX_OMX_FC_BENCH_FRAME);
+    options.packetizations.push_back(MFX_OMX_FC_BENCH_NAL);
+    options.packetizations.push_back(MFX_OMX_FC_BENCH_CHUNK);
+    options.outOfBand.clear();
+    options.outOfBand.push_back(false);
+    options.outOfBand.push_back(true);
+    options.input = NULL;
+    options.output = NULL;
+    options.frames = 300;
+    options.frameSize = 20000;
+    options.chunkSize = 1024;
+    options.loops = 3;
+
+    while (bOk && (-1 != (opt = getopt(argc, argv, "c:p:m:i:n:z:s:l:o:h"))))
+    {
+        switch (opt)
+        {
+        case 'c':
+            bOk = mfx_omx_bench_parse_names(optarg, codecNames, MFX_OMX_GET_ARRAY_SIZE(g_FcBenchCodecs), list);
+            options.codecs.clear();
+            for (size_t i = 0; bOk && (i < list.size()); ++i) options.codecs.push_back(g_FcBenchCodecs[list[i]]);
+            break;
+        case 'p':
+            bOk = mfx_omx_bench_parse_names(optarg, g_FcBenchPacketizations, MFX_OMX_GET_ARRAY_SIZE(g_FcBenchPacketizations), list);
+            options.packetizations.clear();
+            for (size_t i = 0; bOk && (i < list.size()); ++i) options.packetizations.push_back((MfxOmxFcBenchPacketization)list[i]);
+            break;
+        case 'm':
+            bOk = mfx_omx_bench_parse_names(optarg, modes, MFX_OMX_GET_ARRAY_SIZE(modes), list);
+            options.outOfBand.clear();
+            for (size_t i = 0; bOk && (i < list.size()); ++i) options.outOfBand.push_back(1 == list[i]);
+            break;
+        case 'i': options.input = optarg; break;
+        case 'n': options.frames = (uint32_t)atoi(optarg); break;
+        case 'z': options.frameSize = (uint32_t)atoi(optarg); break;
+        case 's': options.chunkSize = (uint32_t)atoi(optarg); break;
+        case 'l': options.loops = (uint32_t)atoi(optarg); break;
+        case 'o': options.output = optarg; break;
+        default: bOk = false; break;
+        }
+    }
+    return bOk && options.frames && (options.frameSize >= 16) && options.chunkSize && options.loops;
+}
+
+/*------------------------------------------------------------------------------*/
+
+static bool is_nal_codec(MfxOmxFrameConstructorType type)
+{
+    return (MfxOmxFC_AVC == type) || (MfxOmxFC_HEVC == type);
+}
+
+/*------------------------------------------------------------------------------*/
+
+// returns offsets of start codes (3 or 4 bytes) within [begin, end)
+static void find_start_codes(const uint8_t* pData, size_t begin, size_t end, std::vector<size_t>& list)
+{
+    list.clear();
+    for (size_t i = begin; i + 3 <= end; ++i)
+    {
+        if (pData[i] || pData[i + 1] || (1 != pData[i + 2])) continue;
+        list.push_back(((i > begin) && !pData[i - 1]) ? i - 1 : i);
+        i += 2;
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+// size of codec config data (sequence and picture headers) at the start of the first frame
+static size_t get_header_size(MfxOmxFrameConstructorType type, const uint8_t* pData, const MfxOmxBenchSample& frame)
+{
+    std::vector<size_t> codes;
+
+    if (!is_nal_codec(type) && (MfxOmxFC_VC1 != type)) return 0;
+
+    find_start_codes(pData, frame.offset, frame.offset + frame.size, codes);
+    for (size_t i = 0; i < codes.size(); ++i)
+    {
+        size_t pos = codes[i] + (pData[codes[i] + 2] ? 3 : 4);
+        bool bPicture = false;
+
+        if (pos >= frame.offset + frame.size) break;
+        if (MfxOmxFC_AVC == type) bPicture = ((pData[pos] & 0x1F) >= 1) && ((pData[pos] & 0x1F) <= 5);
+        else if (MfxOmxFC_HEVC == type) bPicture = ((pData[pos] >> 1) & 0x3F) < 32;
+        else bPicture = (0x0D == pData[pos]); // VC1 frame start code
+
+        if (bPicture) return codes[i] - frame.offset;
+    }
+    return 0;
+}
+
+/*------------------------------------------------------------------------------*/
+
+static void append_unit(std::vector<uint8_t>& data, std::mt19937& rng, const uint8_t* header, size_t headerSize,
+                        size_t payloadSize)
+{
+    static const uint8_t startCode[] = { 0, 0, 0, 1 };
+    std::uniform_int_distribution<int> byte(1, 255);
+
+    data.insert(data.end(), startCode, startCode + sizeof(startCode));
+    data.insert(data.end(), header, header + headerSize);
+    // payload has no zero bytes, so no start code emulation is possible
+    for (size_t i = 0; i < payloadSize; ++i) data.push_back((uint8_t)byte(rng));
+}
+
+/*------------------------------------------------------------------------------*/
+
+// Generates stream which is well formed as far as frame constructors care:
+// start codes, NAL unit types and header units are real, payload is random.
+static void generate_stream(MfxOmxFrameConstructorType type, const MfxOmxFcBenchOptions& options,
+                            std::vector<uint8_t>& data, std::vector<MfxOmxBenchSample>& frames)
+{
+    // AVC: SPS, PPS, IDR slice, non-IDR slice (first_mb_in_slice == 0)
+    static const uint8_t avcSps[] = { 0x67 }, avcPps[] = { 0x68 }, avcIdr[] = { 0x65, 0x88 }, avcSlice[] = { 0x41, 0x9A };
+    // HEVC: VPS, SPS, PPS, IDR_W_RADL and TRAIL_R slices (first_slice_segment_in_pic_flag == 1)
+    static const uint8_t hevcVps[] = { 0x40, 0x01 }, hevcSps[] = { 0x42, 0x01 }, hevcPps[] = { 0x44, 0x01 };
+    static const uint8_t hevcIdr[] = { 0x26, 0x01, 0xAF }, hevcSlice[] = { 0x02, 0x01, 0xD0 };
+    // VC1 advanced profile: sequence header, entry point, frame
+    static const uint8_t vc1Seq[] = { 0x0F }, vc1Entry[] = { 0x0E }, vc1Frame[] = { 0x0D };
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<uint32_t> size(options.frameSize / 2, options.frameSize * 3 / 2);
+    std::uniform_int_distribution<int> byte(1, 255);
+
+    data.clear();
+    frames.clear();
+    for (uint32_t i = 0; i < options.frames; ++i)
+    {
+        MfxOmxBenchSample frame = { data.size(), 0 };
+        // key frame every second of 30 fps video is bigger
+        uint32_t frameSize = (i % 30) ? size(rng) : 4 * options.frameSize;
+        bool bKey = !(i % 30);
+
+        if (MfxOmxFC_AVC == type)
+        {
+            if (!i)
+            {
+                append_unit(data, rng, avcSps, sizeof(avcSps), 12);
+                append_unit(data, rng, avcPps, sizeof(avcPps), 4);
+            }
+            // frames are coded with 4 slices
+            for (uint32_t s = 0; s < 4; ++s)
+            {
+                const uint8_t* header = bKey ? avcIdr : avcSlice;
+                uint8_t sliceHeader[2] = { header[0], (uint8_t)(s ? 0x40 : header[1]) };
+
+                append_unit(data, rng, sliceHeader, sizeof(sliceHeader), frameSize / 4);
+            }
+        }
+        else if (MfxOmxFC_HEVC == type)
+        {
+            if (!i)
+            {
+                append_unit(data, rng, hevcVps, sizeof(hevcVps), 20);
+                append_unit(data, rng, hevcSps, sizeof(hevcSps), 40);
+                append_unit(data, rng, hevcPps, sizeof(hevcPps), 6);
+            }
+            for (uint32_t s = 0; s < 4; ++s)
+            {
+                const uint8_t* header = bKey ? hevcIdr : hevcSlice;
+                uint8_t sliceHeader[3] = { header[0], header[1], (uint8_t)(s ? 0x40 : header[2]) };
+
+                append_unit(data, rng, sliceHeader, sizeof(sliceHeader), frameSize / 4);
+            }
+        }
+        else if (MfxOmxFC_VC1 == type)
+        {
+            if (!i)
+            {
+                append_unit(data, rng, vc1Seq, sizeof(vc1Seq), 8);
+                append_unit(data, rng, vc1Entry, sizeof(vc1Entry), 4);
+            }
+            append_unit(data, rng, vc1Frame, sizeof(vc1Frame), frameSize);
+        }
+        else
+        {
+            // VP8, VP9 and raw frames have no start codes
+            for (uint32_t b = 0; b < frameSize; ++b) data.push_back((uint8_t)byte(rng));
+        }
+        frame.size = data.size() - frame.offset;
+        frames.push_back(frame);
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+// Splits stream into buffers the way a client with the given packetization
+// would send them; frames are expected to be contiguous
+static void packetize(MfxOmxFrameConstructorType type, MfxOmxFcBenchPacketization packetization, bool bOutOfBand,
+                      uint32_t chunkSize, const uint8_t* pData, const std::vector<MfxOmxBenchSample>& frames,
+                      std::vector<MfxOmxFcBenchPacket>& packets)
+{
+    std::vector<size_t> codes;
+    size_t headerSize = bOutOfBand ? get_header_size(type, pData, frames[0]) : 0;
+
+    packets.clear();
+    if (headerSize)
+    {
+        MfxOmxFcBenchPacket packet = { frames[0].offset, headerSize, true, false, 0 };
+        packets.push_back(packet);
+    }
+
+    if (MFX_OMX_FC_BENCH_CHUNK == packetization)
+    {
+        const MfxOmxBenchSample& last = frames.back();
+        size_t pos = frames[0].offset + headerSize;
+        size_t f = 0;
+
+        while (pos < last.offset + last.size)
+        {
+            size_t end = MFX_OMX_MIN(pos + chunkSize, last.offset + last.size);
+
+            // frame the chunk ends in
+            while (frames[f].offset + frames[f].size < end) ++f;
+
+            size_t frameEnd = frames[f].offset + frames[f].size;
+            // clients cutting the stream into chunks do not mark frame ends
+            MfxOmxFcBenchPacket packet = { pos, end - pos, false, false, (end < frameEnd) ? end - frames[f].offset : 0 };
+
+            packets.push_back(packet);
+            pos = end;
+        }
+        return;
+    }
+
+    for (size_t f = 0; f < frames.size(); ++f)
+    {
+        const MfxOmxBenchSample& frame = frames[f];
+        size_t pos = frame.offset + (f ? 0 : headerSize);
+        // borders of buffers within the frame
+        std::vector<size_t> borders;
+
+        if (MFX_OMX_FC_BENCH_NAL == packetization)
+        {
+            if (is_nal_codec(type) || (MfxOmxFC_VC1 == type))
+            {
+                find_start_codes(pData, pos, frame.offset + frame.size, codes);
+                for (size_t i = 0; i < codes.size(); ++i)
+                {
+                    if (codes[i] > pos) borders.push_back(codes[i]);
+                }
+            }
+            else borders.push_back(frame.offset + frame.size / 2);
+        }
+        borders.push_back(frame.offset + frame.size);
+
+        for (size_t i = 0; i < borders.size(); ++i)
+        {
+            bool bEndOfFrame = (i + 1 == borders.size());
+            MfxOmxFcBenchPacket packet = { pos, borders[i] - pos, false, bEndOfFrame, bEndOfFrame ? 0 : borders[i] - frame.offset };
+
+            packets.push_back(packet);
+            pos = borders[i];
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+struct MfxOmxFcBenchResult
+{
+    uint64_t buffers;
+    uint64_t bytes;
+    uint64_t frames;
+    uint64_t ns;
+    uint64_t copyBytes;
+    uint64_t reallocs;
+    uint32_t errors;
+};
+
+/*------------------------------------------------------------------------------*/
+
+static void run(MfxOmxFrameConstructorType type, const MfxOmxFcBenchOptions& options, const uint8_t* pData,
+                const std::vector<MfxOmxFcBenchPacket>& packets, size_t frames, MfxOmxFcBenchResult& result)
+{
+    mfxStatus sts = MFX_ERR_NONE;
+    std::unique_ptr<IMfxOmxFrameConstructor> fc(MfxOmxFrameConstructorFactory::CreateFrameConstructor(type, sts));
+    mfxFrameInfo info;
+    std::vector<uint8_t> buffer;
+    size_t maxSize = 0;
+
+    MFX_OMX_ZERO_MEMORY(result);
+    if (!fc || (MFX_ERR_NONE != sts))
+    {
+        result.errors = 1;
+        return;
+    }
+    MFX_OMX_ZERO_MEMORY(info);
+    fc->Init(MFX_PROFILE_UNKNOWN, info);
+
+    for (size_t i = 0; i < packets.size(); ++i) maxSize = MFX_OMX_MAX(maxSize, packets[i].size);
+    // client owned input buffer, reused as the component releases it after Sync
+    buffer.resize(maxSize);
+
+    for (uint32_t loop = 0; loop < options.loops; ++loop)
+    {
+        // loops restart the stream like a seek does
+        if (loop) fc->Reset();
+
+        for (size_t i = 0; i < packets.size(); ++i)
+        {
+            const MfxOmxFcBenchPacket& packet = packets[i];
+
+            // codec config buffers are sent once as clients do after seek
+            if (loop && packet.bHeader) continue;
+
+            std::copy(pData + packet.offset, pData + packet.offset + packet.size, buffer.begin());
+
+            MfxOmxBenchClock::time_point start = MfxOmxBenchClock::now();
+            mfxU32 copyBytes = fc->GetBstBufCopyBytes();
+            mfxU32 reallocs = fc->GetBstBufReallocs();
+
+            sts = fc->Load(buffer.data(), (mfxU32)packet.size, (mfxU64)i, packet.bHeader, packet.bEndOfFrame);
+            if (MFX_ERR_NONE == sts)
+            {
+                // decoder consumes complete frames and leaves the incomplete one
+                mfxBitstream* pBst = fc->GetMfxBitstream();
+                if (pBst && (pBst->DataLength > packet.pending) && !packet.bHeader)
+                {
+                    mfxU32 consumed = pBst->DataLength - (mfxU32)packet.pending;
+                    pBst->DataOffset += consumed;
+                    pBst->DataLength -= consumed;
+                }
+                sts = fc->Sync();
+            }
+
+            result.ns += std::chrono::duration_cast<std::chrono::nanoseconds>(MfxOmxBenchClock::now() - start).count();
+            // counters are 32 bit and may wrap on long runs, so deltas are summed
+            result.copyBytes += (mfxU32)(fc->GetBstBufCopyBytes() - copyBytes);
+            result.reallocs += (mfxU32)(fc->GetBstBufReallocs() - reallocs);
+
+            if (MFX_ERR_NONE != sts) ++result.errors;
+            ++result.buffers;
+            result.bytes += packet.size;
+        }
+        result.frames += frames;
+    }
+    fc->Close();
+}
+
+/*------------------------------------------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+    MfxOmxFcBenchOptions options;
+    MfxOmxBenchStream stream;
+    std::vector<uint8_t> synthetic;
+    std::vector<MfxOmxBenchSample> frames;
+    std::vector<MfxOmxFcBenchPacket> packets;
+    bool bOk = true;
+
+    if (!parse_options(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    if (options.input && !stream.Open(options.input))
+    {
+        fprintf(stderr, "failed to open %s\n", options.input);
+        return 1;
+    }
+
+    FILE* f = stdout;
+    if (options.output && !(f = fopen(options.output, "a")))
+    {
+        fprintf(stderr, "failed to open %s\n", options.output);
+        return 1;
+    }
+
+    for (size_t c = 0; c < options.codecs.size(); ++c)
+    {
+        MfxOmxFrameConstructorType type = options.codecs[c].type;
+        const uint8_t* pData = NULL;
+
+        if (options.input)
+        {
+            if ((MfxOmxFC_VP8 == type) || (MfxOmxFC_VP9 == type))
+            {
+                if (stream.IsIvf()) stream.SplitIvf();
+            }
+            else if (is_nal_codec(type) && !stream.IsIvf())
+            {
+                stream.SplitAnnexB(MfxOmxFC_HEVC == type);
+            }
+            else
+            {
+                fprintf(stderr, "%s: input file is not supported, use synthetic stream\n", options.codecs[c].name);
+                continue;
+            }
+            pData = stream.GetData();
+            frames = stream.GetSamples();
+            if (!frames.empty() && stream.IsIvf())
+            {
+                // IVF frame headers are dropped, so chunks could cross frame borders
+                synthetic.clear();
+                for (size_t i = 0; i < frames.size(); ++i)
+                {
+                    synthetic.insert(synthetic.end(), pData + frames[i].offset, pData + frames[i].offset + frames[i].size);
+                    frames[i].offset = synthetic.size() - frames[i].size;
+                }
+                pData = synthetic.data();
+            }
+        }
+        else
+        {
+            generate_stream(type, options, synthetic, frames);
+            pData = synthetic.data();
+        }
+        if (frames.empty())
+        {
+            fprintf(stderr, "%s: no frames found\n", options.codecs[c].name);
+            bOk = false;
+            continue;
+        }
+
+        for (size_t p = 0; p < options.packetizations.size(); ++p)
+        {
+            for (size_t m = 0; m < options.outOfBand.size(); ++m)
+            {
+                MfxOmxFcBenchResult result;
+
+                packetize(type, options.packetizations[p], options.outOfBand[m], options.chunkSize, pData, frames, packets);
+                run(type, options, pData, packets, frames.size(), result);
+
+                fprintf(f, "{\"codec\":\"%s\",\"source\":\"%s\",\"packetization\":\"%s\",",
+                        options.codecs[c].name, options.input ? "file" : "synthetic",
+                        g_FcBenchPacketizations[options.packetizations[p]]);
+                if (MFX_OMX_FC_BENCH_CHUNK == options.packetizations[p]) fprintf(f, "\"chunk_size\":%u,", options.chunkSize);
+                fprintf(f, "\"codec_config\":\"%s\",\"loops\":%u,\"buffers\":%llu,\"bytes\":%llu,\"frames\":%llu,"
+                        "\"ns_per_byte\":%.3f,\"ns_per_buffer\":%.1f,\"copies_per_byte\":%.3f,"
+                        "\"reallocs_per_frame\":%.4f,\"copy_bytes\":%llu,\"reallocs\":%llu,\"errors\":%u}\n",
+                        options.outOfBand[m] ? "outband" : "inband", options.loops,
+                        (unsigned long long)result.buffers, (unsigned long long)result.bytes,
+                        (unsigned long long)result.frames,
+                        result.bytes ? (double)result.ns / result.bytes : 0.0,
+                        result.buffers ? (double)result.ns / result.buffers : 0.0,
+                        result.bytes ? (double)result.copyBytes / result.bytes : 0.0,
+                        result.frames ? (double)result.reallocs / result.frames : 0.0,
+                        (unsigned long long)result.copyBytes, (unsigned long long)result.reallocs,
+                        result.errors);
+                fflush(f);
+                if (result.errors) bOk = false;
+            }
+        }
+    }
+
+    if (stdout != f) fclose(f);
+    return bOk ? 0 : 2;
+}
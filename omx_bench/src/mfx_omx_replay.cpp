@@ -0,0 +1,783 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Session replay: drives a component with client calls recorded by
+// MfxOmxRecorder (OMX.Intel.record.dir property, components built with
+// MFX_OMX_DEBUG_DUMP) keeping the recorded timing, scaled timing or no timing
+// at all. Calls which depend on the component (buffers being returned, commands
+// being completed) wait for it, so the replay stays valid when the component
+// runs faster or slower than recorded.
+
+#include "mfx_omx_bench.h"
+#include "mfx_omx_record_format.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <set>
+#include <thread>
+
+/*------------------------------------------------------------------------------*/
+
+// client owned native buffers can't be recreated, the component gets system
+// memory buffers instead, so parameters switching to native buffers are skipped
+static const char* g_ReplaySkippedExtensions[] =
+{
+    "OMX.google.android.index.enableAndroidNativeBuffers",
+    "OMX.google.android.index.useAndroidNativeBuffer",
+    "OMX.google.android.index.useAndroidNativeBuffer2",
+    "OMX.google.android.index.allocateNativeHandle",
+    "OMX.google.android.index.storeMetaDataInBuffers",
+    "OMX.google.android.index.storeANWBufferInMetadata"
+};
+
+struct MfxOmxReplayOptions
+{
+    const char* input;
+    const char* output;
+    std::string component; // recorded one if empty
+    double scale;          // time scale, 0 - replay as fast as possible
+    uint32_t timeout;      // ms to wait for the component before going on
+    bool bVerbose;
+};
+
+struct MfxOmxReplayResult
+{
+    uint32_t records;
+    uint32_t replayed;
+    uint32_t skipped;
+    // calls which result differs from the recorded one
+    uint32_t mismatches;
+    // waits for the component which timed out
+    uint32_t timeouts;
+    uint32_t emptyDone;
+    uint32_t fillDone;
+    uint64_t outputBytes;
+    uint32_t errorEvents;
+    uint32_t portSettingsChanged;
+    bool bTruncated;
+    // delay of calls against their scheduled time, us
+    uint64_t latenessSum;
+    uint64_t latenessMax;
+};
+
+/*------------------------------------------------------------------------------*/
+
+class MfxOmxReplayer
+{
+public:
+    MfxOmxReplayer(const MfxOmxReplayOptions& options);
+    ~MfxOmxReplayer(void);
+
+    // reads the recording
+    bool Load(void);
+    // creates the component and replays the recording
+    bool Run(void);
+    // brings the component to loaded state if the recording didn't and destroys it
+    void Close(void);
+
+    const MfxOmxRecordFileHeader& GetHeader(void) const { return m_Header; }
+    const MfxOmxReplayResult& GetResult(void) const { return m_Result; }
+    uint64_t GetRecordedTime(void) const { return m_nRecordedTime; }
+
+protected:
+    struct Buffer
+    {
+        OMX_BUFFERHEADERTYPE* pHeader;
+        uint32_t port;
+        // memory given to UseBuffer
+        uint8_t* pMemory;
+        bool bOwned; // by the client
+    };
+
+    struct PendingCommand
+    {
+        uint32_t cmd;
+        uint32_t param;
+        // completion events still expected
+        uint32_t events;
+    };
+
+    static OMX_ERRORTYPE EventHandler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
+                                      OMX_EVENTTYPE eEvent, OMX_U32 nData1, OMX_U32 nData2,
+                                      OMX_PTR pEventData);
+    static OMX_ERRORTYPE EmptyBufferDone(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
+                                         OMX_BUFFERHEADERTYPE* pBuffer);
+    static OMX_ERRORTYPE FillBufferDone(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
+                                        OMX_BUFFERHEADERTYPE* pBuffer);
+
+    void OnEvent(OMX_EVENTTYPE eEvent, OMX_U32 nData1, OMX_U32 nData2);
+    void OnBufferDone(OMX_BUFFERHEADERTYPE* pBuffer, bool bOutput);
+
+    // waits till predicate is true, counts timeout otherwise
+    template<typename P> bool Wait(std::unique_lock<std::mutex>& lock, P predicate);
+    bool IsPortBusy(uint32_t port) const;
+    Buffer* FindBuffer(uint64_t id);
+    OMX_INDEXTYPE MapIndex(uint32_t index) const;
+
+    bool Replay(const MfxOmxRecordHeader* pRecord);
+    OMX_ERRORTYPE ReplayCommand(const MfxOmxRecordCommand* pData);
+    OMX_ERRORTYPE ReplayStruct(uint32_t type, const MfxOmxRecordStruct* pData, bool* pSkipped);
+    OMX_ERRORTYPE ReplayExtensionIndex(const MfxOmxRecordExtensionIndex* pData);
+    OMX_ERRORTYPE ReplayBuffer(uint32_t type, const MfxOmxRecordBuffer* pData);
+    OMX_ERRORTYPE ReplayEmptyThisBuffer(const MfxOmxRecordEmptyBuffer* pData);
+    void FreeBuffers(void);
+
+    const MfxOmxReplayOptions& m_Options;
+    std::vector<uint8_t> m_Data;
+    MfxOmxRecordFileHeader m_Header;
+    uint64_t m_nRecordedTime;
+
+    OMX_HANDLETYPE m_hComponent;
+    OMX_CALLBACKTYPE m_Callbacks;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Cond;
+    OMX_STATETYPE m_State;
+    std::deque<PendingCommand> m_Commands;
+    // recorded buffer header address -> own buffer
+    std::map<uint64_t, Buffer> m_Buffers;
+    // recorded extension index -> index of the replayed component
+    std::map<uint32_t, uint32_t> m_Indexes;
+    std::set<uint32_t> m_SkippedIndexes;
+    std::vector<uint8_t> m_Struct;
+
+    MfxOmxReplayResult m_Result;
+
+private:
+    MfxOmxReplayer(const MfxOmxReplayer&);
+    MfxOmxReplayer& operator=(const MfxOmxReplayer&);
+};
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxReplayer::MfxOmxReplayer(const MfxOmxReplayOptions& options):
+    m_Options(options),
+    m_nRecordedTime(0),
+    m_hComponent(NULL),
+    m_State(OMX_StateLoaded)
+{
+    m_Callbacks.EventHandler = EventHandler;
+    m_Callbacks.EmptyBufferDone = EmptyBufferDone;
+    m_Callbacks.FillBufferDone = FillBufferDone;
+
+    memset(&m_Header, 0, sizeof(m_Header));
+    memset(&m_Result, 0, sizeof(m_Result));
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxReplayer::~MfxOmxReplayer(void)
+{
+    Close();
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxReplayer::Load(void)
+{
+    FILE* f = fopen(m_Options.input, "rb");
+
+    if (!f)
+    {
+        fprintf(stderr, "failed to open %s\n", m_Options.input);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size > 0)
+    {
+        m_Data.resize((size_t)size);
+        if (fread(m_Data.data(), 1, m_Data.size(), f) != m_Data.size()) m_Data.clear();
+    }
+    fclose(f);
+
+    if (m_Data.size() < sizeof(m_Header))
+    {
+        fprintf(stderr, "%s is too short\n", m_Options.input);
+        return false;
+    }
+    memcpy(&m_Header, m_Data.data(), sizeof(m_Header));
+    m_Header.component[MFX_OMX_RECORD_NAME_SIZE - 1] = '\0';
+    if ((MFX_OMX_RECORD_MAGIC != m_Header.magic) || (MFX_OMX_RECORD_VERSION != m_Header.version))
+    {
+        fprintf(stderr, "%s is not a supported recording\n", m_Options.input);
+        return false;
+    }
+
+    // counting records, recording may be cut short by a crash or dropped data
+    size_t offset = sizeof(m_Header);
+    m_Result.bTruncated = true;
+    while (offset + sizeof(MfxOmxRecordHeader) <= m_Data.size())
+    {
+        const MfxOmxRecordHeader* pRecord = (const MfxOmxRecordHeader*)(m_Data.data() + offset);
+
+        if (offset + sizeof(MfxOmxRecordHeader) + pRecord->size > m_Data.size()) break;
+        ++m_Result.records;
+        m_nRecordedTime = std::max(m_nRecordedTime, pRecord->time + pRecord->duration);
+        offset += sizeof(MfxOmxRecordHeader) + pRecord->size;
+        if (MFX_OMX_RECORD_END == pRecord->type)
+        {
+            m_Result.bTruncated = false;
+            break;
+        }
+    }
+    m_Data.resize(offset);
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+OMX_ERRORTYPE MfxOmxReplayer::EventHandler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
+                                           OMX_EVENTTYPE eEvent, OMX_U32 nData1, OMX_U32 nData2,
+                                           OMX_PTR pEventData)
+{
+    (void)hComponent;
+    (void)pEventData;
+    static_cast<MfxOmxReplayer*>(pAppData)->OnEvent(eEvent, nData1, nData2);
+    return OMX_ErrorNone;
+}
+
+/*------------------------------------------------------------------------------*/
+
+OMX_ERRORTYPE MfxOmxReplayer::EmptyBufferDone(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
+                                              OMX_BUFFERHEADERTYPE* pBuffer)
+{
+    (void)hComponent;
+    static_cast<MfxOmxReplayer*>(pAppData)->OnBufferDone(pBuffer, false);
+    return OMX_ErrorNone;
+}
+
+/*------------------------------------------------------------------------------*/
+
+OMX_ERRORTYPE MfxOmxReplayer::FillBufferDone(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
+                                             OMX_BUFFERHEADERTYPE* pBuffer)
+{
+    (void)hComponent;
+    static_cast<MfxOmxReplayer*>(pAppData)->OnBufferDone(pBuffer, true);
+    return OMX_ErrorNone;
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxReplayer::OnEvent(OMX_EVENTTYPE eEvent, OMX_U32 nData1, OMX_U32 nData2)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (OMX_EventCmdComplete == eEvent)
+    {
+        if (OMX_CommandStateSet == nData1) m_State = (OMX_STATETYPE)nData2;
+        for (std::deque<PendingCommand>::iterator it = m_Commands.begin(); it != m_Commands.end(); ++it)
+        {
+            if ((it->cmd == nData1) &&
+                ((OMX_CommandStateSet == nData1) || (it->param == nData2) || (OMX_ALL == it->param)))
+            {
+                if (!--it->events) m_Commands.erase(it);
+                break;
+            }
+        }
+    }
+    else if (OMX_EventError == eEvent)
+    {
+        ++m_Result.errorEvents;
+        // failed state transition is not completed otherwise
+        if (!m_Commands.empty() && (OMX_CommandStateSet == m_Commands.front().cmd) &&
+            ((OMX_ERRORTYPE)nData1 == OMX_ErrorIncorrectStateTransition ||
+             (OMX_ERRORTYPE)nData1 == OMX_ErrorSameState))
+        {
+            m_Commands.pop_front();
+        }
+    }
+    else if (OMX_EventPortSettingsChanged == eEvent)
+    {
+        ++m_Result.portSettingsChanged;
+    }
+    if (m_Options.bVerbose)
+    {
+        printf("  event %d data1 0x%x data2 0x%x\n", eEvent, nData1, nData2);
+    }
+    m_Cond.notify_all();
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxReplayer::OnBufferDone(OMX_BUFFERHEADERTYPE* pBuffer, bool bOutput)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    // pAppPrivate holds the recorded id of the buffer
+    std::map<uint64_t, Buffer>::iterator it = m_Buffers.find((uint64_t)(uintptr_t)pBuffer->pAppPrivate);
+    if (m_Buffers.end() != it) it->second.bOwned = true;
+
+    if (bOutput)
+    {
+        ++m_Result.fillDone;
+        m_Result.outputBytes += pBuffer->nFilledLen;
+    }
+    else ++m_Result.emptyDone;
+    m_Cond.notify_all();
+}
+
+/*------------------------------------------------------------------------------*/
+
+template<typename P>
+bool MfxOmxReplayer::Wait(std::unique_lock<std::mutex>& lock, P predicate)
+{
+    if (m_Cond.wait_for(lock, std::chrono::milliseconds(m_Options.timeout), predicate)) return true;
+
+    // the component may behave differently than recorded, going on anyway
+    ++m_Result.timeouts;
+    return false;
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxReplayer::IsPortBusy(uint32_t port) const
+{
+    for (size_t i = 0; i < m_Commands.size(); ++i)
+    {
+        const PendingCommand& c = m_Commands[i];
+
+        if ((OMX_CommandStateSet == c.cmd) || (OMX_ALL == c.param) || (port == c.param)) return true;
+    }
+    return false;
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxReplayer::Buffer* MfxOmxReplayer::FindBuffer(uint64_t id)
+{
+    std::map<uint64_t, Buffer>::iterator it = m_Buffers.find(id);
+
+    return (m_Buffers.end() != it) ? &it->second : NULL;
+}
+
+/*------------------------------------------------------------------------------*/
+
+OMX_INDEXTYPE MfxOmxReplayer::MapIndex(uint32_t index) const
+{
+    std::map<uint32_t, uint32_t>::const_iterator it = m_Indexes.find(index);
+
+    return (OMX_INDEXTYPE)((m_Indexes.end() != it) ? it->second : index);
+}
+
+/*------------------------------------------------------------------------------*/
+
+OMX_ERRORTYPE MfxOmxReplayer::ReplayCommand(const MfxOmxRecordCommand* pData)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    // the recording client waited for previous commands, or raced with them
+    Wait(lock, [this] { return m_Commands.empty(); });
+
+    PendingCommand command = { pData->cmd, pData->param, 1 };
+    if ((OMX_CommandStateSet != pData->cmd) && (OMX_ALL == pData->param)) command.events = MFX_OMX_BENCH_PORTS_NUM;
+    if (OMX_CommandMarkBuffer != pData->cmd) m_Commands.push_back(command);
+    lock.unlock();
+
+    OMX_ERRORTYPE omx_res = OMX_SendCommand(m_hComponent, (OMX_COMMANDTYPE)pData->cmd, pData->param, NULL);
+    if ((OMX_ErrorNone != omx_res) && (OMX_CommandMarkBuffer != pData->cmd))
+    {
+        lock.lock();
+        m_Commands.pop_back();
+    }
+    return omx_res;
+}
+
+/*------------------------------------------------------------------------------*/
+
+OMX_ERRORTYPE MfxOmxReplayer::ReplayStruct(uint32_t type, const MfxOmxRecordStruct* pData, bool* pSkipped)
+{
+    if (m_SkippedIndexes.count(pData->index))
+    {
+        *pSkipped = true;
+        return OMX_ErrorNone;
+    }
+
+    OMX_INDEXTYPE index = MapIndex(pData->index);
+    // structure may be written by the component, so it gets a copy
+    m_Struct.assign((const uint8_t*)(pData + 1), (const uint8_t*)(pData + 1) + pData->size);
+    m_Struct.resize(std::max(pData->size, (uint32_t)sizeof(OMX_U32)));
+    OMX_PTR pStruct = m_Struct.data();
+
+    switch (type)
+    {
+    case MFX_OMX_RECORD_GET_PARAMETER: return OMX_GetParameter(m_hComponent, index, pStruct);
+    case MFX_OMX_RECORD_SET_PARAMETER: return OMX_SetParameter(m_hComponent, index, pStruct);
+    case MFX_OMX_RECORD_GET_CONFIG: return OMX_GetConfig(m_hComponent, index, pStruct);
+    default: return OMX_SetConfig(m_hComponent, index, pStruct);
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+OMX_ERRORTYPE MfxOmxReplayer::ReplayExtensionIndex(const MfxOmxRecordExtensionIndex* pData)
+{
+    std::string name((const char*)(pData + 1), pData->length);
+    OMX_INDEXTYPE index = OMX_IndexComponentStartUnused;
+
+    OMX_ERRORTYPE omx_res = OMX_GetExtensionIndex(m_hComponent, (OMX_STRING)name.c_str(), &index);
+    if (OMX_ErrorNone == omx_res) m_Indexes[pData->index] = (uint32_t)index;
+
+    for (size_t i = 0; i < sizeof(g_ReplaySkippedExtensions) / sizeof(g_ReplaySkippedExtensions[0]); ++i)
+    {
+        if (name == g_ReplaySkippedExtensions[i]) m_SkippedIndexes.insert(pData->index);
+    }
+    return omx_res;
+}
+
+/*------------------------------------------------------------------------------*/
+
+OMX_ERRORTYPE MfxOmxReplayer::ReplayBuffer(uint32_t type, const MfxOmxRecordBuffer* pData)
+{
+    OMX_ERRORTYPE omx_res = OMX_ErrorNone;
+
+    if ((MFX_OMX_RECORD_USE_BUFFER == type) || (MFX_OMX_RECORD_ALLOCATE_BUFFER == type))
+    {
+        Buffer buffer = { NULL, pData->port, NULL, true };
+        OMX_PTR pAppPrivate = (OMX_PTR)(uintptr_t)pData->id;
+
+        if (!pData->id) return OMX_ErrorUndefined; // failed when recorded
+        if (MFX_OMX_RECORD_USE_BUFFER == type)
+        {
+            buffer.pMemory = (uint8_t*)calloc(1, pData->size ? pData->size : 1);
+            if (!buffer.pMemory) return OMX_ErrorInsufficientResources;
+            omx_res = OMX_UseBuffer(m_hComponent, &buffer.pHeader, pData->port, pAppPrivate, pData->size, buffer.pMemory);
+        }
+        else
+        {
+            omx_res = OMX_AllocateBuffer(m_hComponent, &buffer.pHeader, pData->port, pAppPrivate, pData->size);
+        }
+        if (OMX_ErrorNone == omx_res)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Buffers[pData->id] = buffer;
+        }
+        else free(buffer.pMemory);
+        return omx_res;
+    }
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    Buffer* pBuffer = FindBuffer(pData->id);
+
+    if (!pBuffer) return OMX_ErrorBadParameter;
+    if (MFX_OMX_RECORD_FREE_BUFFER == type)
+    {
+        // buffers are returned before they are freed, unless port is being flushed
+        Wait(lock, [pBuffer] { return pBuffer->bOwned; });
+
+        Buffer buffer = *pBuffer;
+        m_Buffers.erase(pData->id);
+        lock.unlock();
+
+        omx_res = OMX_FreeBuffer(m_hComponent, buffer.port, buffer.pHeader);
+        free(buffer.pMemory);
+        return omx_res;
+    }
+
+    // FillThisBuffer
+    uint32_t port = pBuffer->port;
+    Wait(lock, [this, pBuffer, port] { return pBuffer->bOwned && !IsPortBusy(port); });
+    pBuffer->bOwned = false;
+    OMX_BUFFERHEADERTYPE* pHeader = pBuffer->pHeader;
+    lock.unlock();
+
+    pHeader->nFilledLen = 0;
+    pHeader->nOffset = 0;
+    pHeader->nFlags = 0;
+    omx_res = OMX_FillThisBuffer(m_hComponent, pHeader);
+    if (OMX_ErrorNone != omx_res)
+    {
+        lock.lock();
+        pBuffer->bOwned = true;
+    }
+    return omx_res;
+}
+
+/*------------------------------------------------------------------------------*/
+
+OMX_ERRORTYPE MfxOmxReplayer::ReplayEmptyThisBuffer(const MfxOmxRecordEmptyBuffer* pData)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    Buffer* pBuffer = FindBuffer(pData->id);
+
+    if (!pBuffer) return OMX_ErrorBadParameter;
+
+    uint32_t port = pBuffer->port;
+    Wait(lock, [this, pBuffer, port] { return pBuffer->bOwned && !IsPortBusy(port); });
+    pBuffer->bOwned = false;
+    OMX_BUFFERHEADERTYPE* pHeader = pBuffer->pHeader;
+    lock.unlock();
+
+    // without recorded payload the buffer keeps whatever it has
+    uint32_t size = std::min(pData->filledLen, pHeader->nAllocLen);
+    if (pData->payloadSize) memcpy(pHeader->pBuffer, pData + 1, std::min(pData->payloadSize, size));
+    pHeader->nOffset = 0;
+    pHeader->nFilledLen = size;
+    pHeader->nFlags = pData->flags;
+    pHeader->nTimeStamp = pData->timeStamp;
+
+    OMX_ERRORTYPE omx_res = OMX_EmptyThisBuffer(m_hComponent, pHeader);
+    if (OMX_ErrorNone != omx_res)
+    {
+        lock.lock();
+        pBuffer->bOwned = true;
+    }
+    return omx_res;
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxReplayer::Replay(const MfxOmxRecordHeader* pRecord)
+{
+    const void* pData = pRecord + 1;
+    OMX_ERRORTYPE omx_res = OMX_ErrorNone;
+    bool bSkipped = false;
+
+    switch (pRecord->type)
+    {
+    case MFX_OMX_RECORD_SEND_COMMAND:
+        omx_res = ReplayCommand((const MfxOmxRecordCommand*)pData);
+        break;
+    case MFX_OMX_RECORD_GET_PARAMETER:
+    case MFX_OMX_RECORD_SET_PARAMETER:
+    case MFX_OMX_RECORD_GET_CONFIG:
+    case MFX_OMX_RECORD_SET_CONFIG:
+        omx_res = ReplayStruct(pRecord->type, (const MfxOmxRecordStruct*)pData, &bSkipped);
+        break;
+    case MFX_OMX_RECORD_GET_EXTENSION_INDEX:
+        omx_res = ReplayExtensionIndex((const MfxOmxRecordExtensionIndex*)pData);
+        break;
+    case MFX_OMX_RECORD_USE_BUFFER:
+    case MFX_OMX_RECORD_ALLOCATE_BUFFER:
+    case MFX_OMX_RECORD_FREE_BUFFER:
+    case MFX_OMX_RECORD_FILL_THIS_BUFFER:
+        omx_res = ReplayBuffer(pRecord->type, (const MfxOmxRecordBuffer*)pData);
+        break;
+    case MFX_OMX_RECORD_EMPTY_THIS_BUFFER:
+        omx_res = ReplayEmptyThisBuffer((const MfxOmxRecordEmptyBuffer*)pData);
+        break;
+    case MFX_OMX_RECORD_END:
+        return false;
+    default:
+        bSkipped = true;
+        break;
+    }
+
+    if (bSkipped) ++m_Result.skipped;
+    else
+    {
+        ++m_Result.replayed;
+        if ((uint32_t)omx_res != pRecord->result) ++m_Result.mismatches;
+    }
+    if (m_Options.bVerbose)
+    {
+        printf("%10.3f ms: type %u result 0x%x (recorded 0x%x)%s\n", pRecord->time / 1000.0,
+               pRecord->type, omx_res, pRecord->result, bSkipped ? " skipped" : "");
+    }
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxReplayer::Run(void)
+{
+    std::string component = m_Options.component.empty() ? m_Header.component : m_Options.component;
+
+    OMX_ERRORTYPE omx_res = OMX_GetHandle(&m_hComponent, (OMX_STRING)component.c_str(), this, &m_Callbacks);
+    if (OMX_ErrorNone != omx_res)
+    {
+        fprintf(stderr, "GetHandle(%s) failed with 0x%x\n", component.c_str(), omx_res);
+        m_hComponent = NULL;
+        return false;
+    }
+
+    MfxOmxBenchClock::time_point start = MfxOmxBenchClock::now();
+    size_t offset = sizeof(m_Header);
+
+    while (offset < m_Data.size())
+    {
+        const MfxOmxRecordHeader* pRecord = (const MfxOmxRecordHeader*)(m_Data.data() + offset);
+        offset += sizeof(MfxOmxRecordHeader) + pRecord->size;
+
+        MfxOmxBenchClock::time_point scheduled = start +
+            std::chrono::microseconds((uint64_t)(pRecord->time * m_Options.scale));
+        if (m_Options.scale > 0) std::this_thread::sleep_until(scheduled);
+
+        MfxOmxBenchClock::time_point now = MfxOmxBenchClock::now();
+        if ((m_Options.scale > 0) && (now > scheduled))
+        {
+            uint64_t lateness = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(now - scheduled).count();
+
+            m_Result.latenessSum += lateness;
+            m_Result.latenessMax = std::max(m_Result.latenessMax, lateness);
+        }
+        if (!Replay(pRecord)) break;
+    }
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxReplayer::FreeBuffers(void)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    while (!m_Buffers.empty())
+    {
+        Buffer buffer = m_Buffers.begin()->second;
+
+        m_Buffers.erase(m_Buffers.begin());
+        lock.unlock();
+        OMX_FreeBuffer(m_hComponent, buffer.port, buffer.pHeader);
+        free(buffer.pMemory);
+        lock.lock();
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxReplayer::Close(void)
+{
+    if (!m_hComponent) return;
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    Wait(lock, [this] { return m_Commands.empty(); });
+    OMX_STATETYPE state = m_State;
+    lock.unlock();
+
+    // recording may end anywhere, unwinding is done by the replay then
+    if ((OMX_StateExecuting == state) || (OMX_StatePause == state))
+    {
+        MfxOmxRecordCommand command = { OMX_CommandStateSet, OMX_StateIdle };
+        ReplayCommand(&command);
+        state = OMX_StateIdle;
+    }
+    if (OMX_StateIdle == state)
+    {
+        MfxOmxRecordCommand command = { OMX_CommandStateSet, OMX_StateLoaded };
+        ReplayCommand(&command);
+    }
+    FreeBuffers();
+
+    lock.lock();
+    Wait(lock, [this] { return m_Commands.empty(); });
+    lock.unlock();
+
+    OMX_FreeHandle(m_hComponent);
+    m_hComponent = NULL;
+}
+
+/*------------------------------------------------------------------------------*/
+
+static void usage(const char* app)
+{
+    printf("Usage: %s -i recording [options]\n"
+           "  -i file     recording made with OMX.Intel.record.dir property set\n"
+           "  -c name     OMX component to replay on (default: recorded one)\n"
+           "  -s scale    time scale, 2 replays twice slower, 0 as fast as possible (default 1)\n"
+           "  -t ms       timeout for waits on the component (default 5000)\n"
+           "  -v          print every replayed call and event\n"
+           "  -o file     append results to file instead of stdout\n"
+           "Prints one JSON object with replay results.\n", app);
+}
+
+/*------------------------------------------------------------------------------*/
+
+static bool parse_options(int argc, char** argv, MfxOmxReplayOptions& options)
+{
+    bool bOk = true;
+    int opt = 0;
+
+    options.input = NULL;
+    options.output = NULL;
+    options.scale = 1.0;
+    options.timeout = 5000;
+    options.bVerbose = false;
+
+    while (bOk && (-1 != (opt = getopt(argc, argv, "i:c:s:t:o:vh"))))
+    {
+        switch (opt)
+        {
+        case 'i': options.input = optarg; break;
+        case 'c': options.component = optarg; break;
+        case 's': options.scale = atof(optarg); break;
+        case 't': options.timeout = (uint32_t)atoi(optarg); break;
+        case 'o': options.output = optarg; break;
+        case 'v': options.bVerbose = true; break;
+        default: bOk = false; break;
+        }
+    }
+    return bOk && options.input && (options.scale >= 0);
+}
+
+/*------------------------------------------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+    MfxOmxReplayOptions options;
+
+    if (!parse_options(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    MfxOmxReplayer replayer(options);
+    if (!replayer.Load()) return 1;
+
+    FILE* f = stdout;
+    if (options.output && !(f = fopen(options.output, "a")))
+    {
+        fprintf(stderr, "failed to open %s\n", options.output);
+        return 1;
+    }
+    if (OMX_ErrorNone != OMX_Init())
+    {
+        fprintf(stderr, "OMX_Init failed\n");
+        if (stdout != f) fclose(f);
+        return 1;
+    }
+
+    MfxOmxBenchClock::time_point start = MfxOmxBenchClock::now();
+    bool bOk = replayer.Run();
+    replayer.Close();
+    double wall = std::chrono::duration<double, std::milli>(MfxOmxBenchClock::now() - start).count();
+
+    const MfxOmxReplayResult& r = replayer.GetResult();
+    fprintf(f, "{\"recording\":\"%s\",\"component\":\"%s\",\"payloads\":%s,\"truncated\":%s,"
+            "\"scale\":%.3f,\"records\":%u,\"replayed\":%u,\"skipped\":%u,\"mismatches\":%u,"
+            "\"timeouts\":%u,\"empty_done\":%u,\"fill_done\":%u,\"output_bytes\":%llu,"
+            "\"error_events\":%u,\"port_settings_changed\":%u,\"recorded_ms\":%.3f,\"wall_ms\":%.3f,"
+            "\"lateness_us\":{\"mean\":%.1f,\"max\":%llu},\"ok\":%s}\n",
+            options.input, options.component.empty() ? replayer.GetHeader().component : options.component.c_str(),
+            (replayer.GetHeader().flags & MFX_OMX_RECORD_FLAG_PAYLOADS) ? "true" : "false",
+            r.bTruncated ? "true" : "false", options.scale, r.records, r.replayed, r.skipped,
+            r.mismatches, r.timeouts, r.emptyDone, r.fillDone, (unsigned long long)r.outputBytes,
+            r.errorEvents, r.portSettingsChanged, replayer.GetRecordedTime() / 1000.0, wall,
+            r.replayed ? (double)r.latenessSum / r.replayed : 0.0, (unsigned long long)r.latenessMax,
+            (bOk && !r.mismatches && !r.timeouts) ? "true" : "false");
+    fflush(f);
+
+    OMX_Deinit();
+    if (stdout != f) fclose(f);
+    return (bOk && !r.mismatches && !r.timeouts) ? 0 : 2;
+}
@@ -0,0 +1,465 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Synchronization primitives micro-benchmark: compares MfxOmxEvent and
+// MfxOmxSemaphore with the mutex + condition variable implementation they
+// replaced on the patterns components use them in: signaling nobody waits
+// for, waking a sleeping thread (ping-pong between two threads) and short
+// timed waits on the device busy event.
+
+#include "mfx_omx_utils.h"
+#include "mfx_omx_latency.h"
+#include "mfx_omx_bench.h"
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+/*------------------------------------------------------------------------------*/
+
+enum MfxOmxSyncBenchTest
+{
+    MFX_OMX_SYNC_BENCH_UNCONTENDED = 0, // Post + Wait (Signal + Wait) in one thread
+    MFX_OMX_SYNC_BENCH_PINGPONG,        // two threads waking each other
+    MFX_OMX_SYNC_BENCH_TIMEDWAIT        // TimedWait(1) on not signaled event
+};
+
+enum MfxOmxSyncBenchImpl
+{
+    MFX_OMX_SYNC_BENCH_FUTEX = 0, // MfxOmxEvent, MfxOmxSemaphore
+    MFX_OMX_SYNC_BENCH_COND       // reference mutex + condition variable ones
+};
+
+enum MfxOmxSyncBenchPrimitive
+{
+    MFX_OMX_SYNC_BENCH_SEMAPHORE = 0,
+    MFX_OMX_SYNC_BENCH_EVENT
+};
+
+static const char* g_SyncBenchTests[] = { "uncontended", "pingpong", "timedwait" };
+static const char* g_SyncBenchImpls[] = { "futex", "cond" };
+static const char* g_SyncBenchPrimitives[] = { "semaphore", "event" };
+
+struct MfxOmxSyncBenchOptions
+{
+    std::vector<size_t> tests;
+    std::vector<size_t> impls;
+    const char* output;
+    uint32_t iterations;
+    uint32_t timedIterations; // timed waits take ~1 ms each
+};
+
+struct MfxOmxSyncBenchResult
+{
+    mfxU64 ops;
+    mfxU64 ns;       // wall time
+    mfxU64 cpuNs;    // time all threads of the process were on CPU
+    mfxU64 switches; // voluntary context switches
+    mfxU32 errors;
+};
+
+/*------------------------------------------------------------------------------*/
+
+// event on mutex + condition variable, as MfxOmxEvent was before futexes
+class MfxOmxSyncBenchCondEvent
+{
+public:
+    MfxOmxSyncBenchCondEvent(bool manual, bool state): m_manual(manual), m_state(state)
+    {
+        pthread_mutex_init(&m_mutex, NULL);
+        pthread_cond_init(&m_event, NULL);
+    }
+    ~MfxOmxSyncBenchCondEvent(void)
+    {
+        pthread_cond_destroy(&m_event);
+        pthread_mutex_destroy(&m_mutex);
+    }
+
+    int Signal(void)
+    {
+        pthread_mutex_lock(&m_mutex);
+        if (!m_state)
+        {
+            m_state = true;
+            if (m_manual) pthread_cond_broadcast(&m_event);
+            else pthread_cond_signal(&m_event);
+        }
+        return pthread_mutex_unlock(&m_mutex);
+    }
+    int Wait(void)
+    {
+        pthread_mutex_lock(&m_mutex);
+        while (!m_state) pthread_cond_wait(&m_event, &m_mutex);
+        if (!m_manual) m_state = false;
+        return pthread_mutex_unlock(&m_mutex);
+    }
+    int TimedWait(mfxU32 msec)
+    {
+        struct timespec deadline;
+        int res = 0;
+
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += (long)msec * 1000000;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000;
+        deadline.tv_nsec %= 1000000000;
+
+        pthread_mutex_lock(&m_mutex);
+        while (!m_state && !res) res = pthread_cond_timedwait(&m_event, &m_mutex, &deadline);
+        if (m_state)
+        {
+            if (!m_manual) m_state = false;
+            res = 0;
+        }
+        pthread_mutex_unlock(&m_mutex);
+        return res;
+    }
+
+protected:
+    bool m_manual;
+    bool m_state;
+    pthread_cond_t m_event;
+    pthread_mutex_t m_mutex;
+
+private:
+    MFX_OMX_CLASS_NO_COPY(MfxOmxSyncBenchCondEvent)
+};
+
+/*------------------------------------------------------------------------------*/
+
+class MfxOmxSyncBenchCondSemaphore
+{
+public:
+    MfxOmxSyncBenchCondSemaphore(void): m_count(0)
+    {
+        pthread_mutex_init(&m_mutex, NULL);
+        pthread_cond_init(&m_semaphore, NULL);
+    }
+    ~MfxOmxSyncBenchCondSemaphore(void)
+    {
+        pthread_cond_destroy(&m_semaphore);
+        pthread_mutex_destroy(&m_mutex);
+    }
+
+    int Post(void)
+    {
+        pthread_mutex_lock(&m_mutex);
+        if (0 == m_count++) pthread_cond_signal(&m_semaphore);
+        return pthread_mutex_unlock(&m_mutex);
+    }
+    int Wait(void)
+    {
+        pthread_mutex_lock(&m_mutex);
+        while (!m_count) pthread_cond_wait(&m_semaphore, &m_mutex);
+        --m_count;
+        return pthread_mutex_unlock(&m_mutex);
+    }
+
+protected:
+    mfxU32 m_count;
+    pthread_cond_t m_semaphore;
+    pthread_mutex_t m_mutex;
+
+private:
+    MFX_OMX_CLASS_NO_COPY(MfxOmxSyncBenchCondSemaphore)
+};
+
+/*------------------------------------------------------------------------------*/
+
+// uniform Post/Wait over events and semaphores for the templates below
+template<typename T> struct MfxOmxSyncBenchObject
+{
+    MfxOmxSyncBenchObject(void): object() {}
+    int Post(void) { return object.Post(); }
+    int Wait(void) { return object.Wait(); }
+    T object;
+};
+
+template<> struct MfxOmxSyncBenchObject<MfxOmxEvent>
+{
+    MfxOmxSyncBenchObject(void): object(false, false) {}
+    int Post(void) { return object.Signal(); }
+    int Wait(void) { return object.Wait(); }
+    MfxOmxEvent object;
+};
+
+template<> struct MfxOmxSyncBenchObject<MfxOmxSyncBenchCondEvent>
+{
+    MfxOmxSyncBenchObject(void): object(false, false) {}
+    int Post(void) { return object.Signal(); }
+    int Wait(void) { return object.Wait(); }
+    MfxOmxSyncBenchCondEvent object;
+};
+
+/*------------------------------------------------------------------------------*/
+
+static void usage(const char* app)
+{
+    printf("Usage: %s [options]\n"
+           "  -t test,...  uncontended, pingpong, timedwait (default all)\n"
+           "  -i impl,...  futex (MfxOmxEvent, MfxOmxSemaphore), cond (mutex + condition variable) (default both)\n"
+           "  -n N         iterations (default 100000)\n"
+           "  -w N         timedwait iterations, each takes about 1 ms (default 1000)\n"
+           "  -o file      append results to file instead of stdout\n"
+           "Each run prints one JSON object per line, latencies are in ns.\n", app);
+}
+
+/*------------------------------------------------------------------------------*/
+
+static bool parse_options(int argc, char** argv, MfxOmxSyncBenchOptions& options)
+{
+    bool bOk = true;
+    int opt = 0;
+
+    options.tests.clear();
+    for (size_t i = 0; i < MFX_OMX_GET_ARRAY_SIZE(g_SyncBenchTests); ++i) options.tests.push_back(i);
+    options.impls.clear();
+    for (size_t i = 0; i < MFX_OMX_GET_ARRAY_SIZE(g_SyncBenchImpls); ++i) options.impls.push_back(i);
+    options.output = NULL;
+    options.iterations = 100000;
+    options.timedIterations = 1000;
+
+    while (bOk && (-1 != (opt = getopt(argc, argv, "t:i:n:w:o:h"))))
+    {
+        switch (opt)
+        {
+        case 't': bOk = mfx_omx_bench_parse_names(optarg, g_SyncBenchTests, MFX_OMX_GET_ARRAY_SIZE(g_SyncBenchTests), options.tests); break;
+        case 'i': bOk = mfx_omx_bench_parse_names(optarg, g_SyncBenchImpls, MFX_OMX_GET_ARRAY_SIZE(g_SyncBenchImpls), options.impls); break;
+        case 'n': options.iterations = (uint32_t)atoi(optarg); break;
+        case 'w': options.timedIterations = (uint32_t)atoi(optarg); break;
+        case 'o': options.output = optarg; break;
+        default: bOk = false; break;
+        }
+    }
+    return bOk && options.iterations && options.timedIterations;
+}
+
+/*------------------------------------------------------------------------------*/
+
+static mfxU64 get_time_ns(clockid_t clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+    return (mfxU64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*------------------------------------------------------------------------------*/
+
+static mfxU64 get_context_switches(void)
+{
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage)) return 0;
+    return (mfxU64)usage.ru_nvcsw;
+}
+
+/*------------------------------------------------------------------------------*/
+
+// samples process counters around a run
+class MfxOmxSyncBenchMeter
+{
+public:
+    MfxOmxSyncBenchMeter(MfxOmxSyncBenchResult& result): m_result(result)
+    {
+        MFX_OMX_ZERO_MEMORY(m_result);
+        m_nSwitches = get_context_switches();
+        m_nCpuTime = get_time_ns(CLOCK_PROCESS_CPUTIME_ID);
+        m_nTime = get_time_ns(CLOCK_MONOTONIC);
+    }
+    void Stop(mfxU64 ops)
+    {
+        m_result.ns = get_time_ns(CLOCK_MONOTONIC) - m_nTime;
+        m_result.cpuNs = get_time_ns(CLOCK_PROCESS_CPUTIME_ID) - m_nCpuTime;
+        m_result.switches = get_context_switches() - m_nSwitches;
+        m_result.ops = ops;
+    }
+
+protected:
+    MfxOmxSyncBenchResult& m_result;
+    mfxU64 m_nTime;
+    mfxU64 m_nCpuTime;
+    mfxU64 m_nSwitches;
+
+private:
+    MFX_OMX_CLASS_NO_COPY(MfxOmxSyncBenchMeter)
+};
+
+/*------------------------------------------------------------------------------*/
+
+// the path Post/Signal and Wait take when nobody sleeps on the object
+template<typename T>
+static void run_uncontended(const MfxOmxSyncBenchOptions& options, MfxOmxSyncBenchResult& result, MfxOmxLatencyHistogram& histogram)
+{
+    MfxOmxSyncBenchObject<T> object;
+    MfxOmxSyncBenchMeter meter(result);
+
+    // times of single pairs are below clock resolution, only means are reported
+    MFX_OMX_UNUSED(histogram);
+    for (uint32_t i = 0; i < options.iterations; ++i)
+    {
+        if (object.Post()) ++result.errors;
+        if (object.Wait()) ++result.errors;
+    }
+    meter.Stop(options.iterations);
+}
+
+/*------------------------------------------------------------------------------*/
+
+// round trip through a second thread which sleeps on the object between
+// iterations, half of the round trip is the wake up latency
+template<typename T>
+static void run_pingpong(const MfxOmxSyncBenchOptions& options, MfxOmxSyncBenchResult& result, MfxOmxLatencyHistogram& histogram)
+{
+    MfxOmxSyncBenchObject<T> ping, pong;
+    std::atomic<mfxU32> errors(0);
+    uint32_t iterations = options.iterations;
+    MfxOmxSyncBenchMeter meter(result);
+
+    std::thread partner([&]()
+    {
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            if (ping.Wait()) ++errors;
+            if (pong.Post()) ++errors;
+        }
+    });
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        mfxU64 start = get_time_ns(CLOCK_MONOTONIC);
+
+        if (ping.Post()) ++errors;
+        if (pong.Wait()) ++errors;
+        histogram.Record((get_time_ns(CLOCK_MONOTONIC) - start) / 2);
+    }
+    partner.join();
+    meter.Stop(iterations);
+    result.errors = errors;
+}
+
+/*------------------------------------------------------------------------------*/
+
+// components wait on device busy event for 1 ms, oversleeping delays the next submission
+template<typename T>
+static void run_timedwait(const MfxOmxSyncBenchOptions& options, MfxOmxSyncBenchResult& result, MfxOmxLatencyHistogram& histogram)
+{
+    T event(false, false);
+    MfxOmxSyncBenchMeter meter(result);
+
+    for (uint32_t i = 0; i < options.timedIterations; ++i)
+    {
+        mfxU64 start = get_time_ns(CLOCK_MONOTONIC);
+
+        if (ETIMEDOUT != event.TimedWait(1)) ++result.errors;
+        histogram.Record(get_time_ns(CLOCK_MONOTONIC) - start);
+    }
+    meter.Stop(options.timedIterations);
+}
+
+/*------------------------------------------------------------------------------*/
+
+template<typename Event, typename Semaphore>
+static void run(size_t test, MfxOmxSyncBenchPrimitive primitive, const MfxOmxSyncBenchOptions& options,
+                MfxOmxSyncBenchResult& result, MfxOmxLatencyHistogram& histogram)
+{
+    bool bEvent = (MFX_OMX_SYNC_BENCH_EVENT == primitive);
+
+    switch (test)
+    {
+    case MFX_OMX_SYNC_BENCH_UNCONTENDED:
+        if (bEvent) run_uncontended<Event>(options, result, histogram);
+        else run_uncontended<Semaphore>(options, result, histogram);
+        break;
+    case MFX_OMX_SYNC_BENCH_PINGPONG:
+        if (bEvent) run_pingpong<Event>(options, result, histogram);
+        else run_pingpong<Semaphore>(options, result, histogram);
+        break;
+    case MFX_OMX_SYNC_BENCH_TIMEDWAIT:
+        run_timedwait<Event>(options, result, histogram);
+        break;
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+    MfxOmxSyncBenchOptions options;
+    bool bOk = true;
+
+    if (!parse_options(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    FILE* f = stdout;
+    if (options.output && !(f = fopen(options.output, "a")))
+    {
+        fprintf(stderr, "failed to open %s\n", options.output);
+        return 1;
+    }
+
+    for (size_t t = 0; t < options.tests.size(); ++t)
+    {
+        size_t test = options.tests[t];
+
+        for (size_t p = 0; p < MFX_OMX_GET_ARRAY_SIZE(g_SyncBenchPrimitives); ++p)
+        {
+            MfxOmxSyncBenchPrimitive primitive = (MfxOmxSyncBenchPrimitive)p;
+
+            // there is no timed wait on semaphores in components
+            if ((MFX_OMX_SYNC_BENCH_TIMEDWAIT == test) && (MFX_OMX_SYNC_BENCH_SEMAPHORE == primitive)) continue;
+
+            for (size_t i = 0; i < options.impls.size(); ++i)
+            {
+                MfxOmxSyncBenchResult result;
+                MfxOmxLatencyHistogram histogram;
+
+                if (MFX_OMX_SYNC_BENCH_FUTEX == options.impls[i])
+                    run<MfxOmxEvent, MfxOmxSemaphore>(test, primitive, options, result, histogram);
+                else
+                    run<MfxOmxSyncBenchCondEvent, MfxOmxSyncBenchCondSemaphore>(test, primitive, options, result, histogram);
+
+                fprintf(f, "{\"test\":\"%s\",\"primitive\":\"%s\",\"impl\":\"%s\",\"ops\":%llu,"
+                        "\"ns_per_op\":%.1f,\"cpu_ns_per_op\":%.1f,\"switches_per_op\":%.3f,",
+                        g_SyncBenchTests[test], g_SyncBenchPrimitives[primitive], g_SyncBenchImpls[options.impls[i]],
+                        (unsigned long long)result.ops,
+                        result.ops ? (double)result.ns / result.ops : 0.0,
+                        result.ops ? (double)result.cpuNs / result.ops : 0.0,
+                        result.ops ? (double)result.switches / result.ops : 0.0);
+                if (MFX_OMX_SYNC_BENCH_UNCONTENDED != test)
+                {
+                    fprintf(f, "\"latency_ns\":{\"mean\":%llu,\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"max\":%llu},",
+                            (unsigned long long)histogram.GetMean(), (unsigned long long)histogram.GetPercentile(50),
+                            (unsigned long long)histogram.GetPercentile(90), (unsigned long long)histogram.GetPercentile(99),
+                            (unsigned long long)histogram.GetMax());
+                }
+                fprintf(f, "\"errors\":%u}\n", result.errors);
+                fflush(f);
+                if (result.errors) bOk = false;
+            }
+        }
+    }
+
+    if (stdout != f) fclose(f);
+    return bOk ? 0 : 2;
+}
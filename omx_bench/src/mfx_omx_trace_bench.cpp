@@ -0,0 +1,255 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Trace overhead micro-benchmark: cost of the MFX_OMX_AUTO_TRACE_FUNC
+// enter/exit pair (alone and with one value traced) per call of a traced
+// function, with its trace point enabled and masked out, compared with the
+// same function without tracing. The backend is the one the build selected
+// with MFX_OMX_DEBUG and MFX_OMX_DEBUG_TRACE_RING.
+
+#include "mfx_omx_utils.h"
+#include "mfx_omx_bench.h"
+
+#include <unistd.h>
+#include <vector>
+
+/*------------------------------------------------------------------------------*/
+
+// the bench module maps to the utils trace category
+#undef MFX_OMX_MODULE_NAME
+#define MFX_OMX_MODULE_NAME "mfx_omx_trace_bench"
+
+// traced functions are called, not inlined into the loop
+#define MFX_OMX_TRACE_BENCH_NOINLINE __attribute__((noinline))
+
+/*------------------------------------------------------------------------------*/
+
+enum MfxOmxTraceBenchTest
+{
+    MFX_OMX_TRACE_BENCH_FUNC = 0, // enter + exit
+    MFX_OMX_TRACE_BENCH_VALUE     // enter + one MFX_OMX_AUTO_TRACE_I32 + exit
+};
+
+enum MfxOmxTraceBenchMode
+{
+    MFX_OMX_TRACE_BENCH_ENABLED = 0,
+    MFX_OMX_TRACE_BENCH_MASKED
+};
+
+static const char* g_TraceBenchTests[] = { "func", "value" };
+static const char* g_TraceBenchModes[] = { "enabled", "masked" };
+
+#if MFX_OMX_DEBUG != MFX_OMX_YES
+static const char* g_TraceBenchBackend = "none";
+#elif MFX_OMX_DEBUG_TRACE_RING == MFX_OMX_YES
+static const char* g_TraceBenchBackend = "ring";
+#else
+static const char* g_TraceBenchBackend = "text";
+#endif
+
+struct MfxOmxTraceBenchOptions
+{
+    std::vector<size_t> tests;
+    std::vector<size_t> modes;
+    const char* output;
+    uint32_t iterations;
+};
+
+/*------------------------------------------------------------------------------*/
+
+/* Text backend filters trace points by function name patterns (see
+ * mfx_omx_debug.cpp), so enabled functions are named to match one of them
+ * and masked ones to match none. Ring backend filters by category mask.
+ */
+
+static MFX_OMX_TRACE_BENCH_NOINLINE mfxU32 trace_bench_untraced(mfxU32 value)
+{
+    __asm__ __volatile__("" : "+r"(value));
+    return value + 1;
+}
+
+static MFX_OMX_TRACE_BENCH_NOINLINE mfxU32 trace_bench_func_SetConfig(mfxU32 value)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    return value + 1;
+}
+
+static MFX_OMX_TRACE_BENCH_NOINLINE mfxU32 trace_bench_func_filtered(mfxU32 value)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    return value + 1;
+}
+
+static MFX_OMX_TRACE_BENCH_NOINLINE mfxU32 trace_bench_value_SetConfig(mfxU32 value)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    MFX_OMX_AUTO_TRACE_I32(value);
+    return value + 1;
+}
+
+static MFX_OMX_TRACE_BENCH_NOINLINE mfxU32 trace_bench_value_filtered(mfxU32 value)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    MFX_OMX_AUTO_TRACE_I32(value);
+    return value + 1;
+}
+
+typedef mfxU32 (*MfxOmxTraceBenchFunc)(mfxU32 value);
+
+/*------------------------------------------------------------------------------*/
+
+static void usage(const char* app)
+{
+    printf("Usage: %s [options]\n"
+           "  -t test,...  func (enter/exit), value (enter/value/exit) (default both)\n"
+           "  -m mode,...  enabled, masked (default both)\n"
+           "  -n N         calls (default 1000000)\n"
+           "  -o file      append results to file instead of stdout\n"
+           "Each run prints one JSON object per line, times are in ns.\n", app);
+}
+
+/*------------------------------------------------------------------------------*/
+
+static bool parse_options(int argc, char** argv, MfxOmxTraceBenchOptions& options)
+{
+    bool bOk = true;
+    int opt = 0;
+
+    options.tests.clear();
+    for (size_t i = 0; i < MFX_OMX_GET_ARRAY_SIZE(g_TraceBenchTests); ++i) options.tests.push_back(i);
+    options.modes.clear();
+    for (size_t i = 0; i < MFX_OMX_GET_ARRAY_SIZE(g_TraceBenchModes); ++i) options.modes.push_back(i);
+    options.output = NULL;
+    options.iterations = 1000000;
+
+    while (bOk && (-1 != (opt = getopt(argc, argv, "t:m:n:o:h"))))
+    {
+        switch (opt)
+        {
+        case 't': bOk = mfx_omx_bench_parse_names(optarg, g_TraceBenchTests, MFX_OMX_GET_ARRAY_SIZE(g_TraceBenchTests), options.tests); break;
+        case 'm': bOk = mfx_omx_bench_parse_names(optarg, g_TraceBenchModes, MFX_OMX_GET_ARRAY_SIZE(g_TraceBenchModes), options.modes); break;
+        case 'n': options.iterations = (uint32_t)atoi(optarg); break;
+        case 'o': options.output = optarg; break;
+        default: bOk = false; break;
+        }
+    }
+    return bOk && options.iterations;
+}
+
+/*------------------------------------------------------------------------------*/
+
+static mfxU64 get_time_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (mfxU64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*------------------------------------------------------------------------------*/
+
+// returns mean time of one call
+static double run(MfxOmxTraceBenchFunc func, uint32_t iterations)
+{
+    mfxU32 value = 0;
+    mfxU64 start = get_time_ns();
+
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        value = func(value);
+    }
+    mfxU64 ns = get_time_ns() - start;
+
+    // result is used, so calls are not dropped
+    if (value != iterations) return -1.0;
+    return (double)ns / iterations;
+}
+
+/*------------------------------------------------------------------------------*/
+
+static void set_trace_mode(MfxOmxTraceBenchMode mode)
+{
+#if (MFX_OMX_DEBUG == MFX_OMX_YES) && (MFX_OMX_DEBUG_TRACE_RING == MFX_OMX_YES)
+    if (MFX_OMX_TRACE_BENCH_ENABLED == mode) g_OmxTraceMask |= MFX_OMX_TRACE_CATEGORY_UTILS;
+    else g_OmxTraceMask &= ~(mfxU32)MFX_OMX_TRACE_CATEGORY_UTILS;
+#else
+    MFX_OMX_UNUSED(mode);
+#endif
+}
+
+/*------------------------------------------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+    MfxOmxTraceBenchOptions options;
+    bool bOk = true;
+
+    if (!parse_options(argc, argv, options))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    FILE* f = stdout;
+    if (options.output && !(f = fopen(options.output, "a")))
+    {
+        fprintf(stderr, "failed to open %s\n", options.output);
+        return 1;
+    }
+
+    // [test][mode]
+    static const MfxOmxTraceBenchFunc funcs[][2] =
+    {
+        { trace_bench_func_SetConfig, trace_bench_func_filtered },
+        { trace_bench_value_SetConfig, trace_bench_value_filtered }
+    };
+
+    // registers trace points and reads the mask property before the mask is changed
+    for (size_t t = 0; t < MFX_OMX_GET_ARRAY_SIZE(funcs); ++t)
+    {
+        funcs[t][MFX_OMX_TRACE_BENCH_ENABLED](0);
+        funcs[t][MFX_OMX_TRACE_BENCH_MASKED](0);
+    }
+
+    for (size_t t = 0; t < options.tests.size(); ++t)
+    {
+        size_t test = options.tests[t];
+
+        for (size_t m = 0; m < options.modes.size(); ++m)
+        {
+            MfxOmxTraceBenchMode mode = (MfxOmxTraceBenchMode)options.modes[m];
+
+            set_trace_mode(mode);
+
+            double baseline = run(trace_bench_untraced, options.iterations);
+            double traced = run(funcs[test][mode], options.iterations);
+
+            fprintf(f, "{\"backend\":\"%s\",\"test\":\"%s\",\"mode\":\"%s\",\"calls\":%u,"
+                    "\"ns_per_call\":%.2f,\"baseline_ns_per_call\":%.2f,\"overhead_ns\":%.2f}\n",
+                    g_TraceBenchBackend, g_TraceBenchTests[test], g_TraceBenchModes[mode], options.iterations,
+                    traced, baseline, traced - baseline);
+            fflush(f);
+            if ((traced < 0) || (baseline < 0)) bOk = false;
+        }
+    }
+
+    if (stdout != f) fclose(f);
+    return bOk ? 0 : 2;
+}
@@ -55,6 +55,32 @@ enum MfxOmxBitstreamState
 
 /*------------------------------------------------------------------------------*/
 
+// stream parameters parsed from sequence header
+struct MfxOmxStreamInfo
+{
+    mfxU16 CodecProfile;
+    mfxU16 CodecLevel;
+    mfxFrameInfo FrameInfo;
+    // DPB size (not counting current picture) and reorder depth signaled in SPS
+    mfxU16 MaxDecFrameBuffering;
+    mfxU16 NumReorderFrames;
+};
+
+// classes of sequence header changes, ordered by the cost of handling
+enum MfxOmxHeadersChange
+{
+    MFX_OMX_HEADERS_CHANGE_NONE = 0, // PPS only or non-essential SPS fields (VUI timing, aspect ratio)
+    MFX_OMX_HEADERS_CHANGE_CROP,     // only crops differ, decoder reports them on output surfaces
+    MFX_OMX_HEADERS_CHANGE_RESET,    // frame size, DPB size, profile or level differ, decoder reset is needed
+    MFX_OMX_HEADERS_CHANGE_REINIT,   // surface format differs, output port has to be reconfigured
+    MFX_OMX_HEADERS_CHANGE_NUM
+};
+
+// compares stream parameters parsed from old and new sequence headers
+extern MfxOmxHeadersChange mfx_omx_get_headers_change(const MfxOmxStreamInfo& oldInfo, const MfxOmxStreamInfo& newInfo);
+
+/*------------------------------------------------------------------------------*/
+
 class IMfxOmxFrameConstructor
 {
 public:
@@ -84,6 +110,22 @@ public:
     virtual mfxStatus SaveHeaders(mfxBitstream *pSPS, mfxBitstream *pPPS, bool isReset) = 0;
     // detect interlaced content
     virtual bool IsSetInterlaceFlag(bool * bInterlaced) = 0;
+    // returns true if stream headers were (or might be) changed since last reset
+    virtual bool WereHeadersChanged(void) = 0;
+    // parses sequence header found in data (or saved one if data is NULL)
+    virtual mfxStatus GetStreamInfo(mfxU8* data, mfxU32 size, MfxOmxStreamInfo* pInfo) = 0;
+    // sets size of NAL unit length prefix in input samples, 0 means start codes
+    virtual void SetNalLengthSize(mfxU32 size) = 0;
+    virtual mfxU32 GetNalLengthSize(void) = 0;
+    // checks that sample (or codec config record) can be converted to start codes,
+    // may be called from any thread
+    virtual mfxStatus CheckSample(const mfxU8* data, mfxU32 size, bool b_header) = 0;
+    // points data to length prefixed sample converted to start codes, converted
+    // data is owned by frame constructor and is valid till next conversion
+    virtual mfxStatus ConvertToStartCodes(mfxU8*& data, mfxU32& size, bool b_header) = 0;
+    // statistics of internal buffer usage
+    virtual mfxU32 GetBstBufReallocs(void) = 0;
+    virtual mfxU32 GetBstBufCopyBytes(void) = 0;
 
 #ifdef ENABLE_READ_SEI
     // get saved SEI (right now only for HEVC 10 bit SeiHDRStaticInfo)
@@ -137,6 +179,34 @@ public:
         *bInterlaced = false;
         return false;
     }
+    // headers are not tracked, so caller should always check them
+    virtual bool WereHeadersChanged(void) { return true; }
+    // sequence header parsing is not supported
+    virtual mfxStatus GetStreamInfo(mfxU8* data, mfxU32 size, MfxOmxStreamInfo* pInfo)
+    {
+        MFX_OMX_UNUSED(data);
+        MFX_OMX_UNUSED(size);
+        MFX_OMX_UNUSED(pInfo);
+        return MFX_ERR_UNSUPPORTED;
+    }
+    // sets size of NAL unit length prefix in input samples, 0 means start codes
+    virtual void SetNalLengthSize(mfxU32 size) { m_nNalLengthSize = size; }
+    virtual mfxU32 GetNalLengthSize(void) { return m_nNalLengthSize; }
+    // only codecs with NAL units support length prefixed samples
+    virtual mfxStatus CheckSample(const mfxU8* data, mfxU32 size, bool b_header)
+    {
+        MFX_OMX_UNUSED(data);
+        MFX_OMX_UNUSED(size);
+        MFX_OMX_UNUSED(b_header);
+        return m_nNalLengthSize ? MFX_ERR_UNSUPPORTED : MFX_ERR_NONE;
+    }
+    virtual mfxStatus ConvertToStartCodes(mfxU8*& data, mfxU32& size, bool b_header)
+    {
+        return CheckSample(data, size, b_header);
+    }
+    // statistics of internal buffer usage
+    virtual mfxU32 GetBstBufReallocs(void) { return m_nBstBufReallocs; }
+    virtual mfxU32 GetBstBufCopyBytes(void) { return m_nBstBufCopyBytes; }
 
 #ifdef ENABLE_READ_SEI
     // get saved SEI (right now only for HEVC 10 bit SeiHDRStaticInfo)
@@ -178,10 +248,13 @@ protected: // variables
 
     // EOS flag
     bool m_bEOS;
+    // size of NAL unit length prefix in input samples, 0 means start codes;
+    // set by the client thread, updated from codec config record by the main one
+    std::atomic<mfxU32> m_nNalLengthSize;
 
-    // some statistics:
-    mfxU32 m_nBstBufReallocs;
-    mfxU32 m_nBstBufCopyBytes;
+    // some statistics, read by the client thread thru runtime stats:
+    std::atomic<mfxU32> m_nBstBufReallocs;
+    std::atomic<mfxU32> m_nBstBufCopyBytes;
 
     // debug file dumps
     FILE* m_dbg_file;
@@ -203,6 +276,14 @@ public:
     virtual mfxStatus SaveHeaders(mfxBitstream *pSPS, mfxBitstream *pPPS, bool isReset);
     // detect interlaced content
     virtual bool IsSetInterlaceFlag(bool * bInterlaced);
+    // returns true if SPS/PPS different from the saved ones were found after reset
+    virtual bool WereHeadersChanged(void) { return m_bHeadersChanged; }
+    // parses SPS found in data (or saved one if data is NULL)
+    virtual mfxStatus GetStreamInfo(mfxU8* data, mfxU32 size, MfxOmxStreamInfo* pInfo);
+    // checks length prefixed sample or avcC/hvcC record
+    virtual mfxStatus CheckSample(const mfxU8* data, mfxU32 size, bool b_header);
+    // converts length prefixed sample or avcC/hvcC record to start codes
+    virtual mfxStatus ConvertToStartCodes(mfxU8*& data, mfxU32& size, bool b_header);
 
 #ifdef ENABLE_READ_SEI
     // get saved SEI (right now only for HEVC 10 bit SeiHDRStaticInfo)
@@ -210,6 +291,7 @@ public:
 #endif
 
 protected: // functions
+    virtual mfxU32    GetCodecId(void) { return MFX_CODEC_AVC; }
     virtual mfxStatus Load(mfxU8* data, mfxU32 size, mfxU64 pts, bool b_header, bool bCompleteFrame);
     virtual mfxStatus LoadHeader(mfxU8* data, mfxU32 size, bool b_header);
 
@@ -220,6 +302,8 @@ protected: // functions
 
     virtual mfxStatus FindHeaders(mfxU8* data, mfxU32 size, bool &bFoundSps, bool &bFoundPps, bool &bFoundSei);
     virtual mfxI32    FindStartCode(mfxU8 * (&pb), mfxU32 & size, mfxI32 & startCodeSize);
+    // parses SPS NAL unit, data points to NAL unit header
+    virtual mfxStatus ParseSPS(mfxU8* data, mfxU32 size, MfxOmxStreamInfo* pInfo);
     virtual bool      isSPS(mfxI32 code) {return NAL_UT_AVC_SPS == code;}
     virtual bool      isPPS(mfxI32 code) {return NAL_UT_AVC_PPS == code;}
 
@@ -234,6 +318,11 @@ protected: // variables
 
     mfxBitstream m_SPS;
     mfxBitstream m_PPS;
+    // length prefixed sample converted to start codes
+    mfxU8* m_pConvBuf;
+    mfxU32 m_nConvBufSize;
+    // new SPS/PPS differ from the saved ones
+    bool m_bHeadersChanged;
 
 private:
     MFX_OMX_CLASS_NO_COPY(MfxOmxAVCFrameConstructor)
@@ -270,7 +359,9 @@ public:
 #endif
 
 protected: // functions
+    virtual mfxU32 GetCodecId(void) { return MFX_CODEC_HEVC; }
     virtual mfxI32 FindStartCode(mfxU8 * (&pb), mfxU32 & size, mfxI32 & startCodeSize);
+    virtual mfxStatus ParseSPS(mfxU8* data, mfxU32 size, MfxOmxStreamInfo* pInfo);
 
 #ifdef ENABLE_READ_SEI
     // save current SEI
@@ -373,6 +464,9 @@ public:
 
     virtual mfxStatus Reset(void);
 
+    // checks buffer data before the buffer is accepted
+    virtual mfxStatus CheckBuffer(OMX_BUFFERHEADERTYPE* pBuffer);
+
     // MfxOmxInputBuffersPool<OMX_BUFFERHEADERTYPE> methods
     virtual mfxStatus IsBufferLocked(OMX_BUFFERHEADERTYPE* pBuffer, bool& bIsLocked);
 
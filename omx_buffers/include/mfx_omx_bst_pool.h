@@ -24,6 +24,13 @@
 #include "mfx_omx_utils.h"
 #include "mfx_omx_buffers.h"
 
+#include <deque>
+
+/*------------------------------------------------------------------------------*/
+
+// max number of IDR header requests kept for frames in flight
+#define MFX_OMX_IDR_HEADERS_MAX_NUM 16
+
 /*------------------------------------------------------------------------------*/
 
 class MfxOmxBitstreamsPool : public MfxOmxOutputBuffersPool<OMX_BUFFERHEADERTYPE, mfxBitstream>
@@ -41,18 +48,38 @@ public:
     virtual void SendBitstream(OMX_BUFFERHEADERTYPE* pBuffer);
 
     // MfxOmxOutputBuffersPool<OMX_BUFFERHEADERTYPE, mfxBitstream> functions
+    virtual mfxStatus Reset(void);
     virtual mfxStatus UseBuffer(OMX_BUFFERHEADERTYPE* pBuffer);
     virtual mfxStatus IsBufferLocked(OMX_BUFFERHEADERTYPE* pBuffer, bool& bIsLocked);
     void SetRemovingSpsPps(bool bRemove);
     bool IsRemovingSPSPPSNeeded(void);
+    /** Keeps in-band headers of the next IDR frame even if removing is enabled. */
+    void KeepHeadersOnNextIdr(void);
+    /** Keeps or removes in-band headers of the IDR frame with given timestamp, overrides SetRemovingSpsPps. */
+    void SetIdrHeaders(mfxU64 timeStamp, bool bKeep);
+    /** Sets size of NAL unit length prefix, 0 means start codes. */
+    void SetNalLengthSize(mfxU32 size) { m_nNalLengthSize = size; }
 
 protected: //functions
     mfxStatus LoadBitstream(OMX_BUFFERHEADERTYPE* pBuffer);
+    bool IsSliceNalUnit(mfxU8 header);
+    bool GetIdrHeaders(mfxU64 timeStamp, bool& bKeep);
     mfxStatus RemoveHeaders(mfxBitstream *Bitstream);
 protected: // variables
     mfxU32 m_codecId;
     bool m_bCodecDataSent;
     bool m_bRemoveSPSPPS;
+    // set by the main thread, used on the output path
+    std::atomic<bool> m_bKeepHeadersOnIdr;
+    struct IdrHeaders
+    {
+        mfxU64 timeStamp;
+        bool bKeep;
+    };
+    // requested IDR frames still in flight, added by the main thread
+    std::deque<IdrHeaders> m_IdrHeaders;
+    MfxOmxMutex m_idrMutex;
+    mfxU32 m_nNalLengthSize;
     /** Debug purposes file to which encoded bitstream can be dumped. */
     FILE* m_dbg_file;
 
@@ -141,6 +141,7 @@ public:
     MfxOmxInputBuffersPool(mfxStatus &error):
         m_pBuffersCallback(NULL),
         m_pCurrentBufferToProcess(NULL),
+        m_mutex("input_pool"),
         m_pNilBuffer(NULL)
     { error = MFX_ERR_NONE; }
     virtual ~MfxOmxInputBuffersPool(void){}
@@ -168,6 +169,8 @@ public:
 
     /** Returns pool id. */
     inline MfxOmxPoolId GetPoolId(void) { return (MfxOmxPoolId)this; }
+    /** Returns number of incoming buffers waiting for processing. */
+    inline mfxU32 GetQueuedBuffersCount(void) { MfxOmxAutoLock lock(m_mutex); return m_BuffersToProcess.GetItemsCount(); }
 
 protected: // variables
     /** Callback thru which pool will inform that buffer was released. */
@@ -327,6 +330,8 @@ public:
      * it if found.
      */
     virtual mfxStatus CheckBuffers(void);
+    /** Returns number of buffers kept in the pool till they are unlocked. */
+    inline mfxU32 GetUsedBuffersCount(void) { MfxOmxAutoLock lock(this->m_mutex); return m_BuffersUsed.GetItemsCount(); }
 
 protected: // functions
     /**
@@ -534,6 +539,7 @@ public:
         m_pBuffersCallback(NULL),
         m_pCurrentBufferUnlocked(NULL),
         m_pCurrentBufferToBeSent(NULL),
+        m_mutex("output_pool"),
         m_pNilBuffer(NULL)
     { error = MFX_ERR_NONE; }
     virtual ~MfxOmxOutputBuffersPool(void){}
@@ -573,6 +579,10 @@ public:
 
     /** Returns pool id. */
     inline MfxOmxPoolId GetPoolId(void) { return (MfxOmxPoolId)this; }
+    /** Returns number of buffers given to the codec or locked by it. */
+    inline mfxU32 GetUsedBuffersCount(void) { MfxOmxAutoLock lock(m_mutex); return m_BuffersUsed.GetItemsCount() + m_BuffersLocked.GetItemsCount(); }
+    /** Returns number of buffers waiting to be synchronized and sent. */
+    inline mfxU32 GetQueuedBuffersCount(void) { MfxOmxAutoLock lock(m_mutex); return m_BuffersToBeSent.GetItemsCount(); }
 
 protected: // functions
     /**
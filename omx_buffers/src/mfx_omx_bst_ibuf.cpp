@@ -20,10 +20,7 @@
 
 #include "mfx_omx_bst_ibuf.h"
 #include "mfx_omx_avc_bitstream.h"
-
-#ifdef ENABLE_READ_SEI
 #include "mfx_omx_hevc_bitstream.h"
-#endif
 
 /*------------------------------------------------------------------------------*/
 
@@ -47,6 +44,15 @@ static inline mfxU32 BstGetU32(mfxU8* pBuf)
 
 /*------------------------------------------------------------------------------*/
 
+// Annex B data starts with 3 or 4 bytes start code
+static inline bool BstIsStartCode(const mfxU8* pBuf, mfxU32 size)
+{
+    if ((size >= 3) && !pBuf[0] && !pBuf[1] && (1 == pBuf[2])) return true;
+    return (size >= 4) && !pBuf[0] && !pBuf[1] && !pBuf[2] && (1 == pBuf[3]);
+}
+
+/*------------------------------------------------------------------------------*/
+
 static inline void BstSet64(mfxU64 nValue, mfxU8* pBuf)
 {
     if (pBuf)
@@ -92,11 +98,97 @@ static inline void BstSet16(mfxU16 nValue, mfxU8* pBuf)
 
 /*------------------------------------------------------------------------------*/
 
+// compares NAL units ignoring start code length and trailing zero bytes
+static bool BstIsSameNalUnit(const mfxU8* pData1, mfxU32 nSize1, const mfxU8* pData2, mfxU32 nSize2)
+{
+    if (!pData1 || !pData2) return false;
+
+    while (nSize1 && !*pData1) { ++pData1; --nSize1; }
+    while (nSize2 && !*pData2) { ++pData2; --nSize2; }
+    while (nSize1 && !pData1[nSize1 - 1]) --nSize1;
+    while (nSize2 && !pData2[nSize2 - 1]) --nSize2;
+
+    return (nSize1 == nSize2) && std::equal(pData1, pData1 + nSize1, pData2);
+}
+
+/*------------------------------------------------------------------------------*/
+
+// returns MaxDpbFrames for AVC level (Table A-1), used when VUI has no bitstream restrictions
+static mfxU16 BstGetAvcMaxDpbFrames(mfxU8 level_idc, mfxU32 nFrameSizeInMbs)
+{
+    mfxU32 maxDpbMbs = 0;
+
+    switch (level_idc)
+    {
+    case 9:
+    case 10: maxDpbMbs = 396; break;
+    case 11: maxDpbMbs = 900; break;
+    case 12:
+    case 13:
+    case 20: maxDpbMbs = 2376; break;
+    case 21: maxDpbMbs = 4752; break;
+    case 22:
+    case 30: maxDpbMbs = 8100; break;
+    case 31: maxDpbMbs = 18000; break;
+    case 32: maxDpbMbs = 20480; break;
+    case 40:
+    case 41: maxDpbMbs = 32768; break;
+    case 42: maxDpbMbs = 34816; break;
+    case 50: maxDpbMbs = 110400; break;
+    case 51:
+    case 52: maxDpbMbs = 184320; break;
+    default: maxDpbMbs = 696320; break; // levels 6.x and unknown ones
+    }
+    if (!nFrameSizeInMbs) return 16;
+    return (mfxU16)MFX_OMX_MAX(1u, MFX_OMX_MIN(maxDpbMbs / nFrameSizeInMbs, 16u));
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxHeadersChange mfx_omx_get_headers_change(const MfxOmxStreamInfo& oldInfo, const MfxOmxStreamInfo& newInfo)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    MfxOmxHeadersChange change = MFX_OMX_HEADERS_CHANGE_NONE;
+    const mfxFrameInfo& oldFI = oldInfo.FrameInfo;
+    const mfxFrameInfo& newFI = newInfo.FrameInfo;
+
+    if (!oldFI.Width || !oldFI.Height || !newFI.Width || !newFI.Height)
+    {
+        // nothing to compare with, leaving decision to decoder
+        change = MFX_OMX_HEADERS_CHANGE_RESET;
+    }
+    else if ((oldFI.FourCC != newFI.FourCC) ||
+             (oldFI.ChromaFormat != newFI.ChromaFormat) ||
+             (oldFI.BitDepthLuma != newFI.BitDepthLuma) ||
+             (oldFI.BitDepthChroma != newFI.BitDepthChroma) ||
+             (oldFI.PicStruct != newFI.PicStruct))
+    {
+        change = MFX_OMX_HEADERS_CHANGE_REINIT;
+    }
+    else if ((oldFI.Width != newFI.Width) || (oldFI.Height != newFI.Height) ||
+             (oldInfo.CodecProfile != newInfo.CodecProfile) ||
+             (oldInfo.CodecLevel != newInfo.CodecLevel) ||
+             (oldInfo.MaxDecFrameBuffering != newInfo.MaxDecFrameBuffering))
+    {
+        change = MFX_OMX_HEADERS_CHANGE_RESET;
+    }
+    else if ((oldFI.CropX != newFI.CropX) || (oldFI.CropY != newFI.CropY) ||
+             (oldFI.CropW != newFI.CropW) || (oldFI.CropH != newFI.CropH))
+    {
+        change = MFX_OMX_HEADERS_CHANGE_CROP;
+    }
+    MFX_OMX_AUTO_TRACE_I32(change);
+    return change;
+}
+
+/*------------------------------------------------------------------------------*/
+
 MfxOmxFrameConstructor::MfxOmxFrameConstructor(mfxStatus &sts):
     m_bs_state(MfxOmxBS_HeaderAwaiting),
     m_profile(MFX_PROFILE_UNKNOWN),
     m_pBst(NULL),
     m_bEOS(false),
+    m_nNalLengthSize(0),
     m_nBstBufReallocs(0),
     m_nBstBufCopyBytes(0),
     m_dbg_file(NULL),
@@ -120,8 +212,8 @@ MfxOmxFrameConstructor::~MfxOmxFrameConstructor(void)
     if (m_BstBuf.Data)
     {
         MFX_OMX_AUTO_TRACE_I32(m_BstBuf.MaxLength);
-        MFX_OMX_AUTO_TRACE_I32(m_nBstBufReallocs);
-        MFX_OMX_AUTO_TRACE_I32(m_nBstBufCopyBytes);
+        MFX_OMX_AUTO_TRACE_I32(m_nBstBufReallocs.load());
+        MFX_OMX_AUTO_TRACE_I32(m_nBstBufCopyBytes.load());
 
         MFX_OMX_FREE(m_BstBuf.Data);
     }
@@ -456,7 +548,10 @@ mfxBitstream* MfxOmxFrameConstructor::GetMfxBitstream(void)
 /*------------------------------------------------------------------------------*/
 
 MfxOmxAVCFrameConstructor::MfxOmxAVCFrameConstructor(mfxStatus &sts):
-    MfxOmxFrameConstructor(sts)
+    MfxOmxFrameConstructor(sts),
+    m_pConvBuf(NULL),
+    m_nConvBufSize(0),
+    m_bHeadersChanged(false)
 {
     MFX_OMX_AUTO_TRACE_FUNC();
 
@@ -472,6 +567,7 @@ MfxOmxAVCFrameConstructor::~MfxOmxAVCFrameConstructor(void)
 
     MFX_OMX_FREE(m_SPS.Data);
     MFX_OMX_FREE(m_PPS.Data);
+    MFX_OMX_FREE(m_pConvBuf);
 }
 
 /*------------------------------------------------------------------------------*/
@@ -480,7 +576,20 @@ mfxStatus MfxOmxAVCFrameConstructor::SaveHeaders(mfxBitstream *pSPS, mfxBitstrea
 {
     MFX_OMX_AUTO_TRACE_FUNC();
 
-    if (isReset) m_bs_state = MfxOmxBS_Resetting;
+    if (isReset)
+    {
+        m_bs_state = MfxOmxBS_Resetting;
+        // saved headers are the reference for the data which will come after reset
+        m_bHeadersChanged = false;
+    }
+    else
+    {
+        if (pSPS && !BstIsSameNalUnit(m_SPS.Data, m_SPS.DataLength, pSPS->Data + pSPS->DataOffset, pSPS->DataLength))
+            m_bHeadersChanged = true;
+        if (pPPS && !BstIsSameNalUnit(m_PPS.Data, m_PPS.DataLength, pPPS->Data + pPPS->DataOffset, pPPS->DataLength))
+            m_bHeadersChanged = true;
+    }
+    MFX_OMX_AUTO_TRACE_I32(m_bHeadersChanged);
 
     if (pSPS)
     {
@@ -740,9 +849,84 @@ mfxStatus MfxOmxAVCFrameConstructor::Load(mfxU8* data, mfxU32 size, mfxU64 pts,
     MFX_OMX_AUTO_TRACE_FUNC();
     mfxStatus mfx_res = MFX_ERR_NONE;
 
-    mfx_res = MfxOmxFrameConstructor::Load(data, size, pts, b_header, bCompleteFrame);
-    mfx_omx_dump(data, 1, size, m_dbg_file_fc);
+    mfx_res = ConvertToStartCodes(data, size, b_header);
+    if (MFX_ERR_UNDEFINED_BEHAVIOR == mfx_res)
+    {
+        // broken sample is dropped as an empty one, decoder resyncs on the next
+        MFX_OMX_LOG_ERROR("Dropped %d bytes of malformed length prefixed data", size);
+        mfx_res = MFX_ERR_NULL_PTR;
+    }
+    if (MFX_ERR_NONE == mfx_res)
+    {
+        mfx_res = MfxOmxFrameConstructor::Load(data, size, pts, b_header, bCompleteFrame);
+        mfx_omx_dump(data, 1, size, m_dbg_file_fc);
+    }
+
+    MFX_OMX_AUTO_TRACE_I32(mfx_res);
+    return mfx_res;
+}
+
+/*------------------------------------------------------------------------------*/
 
+/* Codec config records are checked by the client thread before the buffer is
+ * accepted, so a malformed one is rejected right in EmptyThisBuffer. Length
+ * prefixes of samples are checked on conversion: length size in effect is
+ * known only after the preceding record is converted.
+ */
+mfxStatus MfxOmxAVCFrameConstructor::CheckSample(const mfxU8* data, mfxU32 size, bool b_header)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    mfxStatus mfx_res = MFX_ERR_NONE;
+
+    if (m_nNalLengthSize && b_header && data && size && !BstIsStartCode(data, size))
+    {
+        mfxU32 length = 0, lengthSize = 0;
+        mfx_res = mfx_omx_convert_config_record_to_start_codes(GetCodecId(), data, size, NULL, length, lengthSize);
+    }
+    MFX_OMX_AUTO_TRACE_I32(mfx_res);
+    return mfx_res;
+}
+
+/*------------------------------------------------------------------------------*/
+
+/* Converts into own buffer, so client data is never modified and parsers and
+ * decoder see Annex B data only. Codec config record also updates length size
+ * with the one it signals; config already in Annex B form is used as is.
+ */
+mfxStatus MfxOmxAVCFrameConstructor::ConvertToStartCodes(mfxU8*& data, mfxU32& size, bool b_header)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    mfxStatus mfx_res = MFX_ERR_NONE;
+    mfxU32 length = 0, lengthSize = m_nNalLengthSize;
+
+    if (!lengthSize || !data || !size) return MFX_ERR_NONE;
+    if (b_header && BstIsStartCode(data, size)) return MFX_ERR_NONE;
+
+    // first pass only checks data and gets size of converted one
+    if (b_header) mfx_res = mfx_omx_convert_config_record_to_start_codes(GetCodecId(), data, size, NULL, length, lengthSize);
+    else mfx_res = mfx_omx_convert_to_start_codes(data, size, lengthSize, NULL, length);
+
+    if ((MFX_ERR_NONE == mfx_res) && (m_nConvBufSize < length))
+    {
+        mfxU8* new_data = (mfxU8*)realloc(m_pConvBuf, length);
+        if (new_data)
+        {
+            ++m_nBstBufReallocs;
+            m_pConvBuf = new_data;
+            m_nConvBufSize = length;
+        }
+        else mfx_res = MFX_ERR_MEMORY_ALLOC;
+    }
+    if (MFX_ERR_NONE == mfx_res)
+    {
+        if (b_header) mfx_omx_convert_config_record_to_start_codes(GetCodecId(), data, size, m_pConvBuf, length, lengthSize);
+        else mfx_omx_convert_to_start_codes(data, size, lengthSize, m_pConvBuf, length);
+
+        if (b_header) m_nNalLengthSize = lengthSize;
+        m_nBstBufCopyBytes += length;
+        data = m_pConvBuf;
+        size = length;
+    }
     MFX_OMX_AUTO_TRACE_I32(mfx_res);
     return mfx_res;
 }
@@ -790,6 +974,180 @@ bool MfxOmxAVCFrameConstructor::IsSetInterlaceFlag(bool * bInterlaced)
 
 /*------------------------------------------------------------------------------*/
 
+mfxStatus MfxOmxAVCFrameConstructor::GetStreamInfo(mfxU8* data, mfxU32 size, MfxOmxStreamInfo* pInfo)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    mfxStatus mfx_res = MFX_ERR_NONE;
+
+    if (!pInfo) mfx_res = MFX_ERR_NULL_PTR;
+    if ((MFX_ERR_NONE == mfx_res) && !data)
+    {
+        data = m_SPS.Data;
+        size = m_SPS.DataLength;
+    }
+    if ((MFX_ERR_NONE == mfx_res) && (!data || !size)) mfx_res = MFX_ERR_MORE_DATA;
+    if (MFX_ERR_NONE == mfx_res)
+    {
+        mfxI32 startCodeSize = 0;
+        mfxI32 code = -1;
+
+        do
+        {
+            code = FindStartCode(data, size, startCodeSize);
+        }
+        while ((-1 != code) && !isSPS(code));
+
+        if (-1 == code) mfx_res = MFX_ERR_MORE_DATA;
+    }
+    if (MFX_ERR_NONE == mfx_res)
+    {
+        // cutting SPS till the next start code
+        mfxU8* next = data;
+        mfxU32 length = size, next_size = size;
+        mfxI32 startCodeSize = 0;
+
+        if (-1 != FindStartCode(next, next_size, startCodeSize))
+            length -= next_size + startCodeSize;
+
+        mfx_res = ParseSPS(data, length, pInfo);
+    }
+    MFX_OMX_AUTO_TRACE_I32(mfx_res);
+    return mfx_res;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxAVCFrameConstructor::ParseSPS(mfxU8* data, mfxU32 size, MfxOmxStreamInfo* pInfo)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    mfxStatus mfx_res = MFX_ERR_NONE;
+
+    if (size <= 1) return MFX_ERR_MORE_DATA;
+
+    std::vector<mfxU8> swappingMemory;
+    mfxU32 swappingMemorySize = size - 1; // size SPS in bytes without marker
+    swappingMemory.resize(swappingMemorySize + 8);
+    BytesSwapper::SwapMemory(&(swappingMemory[0]), swappingMemorySize, data + 1, swappingMemorySize);
+
+    AVCParser::AVCHeadersBitstream bitStream;
+    bitStream.Reset(&(swappingMemory[0]), swappingMemorySize);
+
+    AVCParser::AVCSeqParamSet sps;
+    MFX_OMX_TRY_AND_CATCH(
+        mfx_res = bitStream.GetSequenceParamSet(&sps),
+        mfx_res = MFX_ERR_UNDEFINED_BEHAVIOR);
+
+    if (MFX_ERR_NONE == mfx_res)
+    {
+        mfxFrameInfo& info = pInfo->FrameInfo;
+        MFX_OMX_ZERO_MEMORY(*pInfo);
+
+        // frame_height_in_mbs already takes field coding into account
+        mfxU32 width = sps.frame_width_in_mbs * 16;
+        mfxU32 height = sps.frame_height_in_mbs * 16;
+        mfxU32 cropUnitX = ((1 == sps.chroma_format_idc) || (2 == sps.chroma_format_idc)) ? 2 : 1;
+        mfxU32 cropUnitY = ((1 == sps.chroma_format_idc) ? 2 : 1) * (2 - sps.frame_mbs_only_flag);
+
+        pInfo->CodecProfile = sps.profile_idc;
+        pInfo->CodecLevel = sps.level_idc;
+
+        info.Width = (mfxU16)(MFX_OMX_MEM_ALIGN(width, 16));
+        info.Height = (mfxU16)(sps.frame_mbs_only_flag ? (MFX_OMX_MEM_ALIGN(height, 16)) : (MFX_OMX_MEM_ALIGN(height, 32)));
+        info.CropX = (mfxU16)(sps.frame_cropping_rect_left_offset * cropUnitX);
+        info.CropY = (mfxU16)(sps.frame_cropping_rect_top_offset * cropUnitY);
+        info.CropW = (mfxU16)(width - (sps.frame_cropping_rect_left_offset + sps.frame_cropping_rect_right_offset) * cropUnitX);
+        info.CropH = (mfxU16)(height - (sps.frame_cropping_rect_top_offset + sps.frame_cropping_rect_bottom_offset) * cropUnitY);
+        info.BitDepthLuma = sps.bit_depth_luma;
+        info.BitDepthChroma = sps.bit_depth_chroma;
+        info.ChromaFormat = sps.chroma_format_idc;
+        info.FourCC = (sps.bit_depth_luma > 8) ? MFX_FOURCC_P010 : MFX_FOURCC_NV12;
+        info.PicStruct = sps.frame_mbs_only_flag ? MFX_PICSTRUCT_PROGRESSIVE : MFX_PICSTRUCT_UNKNOWN;
+        if (sps.aspect_ratio_info_present_flag)
+        {
+            info.AspectRatioW = sps.sar_width;
+            info.AspectRatioH = sps.sar_height;
+        }
+        if (sps.timing_info_present_flag && sps.fixed_frame_rate_flag && sps.num_units_in_tick)
+        {
+            info.FrameRateExtN = sps.time_scale;
+            info.FrameRateExtD = 2 * sps.num_units_in_tick;
+        }
+        if (sps.bitstream_restriction_flag)
+        {
+            pInfo->MaxDecFrameBuffering = (mfxU16)MFX_OMX_MAX(sps.max_dec_frame_buffering, 1);
+            pInfo->NumReorderFrames = sps.num_reorder_frames;
+        }
+        else
+        {
+            pInfo->MaxDecFrameBuffering = BstGetAvcMaxDpbFrames(sps.level_idc, sps.frame_width_in_mbs * sps.frame_height_in_mbs);
+            pInfo->NumReorderFrames = pInfo->MaxDecFrameBuffering;
+        }
+    }
+    MFX_OMX_AUTO_TRACE_I32(mfx_res);
+    return mfx_res;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxHEVCFrameConstructor::ParseSPS(mfxU8* data, mfxU32 size, MfxOmxStreamInfo* pInfo)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    mfxStatus mfx_res = MFX_ERR_NONE;
+
+    if (size <= 2) return MFX_ERR_MORE_DATA;
+
+    std::vector<mfxU8> swappingMemory;
+    mfxU32 swappingMemorySize = size - 2; // size SPS in bytes without 2 bytes marker
+    swappingMemory.resize(swappingMemorySize + 8);
+    BytesSwapper::SwapMemory(&(swappingMemory[0]), swappingMemorySize, data + 2, swappingMemorySize);
+
+    HEVCParser::HEVCHeadersBitstream bitStream;
+    bitStream.Reset(&(swappingMemory[0]), swappingMemorySize);
+
+    HEVCParser::H265SeqParamSet sps;
+    MFX_OMX_TRY_AND_CATCH(
+        mfx_res = bitStream.GetSequenceParamSet(&sps),
+        mfx_res = MFX_ERR_UNDEFINED_BEHAVIOR);
+
+    if (MFX_ERR_NONE == mfx_res)
+    {
+        mfxFrameInfo& info = pInfo->FrameInfo;
+        MFX_OMX_ZERO_MEMORY(*pInfo);
+
+        // conformance window offsets are already in luma samples
+        mfxU32 width = sps.pic_width_in_luma_samples;
+        mfxU32 height = sps.pic_height_in_luma_samples;
+
+        pInfo->CodecProfile = (mfxU16)sps.getPTL()->GetGeneralPTL()->profile_idc;
+        pInfo->CodecLevel = (mfxU16)(sps.getPTL()->GetGeneralPTL()->level_idc / 3);
+
+        info.Width = (mfxU16)(MFX_OMX_MEM_ALIGN(width, 16));
+        info.Height = (mfxU16)(MFX_OMX_MEM_ALIGN(height, 16));
+        info.CropX = (mfxU16)sps.conf_win_left_offset;
+        info.CropY = (mfxU16)sps.conf_win_top_offset;
+        info.CropW = (mfxU16)(width - sps.conf_win_left_offset - sps.conf_win_right_offset);
+        info.CropH = (mfxU16)(height - sps.conf_win_top_offset - sps.conf_win_bottom_offset);
+        info.BitDepthLuma = (mfxU16)sps.bit_depth_luma;
+        info.BitDepthChroma = (mfxU16)sps.bit_depth_chroma;
+        info.ChromaFormat = sps.chroma_format_idc;
+        info.FourCC = (sps.bit_depth_luma > 8) ? MFX_FOURCC_P010 : MFX_FOURCC_NV12;
+        info.PicStruct = sps.field_seq_flag ? MFX_PICSTRUCT_UNKNOWN : MFX_PICSTRUCT_PROGRESSIVE;
+        if (sps.aspect_ratio_info_present_flag)
+        {
+            info.AspectRatioW = (mfxU16)sps.sar_width;
+            info.AspectRatioH = (mfxU16)sps.sar_height;
+        }
+        // values of the highest sub-layer are the ones which apply to the whole stream
+        mfxU32 maxSubLayer = sps.sps_max_sub_layers ? sps.sps_max_sub_layers - 1 : 0;
+        pInfo->MaxDecFrameBuffering = (mfxU16)(sps.sps_max_dec_pic_buffering[maxSubLayer] - 1);
+        pInfo->NumReorderFrames = (mfxU16)sps.sps_max_num_reorder_pics[maxSubLayer];
+    }
+    MFX_OMX_AUTO_TRACE_I32(mfx_res);
+    return mfx_res;
+}
+
+/*------------------------------------------------------------------------------*/
+
 mfxI32 MfxOmxHEVCFrameConstructor::FindStartCode(mfxU8 * (&pb), mfxU32 & size, mfxI32 & startCodeSize)
 {
     mfxU32 zeroCount = 0;
@@ -1297,6 +1655,28 @@ mfxStatus MfxOmxBitstream::Reset(void)
 
 /*------------------------------------------------------------------------------*/
 
+mfxStatus MfxOmxBitstream::CheckBuffer(OMX_BUFFERHEADERTYPE* pBuffer)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    mfxStatus mfx_res = MFX_ERR_NONE;
+
+    if (pBuffer && pBuffer->nFilledLen)
+    {
+        if ((pBuffer->nOffset > pBuffer->nAllocLen) || (pBuffer->nFilledLen > pBuffer->nAllocLen - pBuffer->nOffset))
+            mfx_res = MFX_ERR_UNDEFINED_BEHAVIOR;
+        else
+            mfx_res = m_frameConstructor->CheckSample(pBuffer->pBuffer + pBuffer->nOffset, pBuffer->nFilledLen,
+                                                      (pBuffer->nFlags & OMX_BUFFERFLAG_CODECCONFIG));
+        if (MFX_ERR_NONE != mfx_res)
+            MFX_OMX_LOG_ERROR("Rejected input buffer %p: offset %d, %d bytes, flags 0x%x: %d",
+                              pBuffer, pBuffer->nOffset, pBuffer->nFilledLen, pBuffer->nFlags, mfx_res);
+    }
+    MFX_OMX_AUTO_TRACE_I32(mfx_res);
+    return mfx_res;
+}
+
+/*------------------------------------------------------------------------------*/
+
 mfxStatus MfxOmxBitstream::IsBufferLocked(OMX_BUFFERHEADERTYPE* pBuffer, bool& bIsLocked)
 {
     bIsLocked = false;
@@ -32,6 +32,9 @@ MfxOmxBitstreamsPool::MfxOmxBitstreamsPool(mfxU32 CodecId, mfxStatus &sts):
     m_codecId(CodecId),
     m_bCodecDataSent(false),
     m_bRemoveSPSPPS(true),
+    m_bKeepHeadersOnIdr(false),
+    m_idrMutex("bst_pool_idr"),
+    m_nNalLengthSize(0),
     m_dbg_file(NULL)
 {
     MFX_OMX_AUTO_TRACE_FUNC();
@@ -75,6 +78,18 @@ mfxStatus MfxOmxBitstreamsPool::PrepareBitstream(
 }
 
 
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxBitstreamsPool::Reset(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    {
+        MfxOmxAutoLock lock(m_idrMutex);
+        m_IdrHeaders.clear();
+    }
+    return MfxOmxOutputBuffersPool<OMX_BUFFERHEADERTYPE, mfxBitstream>::Reset();
+}
+
 /*------------------------------------------------------------------------------*/
 
 mfxStatus MfxOmxBitstreamsPool::UseBuffer(OMX_BUFFERHEADERTYPE* pBuffer)
@@ -115,6 +130,44 @@ bool MfxOmxBitstreamsPool::IsRemovingSPSPPSNeeded()
 
 /*------------------------------------------------------------------------------*/
 
+void MfxOmxBitstreamsPool::KeepHeadersOnNextIdr(void)
+{
+    m_bKeepHeadersOnIdr = true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxBitstreamsPool::SetIdrHeaders(mfxU64 timeStamp, bool bKeep)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    MfxOmxAutoLock lock(m_idrMutex);
+    IdrHeaders idr = { timeStamp, bKeep };
+
+    // requests of frames which were not encoded as IDR are never taken, the oldest are dropped
+    if (m_IdrHeaders.size() >= MFX_OMX_IDR_HEADERS_MAX_NUM) m_IdrHeaders.pop_front();
+    m_IdrHeaders.push_back(idr);
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxBitstreamsPool::GetIdrHeaders(mfxU64 timeStamp, bool& bKeep)
+{
+    MfxOmxAutoLock lock(m_idrMutex);
+
+    for (std::deque<IdrHeaders>::iterator it = m_IdrHeaders.begin(); it != m_IdrHeaders.end(); ++it)
+    {
+        if (it->timeStamp == timeStamp)
+        {
+            bKeep = it->bKeep;
+            m_IdrHeaders.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+/*------------------------------------------------------------------------------*/
+
 mfxStatus MfxOmxBitstreamsPool::LoadBitstream(OMX_BUFFERHEADERTYPE* pBuffer)
 {
     MFX_OMX_AUTO_TRACE_FUNC();
@@ -131,6 +184,15 @@ mfxStatus MfxOmxBitstreamsPool::LoadBitstream(OMX_BUFFERHEADERTYPE* pBuffer)
 
 /*------------------------------------------------------------------------------*/
 
+bool MfxOmxBitstreamsPool::IsSliceNalUnit(mfxU8 header)
+{
+    mfxU8 type = (MFX_CODEC_HEVC == m_codecId) ? (header & 0x7E) >> 1 : header & 0x1F;
+
+    return (type == 1 || type == 5 || type == 19);
+}
+
+/*------------------------------------------------------------------------------*/
+
 mfxStatus MfxOmxBitstreamsPool::RemoveHeaders(mfxBitstream *Bitstream)
 {
     MFX_OMX_AUTO_TRACE_FUNC();
@@ -138,6 +200,13 @@ mfxStatus MfxOmxBitstreamsPool::RemoveHeaders(mfxBitstream *Bitstream)
 
     mfxU8 * data = Bitstream->Data + Bitstream->DataOffset;
 
+    // most frames already start with a slice and a long start code, nothing to remove or move then
+    if (!Bitstream->DataOffset && (Bitstream->DataLength > 5) &&
+        !data[0] && !data[1] && !data[2] && (1 == data[3]) && IsSliceNalUnit(data[4]))
+    {
+        return mfx_res;
+    }
+
     mfxU8 * begin = Bitstream->Data + Bitstream->DataOffset;
     mfxU8 * end = begin + Bitstream->DataLength;
 
@@ -145,10 +214,7 @@ mfxStatus MfxOmxBitstreamsPool::RemoveHeaders(mfxBitstream *Bitstream)
 
     for (NalUnit nalu = GetNalUnit(begin, end); nalu != NalUnit(); nalu = GetNalUnit(begin, end))
     {
-        mfxU8 type = (MFX_CODEC_HEVC == m_codecId) ?
-                    (nalu.begin[nalu.numZero+1] & 0x7E) >> 1 :
-                     nalu.begin[nalu.numZero+1] & 0x1F;
-        if (type == 1 || type == 5 || type == 19)
+        if (IsSliceNalUnit(nalu.begin[nalu.numZero+1]))
         {
             mfxU32 skip = nalu.begin - data;
             Bitstream->DataOffset += skip;
@@ -193,6 +259,7 @@ void MfxOmxBitstreamsPool::SendBitstream(OMX_BUFFERHEADERTYPE* pBuffer)
 {
     MFX_OMX_AUTO_TRACE_FUNC();
     MfxOmxBufferInfo* pAddBufInfo = MfxOmxGetOutputBufferInfo(pBuffer);
+    mfxStatus mfx_res = MFX_ERR_NONE;
 
     if (pBuffer && pAddBufInfo)
     {
@@ -211,9 +278,42 @@ void MfxOmxBitstreamsPool::SendBitstream(OMX_BUFFERHEADERTYPE* pBuffer)
                 if (MFX_CODEC_AVC == m_codecId ||
                     MFX_CODEC_HEVC == m_codecId)
                 {
+                    mfxU16 frameType = pAddBufInfo->sBitstream.FrameType;
+
                     if (m_bCodecDataSent)
                     {
-                        if (m_bRemoveSPSPPS) RemoveHeaders(&pAddBufInfo->sBitstream);
+                        bool bRemove = m_bRemoveSPSPPS;
+
+                        if (frameType & MFX_FRAMETYPE_IDR)
+                        {
+                            bool bKeep = false;
+
+                            if (GetIdrHeaders(pAddBufInfo->sBitstream.TimeStamp, bKeep)) bRemove = !bKeep;
+                            // changed parameter sets go in-band whatever was requested
+                            if (m_bKeepHeadersOnIdr.exchange(false)) bRemove = false;
+                            if (!bRemove)
+                            {
+                                MFX_OMX_AUTO_TRACE_MSG("keeping in-band headers of IDR frame");
+                            }
+                        }
+                        // any frame may carry SEI or AUD, frames starting with a slice return at once
+                        if (bRemove)
+                        {
+                            RemoveHeaders(&pAddBufInfo->sBitstream);
+                        }
+
+                        if (m_nNalLengthSize)
+                        {
+                            mfxBitstream& bs = pAddBufInfo->sBitstream;
+                            mfx_res = mfx_omx_convert_to_length_prefixed(
+                                bs.Data + bs.DataOffset, bs.DataLength, bs.MaxLength - bs.DataOffset, m_nNalLengthSize);
+                            if (MFX_ERR_NONE != mfx_res)
+                            {
+                                // client can't parse start codes, so the frame is dropped and the error is reported
+                                MFX_OMX_LOG_ERROR("Failed to convert NAL units to %d bytes length prefixed: %d", m_nNalLengthSize, mfx_res);
+                                bs.DataLength = 0;
+                            }
+                        }
                     }
                     else
                     {
@@ -227,7 +327,7 @@ void MfxOmxBitstreamsPool::SendBitstream(OMX_BUFFERHEADERTYPE* pBuffer)
                 pBuffer->nOffset = pAddBufInfo->sBitstream.DataOffset;
             }
 
-            if (pAddBufInfo->sBitstream.FrameType & MFX_FRAMETYPE_IDR)
+            if ((MFX_ERR_NONE == mfx_res) && (pAddBufInfo->sBitstream.FrameType & MFX_FRAMETYPE_IDR))
             {
                 pBuffer->nFlags |= OMX_BUFFERFLAG_SYNCFRAME;
             }
@@ -238,6 +338,6 @@ void MfxOmxBitstreamsPool::SendBitstream(OMX_BUFFERHEADERTYPE* pBuffer)
                 1, pAddBufInfo->sBitstream.DataLength, m_dbg_file);
         }
         // releasing sample to be used by downstream plug-in
-        MFX_OMX_RELEASE_BUFFER(m_pBuffersCallback, GetPoolId(), pBuffer, MFX_ERR_NONE);
+        MFX_OMX_RELEASE_BUFFER(m_pBuffersCallback, GetPoolId(), pBuffer, mfx_res);
     }
 }
@@ -392,7 +392,7 @@ mfxStatus MfxOmxInputSurfacesPool::LoadSurface(
     }
     if (MFX_ERR_NONE != mfx_res)
     {
-        MFX_OMX_DELETE(config.control);
+        mfx_omx_put_encode_ctrl(config.control);
         MFX_OMX_DELETE(config.mfxparams);
     }
     return mfx_res;
@@ -592,15 +592,7 @@ mfxStatus MfxOmxInputSurfacesPool::ReleaseBuffer(OMX_BUFFERHEADERTYPE* pBuffer)
         {
             mfx_res = MFX_ERR_NULL_PTR;
         }
-        if (pBufInfo->config.control) // free payload data
-        {
-            if (pBufInfo->config.control->payload)
-            {
-                MFX_OMX_DELETE(pBufInfo->config.control->payload->Data);
-            }
-            MFX_OMX_DELETE(pBufInfo->config.control->payload);
-        }
-        MFX_OMX_DELETE(pBufInfo->config.control);
+        mfx_omx_put_encode_ctrl(pBufInfo->config.control);
         MFX_OMX_DELETE(pBufInfo->config.mfxparams);
     }
     return mfx_res;
@@ -0,0 +1,118 @@
+// Copyright (c) 2014-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __MFX_OMX_CALLBACK_DISPATCHER_H__
+#define __MFX_OMX_CALLBACK_DISPATCHER_H__
+
+#include <deque>
+
+#include "mfx_omx_utils.h"
+
+/*------------------------------------------------------------------------------*/
+
+#define MFX_OMX_CALLBACK_QUEUE_SIZE 256
+
+/*------------------------------------------------------------------------------*/
+
+struct MfxOmxCallbackData
+{
+    enum {
+        MfxOmx_Callback_None,
+        MfxOmx_Callback_Event,           // EventHandler
+        MfxOmx_Callback_EmptyBufferDone, // EmptyBufferDone
+        MfxOmx_Callback_FillBufferDone,  // FillBufferDone
+        MfxOmx_Callback_Stop,            // stops dispatching thread
+    } type;
+    OMX_HANDLETYPE hComponent;
+    OMX_EVENTTYPE eEvent;
+    OMX_U32 nData1;
+    OMX_U32 nData2;
+    OMX_PTR pEventData;
+    OMX_BUFFERHEADERTYPE* pBuffer;
+};
+
+/*------------------------------------------------------------------------------*/
+
+/* Delivers client callbacks from own thread in the order they were issued, so
+ * slow client callbacks do not delay component threads. Component passes its
+ * callbacks through SetCallbacks and uses returned ones instead. Callbacks
+ * issued while client is inside a callback are queued too and delivered once
+ * it returns, never reentrantly.
+ */
+class MfxOmxCallbackDispatcher
+{
+    friend unsigned int MfxOmxCallbackDispatcher_Thread(void* param);
+
+public:
+    MfxOmxCallbackDispatcher(mfxStatus &sts);
+    // delivers callbacks which are still queued and stops the thread
+    ~MfxOmxCallbackDispatcher(void);
+
+    void SetCallbacks(OMX_CALLBACKTYPE* pCallbacks, OMX_PTR pAppData,
+                      OMX_CALLBACKTYPE** ppCallbacks, OMX_PTR* ppAppData);
+
+    // statistics, may be queried from any thread; times are in us
+    mfxU32 GetCallbacksCount(void) const { return m_nCallbacks.load(); }
+    mfxU64 GetCallbackMeanTime(void) const;
+    mfxU64 GetCallbackMaxTime(void) const { return m_nCallbackMaxTime.load(); }
+    mfxU32 GetQueueFullWaits(void) const { return m_nQueueFullWaits.load(); }
+
+protected: // functions
+    static OMX_ERRORTYPE EventHandler(
+        OMX_HANDLETYPE hComponent, OMX_PTR pAppData, OMX_EVENTTYPE eEvent,
+        OMX_U32 nData1, OMX_U32 nData2, OMX_PTR pEventData);
+    static OMX_ERRORTYPE EmptyBufferDone(
+        OMX_HANDLETYPE hComponent, OMX_PTR pAppData, OMX_BUFFERHEADERTYPE* pBuffer);
+    static OMX_ERRORTYPE FillBufferDone(
+        OMX_HANDLETYPE hComponent, OMX_PTR pAppData, OMX_BUFFERHEADERTYPE* pBuffer);
+
+    void Queue(const MfxOmxCallbackData& data);
+    // delivers one queued callback, returns false if there are none
+    bool Deliver(void);
+    void Thread(void);
+
+protected: // variables
+    OMX_CALLBACKTYPE m_Callbacks;
+    OMX_CALLBACKTYPE* m_pClientCallbacks;
+    OMX_PTR m_pClientAppData;
+
+    MfxOmxLockFreeRing<MfxOmxCallbackData> m_queue;
+    // callbacks issued from the dispatching thread, accessed by it only; they are
+    // caused by the callback being delivered and go right after it
+    std::deque<MfxOmxCallbackData> m_nested;
+    // queued callbacks
+    MfxOmxSemaphore m_semaphore;
+    // free slots of m_queue, producers wait on it when the queue is full
+    MfxOmxSemaphore m_freeSlots;
+    MfxOmxThread* m_pThread;
+    std::atomic<std::thread::id> m_threadId;
+    bool m_bStopped;
+
+    // statistics, written by the dispatching thread only
+    std::atomic<mfxU32> m_nCallbacks;
+    std::atomic<mfxU32> m_nQueueFullWaits;
+    std::atomic<mfxU64> m_nCallbacksTime; // us
+    std::atomic<mfxU64> m_nCallbackMaxTime; // us
+
+private:
+    MFX_OMX_CLASS_NO_COPY(MfxOmxCallbackDispatcher)
+};
+
+#endif // #ifndef __MFX_OMX_CALLBACK_DISPATCHER_H__
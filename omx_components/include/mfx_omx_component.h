@@ -24,6 +24,9 @@
 #include "mfx_omx_utils.h"
 #include "mfx_omx_ports.h"
 #include "mfx_omx_buffers.h"
+#include "mfx_omx_callback_dispatcher.h"
+#include "mfx_omx_latency.h"
+#include "mfx_omx_recorder.h"
 
 /*------------------------------------------------------------------------------*/
 
@@ -78,6 +81,10 @@ enum MfxOmxExtensionIndex
     MfxOmx_IndexIntelDecodedOrder,                  // OMX.intel.index.decodedorder
     MfxOmx_IndexIntelDisableDeblockingIdc,          // OMX.intel.index.disabledeblockingidc
     MfxOmx_IndexIntelEnableSFC,                     // OMX.intel.android.index.enableSFC
+    MfxOmx_IndexIntelLatencyStats,                  // OMX.intel.index.latencystats
+    MfxOmx_IndexIntelRuntimeStats,                  // OMX.intel.index.runtimestats
+    MfxOmx_IndexIntelAsyncDepth,                    // OMX.intel.index.asyncdepth
+    MfxOmx_IndexIntelIdrRequest,                    // OMX.intel.index.idrrequest
 };
 
 inline bool operator==(MfxOmxExtensionIndex left, OMX_INDEXTYPE right)
@@ -143,6 +150,32 @@ struct MfxOmxComponentRegData
 
 /*------------------------------------------------------------------------------*/
 
+// counters updated from any component thread, see OMX_VIDEO_CONFIG_INTEL_RUNTIME_STATS
+struct MfxOmxComponentStats
+{
+    MfxOmxComponentStats(void):
+        nInputBuffers(0),
+        nOutputBuffers(0),
+        nProcessedFrames(0),
+        nDeviceBusy(0),
+        nResets(0),
+        nReinits(0),
+        nErrors(0),
+        nDrains(0)
+    {}
+
+    std::atomic<mfxU32> nInputBuffers;
+    std::atomic<mfxU32> nOutputBuffers;
+    std::atomic<mfxU32> nProcessedFrames;
+    std::atomic<mfxU32> nDeviceBusy;
+    std::atomic<mfxU32> nResets;
+    std::atomic<mfxU32> nReinits;
+    std::atomic<mfxU32> nErrors;
+    std::atomic<mfxU32> nDrains;
+};
+
+/*------------------------------------------------------------------------------*/
+
 class MfxOmxComponent
 {
     friend unsigned int MfxOmxComponent_MainThread(void* param);
@@ -206,6 +239,14 @@ public:
         OMX_OUT OMX_U8 *cRole,
         OMX_IN OMX_U32 nIndex);
 
+#if MFX_OMX_DEBUG_DUMP == MFX_OMX_YES
+    // returns NULL if client calls are not recorded
+    inline MfxOmxRecorder* GetRecorder(void) { return m_pRecorder; }
+#else
+    // recording is not built, so the hooks compile out
+    inline MfxOmxRecorder* GetRecorder(void) { return NULL; }
+#endif
+
 protected:
     MfxOmxComponent(
             OMX_HANDLETYPE self,
@@ -226,6 +267,8 @@ protected:
     virtual void AsyncThread(void) = 0;
     virtual OMX_ERRORTYPE InternalThreadsWait(void);
     virtual OMX_ERRORTYPE ValidateCommand(MfxOmxCommandData *command);
+    // returns true if command should wait for all sync operations to finish
+    virtual bool IsDrainingCommand(const MfxOmxCommandData& command);
     virtual OMX_ERRORTYPE ValidateConfig(
         OMX_U32 kind,
         OMX_INDEXTYPE nIndex,
@@ -233,8 +276,17 @@ protected:
         MfxOmxInputConfig & config) = 0;
 
     virtual mfxU16 GetAsyncDepth(void) = 0;
+    // fills codec specific part of runtime statistics
+    virtual void GetRuntimeStats(OMX_VIDEO_CONFIG_INTEL_RUNTIME_STATS* pStats) { MFX_OMX_UNUSED(pStats); }
 
 protected: // inlines
+    // counts the error in runtime statistics and reports it to the client
+    inline void SendErrorEvent(OMX_ERRORTYPE error)
+    {
+        ++m_Stats.nErrors;
+        m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, error, 0, NULL);
+    }
+
     inline bool IsPortValid(OMX_U32 nPortIndex)
     {
         if (nPortIndex >= m_pRegData->m_ports_num) return false;
@@ -290,11 +342,20 @@ protected: // variables
     OMX_HANDLETYPE m_self;
     OMX_CALLBACKTYPE* m_pCallbacks;
     OMX_PTR m_pAppData;
+    // if set, client callbacks are delivered from its thread
+    MfxOmxCallbackDispatcher* m_pCallbackDispatcher;
+    // per frame latency of processing stages
+    MfxOmxLatencyTracker m_Latency;
+    MfxOmxComponentStats m_Stats;
 
     MfxOmxComponentRegData* m_pRegData;
     MfxOmxPortData** m_pPorts;
     mfxStatus m_Error;
     OMX_U32 m_Flags;
+    // async depth set thru OMX.intel.index.asyncdepth, 0 if not forced
+    mfxU16 m_nForcedAsyncDepth;
+    // records client calls if enabled thru OMX.Intel.record.dir property
+    MfxOmxRecorder* m_pRecorder;
 
     OMX_PARAM_PORTDEFINITIONTYPE* m_pInPortDef;
     OMX_PARAM_PORTDEFINITIONTYPE* m_pOutPortDef;
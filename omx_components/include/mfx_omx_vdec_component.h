@@ -137,7 +137,10 @@ protected:
     OMX_ERRORTYPE CommandFlush(OMX_U32 nPortIndex);
 
     virtual mfxStatus InitCodec(void);
-    virtual mfxStatus ReinitCodec(void);
+    virtual mfxStatus ReinitCodec(MfxOmxHeadersChange change);
+    virtual mfxStatus QuerySurfacesNum(mfxVideoParam* pParams, MfxOmxStreamInfo* pInfo);
+    virtual void PreparseHeaders(void);
+    void SetPoolFrameSize(mfxVideoParam* pParams);
 
     virtual mfxStatus ResetInput(void);
     virtual mfxStatus ResetOutput(void);
@@ -146,6 +149,7 @@ protected:
     void CloseCodec(void);
     virtual bool CanDecode(void);
     virtual bool IsResolutionChanged(void);
+    virtual MfxOmxHeadersChange GetHeadersChange(mfxBitstream* pBitstream);
     virtual mfxStatus DecodeFrame(void);
 
     virtual bool CheckBitstream(const mfxBitstream *bs)
@@ -156,6 +160,7 @@ protected:
 
     virtual mfxStatus GetCurrentHeaders(mfxBitstream *pSPS, mfxBitstream *pPPS);
     virtual mfxU16 GetAsyncDepth(void);
+    virtual void GetRuntimeStats(OMX_VIDEO_CONFIG_INTEL_RUNTIME_STATS* pStats);
 
 #ifdef HEVC10HDR_SUPPORT
     void UpdateHdrStaticInfo();
@@ -163,7 +168,7 @@ protected:
 
 protected:
     mfxIMPL m_Implementation;
-    MFXVideoSession m_Session;
+    MfxOmxVideoSession m_Session;
     MFXVideoDECODE* m_pDEC;
     MfxOmxMutex m_decoderMutex;
     mfxVideoParam m_MfxVideoParams;
@@ -188,6 +193,7 @@ protected:
     bool m_bAllocateNativeHandle;
     bool m_bEnableNativeBuffersReceived;
     bool m_bInterlaced;
+    bool m_bHeadersPreparsed;
 
     MfxInitState m_InitState;
     MfxOmxDev* m_pDevice;
@@ -205,7 +211,12 @@ protected:
     mfxSyncPoint* m_pFreeSyncPoint;
 
     mfxU32 m_nLockedSurfacesNum;
-    mfxU32 m_nCountDecodedFrames;
+    // time of the last output flush (seek), 0 if first frame after it was already sent;
+    // set by the command thread and consumed by the async thread
+    std::atomic<mfxU64> m_nFlushStartTime;
+    // stream info of the last handled sequence header and counters of its changes
+    MfxOmxStreamInfo m_StreamInfo;
+    mfxU32 m_nHeadersChanges[MFX_OMX_HEADERS_CHANGE_NUM];
 
     MfxOmxColorAspectsWrapper m_colorAspects;
 
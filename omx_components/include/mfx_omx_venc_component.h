@@ -30,6 +30,20 @@
 
 /*------------------------------------------------------------------------------*/
 
+#define MFX_OMX_CODEC_DATA_MAX_SIZE 1536
+
+// classes of dynamic encoder configuration changes, ordered by the cost of handling
+enum MfxOmxEncParamsChange
+{
+    MFX_OMX_ENC_CHANGE_CTRL = 0,  // parameters are the same, per-frame control (if any) goes with the next frame
+    MFX_OMX_ENC_CHANGE_RESET,     // bitrate, HRD buffer or framerate: Reset continuing current sequence
+    MFX_OMX_ENC_CHANGE_RESET_IDR, // GOP, slices, references, layers, VUI: Reset starting new sequence
+    MFX_OMX_ENC_CHANGE_REINIT,    // rate control method, surface format, bigger resolution: Reset which may be rejected
+    MFX_OMX_ENC_CHANGE_NUM
+};
+
+/*------------------------------------------------------------------------------*/
+
 class MfxOmxVencComponent : public MfxOmxComponent,
                             public MfxOmxBuffersCallback<OMX_BUFFERHEADERTYPE>
 {
@@ -126,6 +140,8 @@ protected:
 
     mfxStatus InitEncoder(void);
     mfxStatus InitVPP(void);
+    MfxOmxEncParamsChange GetParamsChange(const MfxOmxVideoParamsWrapper& newParams);
+    mfxStatus ResetEncoder(MfxOmxVideoParamsWrapper* wrap, MfxOmxEncParamsChange change);
     mfxStatus ReinitCodec(MfxOmxVideoParamsWrapper* wrap);
     mfxStatus ResetInput(void);
     mfxStatus ResetOutput(void);
@@ -135,12 +151,14 @@ protected:
     mfxStatus ProcessBuffer(void);
     mfxStatus ProcessFrameEnc(bool bHandleEos = false);
     mfxStatus ProcessEOS(void);
+    mfxStatus UpdateCodecData(bool* pbChanged);
     mfxStatus SendCodecData(void);
 
     void CloseCodec(void);
     bool CanProcess(void);
 
     virtual mfxU16 GetAsyncDepth(void);
+    virtual void GetRuntimeStats(OMX_VIDEO_CONFIG_INTEL_RUNTIME_STATS* pStats);
 
     bool IsMiracastMode(void);
     bool IsChromecastMode(void);
@@ -161,16 +179,20 @@ protected:
     void SkipFrame(void);
 protected:
     mfxIMPL m_Implementation;
-    MFXVideoSession m_Session;
+    MfxOmxVideoSession m_Session;
     MFXVideoENCODE* m_pENC;
     MfxOmxMutex m_encoderMutex;
 
     MfxOmxVideoParamsWrapper m_OmxMfxVideoParams;
     MfxOmxVideoParamsWrapper m_OmxMfxVideoParamsNext;
+    // last parameters queued to the main thread, guarded by m_encoderMutex
+    MfxOmxVideoParamsWrapper* m_pLastQueuedParams;
     mfxVideoParam& m_MfxVideoParams;
 
     MfxOmxEncodeCtrlWrapper m_OmxMfxEncodeCtrl;
     mfxEncodeCtrl& m_MfxEncodeCtrl;
+    // per-frame controls, declared before their holders to be destroyed after them
+    MfxOmxEncodeCtrlPool m_EncodeCtrlPool;
 
     MfxOmxInputConfig m_NextConfig;
 
@@ -182,6 +204,11 @@ protected:
     bool m_bEosHandlingStarted;
     bool m_bEosHandlingFinished;
     bool m_bCodecDataSent;
+    // parameter sets of current encoder configuration
+    mfxU8 m_CodecData[MFX_OMX_CODEC_DATA_MAX_SIZE];
+    mfxU32 m_nCodecDataSize;
+    // size of NAL unit length prefix in output, 0 means Annex B start codes
+    mfxU32 m_nNalLengthSize;
     bool m_bVppDetermined;
     bool m_bSkipThisFrame;
     bool m_bEnableInternalSkip;
@@ -201,7 +228,11 @@ protected:
     mfxSyncPoint* m_pFreeSyncPoint;
 
     mfxU32 m_nEncoderInputSurfacesCount;
-    mfxU32 m_nEncoderOutputBitstreamsCount;
+    // read by GetConfig(runtimestats) from client thread
+    std::atomic<mfxU32> m_nParamsChanges[MFX_OMX_ENC_CHANGE_NUM];
+    mfxU32 m_nCoalescedConfigs;
+    mfxU32 m_nReservedEncodeCtrls;
+    mfxU32 m_nEncodeCtrlAllocations;
 
     MfxOmxColorAspectsWrapper m_colorAspects;
 
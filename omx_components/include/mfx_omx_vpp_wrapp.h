@@ -22,11 +22,10 @@
 #define __MFX_OMX_VPP_WRAPP_H__
 
 #include <stdio.h>
-#include <utility>
-#include <vector>
 
 #include "mfx_omx_defs.h"
 #include "mfx_omx_types.h"
+#include "mfx_omx_mock.h"
 
 /*------------------------------------------------------------------------------*/
 
@@ -45,11 +44,11 @@ enum MfxOmxConversion
 
 struct MfxOmxVppWrappParam
 {
-    MFXVideoSession   *session;
-    mfxFrameInfo      *frame_info;
-    mfxFrameAllocator *allocator;
+    MfxOmxVideoSession *session;
+    mfxFrameInfo       *frame_info;
+    mfxFrameAllocator  *allocator;
 
-    MfxOmxConversion   conversion;
+    MfxOmxConversion    conversion;
 };
 
 /*------------------------------------------------------------------------------*/
@@ -68,11 +67,12 @@ public:
 protected:
     mfxStatus FillVppParams(mfxFrameInfo *frame_info, MfxOmxConversion conversion);
     mfxStatus AllocateOneSurface(void);
+    void ReleaseEncodeCtrls(void);
 
     mfxStatus DumpSurface(mfxFrameSurface1 *surface, FILE *file);
 
     MFXVideoVPP *m_pVPP;
-    MFXVideoSession *m_session;
+    MfxOmxVideoSession *m_session;
     mfxVideoParam m_vppParam;
     mfxFrameAllocator m_allocator;
 
@@ -80,8 +80,8 @@ protected:
     mfxFrameSurface1 m_vppSrf[VPP_MAX_SRF_NUM];
     mfxU32 m_numVppSurfaces;
 
-    typedef std::pair<MfxOmxEncodeCtrlWrapper*, mfxFrameSurface1*> EncodeCtrlPair;
-    std::vector<EncodeCtrlPair> m_EncodeCtrls;
+    // encode controls of surfaces in m_vppSrf, released when surface is unlocked
+    MfxOmxEncodeCtrlWrapper* m_EncodeCtrls[VPP_MAX_SRF_NUM];
 
     // debug file
     FILE* m_dbg_vppout;
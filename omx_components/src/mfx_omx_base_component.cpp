@@ -224,6 +224,26 @@ const ext_index gExtIndexParams[] = {
       (char*)"OMX.intel.android.index.enableSFC",
       static_cast<OMX_INDEXTYPE>(MfxOmx_IndexIntelEnableSFC),
       OMX_ErrorNone
+    },
+    {
+      (char*)"OMX.intel.index.latencystats",
+      static_cast<OMX_INDEXTYPE>(MfxOmx_IndexIntelLatencyStats),
+      OMX_ErrorNone
+    },
+    {
+      (char*)"OMX.intel.index.runtimestats",
+      static_cast<OMX_INDEXTYPE>(MfxOmx_IndexIntelRuntimeStats),
+      OMX_ErrorNone
+    },
+    {
+      (char*)"OMX.intel.index.asyncdepth",
+      static_cast<OMX_INDEXTYPE>(MfxOmx_IndexIntelAsyncDepth),
+      OMX_ErrorNone
+    },
+    {
+      (char*)"OMX.intel.index.idrrequest",
+      static_cast<OMX_INDEXTYPE>(MfxOmx_IndexIntelIdrRequest),
+      OMX_ErrorNone
     }
 };
 
@@ -312,9 +332,13 @@ OMX_ERRORTYPE MFX_OMX_SendCommand(
 
         if (pComponent)
         {
+            MfxOmxRecorder* pRecorder = pComponent->GetRecorder();
+            MfxOmxRecordHeader* pRecord = pRecorder ? pRecorder->BeginCommand(Cmd, nParam) : NULL;
+
             MFX_OMX_TRY_AND_CATCH(
               omx_res = pComponent->SendCommand(Cmd, nParam, pCmdData),
               omx_res = OMX_ErrorUndefined);
+            if (pRecord) pRecorder->Commit(pRecord, omx_res);
         }
         else omx_res = OMX_ErrorInvalidComponent;
     }
@@ -352,9 +376,13 @@ OMX_ERRORTYPE MFX_OMX_GetParameter(
 
         if (pComponent)
         {
+            MfxOmxRecorder* pRecorder = pComponent->GetRecorder();
+            MfxOmxRecordHeader* pRecord = pRecorder ? pRecorder->BeginStruct(MFX_OMX_RECORD_GET_PARAMETER, nParamIndex, pComponentParameterStructure) : NULL;
+
             MFX_OMX_TRY_AND_CATCH(
               omx_res = pComponent->GetParameter(nParamIndex, pComponentParameterStructure),
               omx_res = OMX_ErrorUndefined);
+            if (pRecord) pRecorder->Commit(pRecord, omx_res);
         }
         else omx_res = OMX_ErrorInvalidComponent;
     }
@@ -392,9 +420,13 @@ OMX_ERRORTYPE MFX_OMX_SetParameter(
 
         if (pComponent)
         {
+            MfxOmxRecorder* pRecorder = pComponent->GetRecorder();
+            MfxOmxRecordHeader* pRecord = pRecorder ? pRecorder->BeginStruct(MFX_OMX_RECORD_SET_PARAMETER, nParamIndex, pComponentParameterStructure) : NULL;
+
             MFX_OMX_TRY_AND_CATCH(
               omx_res = pComponent->SetParameter(nParamIndex, pComponentParameterStructure),
               omx_res = OMX_ErrorUndefined);
+            if (pRecord) pRecorder->Commit(pRecord, omx_res);
         }
         else omx_res = OMX_ErrorInvalidComponent;
     }
@@ -432,9 +464,13 @@ OMX_ERRORTYPE MFX_OMX_GetConfig(
 
         if (pComponent)
         {
+            MfxOmxRecorder* pRecorder = pComponent->GetRecorder();
+            MfxOmxRecordHeader* pRecord = pRecorder ? pRecorder->BeginStruct(MFX_OMX_RECORD_GET_CONFIG, nIndex, pComponentConfigStructure) : NULL;
+
             MFX_OMX_TRY_AND_CATCH(
               omx_res = pComponent->GetConfig(nIndex, pComponentConfigStructure),
               omx_res = OMX_ErrorUndefined);
+            if (pRecord) pRecorder->Commit(pRecord, omx_res);
         }
         else omx_res = OMX_ErrorInvalidComponent;
     }
@@ -472,9 +508,13 @@ OMX_ERRORTYPE MFX_OMX_SetConfig(
 
         if (pComponent)
         {
+            MfxOmxRecorder* pRecorder = pComponent->GetRecorder();
+            MfxOmxRecordHeader* pRecord = pRecorder ? pRecorder->BeginStruct(MFX_OMX_RECORD_SET_CONFIG, nIndex, pComponentConfigStructure) : NULL;
+
             MFX_OMX_TRY_AND_CATCH(
               omx_res = pComponent->SetConfig(nIndex, pComponentConfigStructure),
               omx_res = OMX_ErrorUndefined);
+            if (pRecord) pRecorder->Commit(pRecord, omx_res);
         }
         else omx_res = OMX_ErrorInvalidComponent;
     }
@@ -513,6 +553,14 @@ OMX_ERRORTYPE MFX_OMX_GetExtensionIndex(
             }
         }
         if (!bIsFound) omx_res = OMX_ErrorUnsupportedIndex;
+
+        MfxOmxComponent* pComponent = (MfxOmxComponent*)omx_component->pComponentPrivate;
+        MfxOmxRecorder* pRecorder = pComponent ? pComponent->GetRecorder() : NULL;
+
+        if (pRecorder)
+        {
+            pRecorder->RecordExtensionIndex(cParameterName, bIsFound ? *pIndexType : OMX_IndexComponentStartUnused, omx_res);
+        }
     }
     MFX_OMX_AUTO_TRACE_MSG(cParameterName);
     MFX_OMX_AUTO_TRACE_U32(*pIndexType);
@@ -613,9 +661,14 @@ OMX_ERRORTYPE MFX_OMX_UseBuffer(
 
         if (pComponent)
         {
+            MfxOmxRecorder* pRecorder = pComponent->GetRecorder();
+            MfxOmxRecordHeader* pRecord = pRecorder ? pRecorder->BeginBuffer(MFX_OMX_RECORD_USE_BUFFER, nPortIndex, nSizeBytes, NULL) : NULL;
+
             MFX_OMX_TRY_AND_CATCH(
               omx_res = pComponent->DealWithBuffer(ppBufferHdr, nPortIndex, pAppPrivate, nSizeBytes, pBuffer),
               omx_res = OMX_ErrorUndefined);
+            if (pRecord && (OMX_ErrorNone == omx_res) && ppBufferHdr) pRecorder->SetBuffer(pRecord, *ppBufferHdr);
+            if (pRecord) pRecorder->Commit(pRecord, omx_res);
         }
         else omx_res = OMX_ErrorInvalidComponent;
     }
@@ -655,9 +708,14 @@ OMX_ERRORTYPE MFX_OMX_AllocateBuffer(
 
         if (pComponent)
         {
+            MfxOmxRecorder* pRecorder = pComponent->GetRecorder();
+            MfxOmxRecordHeader* pRecord = pRecorder ? pRecorder->BeginBuffer(MFX_OMX_RECORD_ALLOCATE_BUFFER, nPortIndex, nSizeBytes, NULL) : NULL;
+
             MFX_OMX_TRY_AND_CATCH(
               omx_res = pComponent->DealWithBuffer(ppBufferHdr, nPortIndex, pAppPrivate, nSizeBytes, NULL),
               omx_res = OMX_ErrorUndefined);
+            if (pRecord && (OMX_ErrorNone == omx_res) && ppBufferHdr) pRecorder->SetBuffer(pRecord, *ppBufferHdr);
+            if (pRecord) pRecorder->Commit(pRecord, omx_res);
         }
         else omx_res = OMX_ErrorInvalidComponent;
     }
@@ -695,9 +753,13 @@ OMX_ERRORTYPE MFX_OMX_FreeBuffer(
 
         if (pComponent)
         {
+            MfxOmxRecorder* pRecorder = pComponent->GetRecorder();
+            MfxOmxRecordHeader* pRecord = pRecorder ? pRecorder->BeginBuffer(MFX_OMX_RECORD_FREE_BUFFER, nPortIndex, 0, pBuffer) : NULL;
+
             MFX_OMX_TRY_AND_CATCH(
               omx_res = pComponent->FreeBuffer(nPortIndex, pBuffer),
               omx_res = OMX_ErrorUndefined);
+            if (pRecord) pRecorder->Commit(pRecord, omx_res);
         }
         else omx_res = OMX_ErrorInvalidComponent;
     }
@@ -734,9 +796,13 @@ OMX_ERRORTYPE MFX_OMX_EmptyThisBuffer(
 
         if (pComponent)
         {
+            MfxOmxRecorder* pRecorder = pComponent->GetRecorder();
+            MfxOmxRecordHeader* pRecord = pRecorder ? pRecorder->BeginEmptyThisBuffer(pBuffer) : NULL;
+
             MFX_OMX_TRY_AND_CATCH(
               omx_res = pComponent->EmptyThisBuffer(pBuffer),
               omx_res = OMX_ErrorUndefined);
+            if (pRecord) pRecorder->Commit(pRecord, omx_res);
         }
         else omx_res = OMX_ErrorInvalidComponent;
     }
@@ -773,9 +839,13 @@ OMX_ERRORTYPE MFX_OMX_FillThisBuffer(
 
         if (pComponent)
         {
+            MfxOmxRecorder* pRecorder = pComponent->GetRecorder();
+            MfxOmxRecordHeader* pRecord = pRecorder ? pRecorder->BeginBuffer(MFX_OMX_RECORD_FILL_THIS_BUFFER, pBuffer ? pBuffer->nOutputPortIndex : 0, 0, pBuffer) : NULL;
+
             MFX_OMX_TRY_AND_CATCH(
               omx_res = pComponent->FillThisBuffer(pBuffer),
               omx_res = OMX_ErrorUndefined);
+            if (pRecord) pRecorder->Commit(pRecord, omx_res);
         }
         else omx_res = OMX_ErrorInvalidComponent;
     }
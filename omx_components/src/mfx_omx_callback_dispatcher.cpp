@@ -0,0 +1,242 @@
+// Copyright (c) 2014-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mfx_omx_callback_dispatcher.h"
+
+/*------------------------------------------------------------------------------*/
+
+#undef MFX_OMX_MODULE_NAME
+#define MFX_OMX_MODULE_NAME "mfx_omx_callback_dispatcher"
+
+/*------------------------------------------------------------------------------*/
+
+unsigned int MfxOmxCallbackDispatcher_Thread(void* param)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    unsigned int res = 0;
+    MfxOmxCallbackDispatcher* pDispatcher = (MfxOmxCallbackDispatcher*) param;
+
+    if (pDispatcher) pDispatcher->Thread();
+    else res = 1;
+    return res;
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxCallbackDispatcher::MfxOmxCallbackDispatcher(mfxStatus &sts):
+    m_pClientCallbacks(NULL),
+    m_pClientAppData(NULL),
+    m_queue(MFX_OMX_CALLBACK_QUEUE_SIZE),
+    m_semaphore(0, "callback_dispatcher"),
+    m_freeSlots(m_queue.GetSize(), "callback_dispatcher_slots"),
+    m_pThread(NULL),
+    m_bStopped(false),
+    m_nCallbacks(0),
+    m_nQueueFullWaits(0),
+    m_nCallbacksTime(0),
+    m_nCallbackMaxTime(0)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+
+    m_Callbacks.EventHandler = EventHandler;
+    m_Callbacks.EmptyBufferDone = EmptyBufferDone;
+    m_Callbacks.FillBufferDone = FillBufferDone;
+
+    sts = MFX_ERR_NONE;
+    if (!m_queue.GetSize()) sts = MFX_ERR_MEMORY_ALLOC;
+    if (MFX_ERR_NONE == sts)
+    {
+        MFX_OMX_NEW(m_pThread, MfxOmxThread(MfxOmxCallbackDispatcher_Thread, this));
+        if (!m_pThread) sts = MFX_ERR_MEMORY_ALLOC;
+    }
+    MFX_OMX_AUTO_TRACE_I32(sts);
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxCallbackDispatcher::~MfxOmxCallbackDispatcher(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+
+    if (m_pThread)
+    {
+        MfxOmxCallbackData data;
+        MFX_OMX_ZERO_MEMORY(data);
+        data.type = MfxOmxCallbackData::MfxOmx_Callback_Stop;
+        Queue(data);
+
+        m_pThread->Wait();
+        MFX_OMX_DELETE(m_pThread);
+    }
+    MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Callbacks: %d, average time %lld us, max time %lld us, queue full waits %d",
+                        GetCallbacksCount(), GetCallbackMeanTime(),
+                        GetCallbackMaxTime(), GetQueueFullWaits());
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxU64 MfxOmxCallbackDispatcher::GetCallbackMeanTime(void) const
+{
+    mfxU32 count = m_nCallbacks.load();
+
+    return count ? m_nCallbacksTime.load() / count : 0;
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxCallbackDispatcher::SetCallbacks(
+    OMX_CALLBACKTYPE* pCallbacks, OMX_PTR pAppData,
+    OMX_CALLBACKTYPE** ppCallbacks, OMX_PTR* ppAppData)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+
+    m_pClientCallbacks = pCallbacks;
+    m_pClientAppData = pAppData;
+    // dispatcher itself is passed to the callbacks as application data
+    *ppCallbacks = &m_Callbacks;
+    *ppAppData = this;
+}
+
+/*------------------------------------------------------------------------------*/
+
+OMX_ERRORTYPE MfxOmxCallbackDispatcher::EventHandler(
+    OMX_HANDLETYPE hComponent, OMX_PTR pAppData, OMX_EVENTTYPE eEvent,
+    OMX_U32 nData1, OMX_U32 nData2, OMX_PTR pEventData)
+{
+    MfxOmxCallbackData data;
+    MFX_OMX_ZERO_MEMORY(data);
+
+    data.type = MfxOmxCallbackData::MfxOmx_Callback_Event;
+    data.hComponent = hComponent;
+    data.eEvent = eEvent;
+    data.nData1 = nData1;
+    data.nData2 = nData2;
+    data.pEventData = pEventData;
+    ((MfxOmxCallbackDispatcher*)pAppData)->Queue(data);
+    return OMX_ErrorNone;
+}
+
+/*------------------------------------------------------------------------------*/
+
+OMX_ERRORTYPE MfxOmxCallbackDispatcher::EmptyBufferDone(
+    OMX_HANDLETYPE hComponent, OMX_PTR pAppData, OMX_BUFFERHEADERTYPE* pBuffer)
+{
+    MfxOmxCallbackData data;
+    MFX_OMX_ZERO_MEMORY(data);
+
+    data.type = MfxOmxCallbackData::MfxOmx_Callback_EmptyBufferDone;
+    data.hComponent = hComponent;
+    data.pBuffer = pBuffer;
+    ((MfxOmxCallbackDispatcher*)pAppData)->Queue(data);
+    return OMX_ErrorNone;
+}
+
+/*------------------------------------------------------------------------------*/
+
+OMX_ERRORTYPE MfxOmxCallbackDispatcher::FillBufferDone(
+    OMX_HANDLETYPE hComponent, OMX_PTR pAppData, OMX_BUFFERHEADERTYPE* pBuffer)
+{
+    MfxOmxCallbackData data;
+    MFX_OMX_ZERO_MEMORY(data);
+
+    data.type = MfxOmxCallbackData::MfxOmx_Callback_FillBufferDone;
+    data.hComponent = hComponent;
+    data.pBuffer = pBuffer;
+    ((MfxOmxCallbackDispatcher*)pAppData)->Queue(data);
+    return OMX_ErrorNone;
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxCallbackDispatcher::Queue(const MfxOmxCallbackData& data)
+{
+    if (std::this_thread::get_id() == m_threadId)
+    {
+        // client called component from the callback: waiting for the full
+        // queue would wait for ourselves
+        MFX_OMX_TRY_AND_CATCH(m_nested.push_back(data), return);
+    }
+    else
+    {
+        if (!m_freeSlots.Try())
+        {
+            ++m_nQueueFullWaits;
+            m_freeSlots.Wait();
+        }
+        // slot is reserved, so the ring has room
+        m_queue.Add(data);
+    }
+    m_semaphore.Post();
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxCallbackDispatcher::Deliver(void)
+{
+    MfxOmxCallbackData data;
+
+    if (!m_nested.empty())
+    {
+        data = m_nested.front();
+        m_nested.pop_front();
+    }
+    else if (m_queue.Get(data)) m_freeSlots.Post();
+    else return false;
+
+    mfxU64 start = mfx_omx_get_time_us();
+    switch (data.type)
+    {
+    case MfxOmxCallbackData::MfxOmx_Callback_Event:
+        m_pClientCallbacks->EventHandler(data.hComponent, m_pClientAppData, data.eEvent,
+                                         data.nData1, data.nData2, data.pEventData);
+        break;
+    case MfxOmxCallbackData::MfxOmx_Callback_EmptyBufferDone:
+        m_pClientCallbacks->EmptyBufferDone(data.hComponent, m_pClientAppData, data.pBuffer);
+        break;
+    case MfxOmxCallbackData::MfxOmx_Callback_FillBufferDone:
+        m_pClientCallbacks->FillBufferDone(data.hComponent, m_pClientAppData, data.pBuffer);
+        break;
+    case MfxOmxCallbackData::MfxOmx_Callback_Stop:
+        m_bStopped = true;
+        return true;
+    default:
+        return true;
+    }
+    mfxU64 time = mfx_omx_get_time_us() - start;
+
+    m_nCallbacksTime += time;
+    ++m_nCallbacks;
+    if (time > m_nCallbackMaxTime.load()) m_nCallbackMaxTime = time;
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxCallbackDispatcher::Thread(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+
+    m_threadId = std::this_thread::get_id();
+    while (!m_bStopped)
+    {
+        m_semaphore.Wait();
+        Deliver();
+    }
+}
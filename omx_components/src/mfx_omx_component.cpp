@@ -22,6 +22,7 @@
 #include "mfx_omx_component.h"
 #include "mfx_omx_vdec_component.h"
 #include "mfx_omx_venc_component.h"
+#include "mfx_omx_lock_stats.h"
 #include <cutils/properties.h>
 
 /*------------------------------------------------------------------------------*/
@@ -129,16 +130,20 @@ MfxOmxComponent::MfxOmxComponent(OMX_HANDLETYPE self,
     : m_self(self)
     , m_pCallbacks(NULL)
     , m_pAppData(NULL)
+    , m_pCallbackDispatcher(NULL)
     , m_pRegData(NULL)
     , m_pPorts(NULL)
     , m_Error(MFX_ERR_NONE)
     , m_Flags(flags)
+    , m_nForcedAsyncDepth(0)
+    , m_pRecorder(NULL)
     , m_pInPortDef(NULL)
     , m_pOutPortDef(NULL)
     , m_pInPortInfo(NULL)
     , m_pOutPortInfo(NULL)
     , m_state(OMX_StateLoaded)
     , m_state_to_set(OMX_StateLoaded)
+    , m_mutex("component")
     , m_bDestroy(false)
     , m_bTransition(false)
     , m_bOnFlySurfacesAllocation(false)
@@ -181,29 +186,37 @@ MfxOmxComponent::MfxOmxComponent(OMX_ERRORTYPE &error,
     }
     if (OMX_ErrorNone == error)
     {
-        MFX_OMX_NEW(m_pCommandsSemaphore, MfxOmxSemaphore());
+        MFX_OMX_NEW(m_pCommandsSemaphore, MfxOmxSemaphore(0, "commands"));
         if (!m_pCommandsSemaphore) error = OMX_ErrorInsufficientResources;
     }
     if (OMX_ErrorNone == error)
     {
-        MFX_OMX_NEW(m_pAsyncSemaphore, MfxOmxSemaphore());
+        MFX_OMX_NEW(m_pAsyncSemaphore, MfxOmxSemaphore(0, "async"));
         if (!m_pAsyncSemaphore) error = OMX_ErrorInsufficientResources;
     }
     if (OMX_ErrorNone == error)
     {
-        MFX_OMX_NEW(m_pAllSyncOpFinished, MfxOmxEvent(true, true));
+        MFX_OMX_NEW(m_pAllSyncOpFinished, MfxOmxEvent(true, true, "all_sync_op_finished"));
         if (!m_pAllSyncOpFinished) error = OMX_ErrorInsufficientResources;
     }
     if (OMX_ErrorNone == error)
     {
-        MFX_OMX_NEW(m_pStateTransitionEvent, MfxOmxEvent(false, false));
+        MFX_OMX_NEW(m_pStateTransitionEvent, MfxOmxEvent(false, false, "state_transition"));
         if (!m_pStateTransitionEvent) error = OMX_ErrorInsufficientResources;
     }
     if (OMX_ErrorNone == error)
     {
-        MFX_OMX_NEW(m_pDevBusyEvent, MfxOmxEvent(false, false));
+        MFX_OMX_NEW(m_pDevBusyEvent, MfxOmxEvent(false, false, "dev_busy"));
         if (!m_pDevBusyEvent) error = OMX_ErrorInsufficientResources;
     }
+    if ((OMX_ErrorNone == error) && (MFX_OMX_COMPONENT_FLAGS_CALLBACK_THREAD & m_Flags))
+    {
+        mfxStatus sts = MFX_ERR_NONE;
+
+        MFX_OMX_NEW(m_pCallbackDispatcher, MfxOmxCallbackDispatcher(sts));
+        if (m_pCallbackDispatcher && (MFX_ERR_NONE != sts)) MFX_OMX_DELETE(m_pCallbackDispatcher);
+        if (!m_pCallbackDispatcher) error = OMX_ErrorInsufficientResources;
+    }
 
     g_OmxLogLevel = 0;
     char value[128];
@@ -213,6 +226,11 @@ MfxOmxComponent::MfxOmxComponent(OMX_ERRORTYPE &error,
     }
     MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Debug logs are enabled");
 
+    if ((OMX_ErrorNone == error) && m_pRegData)
+    {
+        m_pRecorder = MfxOmxRecorder::Create(m_pRegData->m_name);
+    }
+
     MFX_OMX_AUTO_TRACE_U32(error);
 }
 
@@ -223,6 +241,12 @@ MfxOmxComponent::~MfxOmxComponent(void)
     MFX_OMX_AUTO_TRACE_FUNC();
     MFX_OMX_AUTO_TRACE_I32(m_state);
 
+    if (m_pRegData) m_Latency.Dump(m_pRegData->m_name);
+#if (MFX_OMX_DEBUG == MFX_OMX_YES) && (MFX_OMX_DEBUG_TRACE_RING == MFX_OMX_YES)
+    mfx_omx_trace_export(MFX_OMX_TRACE_FILE_NAME);
+#endif
+    // delivers callbacks issued while the component was destroyed
+    MFX_OMX_DELETE(m_pCallbackDispatcher);
     MFX_OMX_DELETE(m_pMainThread);
     MFX_OMX_DELETE(m_pCommandsSemaphore);
     MFX_OMX_DELETE(m_pStateTransitionEvent);
@@ -230,6 +254,7 @@ MfxOmxComponent::~MfxOmxComponent(void)
     MFX_OMX_DELETE(m_pAsyncThread);
     MFX_OMX_DELETE(m_pAsyncSemaphore);
     MFX_OMX_DELETE(m_pAllSyncOpFinished);
+    MFX_OMX_DELETE(m_pRecorder);
 
     if (m_pPorts && m_pRegData)
     {
@@ -239,6 +264,10 @@ MfxOmxComponent::~MfxOmxComponent(void)
         }
     }
     MFX_OMX_FREE(m_pPorts);
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    // statistics are cumulative for all components created in the process
+    mfx_omx_lock_stats_dump("components");
+#endif
 }
 
 /*------------------------------------------------------------------------------*/
@@ -377,6 +406,43 @@ OMX_ERRORTYPE MfxOmxComponent::ValidateCommand(MfxOmxCommandData *command)
 
 /*------------------------------------------------------------------------------*/
 
+/* Only commands which release buffers being processed need all sync operations
+ * to be finished: flush, transition to Idle from active state and disabling of
+ * enabled port while component is active. Others are handled right away.
+ */
+bool MfxOmxComponent::IsDrainingCommand(const MfxOmxCommandData& command)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    bool bActive = (OMX_StateExecuting == m_state) || (OMX_StatePause == m_state);
+    bool bDraining = false;
+
+    switch (command.m_command)
+    {
+    case OMX_CommandFlush:
+        bDraining = true;
+        break;
+    case OMX_CommandStateSet:
+        bDraining = bActive && ((OMX_StateIdle == command.m_new_state) || (OMX_StateInvalid == command.m_new_state));
+        break;
+    case OMX_CommandPortDisable:
+        if (OMX_ALL == command.m_port_number)
+        {
+            for (mfxU32 i = 0; i < m_pRegData->m_ports_num; ++i)
+            {
+                if (IsPortEnabled(i)) bDraining = bActive;
+            }
+        }
+        else bDraining = bActive && IsPortValid(command.m_port_number) && IsPortEnabled(command.m_port_number);
+        break;
+    default:
+        break;
+    }
+    MFX_OMX_AUTO_TRACE_I32(bDraining);
+    return bDraining;
+}
+
+/*------------------------------------------------------------------------------*/
+
 OMX_ERRORTYPE MfxOmxComponent::SendCommand(
     OMX_IN OMX_COMMANDTYPE Cmd,
     OMX_IN OMX_U32 nParam,
@@ -468,7 +534,7 @@ OMX_ERRORTYPE MfxOmxComponent::GetParameter(
     // filling the requested structure
     if (OMX_ErrorNone == omx_res)
     {
-        switch (nParamIndex)
+        switch (static_cast<int>(nParamIndex))
         {
         case OMX_IndexParamVideoInit:
             {
@@ -523,6 +589,18 @@ OMX_ERRORTYPE MfxOmxComponent::GetParameter(
                 else omx_res = OMX_ErrorVersionMismatch;
             }
             break;
+        case MfxOmx_IndexIntelAsyncDepth:
+            {
+                MFX_OMX_AUTO_TRACE_MSG("MfxOmx_IndexIntelAsyncDepth");
+                OMX_VIDEO_PARAM_INTEL_ASYNC_DEPTH* pParam = (OMX_VIDEO_PARAM_INTEL_ASYNC_DEPTH*)pComponentParameterStructure;
+
+                if (IsStructVersionValid<OMX_VIDEO_PARAM_INTEL_ASYNC_DEPTH>(pParam, sizeof(OMX_VIDEO_PARAM_INTEL_ASYNC_DEPTH), OMX_VERSION))
+                {
+                    pParam->nAsyncDepth = m_nForcedAsyncDepth;
+                }
+                else omx_res = OMX_ErrorVersionMismatch;
+            }
+            break;
         default:
             MFX_OMX_AUTO_TRACE_MSG("unknown nParamIndex");
             omx_res = OMX_ErrorUnsupportedIndex;
@@ -560,7 +638,7 @@ OMX_ERRORTYPE MfxOmxComponent::SetParameter(
     // filling the requested structure
     if (OMX_ErrorNone == omx_res)
     {
-        switch (nParamIndex)
+        switch (static_cast<int>(nParamIndex))
         {
         case OMX_IndexParamPortDefinition:
             {
@@ -615,6 +693,22 @@ OMX_ERRORTYPE MfxOmxComponent::SetParameter(
                 else omx_res = OMX_ErrorVersionMismatch;
             }
             break;
+        case MfxOmx_IndexIntelAsyncDepth:
+            {
+                MFX_OMX_AUTO_TRACE_MSG("MfxOmx_IndexIntelAsyncDepth");
+                OMX_VIDEO_PARAM_INTEL_ASYNC_DEPTH* pParam = (OMX_VIDEO_PARAM_INTEL_ASYNC_DEPTH*)pComponentParameterStructure;
+
+                if (IsStructVersionValid<OMX_VIDEO_PARAM_INTEL_ASYNC_DEPTH>(pParam, sizeof(OMX_VIDEO_PARAM_INTEL_ASYNC_DEPTH), OMX_VERSION))
+                {
+                    MFX_OMX_AUTO_TRACE_I32(pParam->nAsyncDepth);
+                    // codec is initialized on loaded to idle transition with this value
+                    if (OMX_StateLoaded != m_state) omx_res = OMX_ErrorIncorrectStateOperation;
+                    else if (pParam->nAsyncDepth > OMX_VIDEO_INTEL_MAX_ASYNC_DEPTH) omx_res = OMX_ErrorBadParameter;
+                    else m_nForcedAsyncDepth = (mfxU16)pParam->nAsyncDepth;
+                }
+                else omx_res = OMX_ErrorVersionMismatch;
+            }
+            break;
         default:
             MFX_OMX_AUTO_TRACE_MSG("unknown nParamIndex");
             omx_res = OMX_ErrorUnsupportedIndex;
@@ -648,8 +742,74 @@ OMX_ERRORTYPE MfxOmxComponent::GetConfig(
     // filling the requested structure
     if (OMX_ErrorNone == omx_res)
     {
-        switch (nIndex)
+        switch (static_cast<int>(nIndex))
         {
+        case MfxOmx_IndexIntelLatencyStats:
+            {
+                MFX_OMX_AUTO_TRACE_MSG("MfxOmx_IndexIntelLatencyStats");
+                OMX_VIDEO_CONFIG_INTEL_LATENCY_STATS* pParam = static_cast<OMX_VIDEO_CONFIG_INTEL_LATENCY_STATS*>(pComponentConfigStructure);
+                if (!IsStructVersionValid<OMX_VIDEO_CONFIG_INTEL_LATENCY_STATS>(pParam, sizeof(OMX_VIDEO_CONFIG_INTEL_LATENCY_STATS), OMX_VERSION))
+                    omx_res = OMX_ErrorVersionMismatch;
+                else if (!IsPortValid(pParam->nPortIndex))
+                    omx_res = OMX_ErrorBadPortIndex;
+                else if ((mfxU32)pParam->eStage >= MFX_OMX_LATENCY_STAGE_NUM)
+                    omx_res = OMX_ErrorBadParameter;
+                else
+                {
+                    const MfxOmxLatencyHistogram& h = m_Latency.GetHistogram((MfxOmxLatencyStage)pParam->eStage);
+                    pParam->nFrames = h.GetCount();
+                    pParam->nMean = (OMX_U32)h.GetMean();
+                    pParam->nMin = (OMX_U32)h.GetMin();
+                    pParam->nMax = (OMX_U32)h.GetMax();
+                    pParam->nP50 = (OMX_U32)h.GetPercentile(50);
+                    pParam->nP90 = (OMX_U32)h.GetPercentile(90);
+                    pParam->nP99 = (OMX_U32)h.GetPercentile(99);
+                }
+            }
+            break;
+        case MfxOmx_IndexIntelRuntimeStats:
+            {
+                MFX_OMX_AUTO_TRACE_MSG("MfxOmx_IndexIntelRuntimeStats");
+                OMX_VIDEO_CONFIG_INTEL_RUNTIME_STATS* pParam = static_cast<OMX_VIDEO_CONFIG_INTEL_RUNTIME_STATS*>(pComponentConfigStructure);
+                if ((pParam->nSize < OMX_VIDEO_INTEL_RUNTIME_STATS_V1_SIZE) ||
+                    !IsStructVersionValid<OMX_VIDEO_CONFIG_INTEL_RUNTIME_STATS>(pParam, pParam->nSize, OMX_VERSION))
+                    omx_res = OMX_ErrorVersionMismatch;
+                else if (!IsPortValid(pParam->nPortIndex))
+                    omx_res = OMX_ErrorBadPortIndex;
+                else
+                {
+                    OMX_VIDEO_CONFIG_INTEL_RUNTIME_STATS stats;
+
+                    MFX_OMX_ZERO_MEMORY(stats);
+                    stats.nSize = pParam->nSize;
+                    stats.nVersion = pParam->nVersion;
+                    stats.nPortIndex = pParam->nPortIndex;
+                    if (pParam->nSize >= OMX_VIDEO_INTEL_RUNTIME_STATS_V3_SIZE) stats.nStatsVersion = 3;
+                    else if (pParam->nSize >= OMX_VIDEO_INTEL_RUNTIME_STATS_V2_SIZE) stats.nStatsVersion = 2;
+                    else stats.nStatsVersion = 1;
+                    stats.nInputBuffers = m_Stats.nInputBuffers;
+                    stats.nOutputBuffers = m_Stats.nOutputBuffers;
+                    stats.nProcessedFrames = m_Stats.nProcessedFrames;
+                    stats.nDeviceBusy = m_Stats.nDeviceBusy;
+                    stats.nResets = m_Stats.nResets;
+                    stats.nReinits = m_Stats.nReinits;
+                    stats.nErrors = m_Stats.nErrors;
+                    stats.nDrains = m_Stats.nDrains;
+                    if (m_pCallbackDispatcher)
+                    {
+                        stats.nCallbacks = m_pCallbackDispatcher->GetCallbacksCount();
+                        stats.nCallbackMeanTime = (OMX_U32)m_pCallbackDispatcher->GetCallbackMeanTime();
+                        stats.nCallbackMaxTime = (OMX_U32)m_pCallbackDispatcher->GetCallbackMaxTime();
+                        stats.nCallbackQueueWaits = m_pCallbackDispatcher->GetQueueFullWaits();
+                    }
+                    GetRuntimeStats(&stats);
+
+                    // clients built against an older version get only the fields they know
+                    const OMX_U8* pData = reinterpret_cast<const OMX_U8*>(&stats);
+                    std::copy(pData, pData + MFX_OMX_MIN(pParam->nSize, sizeof(stats)), reinterpret_cast<OMX_U8*>(pParam));
+                }
+            }
+            break;
         default:
             MFX_OMX_AUTO_TRACE_MSG("unknown nParamIndex");
             omx_res = OMX_ErrorUnsupportedIndex;
@@ -990,6 +1150,7 @@ OMX_ERRORTYPE MfxOmxComponent::EmptyThisBuffer(
     {
         omx_res = OMX_ErrorBadPortIndex;
     }
+    if (OMX_ErrorNone == omx_res) ++m_Stats.nInputBuffers;
     MFX_OMX_AUTO_TRACE_U32(omx_res);
     return omx_res;
 }
@@ -1040,8 +1201,13 @@ OMX_ERRORTYPE MfxOmxComponent::SetCallbacks(
     // setting callbacks information
     if (OMX_ErrorNone == omx_res)
     {
-        m_pCallbacks = pCallbacks;
-        m_pAppData = pAppData;
+        if (m_pCallbackDispatcher)
+            m_pCallbackDispatcher->SetCallbacks(pCallbacks, pAppData, &m_pCallbacks, &m_pAppData);
+        else
+        {
+            m_pCallbacks = pCallbacks;
+            m_pAppData = pAppData;
+        }
     }
     MFX_OMX_AUTO_TRACE_U32(omx_res);
     return omx_res;
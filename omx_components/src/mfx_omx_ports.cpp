@@ -130,6 +130,7 @@ bool mfx_omx_is_index_valid(OMX_INDEXTYPE index, MfxOmxPortId port_id)
             if (MfxOmx_IndexIntelIdrInterval == index) return true;
             if (MfxOmx_IndexIntelGopRefDist == index) return true;
             if (MfxOmx_IndexIntelLowPower == index) return true;
+            if (MfxOmx_IndexIntelIdrRequest == index) return true;
             if (MfxOmx_IndexGoogleDescribeColorAspects == index) return true;
             break;
         case MfxOmxPortVideo_h264vd:
@@ -137,6 +138,7 @@ bool mfx_omx_is_index_valid(OMX_INDEXTYPE index, MfxOmxPortId port_id)
             if (OMX_IndexExtEnableErrorReport == index) return true;
             if (OMX_IndexExtOutputErrorBuffers == index) return true;
             if (OMX_IndexParamIntelAVCDecodeSettings == index) return true;
+            if (OMX_IndexParamNalStreamFormat == index) return true;
             if (OMX_IndexExtDecoderBufferHandle == index) return true;
             if (MfxOmx_IndexIntelEnableSFC == index) return true;
             break;
@@ -145,6 +147,7 @@ bool mfx_omx_is_index_valid(OMX_INDEXTYPE index, MfxOmxPortId port_id)
             break;
         case MfxOmxPortVideo_h265vd:
             if (OMX_IndexParamVideoProfileLevelQuerySupported == index) return true;
+            if (OMX_IndexParamNalStreamFormat == index) return true;
             break;
         case MfxOmxPortVideo_vp8vd:
         case MfxOmxPortVideo_vp9vd:
@@ -154,6 +157,7 @@ bool mfx_omx_is_index_valid(OMX_INDEXTYPE index, MfxOmxPortId port_id)
             if (OMX_IndexParamVideoBitrate == index) return true;
             if (OMX_IndexParamVideoProfileLevelQuerySupported == index) return true;
             if (OMX_IndexParamVideoHevc == index) return true;
+            if (OMX_IndexParamNalStreamFormat == index) return true;
             if (OMX_IndexConfigVideoIntraVOPRefresh == index) return true;
             if (OMX_IndexConfigVideoBitrate == index) return true;
             if (OMX_IndexConfigVideoFramerate == index) return true;
@@ -162,6 +166,7 @@ bool mfx_omx_is_index_valid(OMX_INDEXTYPE index, MfxOmxPortId port_id)
             if (MfxOmx_IndexIntelIdrInterval == index) return true;
             if (MfxOmx_IndexIntelGopRefDist == index) return true;
             if (MfxOmx_IndexIntelDisableDeblockingIdc == index) return true;
+            if (MfxOmx_IndexIntelIdrRequest == index) return true;
             if (MfxOmx_IndexGoogleDescribeColorAspects == index) return true;
             break;
         case MfxOmxPortVideo_vp9ve:
@@ -71,6 +71,7 @@ MfxOmxVdecComponent::MfxOmxVdecComponent(OMX_ERRORTYPE &error,
     MfxOmxComponent(error, self, reg_data, flags),
     m_Implementation(MFX_OMX_IMPLEMENTATION),
     m_pDEC(NULL),
+    m_decoderMutex("vdec_decoder"),
     m_extBuffers{},
     m_bLegacyAdaptivePlayback(false),
     m_nMaxFrameWidth(0),
@@ -86,6 +87,7 @@ MfxOmxVdecComponent::MfxOmxVdecComponent(OMX_ERRORTYPE &error,
     m_bAllocateNativeHandle(false),
     m_bEnableNativeBuffersReceived(false),
     m_bInterlaced(false),
+    m_bHeadersPreparsed(false),
     m_InitState(MFX_INIT_DECODE_HEADER),
     m_pDevice(NULL),
     m_pBufferHeaders(NULL),
@@ -97,7 +99,7 @@ MfxOmxVdecComponent::MfxOmxVdecComponent(OMX_ERRORTYPE &error,
     m_pSurfaces(NULL),
     m_pFreeSyncPoint(NULL),
     m_nLockedSurfacesNum(0),
-    m_nCountDecodedFrames(0),
+    m_nFlushStartTime(0),
 #ifdef HEVC10HDR_SUPPORT
     m_bIsSetHDRSEI(false),
 #endif
@@ -112,6 +114,8 @@ MfxOmxVdecComponent::MfxOmxVdecComponent(OMX_ERRORTYPE &error,
     MFX_OMX_ZERO_MEMORY(m_adaptivePlayback);
     MFX_OMX_ZERO_MEMORY(m_decVideoProc);
     MFX_OMX_ZERO_MEMORY(m_AllocResponse);
+    MFX_OMX_ZERO_MEMORY(m_StreamInfo);
+    MFX_OMX_ZERO_MEMORY(m_nHeadersChanges);
 #ifdef HEVC10HDR_SUPPORT
     MFX_OMX_ZERO_MEMORY(m_SeiHDRStaticInfo);
 #endif
@@ -133,11 +137,14 @@ MfxOmxVdecComponent::~MfxOmxVdecComponent(void)
 
     MFX_OMX_DELETE(m_pDevice);
 
-    if (m_dbg_decin) fclose(m_dbg_decin);
-    if (m_dbg_decin_fc) fclose(m_dbg_decin_fc);
-    if (m_dbg_decout) fclose(m_dbg_decout);
+    mfx_omx_dump_close(m_dbg_decin);
+    mfx_omx_dump_close(m_dbg_decin_fc);
+    mfx_omx_dump_close(m_dbg_decout);
 
-    MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Decoded %d frames", m_nCountDecodedFrames);
+    MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Decoded %d frames", m_Stats.nProcessedFrames.load());
+    MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Headers changes: none %d, crop %d, reset %d, reinit %d",
+                        m_nHeadersChanges[MFX_OMX_HEADERS_CHANGE_NONE], m_nHeadersChanges[MFX_OMX_HEADERS_CHANGE_CROP],
+                        m_nHeadersChanges[MFX_OMX_HEADERS_CHANGE_RESET], m_nHeadersChanges[MFX_OMX_HEADERS_CHANGE_REINIT]);
     MFX_OMX_LOG_INFO("Destroyed %s", m_pRegData->m_name);
 }
 
@@ -166,7 +173,7 @@ OMX_ERRORTYPE MfxOmxVdecComponent::Init(void)
         // decoder creation
         if (MFX_ERR_NONE == sts)
         {
-            MFX_OMX_NEW(m_pDEC, MFXVideoDECODE(m_Session));
+            MFX_OMX_NEW(m_pDEC, MfxOmxVideoDECODE(m_Session));
             if (!m_pDEC) sts = MFX_ERR_MEMORY_ALLOC;
         }
         if (MFX_ERR_NONE != sts) error = ErrorStatusMfxToOmx(sts);
@@ -723,11 +730,16 @@ OMX_ERRORTYPE MfxOmxVdecComponent::EmptyThisBuffer(
     MFX_OMX_AUTO_TRACE_FUNC();
     MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "EmptyThisBuffer(%p) nTimeStamp %lld, nFilledLen %d, nFlags 0x%x",
                         pBuffer, pBuffer->nTimeStamp, pBuffer->nFilledLen, pBuffer->nFlags);
-    OMX_ERRORTYPE omx_res = MfxOmxComponent::EmptyThisBuffer(pBuffer);
+    OMX_ERRORTYPE omx_res = OMX_ErrorNone;
+
+    // malformed codec config is rejected before the buffer is accepted, so it stays with the client
+    if (MFX_ERR_NONE != m_pOmxBitstream->CheckBuffer(pBuffer)) omx_res = OMX_ErrorBadParameter;
+    if (OMX_ErrorNone == omx_res) omx_res = MfxOmxComponent::EmptyThisBuffer(pBuffer);
 
     // emptying buffer
     if (OMX_ErrorNone == omx_res)
     {
+        if (pBuffer->nFilledLen) m_Latency.Mark(MFX_OMX_LATENCY_POINT_INPUT, OMX2MFX_TIME(pBuffer->nTimeStamp));
         if (MFX_ERR_NONE == m_pOmxBitstream->UseBuffer(pBuffer))
         {
             m_pCommandsSemaphore->Post();
@@ -757,7 +769,7 @@ OMX_ERRORTYPE MfxOmxVdecComponent::FillThisBuffer(
         else
         {
             omx_res = ErrorStatusMfxToOmx(mfx_res);
-            m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, omx_res, 0 , NULL);
+            SendErrorEvent(omx_res);
         }
     }
     MFX_OMX_AUTO_TRACE_U32(omx_res);
@@ -897,6 +909,28 @@ OMX_ERRORTYPE MfxOmxVdecComponent::GetParameter(
                 else omx_res = OMX_ErrorVersionMismatch;
             }
             break;
+        case OMX_IndexParamNalStreamFormat:
+            {
+                MFX_OMX_AUTO_TRACE_MSG("OMX_IndexParamNalStreamFormat");
+                OMX_NALSTREAMFORMATTYPE* pParam = (OMX_NALSTREAMFORMATTYPE*)pComponentParameterStructure;
+                if (IsStructVersionValid<OMX_NALSTREAMFORMATTYPE>(pParam, sizeof(OMX_NALSTREAMFORMATTYPE), OMX_VERSION))
+                {
+                    if (IsIndexValid(OMX_IndexParamNalStreamFormat, pParam->nPortIndex))
+                    {
+                        switch (m_pOmxBitstream->GetFrameConstructor()->GetNalLengthSize())
+                        {
+                            case 4:  pParam->eNaluFormat = OMX_NaluFormatFourByteInterleaveLength; break;
+                            case 2:  pParam->eNaluFormat = OMX_NaluFormatTwoByteInterleaveLength; break;
+                            case 1:  pParam->eNaluFormat = OMX_NaluFormatOneByteInterleaveLength; break;
+                            default: pParam->eNaluFormat = OMX_NaluFormatStartCodes; break;
+                        }
+                        omx_res = OMX_ErrorNone;
+                    }
+                    else omx_res = OMX_ErrorBadPortIndex;
+                }
+                else omx_res = OMX_ErrorVersionMismatch;
+            }
+            break;
         case OMX_IndexExtOutputErrorBuffers:
             {
                 MFX_OMX_AUTO_TRACE_MSG("OMX_IndexExtOutputErrorBuffers");
@@ -1012,6 +1046,14 @@ OMX_ERRORTYPE MfxOmxVdecComponent::SetParameter(
                 {
                     MFX_OMX_AUTO_TRACE_I32(pParam->nPortIndex);
                     MFX_OMX_AUTO_TRACE_I32(pParam->enable);
+#if MFX_OMX_MOCK_BACKEND == MFX_OMX_YES
+                    // mock device allocates system memory only
+                    if ((MFX_OMX_OUTPUT_PORT_INDEX == pParam->nPortIndex) && pParam->enable)
+                    {
+                        omx_res = OMX_ErrorUnsupportedSetting;
+                        break;
+                    }
+#endif
                     if (MFX_OMX_OUTPUT_PORT_INDEX == pParam->nPortIndex)
                     {
                         // Set memory type of output surfaces
@@ -1109,6 +1151,36 @@ OMX_ERRORTYPE MfxOmxVdecComponent::SetParameter(
                 else omx_res = OMX_ErrorVersionMismatch;
             }
             break;
+        case OMX_IndexParamNalStreamFormat:
+            {
+                MFX_OMX_AUTO_TRACE_MSG("OMX_IndexParamNalStreamFormat");
+                OMX_NALSTREAMFORMATTYPE* pParam = (OMX_NALSTREAMFORMATTYPE*)pComponentParameterStructure;
+                if (IsStructVersionValid<OMX_NALSTREAMFORMATTYPE>(pParam, sizeof(OMX_NALSTREAMFORMATTYPE), OMX_VERSION))
+                {
+                    if (!IsIndexValid(OMX_IndexParamNalStreamFormat, pParam->nPortIndex)) omx_res = OMX_ErrorBadPortIndex;
+                    else if (bIncorrectState && IsPortEnabled(pParam->nPortIndex)) omx_res = OMX_ErrorInvalidState;
+                    else
+                    {
+                        mfxU32 lengthSize = 0;
+                        omx_res = OMX_ErrorNone;
+                        switch (pParam->eNaluFormat)
+                        {
+                            case OMX_NaluFormatStartCodes:               lengthSize = 0; break;
+                            case OMX_NaluFormatFourByteInterleaveLength: lengthSize = 4; break;
+                            case OMX_NaluFormatTwoByteInterleaveLength:  lengthSize = 2; break;
+                            case OMX_NaluFormatOneByteInterleaveLength:  lengthSize = 1; break;
+                            default: omx_res = OMX_ErrorUnsupportedSetting; break;
+                        }
+                        if (OMX_ErrorNone == omx_res)
+                        {
+                            m_pOmxBitstream->GetFrameConstructor()->SetNalLengthSize(lengthSize);
+                            MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "NAL stream format 0x%x, length size %d", pParam->eNaluFormat, lengthSize);
+                        }
+                    }
+                }
+                else omx_res = OMX_ErrorVersionMismatch;
+            }
+            break;
         case OMX_IndexParamIntelAVCDecodeSettings:
             {
                 MFX_OMX_AUTO_TRACE_MSG("OMX_IndexParamIntelAVCDecodeSettings");
@@ -1392,6 +1464,8 @@ void MfxOmxVdecComponent::BufferReleased(
         }
         MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "FillBufferDone(%p) nTimeStamp %lld, nFilledLen %d, nFlags 0x%x",
                             pBuffer, pBuffer->nTimeStamp, pBuffer->nFilledLen, pBuffer->nFlags);
+        if (pBuffer->nFilledLen) m_Latency.Mark(MFX_OMX_LATENCY_POINT_OUTPUT, OMX2MFX_TIME(pBuffer->nTimeStamp));
+        ++m_Stats.nOutputBuffers;
         m_pCallbacks->FillBufferDone(m_self, m_pAppData, pBuffer);
     }
 }
@@ -1576,7 +1650,7 @@ OMX_ERRORTYPE MfxOmxVdecComponent::CommandStateSet(OMX_STATETYPE new_state)
     MFX_OMX_AUTO_TRACE_I32(new_state);
     if (new_state == m_state)
     {
-        m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, (OMX_U32)OMX_ErrorSameState, 0 , NULL);
+        SendErrorEvent(OMX_ErrorSameState);
     }
     else
     {
@@ -1585,7 +1659,7 @@ OMX_ERRORTYPE MfxOmxVdecComponent::CommandStateSet(OMX_STATETYPE new_state)
         case OMX_StateInvalid:
             MFX_OMX_AUTO_TRACE_MSG("OMX_StateInvalid");
             m_state = OMX_StateInvalid;
-            m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, (OMX_U32)OMX_ErrorInvalidState, 0, NULL);
+            SendErrorEvent(OMX_ErrorInvalidState);
             m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventCmdComplete, (OMX_U32)OMX_CommandStateSet, m_state, NULL);
             break;
         case OMX_StateLoaded:
@@ -1609,7 +1683,7 @@ OMX_ERRORTYPE MfxOmxVdecComponent::CommandStateSet(OMX_STATETYPE new_state)
             else
             {
                 MFX_OMX_LOG_ERROR("Error: OMX_ErrorIncorrectStateTransition");
-                m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, (OMX_U32)OMX_ErrorIncorrectStateTransition, 0, NULL);
+                SendErrorEvent(OMX_ErrorIncorrectStateTransition);
             }
             break;
         case OMX_StateIdle:
@@ -1617,11 +1691,12 @@ OMX_ERRORTYPE MfxOmxVdecComponent::CommandStateSet(OMX_STATETYPE new_state)
             if (OMX_StateInvalid == m_state)
             {
                 MFX_OMX_LOG_ERROR("Error: OMX_ErrorIncorrectStateTransition");
-                m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, (OMX_U32)OMX_ErrorIncorrectStateTransition, 0, NULL);
+                SendErrorEvent(OMX_ErrorIncorrectStateTransition);
             }
             else
             {
                 m_state_to_set = OMX_StateIdle;
+                if ((OMX_StateExecuting == m_state) || (OMX_StatePause == m_state)) m_Latency.Reset();
                 if (OMX_StateExecuting == m_state)
                 { // resetting codec
                     // TODO: loop is needed here: while (MFX_ERR_NONE != ResetCodec()) ;
@@ -1649,7 +1724,7 @@ OMX_ERRORTYPE MfxOmxVdecComponent::CommandStateSet(OMX_STATETYPE new_state)
             else
             {
                 MFX_OMX_LOG_ERROR("Error: OMX_ErrorIncorrectStateTransition");
-                m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, (OMX_U32)OMX_ErrorIncorrectStateTransition, 0, NULL);
+                SendErrorEvent(OMX_ErrorIncorrectStateTransition);
             }
             break;
         case OMX_StatePause:
@@ -1662,7 +1737,7 @@ OMX_ERRORTYPE MfxOmxVdecComponent::CommandStateSet(OMX_STATETYPE new_state)
             else
             {
                 MFX_OMX_LOG_ERROR("Error: OMX_ErrorIncorrectStateTransition");
-                m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, (OMX_U32)OMX_ErrorIncorrectStateTransition, 0, NULL);
+                SendErrorEvent(OMX_ErrorIncorrectStateTransition);
             }
             break;
         case OMX_StateWaitForResources:
@@ -1675,7 +1750,7 @@ OMX_ERRORTYPE MfxOmxVdecComponent::CommandStateSet(OMX_STATETYPE new_state)
             else
             {
                 MFX_OMX_LOG_ERROR("Error: OMX_ErrorIncorrectStateTransition");
-                m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, (OMX_U32)OMX_ErrorIncorrectStateTransition, 0, NULL);
+                SendErrorEvent(OMX_ErrorIncorrectStateTransition);
             }
             break;
         default:
@@ -1834,7 +1909,9 @@ OMX_ERRORTYPE MfxOmxVdecComponent::CommandFlush(OMX_U32 nPortIndex)
     OMX_ERRORTYPE omx_res = OMX_ErrorNone;
     mfxStatus mfx_sts = MFX_ERR_NONE;
 
-    m_bFlush = true;
+    // flushed frames never reach the output, their time stamps may come again after seek
+    m_Latency.Reset();
+
     MFX_OMX_AUTO_TRACE_I32(nPortIndex);
     if ((MFX_OMX_INPUT_PORT_INDEX == nPortIndex) || (OMX_ALL == nPortIndex))
     {
@@ -1852,7 +1929,7 @@ OMX_ERRORTYPE MfxOmxVdecComponent::CommandFlush(OMX_U32 nPortIndex)
                     MFX_OMX_LOG_ERROR("LoadBuffer failed");
                     MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "CommandFlush : LoadBuffer failed : mfx_sts = %d", mfx_sts);
                     MFX_OMX_AUTO_TRACE_I32(mfx_sts);
-                    m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, ErrorStatusMfxToOmx(mfx_sts), 0 , NULL);
+                    SendErrorEvent(ErrorStatusMfxToOmx(mfx_sts));
                 }
             }
         }
@@ -1868,7 +1945,7 @@ OMX_ERRORTYPE MfxOmxVdecComponent::CommandFlush(OMX_U32 nPortIndex)
             MFX_OMX_LOG_ERROR("Flush input buffers failed");
             MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "CommandFlush : Flush input buffers failed : mfx_sts = %d", mfx_sts);
             MFX_OMX_AUTO_TRACE_I32(mfx_sts);
-            m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, ErrorStatusMfxToOmx(mfx_sts), 0 , NULL);
+            SendErrorEvent(ErrorStatusMfxToOmx(mfx_sts));
         }
     }
     if ((MFX_OMX_OUTPUT_PORT_INDEX == nPortIndex) || (OMX_ALL == nPortIndex))
@@ -1876,6 +1953,8 @@ OMX_ERRORTYPE MfxOmxVdecComponent::CommandFlush(OMX_U32 nPortIndex)
         MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Flush output buffers");
         MFX_OMX_AUTO_TRACE("Flush output buffers");
 
+        m_nFlushStartTime = mfx_omx_get_time_us();
+        // decoder session and surfaces are kept, decoder is just reset with current parameters
         mfx_sts = ResetOutput();
         if (MFX_ERR_NONE == mfx_sts)
         {
@@ -1887,11 +1966,13 @@ OMX_ERRORTYPE MfxOmxVdecComponent::CommandFlush(OMX_U32 nPortIndex)
             MFX_OMX_LOG_ERROR("Flush output buffers failed");
             MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "CommandFlush : Flush output buffers failed : mfx_sts = %d", mfx_sts);
             MFX_OMX_AUTO_TRACE_I32(mfx_sts);
-            m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, ErrorStatusMfxToOmx(mfx_sts), 0 , NULL);
+            SendErrorEvent(ErrorStatusMfxToOmx(mfx_sts));
         }
     }
     if ((MFX_OMX_INPUT_PORT_INDEX != nPortIndex) && (MFX_OMX_OUTPUT_PORT_INDEX != nPortIndex) && (OMX_ALL != nPortIndex))
         omx_res = OMX_ErrorBadPortIndex;
+    else
+        m_bFlush = true; // new stream headers will be checked on the first data after flush
 
     MFX_OMX_AUTO_TRACE_U32(omx_res);
     return omx_res;
@@ -1923,8 +2004,12 @@ void MfxOmxVdecComponent::MainThread(void)
             MFX_OMX_AUTO_TRACE("Got new command");
             MFX_OMX_AUTO_TRACE_I32(command.m_command);
 
-            MFX_OMX_AUTO_TRACE_MSG("m_pAllSyncOpFinished->Wait()");
-            m_pAllSyncOpFinished->Wait();
+            if (IsDrainingCommand(command))
+            {
+                MFX_OMX_AUTO_TRACE_MSG("m_pAllSyncOpFinished->Wait()");
+                ++m_Stats.nDrains;
+                m_pAllSyncOpFinished->Wait();
+            }
 
             switch (command.m_command)
             {
@@ -1950,6 +2035,12 @@ void MfxOmxVdecComponent::MainThread(void)
             };
         }
 
+        if (((OMX_StateIdle == m_state) || (OMX_StateExecuting == m_state)) && (MFX_ERR_NONE == m_Error) &&
+            (MFX_INIT_DECODE_HEADER == m_InitState) && !m_bHeadersPreparsed)
+        {
+            PreparseHeaders();
+        }
+
         if ((OMX_StateExecuting == m_state) && (MFX_ERR_NONE == m_Error) && ArePortsEnabled(OMX_ALL) && CanDecode())
         {
             MFX_OMX_AUTO_TRACE_MSG("Trying to decode");
@@ -2003,12 +2094,19 @@ void MfxOmxVdecComponent::MainThread(void)
 
                     if ((MFX_ERR_NONE == mfx_sts) && !m_bChangeOutputPortSettings)
                     {
-                        if (m_bFlush)
+                        if (m_bFlush && m_pBitstream && m_pBitstream->DataLength)
                         {
                             m_bFlush = false;
-                            if (IsResolutionChanged())
+                            // reinit is possible only if stream headers were changed after flush,
+                            // PPS and crop changes are handled by decoder itself
+                            MfxOmxHeadersChange change = MFX_OMX_HEADERS_CHANGE_NONE;
+                            if (m_pOmxBitstream->GetFrameConstructor()->WereHeadersChanged())
+                                change = GetHeadersChange(NULL);
+
+                            if ((MFX_OMX_HEADERS_CHANGE_REINIT == change) ||
+                                ((MFX_OMX_HEADERS_CHANGE_RESET == change) && IsResolutionChanged()))
                             {
-                                mfx_sts = ReinitCodec();
+                                mfx_sts = ReinitCodec(change);
                                 if (MFX_ERR_NONE != mfx_sts)
                                 {
                                     MFX_OMX_AUTO_TRACE("Failed to reinit codec");
@@ -2029,6 +2127,8 @@ void MfxOmxVdecComponent::MainThread(void)
                         if (pBuffer)
                         {
                             mfx_sts = loader.LoadBuffer(pBuffer);
+                            if (MFX_ERR_NONE == mfx_sts && pBuffer->nFilledLen)
+                                m_Latency.Mark(MFX_OMX_LATENCY_POINT_PARSED, OMX2MFX_TIME(pBuffer->nTimeStamp));
 
                             // MFX_ERR_NULL_PTR is a valid status, we need to continue Decoding/Initialization,
                             // Without this we will go outside the "while" loop
@@ -2086,11 +2186,13 @@ void MfxOmxVdecComponent::MainThread(void)
                         }
                         else
                         {
+                            ++m_Stats.nDrains;
                             m_pAllSyncOpFinished->Wait();
                             MFX_OMX_AUTO_TRACE_MSG("Buffered frames flush is finished. Resetting decoder");
                             m_bEosHandlingStarted = m_bEosHandlingFinished = false;
 
-                            mfx_sts = ReinitCodec();
+                            // decoder stopped at the new sequence header, it is not saved by frame constructor
+                            mfx_sts = ReinitCodec(GetHeadersChange(m_pOmxBitstream->GetFrameConstructor()->GetMfxBitstream()));
                             if (MFX_ERR_MORE_DATA == mfx_sts)
                             {
                                 OMX_BUFFERHEADERTYPE* pBuffer = m_pOmxBitstream->GetBuffer();
@@ -2126,7 +2228,7 @@ void MfxOmxVdecComponent::MainThread(void)
 
                                     MFX_OMX_LOG_ERROR("Sending ErrorEvent to OMAX - OMX_ErrorStreamCorrupt");
                                     MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Sending ErrorEvent to OMAX - OMX_ErrorStreamCorrupt");
-                                    m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, OMX_ErrorStreamCorrupt, 0 , NULL);
+                                    SendErrorEvent(OMX_ErrorStreamCorrupt);
                                 }
                             }
                             else if (MFX_ERR_NONE != mfx_sts)
@@ -2143,7 +2245,7 @@ void MfxOmxVdecComponent::MainThread(void)
                 MFX_OMX_LOG_ERROR("Sending ErrorEvent to OMAX client because of error in component");
                 MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "MainThread : m_Error = %d", m_Error);
                 MFX_OMX_AUTO_TRACE_I32(m_Error);
-                m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, ErrorStatusMfxToOmx(m_Error), 0 , NULL);
+                SendErrorEvent(ErrorStatusMfxToOmx(m_Error));
             }
         }
     }
@@ -2165,12 +2267,33 @@ mfxU16 MfxOmxVdecComponent::GetAsyncDepth(void)
     else
         asyncDepth = 0;
 
+    if (m_nForcedAsyncDepth) asyncDepth = m_nForcedAsyncDepth;
+
     MFX_OMX_AUTO_TRACE_I32(asyncDepth);
     return asyncDepth;
 }
 
 /*------------------------------------------------------------------------------*/
 
+void MfxOmxVdecComponent::GetRuntimeStats(OMX_VIDEO_CONFIG_INTEL_RUNTIME_STATS* pStats)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+
+    if (m_pOmxBitstream)
+    {
+        pStats->nBytesCopied = m_pOmxBitstream->GetFrameConstructor()->GetBstBufCopyBytes();
+        pStats->nBufferReallocs = m_pOmxBitstream->GetFrameConstructor()->GetBstBufReallocs();
+        pStats->nInputQueueDepth = m_pOmxBitstream->GetQueuedBuffersCount();
+    }
+    if (m_pSurfaces)
+    {
+        pStats->nSurfacesHeld = m_pSurfaces->GetUsedBuffersCount();
+        pStats->nOutputQueueDepth = m_pSurfaces->GetQueuedBuffersCount();
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
 mfxStatus MfxOmxVdecComponent::InitCodec(void)
 {
     MFX_OMX_AUTO_TRACE_FUNC();
@@ -2299,29 +2422,7 @@ mfxStatus MfxOmxVdecComponent::InitCodec(void)
                 m_MfxVideoParams.ExtParam = &m_extBuffers.front();
             }
 
-            mfxFrameAllocRequest request;
-            MFX_OMX_ZERO_MEMORY(request);
-
-            mfx_res = m_pDEC->QueryIOSurf(&m_MfxVideoParams, &request);
-            if (MFX_WRN_PARTIAL_ACCELERATION == mfx_res)
-            {
-                MFX_OMX_LOG_INFO("MFX_WRN_PARTIAL_ACCELERATION");
-                mfx_res = MFX_ERR_NONE;
-            }
-            if (MFX_ERR_NONE == mfx_res)
-            {
-                m_nSurfacesNumMin = MFX_OMX_MAX(request.NumFrameSuggested,
-                                                MFX_OMX_MAX(request.NumFrameMin, 1));
-                m_nSurfacesNum = MFX_OMX_MAX(m_nSurfacesNumMin, 4);
-
-                if (m_bOnFlySurfacesAllocation && m_bANWBufferInMetaData)
-                {
-                    m_nSurfacesNumMin++;
-                    m_nSurfacesNum++;
-                }
-            }
-            MFX_OMX_AUTO_TRACE_I32(m_nSurfacesNumMin);
-            MFX_OMX_AUTO_TRACE_I32(m_nSurfacesNum);
+            mfx_res = QuerySurfacesNum(&m_MfxVideoParams, NULL);
         }
     }
     if (MFX_INIT_DECODER == m_InitState)
@@ -2386,10 +2487,14 @@ mfxStatus MfxOmxVdecComponent::InitCodec(void)
                                                   (!m_bUseSystemMemory) ? m_AllocResponse.mids[i]: NULL);
         }
 
+        // stream frame size is restored after Init, decoder itself works with the pool frame size
+        mfxU16 nStreamWidth = m_MfxVideoParams.mfx.FrameInfo.Width;
+        mfxU16 nStreamHeight = m_MfxVideoParams.mfx.FrameInfo.Height;
         if (MFX_ERR_NONE == mfx_res)
         {
             if (!m_bOnFlySurfacesAllocation)
             {
+                SetPoolFrameSize(&m_MfxVideoParams);
                 mfx_res = m_pDEC->Init(&m_MfxVideoParams);
             }
             else
@@ -2426,8 +2531,14 @@ mfxStatus MfxOmxVdecComponent::InitCodec(void)
         {
             mfx_res = m_pDEC->GetVideoParam(&m_MfxVideoParams);
         }
+        m_MfxVideoParams.mfx.FrameInfo.Width = nStreamWidth;
+        m_MfxVideoParams.mfx.FrameInfo.Height = nStreamHeight;
         if (MFX_ERR_NONE == mfx_res)
         {
+            // reference for classification of further headers changes
+            if (MFX_ERR_NONE != m_pOmxBitstream->GetFrameConstructor()->GetStreamInfo(NULL, 0, &m_StreamInfo))
+                MFX_OMX_ZERO_MEMORY(m_StreamInfo);
+
             m_InitState = MFX_INIT_COMPLETED;
         }
         MFX_OMX_AT__mfxVideoParam_dec(m_MfxVideoParams);
@@ -2472,6 +2583,180 @@ mfxStatus MfxOmxVdecComponent::InitCodec(void)
 
 /*------------------------------------------------------------------------------*/
 
+/* If pInfo is NULL, stream info is taken from headers saved by frame constructor.
+ * It is used only in DPB sized surfaces mode to lower QueryIOSurf estimation
+ * (based on level limits) down to DPB size signaled in SPS.
+ */
+mfxStatus MfxOmxVdecComponent::QuerySurfacesNum(mfxVideoParam* pParams, MfxOmxStreamInfo* pInfo)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    mfxStatus mfx_res = MFX_ERR_NONE;
+
+    mfxFrameAllocRequest request;
+    MFX_OMX_ZERO_MEMORY(request);
+
+    MfxOmxStreamInfo info;
+    MFX_OMX_ZERO_MEMORY(info);
+    bool bDpbSizedSurfaces = false;
+
+    if ((MFX_OMX_COMPONENT_FLAGS_DPB_SIZED_SURFACES & m_Flags) &&
+        ((MFX_CODEC_AVC == pParams->mfx.CodecId) || (MFX_CODEC_HEVC == pParams->mfx.CodecId)))
+    {
+        if (pInfo)
+        {
+            info = *pInfo;
+            bDpbSizedSurfaces = true;
+        }
+        else
+        {
+            bDpbSizedSurfaces = (MFX_ERR_NONE == m_pOmxBitstream->GetFrameConstructor()->GetStreamInfo(NULL, 0, &info));
+        }
+    }
+
+    mfx_res = m_pDEC->QueryIOSurf(pParams, &request);
+    if (MFX_WRN_PARTIAL_ACCELERATION == mfx_res)
+    {
+        MFX_OMX_LOG_INFO("MFX_WRN_PARTIAL_ACCELERATION");
+        mfx_res = MFX_ERR_NONE;
+    }
+    if (MFX_ERR_NONE == mfx_res)
+    {
+        m_nSurfacesNumMin = MFX_OMX_MAX(request.NumFrameSuggested,
+                                        MFX_OMX_MAX(request.NumFrameMin, 1));
+        if (bDpbSizedSurfaces)
+        {
+            // DPB + frames in flight + currently decoded frame + frame held by client,
+            // but never less than decoder requires
+            mfxU16 nDpbSurfacesNum = (mfxU16)(MFX_OMX_MAX(info.MaxDecFrameBuffering, info.NumReorderFrames) +
+                                              pParams->AsyncDepth + 2);
+            nDpbSurfacesNum = MFX_OMX_MAX(nDpbSurfacesNum, request.NumFrameMin);
+
+            MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "DPB sized surfaces: max_dec_frame_buffering %d, num_reorder_frames %d, surfaces %d (QueryIOSurf %d)",
+                                info.MaxDecFrameBuffering, info.NumReorderFrames, nDpbSurfacesNum, m_nSurfacesNumMin);
+            if (nDpbSurfacesNum < m_nSurfacesNumMin) m_nSurfacesNumMin = nDpbSurfacesNum;
+        }
+        m_nSurfacesNum = MFX_OMX_MAX(m_nSurfacesNumMin, 4);
+
+        if (m_bOnFlySurfacesAllocation && m_bANWBufferInMetaData)
+        {
+            m_nSurfacesNumMin++;
+            m_nSurfacesNum++;
+        }
+    }
+    MFX_OMX_AUTO_TRACE_I32(m_nSurfacesNumMin);
+    MFX_OMX_AUTO_TRACE_I32(m_nSurfacesNum);
+
+    MFX_OMX_AUTO_TRACE_I32(mfx_res);
+    return mfx_res;
+}
+
+/*------------------------------------------------------------------------------*/
+
+/* Parses headers of the first input buffer (codec config or first frame) with
+ * SPL parsers as soon as it arrives (even in Idle). If output port is disabled
+ * and unpopulated, its definition is filled before client allocates buffers:
+ * if the guess matches DecodeHeader results, InitCodec will not request port
+ * settings change. Otherwise port definition can't be changed silently and the
+ * result only tells in the log whether InitCodec will request the change.
+ */
+void MfxOmxVdecComponent::PreparseHeaders(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    mfxStatus mfx_res = MFX_ERR_NONE;
+
+    OMX_BUFFERHEADERTYPE* pBuffer = m_pOmxBitstream->GetCurrentBuffer();
+    if (!pBuffer) return;
+
+    // only first buffer is checked, it is expected to hold sequence header
+    m_bHeadersPreparsed = true;
+
+    // port definition can't be changed if buffers are allocated or will be reconfigured anyway
+    bool bUpdatePort = !m_pOutPortDef->bEnabled && !m_pOutPortDef->bPopulated &&
+                       !m_bLegacyAdaptivePlayback && !m_bEnableVP;
+
+    MfxOmxStreamInfo info;
+    MFX_OMX_ZERO_MEMORY(info);
+
+    // length prefixed config is parsed in its converted form
+    mfxU8* data = pBuffer->pBuffer + pBuffer->nOffset;
+    mfxU32 size = pBuffer->nFilledLen;
+
+    mfx_res = m_pOmxBitstream->GetFrameConstructor()->ConvertToStartCodes(data, size, (pBuffer->nFlags & OMX_BUFFERFLAG_CODECCONFIG));
+    if (MFX_ERR_NONE == mfx_res)
+    {
+        mfx_res = m_pOmxBitstream->GetFrameConstructor()->GetStreamInfo(data, size, &info);
+    }
+    if ((MFX_ERR_NONE == mfx_res) &&
+        (!info.FrameInfo.Width || !info.FrameInfo.Height || info.FrameInfo.Width > 8192 || info.FrameInfo.Height > 8192))
+    {
+        mfx_res = MFX_ERR_UNSUPPORTED;
+    }
+    if ((MFX_ERR_NONE == mfx_res) && (MFX_FOURCC_P010 == info.FrameInfo.FourCC) && m_bUseSystemMemory)
+    {
+        mfx_res = MFX_ERR_UNSUPPORTED;
+    }
+
+    mfxVideoParam params = m_MfxVideoParams;
+    if (MFX_ERR_NONE == mfx_res)
+    {
+        mfxFrameInfo& frameInfo = params.mfx.FrameInfo;
+
+        frameInfo.Width = info.FrameInfo.Width;
+        frameInfo.Height = info.FrameInfo.Height;
+        frameInfo.CropX = info.FrameInfo.CropX;
+        frameInfo.CropY = info.FrameInfo.CropY;
+        frameInfo.CropW = info.FrameInfo.CropW;
+        frameInfo.CropH = info.FrameInfo.CropH;
+        frameInfo.FourCC = info.FrameInfo.FourCC;
+        frameInfo.ChromaFormat = info.FrameInfo.ChromaFormat;
+        frameInfo.BitDepthLuma = info.FrameInfo.BitDepthLuma;
+        frameInfo.BitDepthChroma = info.FrameInfo.BitDepthChroma;
+        frameInfo.PicStruct = info.FrameInfo.PicStruct;
+        params.mfx.CodecProfile = info.CodecProfile;
+        params.mfx.CodecLevel = info.CodecLevel;
+
+        params.AsyncDepth = GetAsyncDepth();
+        params.IOPattern = (mfxU16)((m_pDevice && !m_bUseSystemMemory) ? MFX_IOPATTERN_OUT_VIDEO_MEMORY : MFX_IOPATTERN_OUT_SYSTEM_MEMORY);
+
+        mfx_res = QuerySurfacesNum(&params, &info);
+    }
+    if (MFX_ERR_NONE == mfx_res)
+    {
+        MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Preparsed headers: %dx%d, crop %dx%d, surfaces %d (min %d)",
+                            params.mfx.FrameInfo.Width, params.mfx.FrameInfo.Height,
+                            params.mfx.FrameInfo.CropW, params.mfx.FrameInfo.CropH,
+                            m_nSurfacesNum, m_nSurfacesNumMin);
+    }
+    if ((MFX_ERR_NONE == mfx_res) && !bUpdatePort)
+    {
+        bool bMatches = (m_pOutPortDef->format.video.nFrameWidth == params.mfx.FrameInfo.Width) &&
+                        (m_pOutPortDef->format.video.nFrameHeight == params.mfx.FrameInfo.Height) &&
+                        (m_pOutPortDef->nBufferCountMin >= m_nSurfacesNumMin) &&
+                        (m_pOutPortDef->nBufferCountActual >= m_nSurfacesNum);
+
+        MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Output port is in use, its settings %s preparsed headers",
+                            bMatches ? "match" : "will be changed to");
+    }
+    else if (MFX_ERR_NONE == mfx_res)
+    {
+        {
+            MfxOmxAutoLock lock(m_decoderMutex);
+            m_MfxVideoParams.mfx.FrameInfo = params.mfx.FrameInfo;
+            m_Crops = m_MfxVideoParams.mfx.FrameInfo;
+            MfxVideoParams_2_PortsParams();
+        }
+        m_pOutPortDef->nBufferCountMin = m_nSurfacesNumMin;
+        m_pOutPortDef->nBufferCountActual = MFX_OMX_MAX(m_pOutPortDef->nBufferCountActual, m_nSurfacesNum);
+    }
+    else
+    {
+        MFX_OMX_AUTO_TRACE_MSG("Preparsing failed, headers will be decoded later");
+    }
+    MFX_OMX_AUTO_TRACE_I32(mfx_res);
+}
+
+/*------------------------------------------------------------------------------*/
+
 bool MfxOmxVdecComponent::IsResolutionChanged(void)
 {
     MFX_OMX_AUTO_TRACE_FUNC();
@@ -2520,7 +2805,36 @@ bool MfxOmxVdecComponent::IsResolutionChanged(void)
 
 /*------------------------------------------------------------------------------*/
 
-mfxStatus MfxOmxVdecComponent::ReinitCodec(void)
+/* Classifies headers found in pBitstream (or saved by frame constructor if NULL)
+ * against the last handled ones.
+ */
+MfxOmxHeadersChange MfxOmxVdecComponent::GetHeadersChange(mfxBitstream* pBitstream)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    MfxOmxHeadersChange change = MFX_OMX_HEADERS_CHANGE_RESET;
+
+    MfxOmxStreamInfo info;
+    MFX_OMX_ZERO_MEMORY(info);
+
+    // without parsed headers (codecs other than AVC/HEVC) decision is left to DecodeHeader
+    mfxU8* data = pBitstream ? pBitstream->Data + pBitstream->DataOffset : NULL;
+    mfxU32 size = pBitstream ? pBitstream->DataLength : 0;
+
+    if (MFX_ERR_NONE == m_pOmxBitstream->GetFrameConstructor()->GetStreamInfo(data, size, &info))
+    {
+        change = mfx_omx_get_headers_change(m_StreamInfo, info);
+        m_StreamInfo = info;
+    }
+    ++m_nHeadersChanges[change];
+
+    MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Headers change class %d", change);
+    MFX_OMX_AUTO_TRACE_I32(change);
+    return change;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxVdecComponent::ReinitCodec(MfxOmxHeadersChange change)
 {
     MFX_OMX_AUTO_TRACE_FUNC();
     mfxStatus mfx_res = MFX_ERR_NONE;
@@ -2568,8 +2882,17 @@ mfxStatus MfxOmxVdecComponent::ReinitCodec(void)
 
         m_colorAspects.UpdateBitsreamColorAspects(m_signalInfo);
 
-        if (newVideoParams.mfx.FrameInfo.Width > m_nMaxFrameWidth ||
-            newVideoParams.mfx.FrameInfo.Height > m_nMaxFrameHeight)
+        if (MFX_OMX_HEADERS_CHANGE_REINIT == change ||
+            newVideoParams.mfx.FrameInfo.FourCC != m_MfxVideoParams.mfx.FrameInfo.FourCC)
+        {
+            MFX_OMX_AUTO_TRACE_MSG("New surface format differs from old");
+            bNeedChangePortSetting = true;
+
+            m_nMaxFrameWidth = (mfxU16)MFX_OMX_MAX(newVideoParams.mfx.FrameInfo.Width, m_nMaxFrameWidth);
+            m_nMaxFrameHeight = (mfxU16)MFX_OMX_MAX(newVideoParams.mfx.FrameInfo.Height, m_nMaxFrameHeight);
+        }
+        else if (newVideoParams.mfx.FrameInfo.Width > m_nMaxFrameWidth ||
+                 newVideoParams.mfx.FrameInfo.Height > m_nMaxFrameHeight)
         {
             MFX_OMX_AUTO_TRACE_MSG("New resolution exceeds old");
             bNeedChangePortSetting = true;
@@ -2588,8 +2911,18 @@ mfxStatus MfxOmxVdecComponent::ReinitCodec(void)
         else
         {
             MFX_OMX_AUTO_TRACE_MSG("New resolution doesn't exceed old. Trying to reset decoder");
-            mfx_res = m_pDEC->Reset(&newVideoParams);
-            if (MFX_ERR_NONE != mfx_res)
+            // existing surfaces are reused, so decoder keeps the pool frame size
+            mfxVideoParam resetVideoParams = newVideoParams;
+            SetPoolFrameSize(&resetVideoParams);
+
+            mfx_res = m_pDEC->Reset(&resetVideoParams);
+            if (MFX_ERR_NONE == mfx_res)
+            {
+                MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Decoder reset to %dx%d within surfaces of %dx%d",
+                                    newVideoParams.mfx.FrameInfo.Width, newVideoParams.mfx.FrameInfo.Height,
+                                    resetVideoParams.mfx.FrameInfo.Width, resetVideoParams.mfx.FrameInfo.Height);
+            }
+            else
             {
                 MFX_OMX_AUTO_TRACE_MSG("Reset decoder failed. Calling reinit");
                 mfx_res = MFX_ERR_NONE;
@@ -2598,7 +2931,7 @@ mfxStatus MfxOmxVdecComponent::ReinitCodec(void)
 
                 mfxFrameAllocRequest request;
                 MFX_OMX_ZERO_MEMORY(request);
-                mfx_res = m_pDEC->QueryIOSurf(&newVideoParams, &request);
+                mfx_res = m_pDEC->QueryIOSurf(&resetVideoParams, &request);
                 if (MFX_WRN_PARTIAL_ACCELERATION == mfx_res)
                 {
                     MFX_OMX_LOG_INFO("MFX_WRN_PARTIAL_ACCELERATION");
@@ -2611,10 +2944,11 @@ mfxStatus MfxOmxVdecComponent::ReinitCodec(void)
                     MFX_OMX_AUTO_TRACE_I32(m_pOutPortDef->nBufferCountMin);
                     if (nSurfacesRequired <= m_pOutPortDef->nBufferCountMin)
                     {
+                        ++m_Stats.nReinits;
                         mfx_res = m_pDEC->Close();
                         if (MFX_ERR_NONE == mfx_res)
                         {
-                            mfx_res = m_pDEC->Init(&newVideoParams);
+                            mfx_res = m_pDEC->Init(&resetVideoParams);
                             MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Decoder initialized with sts %d", mfx_res);
 
                             if (MFX_WRN_PARTIAL_ACCELERATION == mfx_res)
@@ -2644,6 +2978,7 @@ mfxStatus MfxOmxVdecComponent::ReinitCodec(void)
         {
             m_bChangeOutputPortSettings = true;
 
+            ++m_Stats.nReinits;
             mfx_res = m_pDEC->Close();
             if (MFX_ERR_NONE == mfx_res)
             {
@@ -2657,29 +2992,7 @@ mfxStatus MfxOmxVdecComponent::ReinitCodec(void)
 
                 MFX_OMX_AUTO_TRACE_MSG("Requesting change of output port settings");
 
-                mfxFrameAllocRequest request;
-                MFX_OMX_ZERO_MEMORY(request);
-
-                mfx_res = m_pDEC->QueryIOSurf(&newVideoParams, &request);
-                if (MFX_WRN_PARTIAL_ACCELERATION == mfx_res)
-                {
-                    MFX_OMX_LOG_INFO("MFX_WRN_PARTIAL_ACCELERATION");
-                    mfx_res = MFX_ERR_NONE;
-                }
-                if (MFX_ERR_NONE == mfx_res)
-                {
-                    m_nSurfacesNumMin = MFX_OMX_MAX(request.NumFrameSuggested,
-                                                    MFX_OMX_MAX(request.NumFrameMin, 1));
-                    m_nSurfacesNum = MFX_OMX_MAX(m_nSurfacesNumMin, 4);
-
-                    if (m_bOnFlySurfacesAllocation && m_bANWBufferInMetaData)
-                    {
-                        m_nSurfacesNumMin++;
-                        m_nSurfacesNum++;
-                    }
-                }
-                MFX_OMX_AUTO_TRACE_I32(m_nSurfacesNumMin);
-                MFX_OMX_AUTO_TRACE_I32(m_nSurfacesNum);
+                mfx_res = QuerySurfacesNum(&newVideoParams, NULL);
                 {
                     MfxOmxAutoLock lock(m_decoderMutex);
                     m_MfxVideoParams = newVideoParams;
@@ -2725,6 +3038,28 @@ mfxStatus MfxOmxVdecComponent::ReinitCodec(void)
 
 /*------------------------------------------------------------------------------*/
 
+/* Surfaces are allocated with m_nMaxFrameWidth x m_nMaxFrameHeight. If decoder is
+ * initialized with the same size, any later resolution change within it is handled
+ * by Reset without draining the port and reallocating buffers. Not applicable to
+ * system memory (frame size defines buffers layout), on fly allocation (surfaces
+ * follow stream size) and video processing (output size is fixed).
+ */
+void MfxOmxVdecComponent::SetPoolFrameSize(mfxVideoParam* pParams)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+
+    if (pParams && m_pDevice && !m_bUseSystemMemory && !m_bOnFlySurfacesAllocation && !m_bEnableVP)
+    {
+        pParams->mfx.FrameInfo.Width = (mfxU16)MFX_OMX_MAX(pParams->mfx.FrameInfo.Width, m_nMaxFrameWidth);
+        pParams->mfx.FrameInfo.Height = (mfxU16)MFX_OMX_MAX(pParams->mfx.FrameInfo.Height, m_nMaxFrameHeight);
+
+        MFX_OMX_AUTO_TRACE_I32(pParams->mfx.FrameInfo.Width);
+        MFX_OMX_AUTO_TRACE_I32(pParams->mfx.FrameInfo.Height);
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
 mfxStatus MfxOmxVdecComponent::GetCurrentHeaders(mfxBitstream *pSPS, mfxBitstream *pPPS)
 {
     MFX_OMX_AUTO_TRACE_FUNC();
@@ -2804,7 +3139,10 @@ mfxStatus MfxOmxVdecComponent::ResetOutput(void)
 
     if (m_pDEC)
     {
-        mfx_res = m_pDEC->Reset(&m_MfxVideoParams);
+        mfxVideoParam resetVideoParams = m_MfxVideoParams;
+        SetPoolFrameSize(&resetVideoParams);
+
+        mfx_res = m_pDEC->Reset(&resetVideoParams);
     }
 
     if (MFX_ERR_NOT_INITIALIZED == mfx_res) mfx_res = MFX_ERR_NONE;
@@ -2826,6 +3164,8 @@ mfxStatus MfxOmxVdecComponent::ResetCodec(void)
     MFX_OMX_AUTO_TRACE_FUNC();
     mfxStatus mfx_res = MFX_ERR_NONE, mfx_sts = MFX_ERR_NONE;
 
+    ++m_Stats.nResets;
+
     mfx_sts = ResetInput();
     if (MFX_ERR_NONE == mfx_res) mfx_res = mfx_sts;
     mfx_sts = ResetOutput();
@@ -2881,6 +3221,8 @@ void MfxOmxVdecComponent::CloseCodec(void)
     m_nSurfacesNum = 1;
     m_nSurfacesNumMin = 1;
     m_bChangeOutputPortSettings = false;
+    m_bHeadersPreparsed = false;
+    MFX_OMX_ZERO_MEMORY(m_StreamInfo);
 }
 
 /*------------------------------------------------------------------------------*/
@@ -2971,6 +3313,8 @@ mfxStatus MfxOmxVdecComponent::DecodeFrame(void)
             if (m_pBitstream) MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "DecodeFrameAsync+ DataLength %d, DataOffset %d", m_pBitstream->DataLength, m_pBitstream->DataOffset);
             else MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "DecodeFrameAsync(NULL)+");
 
+            if (m_pBitstream && m_pBitstream->DataLength)
+                m_Latency.Mark(MFX_OMX_LATENCY_POINT_SUBMIT, m_pBitstream->TimeStamp);
             mfx_res = m_pDEC->DecodeFrameAsync(m_pBitstream, pWorkSurface, &pOutSurface, pSyncPoint);
 
             if (m_pBitstream) MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "DecodeFrameAsync- sts %d, output surface %p, DataLength %d, DataOffset %d",
@@ -2986,6 +3330,7 @@ mfxStatus MfxOmxVdecComponent::DecodeFrame(void)
             {
                 mfxStatus mfx_sts = MFX_ERR_NONE;
                 MFX_OMX_AUTO_TRACE("mfx(DecodeFrameAsync)::MFX_WRN_DEVICE_BUSY");
+                ++m_Stats.nDeviceBusy;
                 mfxSyncPoint* pDevBusySyncPoint = m_pSurfaces->GetSyncPoint();
                 if (pDevBusySyncPoint)
                 {
@@ -3060,7 +3405,7 @@ mfxStatus MfxOmxVdecComponent::DecodeFrame(void)
                     }
                     else
                     {
-                        m_nCountDecodedFrames++;
+                        ++m_Stats.nProcessedFrames;
                         m_pFreeSyncPoint = NULL;
 
                         if (MFX_ERR_NONE == mfx_res)
@@ -3122,6 +3467,9 @@ void MfxOmxVdecComponent::AsyncThread(void)
                 }
                 if (MFX_ERR_NONE == mfx_res)
                 {
+                    MfxOmxBufferInfo* pBufInfo = MfxOmxGetOutputBufferInfo(m_pSurfaces->GetOutputBuffer());
+                    if (pBufInfo) m_Latency.Mark(MFX_OMX_LATENCY_POINT_SYNC, pBufInfo->sSurface.Data.TimeStamp);
+
                     if (!m_SyncPoints.Add(&pSyncPoint)) mfx_res = MFX_ERR_UNKNOWN;
                 }
                 else
@@ -3132,6 +3480,13 @@ void MfxOmxVdecComponent::AsyncThread(void)
                 if (MFX_ERR_NONE == mfx_res)
                 {
                     m_pSurfaces->DisplaySurface(m_bErrorReportingEnabled);
+
+                    mfxU64 flushStartTime = m_nFlushStartTime.exchange(0);
+                    if (flushStartTime)
+                    {
+                        MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Seek to first frame latency: %.2f ms",
+                            (mfx_omx_get_time_us() - flushStartTime) / 1000.0);
+                    }
                 }
                 if (MFX_ERR_NONE != mfx_res) // Error processing
                 {
@@ -3139,7 +3494,7 @@ void MfxOmxVdecComponent::AsyncThread(void)
                     MFX_OMX_LOG_ERROR("Sending ErrorEvent to OMAX client because of error in component");
                     MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "AsyncThread : m_Error = %d", m_Error);
                     MFX_OMX_AUTO_TRACE_I32(m_Error);
-                    m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, ErrorStatusMfxToOmx(m_Error), 0 , NULL);
+                    SendErrorEvent(ErrorStatusMfxToOmx(m_Error));
                 }
             }
             else
@@ -70,6 +70,7 @@ MfxOmxVencComponent::MfxOmxVencComponent(OMX_ERRORTYPE &error,
     MfxOmxComponent(error, self, reg_data, flags),
     m_Implementation(MFX_OMX_IMPLEMENTATION),
     m_pENC(NULL),
+    m_encoderMutex("venc_encoder"),
     m_MfxVideoParams(m_OmxMfxVideoParams),
     m_MfxEncodeCtrl(m_OmxMfxEncodeCtrl),
     m_eOmxControlRate(OMX_Video_ControlRateConstant),
@@ -91,7 +92,6 @@ MfxOmxVencComponent::MfxOmxVencComponent(OMX_ERRORTYPE &error,
     m_pSurfaces(NULL),
     m_pFreeSyncPoint(NULL),
     m_nEncoderInputSurfacesCount(0),
-    m_nEncoderOutputBitstreamsCount(0),
     m_blackFrame(NULL),
     m_lastTimeStamp(0xFFFFFFFFFFFFFFFF),
     m_priority(MFX_OMX_PRIORITY_PERFORMANCE),
@@ -101,6 +101,13 @@ MfxOmxVencComponent::MfxOmxVencComponent(OMX_ERRORTYPE &error,
     MFX_OMX_AUTO_TRACE_FUNC();
 
     MFX_OMX_ZERO_MEMORY(m_NextConfig);
+    for (mfxU32 i = 0; i < MFX_OMX_ENC_CHANGE_NUM; ++i) m_nParamsChanges[i] = 0;
+    m_nCoalescedConfigs = 0;
+    m_pLastQueuedParams = NULL;
+    m_nCodecDataSize = 0;
+    m_nNalLengthSize = 0;
+    m_nReservedEncodeCtrls = 0;
+    m_nEncodeCtrlAllocations = 0;
     m_NextConfig.mfxparams = &m_OmxMfxVideoParams;
 }
 
@@ -122,9 +129,13 @@ MfxOmxVencComponent::~MfxOmxVencComponent(void)
 
     MFX_OMX_DELETE(m_pDevice);
 
-    if (m_dbg_encin) fclose(m_dbg_encin);
-    if (m_dbg_encout) fclose(m_dbg_encout);
-    MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Encoded %d frames", m_nEncoderOutputBitstreamsCount);
+    mfx_omx_dump_close(m_dbg_encin);
+    mfx_omx_dump_close(m_dbg_encout);
+    MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Encoded %d frames", m_Stats.nProcessedFrames.load());
+    MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Params changes: ctrl %d, reset %d, reset with idr %d, reinit %d",
+                        m_nParamsChanges[MFX_OMX_ENC_CHANGE_CTRL].load(), m_nParamsChanges[MFX_OMX_ENC_CHANGE_RESET].load(),
+                        m_nParamsChanges[MFX_OMX_ENC_CHANGE_RESET_IDR].load(), m_nParamsChanges[MFX_OMX_ENC_CHANGE_REINIT].load());
+    MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Params changes coalesced: %d", m_nCoalescedConfigs);
     MFX_OMX_LOG_INFO("Destroyed %s", m_pRegData->m_name);
 }
 
@@ -153,7 +164,7 @@ OMX_ERRORTYPE MfxOmxVencComponent::Init(void)
         // encoder creation
         if (MFX_ERR_NONE == sts)
         {
-            MFX_OMX_NEW(m_pENC, MFXVideoENCODE(m_Session));
+            MFX_OMX_NEW(m_pENC, MfxOmxVideoENCODE(m_Session));
             if (!m_pENC) sts = MFX_ERR_MEMORY_ALLOC;
         }
         if (MFX_ERR_NONE != sts) error = OMX_ErrorUndefined;
@@ -518,6 +529,7 @@ mfxU16 MfxOmxVencComponent::GetAsyncDepth(void)
     }
     else if (frameRate > 30) asyncDepth = 2; // 60 fps camera
 
+    if (m_nForcedAsyncDepth) asyncDepth = m_nForcedAsyncDepth;
 
     MFX_OMX_AUTO_TRACE_I32(asyncDepth);
     return asyncDepth;
@@ -525,6 +537,24 @@ mfxU16 MfxOmxVencComponent::GetAsyncDepth(void)
 
 /*------------------------------------------------------------------------------*/
 
+void MfxOmxVencComponent::GetRuntimeStats(OMX_VIDEO_CONFIG_INTEL_RUNTIME_STATS* pStats)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+
+    pStats->nInputQueueDepth = m_input_queue.GetItemsCount();
+    if (m_pSurfaces)
+    {
+        pStats->nSurfacesHeld = m_pSurfaces->GetUsedBuffersCount();
+        pStats->nInputQueueDepth += m_pSurfaces->GetQueuedBuffersCount();
+    }
+    if (m_pBitstreams) pStats->nOutputQueueDepth = m_pBitstreams->GetQueuedBuffersCount();
+    pStats->nConfigResets = m_nParamsChanges[MFX_OMX_ENC_CHANGE_RESET];
+    pStats->nConfigResetsIdr = m_nParamsChanges[MFX_OMX_ENC_CHANGE_RESET_IDR];
+    pStats->nConfigReinits = m_nParamsChanges[MFX_OMX_ENC_CHANGE_REINIT];
+}
+
+/*------------------------------------------------------------------------------*/
+
 bool MfxOmxVencComponent::IsMiracastMode(void)
 {
     MFX_OMX_AUTO_TRACE_FUNC();
@@ -675,6 +705,7 @@ OMX_ERRORTYPE MfxOmxVencComponent::ValidateConfig(
 {
     MFX_OMX_AUTO_TRACE_FUNC();
     OMX_ERRORTYPE omx_res = OMX_ErrorUnsupportedIndex;
+    mfxU64 start = mfx_omx_get_time_us();
 
     // Mutex is need to 1) avoid race condition on setting parameters and encoder
     // initialization, 2) avoid using old data in Query below.
@@ -775,8 +806,26 @@ OMX_ERRORTYPE MfxOmxVencComponent::ValidateConfig(
             OMX_NALSTREAMFORMATTYPE* pParam = static_cast<OMX_NALSTREAMFORMATTYPE*>(pConfig);
             if (IsStructVersionValid<OMX_NALSTREAMFORMATTYPE>(pParam, sizeof(OMX_NALSTREAMFORMATTYPE), OMX_VERSION))
             {
-                if (OMX_NaluFormatStartCodes == pParam->eNaluFormat) omx_res = OMX_ErrorNone;
-                else omx_res = OMX_ErrorUnsupportedSetting;
+                omx_res = OMX_ErrorNone;
+                switch (pParam->eNaluFormat)
+                {
+                    case OMX_NaluFormatStartCodes:               m_nNalLengthSize = 0; break;
+                    case OMX_NaluFormatFourByteInterleaveLength: m_nNalLengthSize = 4; break;
+                    // size of NAL units is limited only by the output buffer size (there is no
+                    // max slice size control), so it should fit the prefix
+                    case OMX_NaluFormatTwoByteInterleaveLength:
+                    case OMX_NaluFormatOneByteInterleaveLength:
+                        {
+                            mfxU32 lengthSize = (OMX_NaluFormatTwoByteInterleaveLength == pParam->eNaluFormat) ? 2 : 1;
+
+                            if (m_pOutPortDef->nBufferSize > (1u << (8 * lengthSize))) omx_res = OMX_ErrorUnsupportedSetting;
+                            else m_nNalLengthSize = lengthSize;
+                        }
+                        break;
+                    default: omx_res = OMX_ErrorUnsupportedSetting; break;
+                }
+                if ((OMX_ErrorNone == omx_res) && m_pBitstreams) m_pBitstreams->SetNalLengthSize(m_nNalLengthSize);
+                MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "NAL stream format 0x%x, length size %d", pParam->eNaluFormat, m_nNalLengthSize);
             }
             else omx_res = OMX_ErrorVersionMismatch;
         }
@@ -797,6 +846,19 @@ OMX_ERRORTYPE MfxOmxVencComponent::ValidateConfig(
             nIndex,
             static_cast<OMX_CONFIG_INTRAREFRESHVOPTYPE*>(pConfig));
         break;
+    case MfxOmx_IndexIntelIdrRequest: // per-frame
+        MFX_OMX_AUTO_TRACE_MSG("MfxOmx_IndexIntelIdrRequest");
+        if (kind != eSetConfig) break;
+        omx_res = ValidateAndConvert(
+            config,
+            nIndex,
+            static_cast<OMX_VIDEO_CONFIG_INTEL_IDR_REQUEST*>(pConfig));
+        if (OMX_ErrorNone == omx_res)
+        {
+            config.nIdrHeaders = (OMX_TRUE == static_cast<OMX_VIDEO_CONFIG_INTEL_IDR_REQUEST*>(pConfig)->bInsertHeaders) ?
+                MFX_CODINGOPTION_ON : MFX_CODINGOPTION_OFF;
+        }
+        break;
     case OMX_IndexConfigVideoAVCIntraPeriod: // reset
         MFX_OMX_AUTO_TRACE_MSG("OMX_IndexConfigVideoAVCIntraPeriod");
         if ((kind != eSetConfig) && (kind != eSetParameter)) break;
@@ -1037,15 +1099,7 @@ OMX_ERRORTYPE MfxOmxVencComponent::ValidateConfig(
         if ((MFX_ERR_NONE != sts) && (MFX_WRN_INCOMPATIBLE_VIDEO_PARAM != sts))
         {
             MFX_OMX_DELETE(config.mfxparams);
-            if (config.control)
-            {
-                if (config.control->payload)
-                {
-                    MFX_OMX_DELETE(config.control->payload->Data);
-                }
-                MFX_OMX_DELETE(config.control->payload);
-            }
-            MFX_OMX_DELETE(config.control);
+            mfx_omx_put_encode_ctrl(config.control);
             omx_res = OMX_ErrorUnsupportedSetting;
         }
         else
@@ -1053,6 +1107,7 @@ OMX_ERRORTYPE MfxOmxVencComponent::ValidateConfig(
             if (!m_bInitialized)
             { // encoder was not yet initialized - we just aggregate parameters
                 m_OmxMfxVideoParams = *wrap;
+                m_pLastQueuedParams = NULL;
                 MFX_OMX_DELETE(config.mfxparams);
             }
             else
@@ -1063,10 +1118,21 @@ OMX_ERRORTYPE MfxOmxVencComponent::ValidateConfig(
                     m_NextConfig.mfxparams = &m_OmxMfxVideoParamsNext;
                 }
                 m_OmxMfxVideoParamsNext = *wrap;
+                m_pLastQueuedParams = wrap;
             }
         }
         MFX_OMX_AUTO_TRACE_MSG("m_NextConfig.params: what is...");
         MFX_OMX_AT__mfxVideoParam_enc((*m_NextConfig.mfxparams));
+
+        // one wrapper is allocated per config and copied on validation and on reset,
+        // a full copy would also take all disabled ext buffer slots
+        MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Config 0x%x validated in %llu us: wrapper of %d bytes allocated, %d bytes per copy (%d ext buffers in use, full copy %d bytes)",
+                            nIndex,
+                            (unsigned long long)(mfx_omx_get_time_us() - start),
+                            (int)sizeof(MfxOmxVideoParamsWrapper),
+                            (int)m_NextConfig.mfxparams->getCopySize(),
+                            m_NextConfig.mfxparams->NumExtParam,
+                            (int)(sizeof(mfxVideoParam) + MFX_OMX_ENCODE_VIDEOPARAM_EXTBUF_MAX_NUM * sizeof(MfxOmxExtBuffer)));
     }
 
     MFX_OMX_AUTO_TRACE_U32(omx_res);
@@ -1391,6 +1457,8 @@ OMX_ERRORTYPE MfxOmxVencComponent::EmptyThisBuffer(
 
     if (OMX_ErrorNone == omx_res)
     {
+        if (pBuffer->nFilledLen) m_Latency.Mark(MFX_OMX_LATENCY_POINT_INPUT, OMX2MFX_TIME(pBuffer->nTimeStamp));
+
         MfxOmxInputData input;
         MFX_OMX_ZERO_MEMORY(input);
 
@@ -1510,6 +1578,24 @@ OMX_ERRORTYPE MfxOmxVencComponent::GetParameter(
                 else omx_res = OMX_ErrorVersionMismatch;
             }
             break;
+        case OMX_IndexParamNalStreamFormat:
+            {
+                MFX_OMX_AUTO_TRACE_MSG("OMX_IndexParamNalStreamFormat");
+                OMX_NALSTREAMFORMATTYPE* pParam = (OMX_NALSTREAMFORMATTYPE*)pComponentParameterStructure;
+                if (IsStructVersionValid<OMX_NALSTREAMFORMATTYPE>(pParam, sizeof(OMX_NALSTREAMFORMATTYPE), OMX_VERSION))
+                {
+                    switch (m_nNalLengthSize)
+                    {
+                        case 4:  pParam->eNaluFormat = OMX_NaluFormatFourByteInterleaveLength; break;
+                        case 2:  pParam->eNaluFormat = OMX_NaluFormatTwoByteInterleaveLength; break;
+                        case 1:  pParam->eNaluFormat = OMX_NaluFormatOneByteInterleaveLength; break;
+                        default: pParam->eNaluFormat = OMX_NaluFormatStartCodes; break;
+                    }
+                    omx_res = OMX_ErrorNone;
+                }
+                else omx_res = OMX_ErrorVersionMismatch;
+            }
+            break;
         case OMX_IndexParamIntelAVCVUI:
             MFX_OMX_AUTO_TRACE_MSG("OMX_IndexParamIntelAVCVUI");
             omx_res = mfx2omx(
@@ -1908,7 +1994,8 @@ OMX_ERRORTYPE MfxOmxVencComponent::GetBlackFrame(OMX_VIDEO_INTEL_REQUEST_BALCK_F
         buffer_handle_t handle = NULL;
 
         MfxOmxGrallocAllocator * gralloc = m_pDevice->GetGrallocAllocator();
-        mfx_res = gralloc->Alloc(m_MfxVideoParams.mfx.FrameInfo.Width, m_MfxVideoParams.mfx.FrameInfo.Height, handle);
+        if (gralloc) mfx_res = gralloc->Alloc(m_MfxVideoParams.mfx.FrameInfo.Width, m_MfxVideoParams.mfx.FrameInfo.Height, handle);
+        else mfx_res = MFX_ERR_UNSUPPORTED; // mock backend has no gralloc
 
         mfxFrameData data = {};
         if (MFX_ERR_NONE == mfx_res)
@@ -1945,7 +2032,6 @@ void MfxOmxVencComponent::BufferReleased(
     mfxStatus error)
 {
     MFX_OMX_AUTO_TRACE_FUNC();
-    MFX_OMX_UNUSED(error);
     if (id == m_pSurfaces->GetPoolId())
     {
         char name[25];
@@ -1963,6 +2049,14 @@ void MfxOmxVencComponent::BufferReleased(
 
         MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "FillBufferDone(%p) nFilledLen %d, nTimeStamp %lld, nFlags 0x%x",
                             pBuffer, pBuffer->nFilledLen, pBuffer->nTimeStamp, pBuffer->nFlags);
+        if (pBuffer->nFilledLen && !(pBuffer->nFlags & OMX_BUFFERFLAG_CODECCONFIG))
+            m_Latency.Mark(MFX_OMX_LATENCY_POINT_OUTPUT, OMX2MFX_TIME(pBuffer->nTimeStamp));
+        ++m_Stats.nOutputBuffers;
+        if (MFX_ERR_NONE != error)
+        {
+            // frame could not be delivered in the negotiated format and was dropped
+            SendErrorEvent(ErrorStatusMfxToOmx(error));
+        }
         m_pCallbacks->FillBufferDone(m_self, m_pAppData, pBuffer);
     }
 }
@@ -2053,7 +2147,7 @@ OMX_ERRORTYPE MfxOmxVencComponent::CommandStateSet(OMX_STATETYPE new_state)
     MFX_OMX_AUTO_TRACE_I32(new_state);
     if (new_state == m_state)
     {
-        m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, (OMX_U32)OMX_ErrorSameState, 0 , NULL);
+        SendErrorEvent(OMX_ErrorSameState);
     }
     else
     {
@@ -2062,7 +2156,7 @@ OMX_ERRORTYPE MfxOmxVencComponent::CommandStateSet(OMX_STATETYPE new_state)
         case OMX_StateInvalid:
             MFX_OMX_AUTO_TRACE_MSG("OMX_StateInvalid");
             m_state = OMX_StateInvalid;
-            m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, (OMX_U32)OMX_ErrorInvalidState, 0, NULL);
+            SendErrorEvent(OMX_ErrorInvalidState);
             m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventCmdComplete, (OMX_U32)OMX_CommandStateSet, m_state, NULL);
             break;
         case OMX_StateLoaded:
@@ -2086,7 +2180,7 @@ OMX_ERRORTYPE MfxOmxVencComponent::CommandStateSet(OMX_STATETYPE new_state)
             else
             {
                 MFX_OMX_LOG_ERROR("error: OMX_ErrorIncorrectStateTransition");
-                m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, (OMX_U32)OMX_ErrorIncorrectStateTransition, 0, NULL);
+                SendErrorEvent(OMX_ErrorIncorrectStateTransition);
             }
             break;
         case OMX_StateIdle:
@@ -2094,11 +2188,12 @@ OMX_ERRORTYPE MfxOmxVencComponent::CommandStateSet(OMX_STATETYPE new_state)
             if (OMX_StateInvalid == m_state)
             {
                 MFX_OMX_LOG_ERROR("error: OMX_ErrorIncorrectStateTransition");
-                m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, (OMX_U32)OMX_ErrorIncorrectStateTransition, 0, NULL);
+                SendErrorEvent(OMX_ErrorIncorrectStateTransition);
             }
             else
             {
                 m_state_to_set = OMX_StateIdle;
+                if ((OMX_StateExecuting == m_state) || (OMX_StatePause == m_state)) m_Latency.Reset();
                 if (OMX_StateExecuting == m_state)
                 { // resetting codec
                     ResetCodec();
@@ -2125,7 +2220,7 @@ OMX_ERRORTYPE MfxOmxVencComponent::CommandStateSet(OMX_STATETYPE new_state)
             else
             {
                 MFX_OMX_LOG_ERROR("error: OMX_ErrorIncorrectStateTransition");
-                m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, (OMX_U32)OMX_ErrorIncorrectStateTransition, 0, NULL);
+                SendErrorEvent(OMX_ErrorIncorrectStateTransition);
             }
             break;
         case OMX_StatePause:
@@ -2138,7 +2233,7 @@ OMX_ERRORTYPE MfxOmxVencComponent::CommandStateSet(OMX_STATETYPE new_state)
             else
             {
                 MFX_OMX_LOG_ERROR("error: OMX_ErrorIncorrectStateTransition");
-                m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, (OMX_U32)OMX_ErrorIncorrectStateTransition, 0, NULL);
+                SendErrorEvent(OMX_ErrorIncorrectStateTransition);
             }
             break;
         case OMX_StateWaitForResources:
@@ -2151,7 +2246,7 @@ OMX_ERRORTYPE MfxOmxVencComponent::CommandStateSet(OMX_STATETYPE new_state)
             else
             {
                 MFX_OMX_LOG_ERROR("error: OMX_ErrorIncorrectStateTransition");
-                m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, (OMX_U32)OMX_ErrorIncorrectStateTransition, 0, NULL);
+                SendErrorEvent(OMX_ErrorIncorrectStateTransition);
             }
             break;
         default:
@@ -2280,6 +2375,9 @@ OMX_ERRORTYPE MfxOmxVencComponent::CommandFlush(OMX_U32 nPortIndex)
     OMX_ERRORTYPE omx_res = OMX_ErrorNone;
     mfxStatus mfx_sts = MFX_ERR_NONE;
 
+    // flushed frames never reach the output, their time stamps may come again after seek
+    m_Latency.Reset();
+
     MFX_OMX_AUTO_TRACE_I32(nPortIndex);
     if ((MFX_OMX_INPUT_PORT_INDEX == nPortIndex) || (OMX_ALL == nPortIndex))
     {
@@ -2298,7 +2396,7 @@ OMX_ERRORTYPE MfxOmxVencComponent::CommandFlush(OMX_U32 nPortIndex)
             MFX_OMX_LOG_ERROR("Flush input buffers failed");
             MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "CommandFlush : Flush input buffers failed : mfx_sts = %d", mfx_sts);
             MFX_OMX_AUTO_TRACE_I32(mfx_sts);
-            m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, ErrorStatusMfxToOmx(mfx_sts), 0 , NULL);
+            SendErrorEvent(ErrorStatusMfxToOmx(mfx_sts));
         }
     }
     if ((MFX_OMX_OUTPUT_PORT_INDEX == nPortIndex) || (OMX_ALL == nPortIndex))
@@ -2317,7 +2415,7 @@ OMX_ERRORTYPE MfxOmxVencComponent::CommandFlush(OMX_U32 nPortIndex)
             MFX_OMX_LOG_ERROR("Flush output buffers failed");
             MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "CommandFlush : Flush output buffers failed : mfx_sts = %d", mfx_sts);
             MFX_OMX_AUTO_TRACE_I32(mfx_sts);
-            m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, ErrorStatusMfxToOmx(mfx_sts), 0 , NULL);
+            SendErrorEvent(ErrorStatusMfxToOmx(mfx_sts));
         }
     }
     if ((MFX_OMX_INPUT_PORT_INDEX != nPortIndex) && (MFX_OMX_OUTPUT_PORT_INDEX != nPortIndex) && (OMX_ALL != nPortIndex))
@@ -2356,8 +2454,10 @@ void MfxOmxVencComponent::MainThread(void)
             MFX_OMX_AUTO_TRACE("Got new command");
             MFX_OMX_AUTO_TRACE_I32(command.m_command);
 
+            if (IsDrainingCommand(command))
             {
                 MFX_OMX_AUTO_TRACE("Awaiting for m_pAllSyncOpFinished");
+                ++m_Stats.nDrains;
                 m_pAllSyncOpFinished->Wait();
             }
 
@@ -2388,9 +2488,25 @@ void MfxOmxVencComponent::MainThread(void)
         {
             if (input.config.mfxparams)
             {
-                MFX_OMX_AUTO_TRACE_MSG("Trying to reset encoder");
                 MfxOmxAutoLock lock(m_encoderMutex);
-                m_Error = ReinitCodec(input.config.mfxparams);
+                if (input.config.mfxparams != m_pLastQueuedParams)
+                {
+                    // a newer config was validated meanwhile: it is built on top
+                    // of this one and is applied when dequeued, so a burst of
+                    // configs ends up in a single encoder reset
+                    ++m_nCoalescedConfigs;
+                }
+                else if (m_bInitialized)
+                {
+                    MFX_OMX_AUTO_TRACE_MSG("Trying to reset encoder");
+                    m_Error = ReinitCodec(input.config.mfxparams);
+                    m_pLastQueuedParams = NULL;
+                }
+                else
+                { // encoder was closed meanwhile - it will be initialized with new parameters
+                    m_OmxMfxVideoParams = *input.config.mfxparams;
+                    m_pLastQueuedParams = NULL;
+                }
                 MFX_OMX_DELETE(input.config.mfxparams);
             }
             aggregator += input.config;
@@ -2435,7 +2551,7 @@ void MfxOmxVencComponent::MainThread(void)
             MFX_OMX_LOG_ERROR("Sending ErrorEvent to OMAX client because of error in component");
             MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "MainThread : m_Error = %d", m_Error);
             MFX_OMX_AUTO_TRACE_I32(m_Error);
-            m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, ErrorStatusMfxToOmx(m_Error), 0 , NULL);
+            SendErrorEvent(ErrorStatusMfxToOmx(m_Error));
         }
     }
 }
@@ -2568,6 +2684,12 @@ mfxStatus MfxOmxVencComponent::InitEncoder(void)
     {
         m_bInitialized = true;
 
+        // per-frame controls live with surfaces held by the encoder: frames in flight
+        // plus frames buffered for reordering
+        m_nReservedEncodeCtrls = m_MfxVideoParams.AsyncDepth + MFX_OMX_MAX(m_MfxVideoParams.mfx.GopRefDist, 1);
+        m_EncodeCtrlPool.Reserve(m_nReservedEncodeCtrls);
+        m_nEncodeCtrlAllocations = m_EncodeCtrlPool.GetAllocationsCount();
+
         if (m_pOutPortDef->nBufferSize < m_MfxVideoParams.mfx.BufferSizeInKB * 1000 * m_MfxVideoParams.mfx.BRCParamMultiplier)
         {
             m_bChangeOutputPortSettings = true;
@@ -2633,26 +2755,145 @@ mfxStatus MfxOmxVencComponent::InitVPP(void)
 
 /*------------------------------------------------------------------------------*/
 
+/* Compares new parameters with the current ones and returns the cheapest
+ * action which applies them.
+ */
+MfxOmxEncParamsChange MfxOmxVencComponent::GetParamsChange(const MfxOmxVideoParamsWrapper& newParams)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    MfxOmxEncParamsChange change = MFX_OMX_ENC_CHANGE_CTRL;
+
+    const mfxInfoMFX& oldMfx = m_MfxVideoParams.mfx;
+    mfxInfoMFX newMfx = newParams.mfx;
+
+    if ((oldMfx.CodecId != newMfx.CodecId) ||
+        (oldMfx.RateControlMethod != newMfx.RateControlMethod) ||
+        (oldMfx.LowPower != newMfx.LowPower) ||
+        (oldMfx.FrameInfo.FourCC != newMfx.FrameInfo.FourCC) ||
+        (oldMfx.FrameInfo.ChromaFormat != newMfx.FrameInfo.ChromaFormat) ||
+        (oldMfx.FrameInfo.Width < newMfx.FrameInfo.Width) ||
+        (oldMfx.FrameInfo.Height < newMfx.FrameInfo.Height) ||
+        (m_MfxVideoParams.IOPattern != newParams.IOPattern))
+    {
+        change = MFX_OMX_ENC_CHANGE_REINIT;
+    }
+    else
+    {
+        // rate control parameters (they share memory with QP values) are changed by BRC reset
+        if ((oldMfx.TargetKbps != newMfx.TargetKbps) ||
+            (oldMfx.MaxKbps != newMfx.MaxKbps) ||
+            (oldMfx.InitialDelayInKB != newMfx.InitialDelayInKB) ||
+            (oldMfx.BufferSizeInKB != newMfx.BufferSizeInKB) ||
+            (oldMfx.BRCParamMultiplier != newMfx.BRCParamMultiplier) ||
+            (oldMfx.FrameInfo.FrameRateExtN != newMfx.FrameInfo.FrameRateExtN) ||
+            (oldMfx.FrameInfo.FrameRateExtD != newMfx.FrameInfo.FrameRateExtD))
+        {
+            change = MFX_OMX_ENC_CHANGE_RESET;
+        }
+        newMfx.TargetKbps = oldMfx.TargetKbps;
+        newMfx.MaxKbps = oldMfx.MaxKbps;
+        newMfx.InitialDelayInKB = oldMfx.InitialDelayInKB;
+        newMfx.BufferSizeInKB = oldMfx.BufferSizeInKB;
+        newMfx.BRCParamMultiplier = oldMfx.BRCParamMultiplier;
+        newMfx.FrameInfo.FrameRateExtN = oldMfx.FrameInfo.FrameRateExtN;
+        newMfx.FrameInfo.FrameRateExtD = oldMfx.FrameInfo.FrameRateExtD;
+
+        // anything else in mfxInfoMFX (GOP, slices, references, profile, crops) needs new sequence
+        if (memcmp(&oldMfx, &newMfx, sizeof(mfxInfoMFX))) change = MFX_OMX_ENC_CHANGE_RESET_IDR;
+
+        for (mfxU32 i = 0; (i < newParams.NumExtParam) && (MFX_OMX_ENC_CHANGE_RESET_IDR != change); ++i)
+        {
+            const mfxExtBuffer& header = newParams.ext_buf[i].header;
+
+            if (MFX_EXTBUFF_ENCODER_RESET_OPTION == header.BufferId)
+            {
+                if (MFX_CODINGOPTION_ON == newParams.ext_buf[i].reset.StartNewSequence)
+                    change = MFX_OMX_ENC_CHANGE_RESET_IDR;
+                continue;
+            }
+
+            int idx = m_OmxMfxVideoParams.getExtParamIdx(header.BufferId);
+            if ((idx < 0) ||
+                (m_OmxMfxVideoParams.ext_buf[idx].header.BufferSz != header.BufferSz) ||
+                memcmp(&m_OmxMfxVideoParams.ext_buf[idx], &newParams.ext_buf[i], header.BufferSz))
+            {
+                change = MFX_OMX_ENC_CHANGE_RESET_IDR;
+            }
+        }
+    }
+    ++m_nParamsChanges[change];
+
+    MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Params change class %d", change);
+    MFX_OMX_AUTO_TRACE_I32(change);
+    return change;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxVencComponent::ResetEncoder(MfxOmxVideoParamsWrapper* wrap, MfxOmxEncParamsChange change)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    mfxStatus mfx_res = MFX_ERR_NONE;
+
+    int idx = wrap->getExtParamIdx(MFX_EXTBUFF_ENCODER_RESET_OPTION);
+
+    if (MFX_OMX_ENC_CHANGE_RESET == change)
+    {
+        // BRC reset does not need frames in flight to be finished and new sequence to be started
+        if (idx >= 0) wrap->ext_buf[idx].reset.StartNewSequence = MFX_CODINGOPTION_OFF;
+
+        mfx_res = m_pENC->Reset(wrap);
+        if (MFX_WRN_INCOMPATIBLE_VIDEO_PARAM == mfx_res) mfx_res = MFX_ERR_NONE;
+        if (MFX_ERR_NONE != mfx_res)
+        {
+            MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Reset without new sequence failed with %d, starting new sequence", mfx_res);
+            if (idx >= 0) wrap->ext_buf[idx].reset.StartNewSequence = MFX_CODINGOPTION_UNKNOWN;
+            change = MFX_OMX_ENC_CHANGE_RESET_IDR;
+        }
+    }
+    if ((MFX_OMX_ENC_CHANGE_RESET_IDR == change) || (MFX_OMX_ENC_CHANGE_REINIT == change))
+    {
+        // surfaces, bitstreams and sync points are sized for the current parameters,
+        // so changes which do not fit them are left to Reset to reject and roll back
+        ++m_Stats.nDrains;
+        m_pAllSyncOpFinished->Wait();
+
+        mfx_res = m_pENC->Reset(wrap);
+        if (MFX_WRN_INCOMPATIBLE_VIDEO_PARAM == mfx_res) mfx_res = MFX_ERR_NONE;
+    }
+    MFX_OMX_AUTO_TRACE_I32(mfx_res);
+    return mfx_res;
+}
+
+/*------------------------------------------------------------------------------*/
+
 mfxStatus MfxOmxVencComponent::ReinitCodec(MfxOmxVideoParamsWrapper* wrap)
 {
     MFX_OMX_AUTO_TRACE_FUNC();
     MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Reinit encoder+");
     mfxStatus mfx_res = MFX_ERR_NONE;
 
-    m_pAllSyncOpFinished->Wait();
-
     MFX_OMX_AT__mfxVideoParam_enc((*wrap));
 
-    mfx_res = m_pENC->Reset(wrap);
-    if (MFX_WRN_INCOMPATIBLE_VIDEO_PARAM == mfx_res)
+    MfxOmxEncParamsChange change = GetParamsChange(*wrap);
+    if (MFX_OMX_ENC_CHANGE_CTRL == change)
     {
-        MFX_OMX_AUTO_TRACE_MSG("[WRN] MFX_WRN_INCOMPATIBLE_VIDEO_PARAM was received.");
-        mfx_res = MFX_ERR_NONE;
+        MFX_OMX_AUTO_TRACE_MSG("parameters are the same, nothing to reset");
+        m_OmxMfxVideoParamsNext = m_OmxMfxVideoParams;
+
+        MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Reinit encoder-");
+        MFX_OMX_AUTO_TRACE_I32(mfx_res);
+        return mfx_res;
     }
+
+    mfx_res = ResetEncoder(wrap, change);
     if (MFX_ERR_NONE != mfx_res)
     {
         MFX_OMX_AUTO_TRACE_MSG("failed to reset codec, trying to roll back");
 
+        ++m_Stats.nDrains;
+        m_pAllSyncOpFinished->Wait();
+
         mfx_res = m_pENC->Reset(&m_MfxVideoParams);
         if (MFX_WRN_INCOMPATIBLE_VIDEO_PARAM == mfx_res)
         {
@@ -2670,6 +2911,17 @@ mfxStatus MfxOmxVencComponent::ReinitCodec(MfxOmxVideoParamsWrapper* wrap)
     {
         mfx_res = m_pENC->GetVideoParam(&m_MfxVideoParams);
     }
+    if ((MFX_ERR_NONE == mfx_res) && m_nCodecDataSize)
+    {
+        // codec config was sent already: if parameter sets changed, downstream
+        // gets them in-band with the next IDR even if headers are removed
+        bool bChanged = false;
+
+        if (MFX_ERR_NONE == UpdateCodecData(&bChanged) && bChanged)
+        {
+            m_pBitstreams->KeepHeadersOnNextIdr();
+        }
+    }
     if (MFX_ERR_NONE == mfx_res)
     {
         m_OmxMfxVideoParamsNext = m_OmxMfxVideoParams;
@@ -2747,6 +2999,8 @@ mfxStatus MfxOmxVencComponent::ResetCodec(void)
     MFX_OMX_AUTO_TRACE_FUNC();
     mfxStatus mfx_res = MFX_ERR_NONE, mfx_sts = MFX_ERR_NONE;
 
+    ++m_Stats.nResets;
+
     mfx_sts = ResetInput();
     if (MFX_ERR_NONE == mfx_res) mfx_res = mfx_sts;
     mfx_sts = ResetOutput();
@@ -2772,9 +3026,22 @@ void MfxOmxVencComponent::CloseCodec(void)
     }
     while (m_SyncPoints.Get(&m_pFreeSyncPoint, g_NilSyncPoint));
 
+    if (m_nReservedEncodeCtrls)
+    {
+        mfxU32 allocations = m_EncodeCtrlPool.GetAllocationsCount() - m_nEncodeCtrlAllocations;
+        if (allocations)
+        {
+            MFX_OMX_LOG_ERROR("Encode ctrls allocated on heap while encoding: %d", allocations);
+        }
+        m_EncodeCtrlPool.Reserve(-(mfxI32)m_nReservedEncodeCtrls);
+    }
+
     // return parameters to initial state
     m_bInitialized = false;
     m_nSurfacesNum = 0;
+    m_nCodecDataSize = 0;
+    m_nReservedEncodeCtrls = 0;
+    m_nEncodeCtrlAllocations = 0;
 }
 
 /*------------------------------------------------------------------------------*/
@@ -2873,7 +3140,7 @@ mfxStatus MfxOmxVencComponent::ProcessFrameEnc(bool bHandleEos)
                 {
                     if (NULL == pEncodeCtrl)
                     {
-                        if (config) pEncodeCtrl = config->control = CreateEncodeCtrlWrapper();
+                        if (config) pEncodeCtrl = config->control = mfx_omx_get_encode_ctrl(&m_EncodeCtrlPool);
                         if (NULL == pEncodeCtrl) mfx_res = MFX_ERR_NULL_PTR;
                     }
                 }
@@ -2888,7 +3155,7 @@ mfxStatus MfxOmxVencComponent::ProcessFrameEnc(bool bHandleEos)
                 {
                     if (NULL == pEncodeCtrl)
                     {
-                         if (config) pEncodeCtrl = config->control = CreateEncodeCtrlWrapper();
+                         if (config) pEncodeCtrl = config->control = mfx_omx_get_encode_ctrl(&m_EncodeCtrlPool);
                          if (NULL == pEncodeCtrl) mfx_res = MFX_ERR_NULL_PTR;
                     }
                     if (MFX_ERR_NONE == mfx_res)
@@ -2923,12 +3190,14 @@ mfxStatus MfxOmxVencComponent::ProcessFrameEnc(bool bHandleEos)
                 do
                 {
                     MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "EncodeFrameAsync+");
+                    if (pSurfaceToEncode) m_Latency.Mark(MFX_OMX_LATENCY_POINT_SUBMIT, pSurfaceToEncode->Data.TimeStamp);
                     mfx_res = m_pENC->EncodeFrameAsync(pEncodeCtrl, pSurfaceToEncode, pBitstream, pSyncPoint);
                     MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "EncodeFrameAsync- sts %d", mfx_res);
                     if (MFX_WRN_DEVICE_BUSY == mfx_res)
                     {
                         mfxStatus mfx_sts = MFX_ERR_NONE;
                         MFX_OMX_AUTO_TRACE("mfx(EncodeFrameAsync)::MFX_WRN_DEVICE_BUSY");
+                        ++m_Stats.nDeviceBusy;
                         mfxSyncPoint* pDevBusySyncPoint = m_pBitstreams->GetSyncPoint();
                         if (pDevBusySyncPoint)
                         {
@@ -2962,11 +3231,17 @@ mfxStatus MfxOmxVencComponent::ProcessFrameEnc(bool bHandleEos)
             {
                 ++m_nEncoderInputSurfacesCount;
                 if (pSurfaceToEncode) m_lastTimeStamp = pSurfaceToEncode->Data.TimeStamp;
+                if (pSurfaceToEncode && config && config->nIdrHeaders)
+                {
+                    // Media SDK puts the timestamp of the frame to its bitstream
+                    m_pBitstreams->SetIdrHeaders(pSurfaceToEncode->Data.TimeStamp, MFX_CODINGOPTION_ON == config->nIdrHeaders);
+                    config->nIdrHeaders = 0;
+                }
 
                 if (MFX_ERR_NONE == mfx_res)
                 {
-                    ++m_nEncoderOutputBitstreamsCount;
-                    MFX_OMX_AUTO_TRACE_I32(m_nEncoderOutputBitstreamsCount);
+                    ++m_Stats.nProcessedFrames;
+                    MFX_OMX_AUTO_TRACE_I32(m_Stats.nProcessedFrames.load());
 
                     MFX_OMX_AUTO_TRACE_P(pSyncPoint);
                     mfx_res = m_pBitstreams->QueueBufferForSending(pBitstream, pSyncPoint);
@@ -3000,21 +3275,21 @@ mfxStatus MfxOmxVencComponent::ProcessFrameEnc(bool bHandleEos)
 
 /*------------------------------------------------------------------------------*/
 
-mfxStatus MfxOmxVencComponent::SendCodecData(void)
+/* Queries parameter sets (VPS for HEVC, SPS and PPS) from the encoder into
+ * m_CodecData. The cache lives until encoder parameters are changed.
+ */
+mfxStatus MfxOmxVencComponent::UpdateCodecData(bool* pbChanged)
 {
     MFX_OMX_AUTO_TRACE_FUNC();
     mfxStatus mfx_res = MFX_ERR_NONE;
 
-    mfxBitstream* pBitstream = NULL;
-
-    pBitstream = m_pBitstreams->GetBuffer();
-
     mfxExtCodingOptionSPSPPS spspps;
     MFX_OMX_ZERO_MEMORY(spspps);
     mfxExtCodingOptionVPS vps;
     MFX_OMX_ZERO_MEMORY(vps);
 
-    mfxU8 buf[1024] = {0};
+    mfxU8 buf[MFX_OMX_CODEC_DATA_MAX_SIZE] = {0};
+    mfxU32 size = 0;
     mfxExtBuffer* tmp_pExtBuf = &vps.Header;
 
     if (MFX_CODEC_HEVC == m_MfxVideoParams.mfx.CodecId)
@@ -3027,22 +3302,13 @@ mfxStatus MfxOmxVencComponent::SendCodecData(void)
         vps.Header.BufferId = MFX_EXTBUFF_CODING_OPTION_VPS;
         vps.Header.BufferSz = sizeof(mfxExtCodingOptionVPS);
         vps.VPSBuffer = buf;
-        vps.VPSBufSize = 512;
+        vps.VPSBufSize = MFX_OMX_CODEC_DATA_MAX_SIZE / 3;
 
         tmp_par.NumExtParam = 1;
         tmp_par.ExtParam = &tmp_pExtBuf;
 
         mfx_res = m_pENC->GetVideoParam(&tmp_par);
-        if (MFX_ERR_NONE == mfx_res && pBitstream)
-        {
-            if (vps.VPSBufSize <= pBitstream->MaxLength - (pBitstream->DataOffset + pBitstream->DataLength))
-            {
-                std::copy(vps.VPSBuffer, vps.VPSBuffer + vps.VPSBufSize, pBitstream->Data + pBitstream->DataOffset + pBitstream->DataLength);
-                pBitstream->DataLength += vps.VPSBufSize;
-            }
-            else
-                mfx_res = MFX_ERR_NOT_ENOUGH_BUFFER;
-        }
+        if (MFX_ERR_NONE == mfx_res) size += vps.VPSBufSize;
     }
 
     if (MFX_ERR_NONE == mfx_res)
@@ -3052,34 +3318,71 @@ mfxStatus MfxOmxVencComponent::SendCodecData(void)
 
         tmp_pExtBuf = &spspps.Header;
 
+        // SPS and PPS go right after VPS, so buffer holds all headers in order
         spspps.Header.BufferId = MFX_EXTBUFF_CODING_OPTION_SPSPPS;
         spspps.Header.BufferSz = sizeof(mfxExtCodingOptionSPSPPS);
-        spspps.SPSBuffer = buf;
-        spspps.SPSBufSize = 512;
-        spspps.PPSBuffer = buf + spspps.SPSBufSize;
-        spspps.PPSBufSize = 512;
+        spspps.SPSBuffer = buf + size;
+        spspps.SPSBufSize = MFX_OMX_CODEC_DATA_MAX_SIZE / 3;
+        spspps.PPSBuffer = spspps.SPSBuffer + spspps.SPSBufSize;
+        spspps.PPSBufSize = MFX_OMX_CODEC_DATA_MAX_SIZE / 3;
 
         tmp_par.NumExtParam = 1;
         tmp_par.ExtParam = &tmp_pExtBuf;
 
         mfx_res = m_pENC->GetVideoParam(&tmp_par);
     }
-    if (MFX_ERR_NONE == mfx_res && pBitstream)
+    if (MFX_ERR_NONE == mfx_res)
     {
-        if (spspps.SPSBufSize <= pBitstream->MaxLength - (pBitstream->DataOffset + pBitstream->DataLength))
+        // PPS was written after space reserved for SPS, close the gap
+        memmove(buf + size + spspps.SPSBufSize, spspps.PPSBuffer, spspps.PPSBufSize);
+        size += spspps.SPSBufSize + spspps.PPSBufSize;
+
+        bool bChanged = (size != m_nCodecDataSize) || memcmp(buf, m_CodecData, size);
+        if (bChanged)
         {
-            std::copy(spspps.SPSBuffer, spspps.SPSBuffer + spspps.SPSBufSize, pBitstream->Data + pBitstream->DataOffset + pBitstream->DataLength);
-            pBitstream->DataLength += spspps.SPSBufSize;
+            std::copy(buf, buf + size, m_CodecData);
+            m_nCodecDataSize = size;
         }
-        else
-            mfx_res = MFX_ERR_NOT_ENOUGH_BUFFER;
+        if (pbChanged) *pbChanged = bChanged;
+        MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Codec data of %d bytes cached, changed %d", m_nCodecDataSize, bChanged);
+    }
+
+    MFX_OMX_AUTO_TRACE_I32(mfx_res);
+    return mfx_res;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxVencComponent::SendCodecData(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    mfxStatus mfx_res = MFX_ERR_NONE;
+
+    mfxBitstream* pBitstream = NULL;
+
+    pBitstream = m_pBitstreams->GetBuffer();
+
+    if (!m_nCodecDataSize) mfx_res = UpdateCodecData(NULL);
+
+    mfxU8* data = m_CodecData;
+    mfxU32 size = m_nCodecDataSize;
+    // record has 2 bytes length instead of start code per NAL unit plus fixed header
+    mfxU8 record[MFX_OMX_CODEC_DATA_MAX_SIZE + 64];
+
+    if (MFX_ERR_NONE == mfx_res && m_nNalLengthSize)
+    {
+        size = sizeof(record);
+        mfx_res = mfx_omx_make_codec_config_record(m_MfxVideoParams.mfx.CodecId, m_CodecData, m_nCodecDataSize,
+                                                   m_nNalLengthSize, m_MfxVideoParams.mfx.FrameInfo, record, size);
+        data = record;
+        MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Codec config record of %d bytes, sts %d", size, mfx_res);
     }
     if (MFX_ERR_NONE == mfx_res && pBitstream)
     {
-        if (spspps.PPSBufSize <= pBitstream->MaxLength - (pBitstream->DataOffset + pBitstream->DataLength))
+        if (size <= pBitstream->MaxLength - (pBitstream->DataOffset + pBitstream->DataLength))
         {
-            std::copy(spspps.PPSBuffer, spspps.PPSBuffer + spspps.PPSBufSize, pBitstream->Data + pBitstream->DataOffset + pBitstream->DataLength);
-            pBitstream->DataLength += spspps.PPSBufSize;
+            std::copy(data, data + size, pBitstream->Data + pBitstream->DataOffset + pBitstream->DataLength);
+            pBitstream->DataLength += size;
         }
         else
             mfx_res = MFX_ERR_NOT_ENOUGH_BUFFER;
@@ -3172,6 +3475,9 @@ void MfxOmxVencComponent::AsyncThread(void)
                 }
                 if (MFX_ERR_NONE == mfx_sts)
                 {
+                    pAddBufInfo = MfxOmxGetOutputBufferInfo(m_pBitstreams->GetOutputBuffer());
+                    if (pAddBufInfo) m_Latency.Mark(MFX_OMX_LATENCY_POINT_SYNC, pAddBufInfo->sBitstream.TimeStamp);
+
                     if (!m_SyncPoints.Add(&pSyncPoint)) mfx_sts = MFX_ERR_UNKNOWN;
                 }
                 else
@@ -3208,7 +3514,7 @@ void MfxOmxVencComponent::AsyncThread(void)
                 MFX_OMX_LOG_ERROR("Sending ErrorEvent to OMAX client because of error in component");
                 MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "AsyncThread : m_Error = %d", m_Error);
                 MFX_OMX_AUTO_TRACE_I32(m_Error);
-                m_pCallbacks->EventHandler(m_self, m_pAppData, OMX_EventError, ErrorStatusMfxToOmx(m_Error), 0 , NULL);
+                SendErrorEvent(ErrorStatusMfxToOmx(m_Error));
             }
         }
 
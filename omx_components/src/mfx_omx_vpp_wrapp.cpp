@@ -35,13 +35,14 @@ MfxOmxVppWrapp::MfxOmxVppWrapp(void):
     m_pVPP(NULL),
     m_session(NULL),
     m_numVppSurfaces(0),
-    m_EncodeCtrls{},
     m_dbg_vppout(NULL)
 {
     MFX_OMX_AUTO_TRACE_FUNC();
     MFX_OMX_ZERO_MEMORY(m_vppParam);
     MFX_OMX_ZERO_MEMORY(m_allocator);
     MFX_OMX_ZERO_MEMORY(m_responses);
+    MFX_OMX_ZERO_MEMORY(m_vppSrf);
+    MFX_OMX_ZERO_MEMORY(m_EncodeCtrls);
 }
 
 /*------------------------------------------------------------------------------*/
@@ -67,7 +68,7 @@ mfxStatus MfxOmxVppWrapp::Init(MfxOmxVppWrappParam *param)
         m_allocator = *param->allocator;
         m_session = param->session;
 
-        MFX_OMX_NEW(m_pVPP, MFXVideoVPP(*m_session));
+        MFX_OMX_NEW(m_pVPP, MfxOmxVideoVPP(*m_session));
         if(!m_pVPP) sts = MFX_ERR_UNKNOWN;
 
         if (MFX_ERR_NONE == sts) sts = FillVppParams(param->frame_info, param->conversion);
@@ -99,18 +100,7 @@ mfxStatus MfxOmxVppWrapp::Close(void)
     MFX_OMX_AUTO_TRACE_FUNC();
     mfxStatus sts = MFX_ERR_NONE;
 
-    std::vector<EncodeCtrlPair>::iterator iter = m_EncodeCtrls.begin();
-    while (iter != m_EncodeCtrls.end())
-    {
-        EncodeCtrlPair pair = *iter;
-        if (0 == pair.second->Data.Locked)
-        {
-            MfxOmxEncodeCtrlWrapper* wrap = pair.first;
-            MFX_OMX_DELETE(wrap);
-            iter = m_EncodeCtrls.erase(iter);
-        }
-        else ++iter;
-    }
+    ReleaseEncodeCtrls();
 
     if (m_pVPP)
     {
@@ -133,7 +123,8 @@ mfxStatus MfxOmxVppWrapp::Close(void)
     m_numVppSurfaces = 0;
     m_session = NULL;
 
-    if (m_dbg_vppout) fclose(m_dbg_vppout);
+    mfx_omx_dump_close(m_dbg_vppout);
+    m_dbg_vppout = NULL;
 
     MFX_OMX_AUTO_TRACE_I32(sts);
     return sts;
@@ -226,18 +217,7 @@ mfxStatus MfxOmxVppWrapp::ProcessFrameVpp(mfxFrameSurface1 *in_srf, mfxFrameSurf
     mfxFrameSurface1* outSurface = NULL;
     mfxSyncPoint syncp;
 
-    std::vector<EncodeCtrlPair>::iterator iter = m_EncodeCtrls.begin();
-    while (iter != m_EncodeCtrls.end())
-    {
-        EncodeCtrlPair pair = *iter;
-        if (0 == pair.second->Data.Locked)
-        {
-            MfxOmxEncodeCtrlWrapper* wrap = pair.first;
-            MFX_OMX_DELETE(wrap);
-            iter = m_EncodeCtrls.erase(iter);
-        }
-        else ++iter;
-    }
+    ReleaseEncodeCtrls();
 
     if (!in_srf || !out_srf) return MFX_ERR_UNKNOWN;
 
@@ -282,9 +262,33 @@ mfxStatus MfxOmxVppWrapp::ProcessFrameVpp(mfxFrameSurface1 *in_srf, mfxFrameSurf
 void MfxOmxVppWrapp::SetEncodeCtrl(MfxOmxEncodeCtrlWrapper* pEncodeCtrlWrap, mfxFrameSurface1 *pFrameSurface)
 {
     MFX_OMX_AUTO_TRACE_FUNC();
-    if (pEncodeCtrlWrap && pFrameSurface)
+    if (!pEncodeCtrlWrap) return;
+
+    // VPP output surface is taken from m_vppSrf, so its index is the control slot
+    size_t idx = pFrameSurface ? (size_t)(pFrameSurface - m_vppSrf) : m_numVppSurfaces;
+    if (idx < m_numVppSurfaces)
+    {
+        mfx_omx_put_encode_ctrl(m_EncodeCtrls[idx]);
+        m_EncodeCtrls[idx] = pEncodeCtrlWrap;
+    }
+    else
+    {
+        MFX_OMX_AUTO_TRACE_MSG("surface is not VPP output, control is returned to the pool");
+        mfx_omx_put_encode_ctrl(pEncodeCtrlWrap);
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxVppWrapp::ReleaseEncodeCtrls(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    for (mfxU32 i = 0; i < VPP_MAX_SRF_NUM; ++i)
     {
-        m_EncodeCtrls.push_back(std::make_pair(pEncodeCtrlWrap, pFrameSurface));
+        if (m_EncodeCtrls[i] && !m_vppSrf[i].Data.Locked)
+        {
+            mfx_omx_put_encode_ctrl(m_EncodeCtrls[i]);
+        }
     }
 }
 
@@ -45,6 +45,7 @@ Defined help functions:
 #define MFX_OMX_FILE_INIT
 
 #include "mfx_omx_utils.h"
+#include "mfx_omx_lock_stats.h"
 
 #ifdef MFX_RESOURCES_LIMIT
 #include "mfx_omx_component_manager.h"
@@ -107,10 +108,40 @@ static pthread_mutex_t g_OMXCoreLock = PTHREAD_MUTEX_INITIALIZER;
 static mfxU32 g_OMXCoreRefCount = 0;
 static mfx_omx_so_handle g_soHandleHw = NULL;
 
-#define MFX_OMX_CORE_LOCK()  int res_lock = pthread_mutex_lock(&g_OMXCoreLock); \
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+// time the core lock was taken, updated while it is held
+static mfxU64 g_OMXCoreLockTime = 0;
+
+// core lock stays statically initialized pthread mutex, its statistics are taken on first use
+static inline MfxOmxLockStats* mfx_omx_core_lock_stats(void)
+{
+    static MfxOmxLockStats* pStats = mfx_omx_lock_stats_get("core", MFX_OMX_LOCK_MUTEX);
+    return pStats;
+}
+#endif
+
+static inline int mfx_omx_core_lock(void)
+{
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    return mfx_omx_lock_stats_mutex_lock(&g_OMXCoreLock, mfx_omx_core_lock_stats(), g_OMXCoreLockTime);
+#else
+    return pthread_mutex_lock(&g_OMXCoreLock);
+#endif
+}
+
+static inline int mfx_omx_core_unlock(void)
+{
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    return mfx_omx_lock_stats_mutex_unlock(&g_OMXCoreLock, mfx_omx_core_lock_stats(), g_OMXCoreLockTime);
+#else
+    return pthread_mutex_unlock(&g_OMXCoreLock);
+#endif
+}
+
+#define MFX_OMX_CORE_LOCK()  int res_lock = mfx_omx_core_lock(); \
     if (res_lock) return OMX_ErrorUndefined;
 
-#define MFX_OMX_CORE_UNLOCK()  int res_unlock = pthread_mutex_unlock(&g_OMXCoreLock); \
+#define MFX_OMX_CORE_UNLOCK()  int res_unlock = mfx_omx_core_unlock(); \
     if (res_unlock) return OMX_ErrorUndefined;
 
 /*------------------------------------------------------------------------------*/
@@ -414,6 +445,9 @@ OMX_API OMX_ERRORTYPE OMX_APIENTRY OMX_Deinit(void)
             g_ComponentsRegistryNum = 0;
 
             g_bInitialized = false;
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+            mfx_omx_lock_stats_dump("core");
+#endif
         }
         if (g_soHandleHw)
         {
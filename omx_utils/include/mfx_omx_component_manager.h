@@ -25,7 +25,7 @@
 
 #include <vector>
 #include <string>
-#include <mutex>
+#include "mfx_omx_vm.h"
 
 enum class ResolutionType_e
 {
@@ -94,7 +94,7 @@ private:
 
     unsigned int            mCurrNumOfComponents = 0;
     unsigned int            mMaxResourcesNum = 0;
-    std::mutex              mLock;
+    MfxOmxMutex             mLock{"component_manager"};
 
 
 
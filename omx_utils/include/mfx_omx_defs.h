@@ -93,12 +93,24 @@ extern "C" {
 
 /* Notes:
  *  - MFX_OMX_DEBUG - will switch on massive text logging
+ *  - MFX_OMX_DEBUG_TRACE_RING - together with MFX_OMX_DEBUG replaces text logging
+ *  with binary records kept in per-thread ring buffers, records are exported in
+ *  Chrome trace event format on component destruction (see mfx_omx_trace_ring.cpp)
  *  - MFX_OMX_DEBUG_DUMP - will switch on input/output file dumps (need configure
- *  additionally thru the plug-ins registry file)
+ *  additionally thru the plug-ins registry file) and session recording (see
+ *  mfx_omx_recorder.h)
+ *  - MFX_OMX_MOCK_BACKEND - will replace Media SDK and device with stand-ins
+ *  which complete tasks after configured latency without GPU (see mfx_omx_mock.cpp)
+ *  - MFX_OMX_LOCK_STATS - will collect acquisition counts, contention and wait/hold
+ *  time histograms of named MfxOmxMutex, MfxOmxEvent and MfxOmxSemaphore objects,
+ *  dumped on component destruction (see mfx_omx_lock_stats.cpp)
  */
 #define MFX_OMX_DEBUG MFX_OMX_NO
+#define MFX_OMX_DEBUG_TRACE_RING MFX_OMX_NO
 #define MFX_OMX_DEBUG_DUMP MFX_OMX_NO
 #define MFX_OMX_PERF MFX_OMX_NO
+#define MFX_OMX_MOCK_BACKEND MFX_OMX_NO
+#define MFX_OMX_LOCK_STATS MFX_OMX_NO
 
 //#define MFX_OMX_STDOUT MFX_OMX_NO
 #define MFX_OMX_LOG_TAG "mediasdk_omx"
@@ -227,6 +239,54 @@ extern "C" {
         #endif // #ifdef MFX_OMX_FILE_INIT
     #endif
 
+#if MFX_OMX_DEBUG_TRACE_RING == MFX_OMX_YES
+
+    // categories of trace points, enabled ones are set by OMX.Intel.trace.mask property
+    enum
+    {
+        MFX_OMX_TRACE_CATEGORY_CORE       = 0x01,
+        MFX_OMX_TRACE_CATEGORY_COMPONENTS = 0x02,
+        MFX_OMX_TRACE_CATEGORY_BUFFERS    = 0x04,
+        MFX_OMX_TRACE_CATEGORY_UTILS      = 0x08,
+    };
+
+    #ifndef MFX_OMX_TRACE_FILE_NAME
+        #define MFX_OMX_TRACE_FILE_NAME "/data/local/tmp/mfx_omx_trace.json"
+    #endif
+
+    extern mfxU32 g_OmxTraceMask;
+
+    // registers trace point, returned id contains trace point category
+    mfxU32 mfx_omx_trace_register(const char* modulename, const char* function, const char* taskname);
+    // writes records of all threads to the file in Chrome trace event (JSON) format
+    mfxStatus mfx_omx_trace_export(const char* filename);
+
+    class mfx_omx_trace
+    {
+    public:
+        mfx_omx_trace(mfxU32 _id);
+        ~mfx_omx_trace(void);
+        void printf_msg(const char* msg);
+        void printf_i32(const char* name, mfxI32 value);
+        void printf_u32(const char* name, mfxU32 value);
+        void printf_i64(const char* name, mfxI64 value);
+        void printf_f64(const char* name, mfxF64 value);
+        void printf_p(const char* name, void* value);
+        void printf_s(const char* name, const char* value);
+
+    protected:
+        // 0 if trace point category is disabled
+        mfxU32 id;
+    private:
+        MFX_OMX_CLASS_NO_COPY(mfx_omx_trace)
+    };
+
+    #define MFX_OMX_AUTO_TRACE(_task_name) \
+        static const mfxU32 _mfx_omx_trace_id = mfx_omx_trace_register(MFX_OMX_MODULE_NAME, __FUNCTION__, _task_name); \
+        mfx_omx_trace _mfx_omx_trace(_mfx_omx_trace_id)
+
+#else // #if MFX_OMX_DEBUG_TRACE_RING == MFX_OMX_YES
+
     class mfx_omx_trace
     {
     public:
@@ -251,6 +311,8 @@ extern "C" {
     #define MFX_OMX_AUTO_TRACE(_task_name) \
         mfx_omx_trace _mfx_omx_trace(MFX_OMX_MODULE_NAME, __FUNCTION__, _task_name)
 
+#endif // #if MFX_OMX_DEBUG_TRACE_RING == MFX_OMX_YES
+
     #define MFX_OMX_AUTO_TRACE_FUNC() \
         MFX_OMX_AUTO_TRACE(NULL)
 
@@ -23,6 +23,7 @@
 
 #include "mfx_omx_utils.h"
 #include "mfx_omx_vaapi_allocator.h"
+#include "mfx_omx_mock.h"
 
 /*------------------------------------------------------------------------------*/
 
@@ -0,0 +1,110 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __MFX_OMX_DEV_MOCK_H__
+#define __MFX_OMX_DEV_MOCK_H__
+
+#include "mfx_omx_dev.h"
+#include "mfx_omx_allocator.h"
+
+#if MFX_OMX_MOCK_BACKEND == MFX_OMX_YES
+
+/*------------------------------------------------------------------------------*/
+
+// Allocates frames in system memory, memory id points to the frame descriptor
+class MfxOmxMockFrameAllocator : public MfxOmxFrameAllocator
+{
+public:
+    MfxOmxMockFrameAllocator(void);
+    virtual ~MfxOmxMockFrameAllocator(void);
+
+    virtual mfxStatus LockFrame(mfxMemId mid, mfxFrameData *ptr);
+    virtual mfxStatus UnlockFrame(mfxMemId mid, mfxFrameData *ptr);
+    virtual mfxStatus GetFrameHDL(mfxMemId mid, mfxHDL *handle);
+
+protected:
+    struct Frame
+    {
+        mfxU8* pData;
+        mfxU32 fourcc;
+        mfxU16 width;
+        mfxU16 height;
+        mfxU32 pitch;
+    };
+
+    virtual mfxStatus ReleaseResponse(mfxFrameAllocResponse *response);
+    virtual mfxStatus AllocImpl(mfxFrameAllocRequest *request, mfxFrameAllocResponse *response);
+
+private:
+    MFX_OMX_CLASS_NO_COPY(MfxOmxMockFrameAllocator)
+};
+
+/*------------------------------------------------------------------------------*/
+
+class MfxOmxDevMock : public MfxOmxDev
+{
+public:
+    MfxOmxDevMock(mfxStatus &sts);
+    virtual ~MfxOmxDevMock(void);
+
+    virtual mfxStatus DevInit(void);
+    virtual mfxStatus DevClose(void);
+
+    virtual mfxStatus InitMfxSession(MFXVideoSession* session);
+    virtual mfxFrameAllocator* GetFrameAllocator(void)
+    {
+        return m_pFrameAllocator;
+    }
+
+    // there is no gralloc, so components can't use native buffers
+    virtual MfxOmxGrallocAllocator* GetGrallocAllocator(void)
+    {
+        return NULL;
+    }
+
+    virtual eMfxOmxHwType GetPlatformType(void)
+    {
+        return MFX_HW_UNKNOWN;
+    }
+
+    virtual OMX_U64 GetDriverVersion(void)
+    {
+        return 0;
+    }
+
+    virtual OMX_U32 GetDecProcessingRate(mfxVideoParam const & par)
+    {
+        MFX_OMX_UNUSED(par);
+        return 0;
+    }
+
+protected:
+    bool m_bInitialized;
+    MfxOmxMockFrameAllocator* m_pFrameAllocator;
+
+private:
+    MFX_OMX_CLASS_NO_COPY(MfxOmxDevMock)
+};
+
+/*------------------------------------------------------------------------------*/
+
+#endif // #if MFX_OMX_MOCK_BACKEND == MFX_OMX_YES
+
+#endif // #ifndef __MFX_OMX_DEV_MOCK_H__
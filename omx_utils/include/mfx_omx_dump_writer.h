@@ -0,0 +1,95 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __MFX_OMX_DUMP_WRITER_H__
+#define __MFX_OMX_DUMP_WRITER_H__
+
+#include <deque>
+
+#include "mfx_omx_utils.h"
+
+/*------------------------------------------------------------------------------*/
+
+// maximum size of data queued for writing, data above it is dropped
+#define MFX_OMX_DUMP_WRITER_BUDGET (64 * 1024 * 1024)
+
+/*------------------------------------------------------------------------------*/
+
+/* Writes debug dumps from own thread, so dumping does not change timings of
+ * component threads much. Producers either pass data to Write (one copy) or
+ * fill buffer taken with GetBuffer directly (no extra copies) and Commit it.
+ * Each queued chunk is written with one fwrite.
+ */
+class MfxOmxDumpWriter
+{
+    friend unsigned int MfxOmxDumpWriter_Thread(void* param);
+
+public:
+    MfxOmxDumpWriter(mfxU32 budget = MFX_OMX_DUMP_WRITER_BUDGET);
+    // writes queued data and stops the thread
+    ~MfxOmxDumpWriter(void);
+
+    // returns buffer of given size to be filled and committed, NULL if budget is exceeded
+    mfxU8* GetBuffer(mfxU32 size);
+    // queues buffer taken with GetBuffer for writing to the file
+    void Commit(FILE* file, mfxU8* buffer, mfxU32 size);
+    // copies data and queues it for writing, returns false if data were dropped
+    bool Write(FILE* file, const void* data, mfxU32 size);
+    // waits till all queued data of the file are written and closes it
+    void Close(FILE* file);
+
+protected: // functions
+    void Thread(void);
+
+protected: // variables
+    struct Chunk
+    {
+        FILE* file;
+        mfxU8* data;
+        mfxU32 size;
+    };
+
+    std::deque<Chunk> m_Chunks;
+    // file which chunk is being written by the thread now
+    FILE* m_pWritingFile;
+    MfxOmxMutex m_mutex;
+    MfxOmxSemaphore m_semaphore;
+    MfxOmxThread* m_pThread;
+    bool m_bStop;
+
+    mfxU32 m_nBudget;
+    // size of taken and queued buffers
+    mfxU32 m_nQueuedBytes;
+
+    // statistics
+    mfxU64 m_nWrittenBytes;
+    mfxU32 m_nDroppedChunks;
+    mfxU64 m_nDroppedBytes;
+
+private:
+    MFX_OMX_CLASS_NO_COPY(MfxOmxDumpWriter)
+};
+
+/*------------------------------------------------------------------------------*/
+
+// writer shared by all dump files of the library
+extern MfxOmxDumpWriter& mfx_omx_get_dump_writer(void);
+
+#endif // #ifndef __MFX_OMX_DUMP_WRITER_H__
@@ -0,0 +1,137 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __MFX_OMX_LATENCY_H__
+#define __MFX_OMX_LATENCY_H__
+
+#include <atomic>
+
+#include "mfx_omx_utils.h"
+
+/*------------------------------------------------------------------------------*/
+
+// points of frame processing at which time is recorded
+enum MfxOmxLatencyPoint
+{
+    MFX_OMX_LATENCY_POINT_INPUT = 0, // EmptyThisBuffer
+    MFX_OMX_LATENCY_POINT_PARSED,    // frame constructor loaded the sample (decoders only)
+    MFX_OMX_LATENCY_POINT_SUBMIT,    // DecodeFrameAsync/EncodeFrameAsync
+    MFX_OMX_LATENCY_POINT_SYNC,      // SyncOperation completion
+    MFX_OMX_LATENCY_POINT_OUTPUT,    // FillBufferDone
+    MFX_OMX_LATENCY_POINT_NUM
+};
+
+// stages between points, values match OMX_VIDEO_INTEL_LATENCY_STAGE
+enum MfxOmxLatencyStage
+{
+    MFX_OMX_LATENCY_STAGE_PARSE = 0, // input -> parsed
+    MFX_OMX_LATENCY_STAGE_QUEUE,     // parsed (or input) -> submit
+    MFX_OMX_LATENCY_STAGE_GPU,       // submit -> sync
+    MFX_OMX_LATENCY_STAGE_OUTPUT,    // sync -> output
+    MFX_OMX_LATENCY_STAGE_TOTAL,     // input -> output
+    MFX_OMX_LATENCY_STAGE_NUM
+};
+
+/*------------------------------------------------------------------------------*/
+
+/* Log-linear histogram of values in microseconds: values below 32 have own
+ * buckets, bigger ones are split into 16 buckets per power of 2, so relative
+ * error stays below 1/16 up to 2^32 us. Recording is lock-free.
+ */
+class MfxOmxLatencyHistogram
+{
+public:
+    MfxOmxLatencyHistogram(void);
+
+    void Record(mfxU64 value);
+    void Reset(void);
+
+    mfxU32 GetCount(void) const { return m_nCount.load(std::memory_order_relaxed); }
+    mfxU64 GetMean(void) const;
+    mfxU64 GetMin(void) const;
+    mfxU64 GetMax(void) const { return m_nMax.load(std::memory_order_relaxed); }
+    // returns lower bound of the bucket holding given percentile (0-100)
+    mfxU64 GetPercentile(mfxU32 percentile) const;
+
+protected: // functions
+    static mfxU32 GetBucket(mfxU64 value);
+    static mfxU64 GetBucketValue(mfxU32 bucket);
+
+protected: // variables
+    static const mfxU32 SUB_BUCKETS = 16;
+    static const mfxU32 BUCKETS_NUM = (32 - 3) * SUB_BUCKETS;
+
+    std::atomic<mfxU32> m_Buckets[BUCKETS_NUM];
+    std::atomic<mfxU32> m_nCount;
+    std::atomic<mfxU64> m_nSum;
+    std::atomic<mfxU64> m_nMin;
+    std::atomic<mfxU64> m_nMax;
+
+private:
+    MFX_OMX_CLASS_NO_COPY(MfxOmxLatencyHistogram)
+};
+
+/*------------------------------------------------------------------------------*/
+
+/* Collects times of processing points per frame keyed by frame time stamp
+ * (in 90 kHz units) and records stage latencies into histograms once frame
+ * was output and synchronized. Frame slot is selected by time stamp hash, so
+ * marking is lock-free; frames which never reach the output or collide with
+ * a newer frame are dropped when their slot is taken.
+ */
+class MfxOmxLatencyTracker
+{
+public:
+    MfxOmxLatencyTracker(void);
+
+    void Mark(MfxOmxLatencyPoint point, mfxU64 timeStamp, mfxU64 time = 0);
+    void Reset(void);
+
+    const MfxOmxLatencyHistogram& GetHistogram(MfxOmxLatencyStage stage) const { return m_Histograms[stage]; }
+    // logs statistics of all stages
+    void Dump(const char* name) const;
+
+protected: // types
+    struct Slot
+    {
+        // time stamp of the frame owning the slot plus 1, 0 for a free slot
+        std::atomic<mfxU64> key;
+        std::atomic<mfxU64> times[MFX_OMX_LATENCY_POINT_NUM];
+    };
+
+protected: // functions
+    static mfxU32 GetSlotIndex(mfxU64 timeStamp);
+    Slot* FindSlot(mfxU64 timeStamp, mfxU64& key);
+    void Record(const mfxU64* times);
+
+protected: // variables
+    static const mfxU32 SLOTS_BITS = 8;
+    static const mfxU32 SLOTS_NUM = 1 << SLOTS_BITS;
+
+    Slot m_Slots[SLOTS_NUM];
+    std::atomic<mfxU32> m_nDroppedFrames;
+
+    MfxOmxLatencyHistogram m_Histograms[MFX_OMX_LATENCY_STAGE_NUM];
+
+private:
+    MFX_OMX_CLASS_NO_COPY(MfxOmxLatencyTracker)
+};
+
+#endif // #ifndef __MFX_OMX_LATENCY_H__
@@ -0,0 +1,89 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __MFX_OMX_LOCK_STATS_H__
+#define __MFX_OMX_LOCK_STATS_H__
+
+#include "mfx_omx_latency.h"
+
+/*------------------------------------------------------------------------------*/
+
+// directory to write per-process statistics files to, logcat only if not set
+#define MFX_OMX_LOCK_STATS_DIR_PROPERTY "OMX.Intel.lock_stats.dir"
+// number of different lock names tracked, locks with other names are not tracked
+#define MFX_OMX_LOCK_STATS_MAX 64
+
+enum MfxOmxLockKind
+{
+    MFX_OMX_LOCK_MUTEX = 0,
+    MFX_OMX_LOCK_EVENT,
+    MFX_OMX_LOCK_SEMAPHORE,
+    MFX_OMX_LOCK_KIND_NUM
+};
+
+/*------------------------------------------------------------------------------*/
+
+/* Statistics shared by all locks of one name and kind (MFX_OMX_LOCK_STATS
+ * builds only). Acquisitions are Lock/Try of mutexes and Wait calls of
+ * events and semaphores, contended ones are those which had to block.
+ * Histograms are in nanoseconds: wait time of contended acquisitions and
+ * time mutexes were held.
+ */
+struct MfxOmxLockStats
+{
+    MfxOmxLockStats(void): name(NULL), kind(MFX_OMX_LOCK_MUTEX), instances(0), acquisitions(0), contended(0) {}
+
+    const char* name;
+    MfxOmxLockKind kind;
+    std::atomic<mfxU32> instances;
+    std::atomic<mfxU64> acquisitions;
+    std::atomic<mfxU64> contended;
+    MfxOmxLatencyHistogram waitTime;
+    MfxOmxLatencyHistogram holdTime;
+
+private:
+    MFX_OMX_CLASS_NO_COPY(MfxOmxLockStats)
+};
+
+/*------------------------------------------------------------------------------*/
+
+// returns statistics of locks with given name (string literal), NULL if table is full
+extern MfxOmxLockStats* mfx_omx_lock_stats_get(const char* name, MfxOmxLockKind kind);
+// logs statistics of all locks of the module (each shared library has own table)
+extern void mfx_omx_lock_stats_dump(const char* module);
+
+/* pthread mutex operations counted in the given statistics (NULL - not counted):
+ * lockTime is set on acquisition and is passed back on unlock to record hold
+ * time. Return pthread_mutex_* results.
+ */
+extern int mfx_omx_lock_stats_mutex_lock(pthread_mutex_t* mutex, MfxOmxLockStats* stats, mfxU64& lockTime);
+extern int mfx_omx_lock_stats_mutex_trylock(pthread_mutex_t* mutex, MfxOmxLockStats* stats, mfxU64& lockTime);
+extern int mfx_omx_lock_stats_mutex_unlock(pthread_mutex_t* mutex, MfxOmxLockStats* stats, mfxU64 lockTime);
+
+// monotonic time in nanoseconds
+inline mfxU64 mfx_omx_lock_stats_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (mfxU64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+#endif // #ifndef __MFX_OMX_LOCK_STATS_H__
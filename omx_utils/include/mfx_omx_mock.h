@@ -0,0 +1,232 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __MFX_OMX_MOCK_H__
+#define __MFX_OMX_MOCK_H__
+
+#include "mfx_omx_utils.h"
+
+/* MFX_OMX_MOCK_BACKEND replaces Media SDK session, decoder, encoder and VPP
+ * with stand-ins which do not touch hardware (see mfx_omx_mock.cpp). Components
+ * use MfxOmxVideo* types below, so they get mocks or real classes depending on
+ * the build.
+ */
+#if MFX_OMX_MOCK_BACKEND == MFX_OMX_YES
+
+#include <map>
+#include <mutex>
+#include <random>
+#include <chrono>
+
+/*------------------------------------------------------------------------------*/
+
+enum MfxOmxMockDistribution
+{
+    MFX_OMX_MOCK_LATENCY_FIXED = 0,   // latency
+    MFX_OMX_MOCK_LATENCY_UNIFORM,     // latency +/- jitter
+    MFX_OMX_MOCK_LATENCY_EXPONENTIAL  // jitter + exponential with mean (latency - jitter)
+};
+
+// Configuration is read once from OMX.Intel.mock.* properties
+struct MfxOmxMockConfig
+{
+    mfxU32 latency;        // mean task latency in us (OMX.Intel.mock.latency)
+    mfxU32 jitter;         // us (OMX.Intel.mock.jitter)
+    mfxU32 distribution;   // MfxOmxMockDistribution (OMX.Intel.mock.distribution)
+    bool   bOutOfOrder;    // tasks may complete in any order (OMX.Intel.mock.order)
+    mfxU32 busyPercent;    // share of submissions returning MFX_WRN_DEVICE_BUSY (OMX.Intel.mock.busy)
+    mfxU32 incompatiblePeriod; // every Nth frame (decoder) or Reset (encoder) fails
+                               // with MFX_ERR_INCOMPATIBLE_VIDEO_PARAM, 0 - never (OMX.Intel.mock.incompatible)
+    mfxU32 seed;           // random generator seed (OMX.Intel.mock.seed)
+    mfxU16 width;          // stream resolution reported by DecodeHeader (OMX.Intel.mock.resolution, WxH)
+    mfxU16 height;
+    mfxU32 frameSize;      // encoded frame size in bytes if bitrate is not set (OMX.Intel.mock.framesize)
+};
+
+extern const MfxOmxMockConfig& mfx_omx_mock_get_config(void);
+
+/*------------------------------------------------------------------------------*/
+
+// Session keeps asynchronous tasks of all mocks created on it
+class MfxOmxMockSession : public MFXVideoSession
+{
+public:
+    MfxOmxMockSession(void);
+    virtual ~MfxOmxMockSession(void);
+
+    virtual mfxStatus Init(mfxIMPL impl, mfxVersion *ver);
+    virtual mfxStatus Close(void);
+
+    virtual mfxStatus QueryIMPL(mfxIMPL *impl);
+    virtual mfxStatus QueryVersion(mfxVersion *version);
+
+    virtual mfxStatus SetFrameAllocator(mfxFrameAllocator *allocator);
+    virtual mfxStatus SetHandle(mfxHandleType type, mfxHDL hdl);
+    virtual mfxStatus GetHandle(mfxHandleType type, mfxHDL *hdl);
+
+    virtual mfxStatus SyncOperation(mfxSyncPoint syncp, mfxU32 wait);
+
+    // returns true if submission should be rejected with MFX_WRN_DEVICE_BUSY
+    bool IsDeviceBusy(void);
+    // queues a task which unlocks given surfaces on completion
+    mfxSyncPoint Submit(mfxStatus sts, mfxFrameSurface1* pSurface1, mfxFrameSurface1* pSurface2 = NULL);
+
+protected:
+    struct Task
+    {
+        std::chrono::steady_clock::time_point ready;
+        mfxStatus status;
+        mfxFrameSurface1* pSurfaces[2];
+        bool bDone;
+    };
+
+    void CompleteTask(Task& task);
+    void CompleteReadyTasks(std::chrono::steady_clock::time_point now);
+    std::chrono::microseconds SampleLatency(void);
+
+    const MfxOmxMockConfig& m_Config;
+    mfxIMPL m_Implementation;
+    mfxVersion m_Version;
+    mfxFrameAllocator* m_pAllocator;
+    mfxHDL m_Handle;
+
+    std::mutex m_Mutex;
+    std::mt19937 m_Random;
+    std::map<mfxU64, Task> m_Tasks;
+    mfxU64 m_nNextTaskId;
+    std::chrono::steady_clock::time_point m_LastReady;
+
+private:
+    MFX_OMX_CLASS_NO_COPY(MfxOmxMockSession)
+};
+
+/*------------------------------------------------------------------------------*/
+
+// Decoder consumes whole bitstream per call and outputs the work surface
+class MfxOmxMockDecode : public MFXVideoDECODE
+{
+public:
+    MfxOmxMockDecode(MfxOmxMockSession& session);
+    virtual ~MfxOmxMockDecode(void);
+
+    virtual mfxStatus Query(mfxVideoParam *in, mfxVideoParam *out);
+    virtual mfxStatus DecodeHeader(mfxBitstream *bs, mfxVideoParam *par);
+    virtual mfxStatus QueryIOSurf(mfxVideoParam *par, mfxFrameAllocRequest *request);
+    virtual mfxStatus Init(mfxVideoParam *par);
+    virtual mfxStatus Reset(mfxVideoParam *par);
+    virtual mfxStatus Close(void);
+
+    virtual mfxStatus GetVideoParam(mfxVideoParam *par);
+    virtual mfxStatus GetDecodeStat(mfxDecodeStat *stat);
+    virtual mfxStatus GetPayload(mfxU64 *ts, mfxPayload *payload);
+    virtual mfxStatus SetSkipMode(mfxSkipMode mode);
+    virtual mfxStatus DecodeFrameAsync(mfxBitstream *bs, mfxFrameSurface1 *surface_work, mfxFrameSurface1 **surface_out, mfxSyncPoint *syncp);
+
+protected:
+    MfxOmxMockSession& m_MockSession;
+    mfxVideoParam m_Params;
+    bool m_bInitialized;
+    bool m_bIncompatibleReported;
+    mfxU32 m_nFrames;
+
+private:
+    MFX_OMX_CLASS_NO_COPY(MfxOmxMockDecode)
+};
+
+/*------------------------------------------------------------------------------*/
+
+// Encoder writes a synthetic frame of the target size per input surface
+class MfxOmxMockEncode : public MFXVideoENCODE
+{
+public:
+    MfxOmxMockEncode(MfxOmxMockSession& session);
+    virtual ~MfxOmxMockEncode(void);
+
+    virtual mfxStatus Query(mfxVideoParam *in, mfxVideoParam *out);
+    virtual mfxStatus QueryIOSurf(mfxVideoParam *par, mfxFrameAllocRequest *request);
+    virtual mfxStatus Init(mfxVideoParam *par);
+    virtual mfxStatus Reset(mfxVideoParam *par);
+    virtual mfxStatus Close(void);
+
+    virtual mfxStatus GetVideoParam(mfxVideoParam *par);
+    virtual mfxStatus GetEncodeStat(mfxEncodeStat *stat);
+    virtual mfxStatus EncodeFrameAsync(mfxEncodeCtrl *ctrl, mfxFrameSurface1 *surface, mfxBitstream *bs, mfxSyncPoint *syncp);
+
+protected:
+    mfxU32 GetFrameSize(void);
+    mfxStatus WriteHeaders(mfxExtBuffer* pExtBuf);
+
+    MfxOmxMockSession& m_MockSession;
+    mfxVideoParam m_Params;
+    bool m_bInitialized;
+    mfxU32 m_nFrames;
+    mfxU32 m_nResets;
+    mfxU64 m_nBytes;
+
+private:
+    MFX_OMX_CLASS_NO_COPY(MfxOmxMockEncode)
+};
+
+/*------------------------------------------------------------------------------*/
+
+// VPP passes frame attributes through without touching pixels
+class MfxOmxMockVPP : public MFXVideoVPP
+{
+public:
+    MfxOmxMockVPP(MfxOmxMockSession& session);
+    virtual ~MfxOmxMockVPP(void);
+
+    virtual mfxStatus Query(mfxVideoParam *in, mfxVideoParam *out);
+    virtual mfxStatus QueryIOSurf(mfxVideoParam *par, mfxFrameAllocRequest request[2]);
+    virtual mfxStatus Init(mfxVideoParam *par);
+    virtual mfxStatus Reset(mfxVideoParam *par);
+    virtual mfxStatus Close(void);
+
+    virtual mfxStatus GetVideoParam(mfxVideoParam *par);
+    virtual mfxStatus GetVPPStat(mfxVPPStat *stat);
+    virtual mfxStatus RunFrameVPPAsync(mfxFrameSurface1 *in, mfxFrameSurface1 *out, mfxExtVppAuxData *aux, mfxSyncPoint *syncp);
+
+protected:
+    MfxOmxMockSession& m_MockSession;
+    mfxVideoParam m_Params;
+    bool m_bInitialized;
+    mfxU32 m_nFrames;
+
+private:
+    MFX_OMX_CLASS_NO_COPY(MfxOmxMockVPP)
+};
+
+/*------------------------------------------------------------------------------*/
+
+typedef MfxOmxMockSession MfxOmxVideoSession;
+typedef MfxOmxMockDecode MfxOmxVideoDECODE;
+typedef MfxOmxMockEncode MfxOmxVideoENCODE;
+typedef MfxOmxMockVPP MfxOmxVideoVPP;
+
+#else // #if MFX_OMX_MOCK_BACKEND == MFX_OMX_YES
+
+typedef MFXVideoSession MfxOmxVideoSession;
+typedef MFXVideoDECODE MfxOmxVideoDECODE;
+typedef MFXVideoENCODE MfxOmxVideoENCODE;
+typedef MFXVideoVPP MfxOmxVideoVPP;
+
+#endif // #if MFX_OMX_MOCK_BACKEND == MFX_OMX_YES
+
+#endif // #ifndef __MFX_OMX_MOCK_H__
@@ -0,0 +1,129 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __MFX_OMX_RECORD_FORMAT_H__
+#define __MFX_OMX_RECORD_FORMAT_H__
+
+#include <stdint.h>
+
+/* Layout of OMX session recordings written by MfxOmxRecorder and read by
+ * mfx_omx_replay. File starts with MfxOmxRecordFileHeader followed by
+ * records: MfxOmxRecordHeader and type specific data padded to 8 bytes.
+ * Records are in the order calls completed, times are taken at call entry.
+ * Data are stored in the byte order of the recording device.
+ */
+
+/*------------------------------------------------------------------------------*/
+
+#define MFX_OMX_RECORD_MAGIC 0x52584d4f // "OMXR"
+#define MFX_OMX_RECORD_VERSION 1
+#define MFX_OMX_RECORD_NAME_SIZE 128
+
+#define MFX_OMX_RECORD_ALIGN(size) (((size) + 7) & ~7)
+
+// file header flags
+#define MFX_OMX_RECORD_FLAG_PAYLOADS 0x1 // input buffers data were recorded
+
+/*------------------------------------------------------------------------------*/
+
+enum MfxOmxRecordType
+{
+    MFX_OMX_RECORD_SEND_COMMAND = 1,   // MfxOmxRecordCommand
+    MFX_OMX_RECORD_GET_PARAMETER,      // MfxOmxRecordStruct + structure passed in
+    MFX_OMX_RECORD_SET_PARAMETER,      // MfxOmxRecordStruct + structure
+    MFX_OMX_RECORD_GET_CONFIG,         // MfxOmxRecordStruct + structure passed in
+    MFX_OMX_RECORD_SET_CONFIG,         // MfxOmxRecordStruct + structure
+    MFX_OMX_RECORD_GET_EXTENSION_INDEX,// MfxOmxRecordExtensionIndex + name
+    MFX_OMX_RECORD_USE_BUFFER,         // MfxOmxRecordBuffer
+    MFX_OMX_RECORD_ALLOCATE_BUFFER,    // MfxOmxRecordBuffer
+    MFX_OMX_RECORD_FREE_BUFFER,        // MfxOmxRecordBuffer
+    MFX_OMX_RECORD_EMPTY_THIS_BUFFER,  // MfxOmxRecordEmptyBuffer + payload
+    MFX_OMX_RECORD_FILL_THIS_BUFFER,   // MfxOmxRecordBuffer
+    MFX_OMX_RECORD_END                 // no data, written on component destruction
+};
+
+/*------------------------------------------------------------------------------*/
+
+struct MfxOmxRecordFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t reserved;
+    // wall clock time of recording start, us
+    uint64_t startTime;
+    char component[MFX_OMX_RECORD_NAME_SIZE];
+};
+
+struct MfxOmxRecordHeader
+{
+    uint32_t type;
+    // size of data following the header, multiple of 8
+    uint32_t size;
+    // call entry time since recording start, us
+    uint64_t time;
+    // OMX_ERRORTYPE returned by the call
+    uint32_t result;
+    // time spent in the call, us
+    uint32_t duration;
+};
+
+struct MfxOmxRecordCommand
+{
+    uint32_t cmd;
+    uint32_t param;
+};
+
+struct MfxOmxRecordStruct
+{
+    uint32_t index;
+    // size of structure following this one
+    uint32_t size;
+};
+
+struct MfxOmxRecordExtensionIndex
+{
+    // index returned by the component
+    uint32_t index;
+    // length of name following this structure, without terminating zero
+    uint32_t length;
+};
+
+struct MfxOmxRecordBuffer
+{
+    // buffer header address in the recorded process, identifies the buffer
+    uint64_t id;
+    uint32_t port;
+    // requested size (Use/AllocateBuffer only)
+    uint32_t size;
+};
+
+struct MfxOmxRecordEmptyBuffer
+{
+    uint64_t id;
+    int64_t timeStamp;
+    uint32_t flags;
+    uint32_t filledLen;
+    // size of recorded payload following this structure, 0 or filledLen
+    uint32_t payloadSize;
+    uint32_t reserved;
+};
+
+#endif // #ifndef __MFX_OMX_RECORD_FORMAT_H__
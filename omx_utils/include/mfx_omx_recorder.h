@@ -0,0 +1,85 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __MFX_OMX_RECORDER_H__
+#define __MFX_OMX_RECORDER_H__
+
+#include <atomic>
+
+#include "mfx_omx_utils.h"
+#include "mfx_omx_record_format.h"
+
+/*------------------------------------------------------------------------------*/
+
+// directory to write recordings to, recording is off if not set
+#define MFX_OMX_RECORD_DIR_PROPERTY "OMX.Intel.record.dir"
+// set to 0 to skip input buffers data (recording gets much smaller)
+#define MFX_OMX_RECORD_PAYLOADS_PROPERTY "OMX.Intel.record.payloads"
+// bigger structures are truncated
+#define MFX_OMX_RECORD_MAX_STRUCT_SIZE (64 * 1024)
+
+/*------------------------------------------------------------------------------*/
+
+/* Records client calls of one component with their times and input data,
+ * see mfx_omx_record_format.h. Records are filled in buffers of the dump
+ * writer, so the component threads do not wait for the file. Data are taken
+ * at call entry (input buffer may be refilled once it is returned) and the
+ * record is committed when the call returns. If the writer falls behind and
+ * drops data, recording stops: the file is shorter, but has no holes.
+ * Recording writes client data to disk, so it is built with MFX_OMX_DEBUG_DUMP
+ * only; otherwise Create always returns NULL.
+ */
+class MfxOmxRecorder
+{
+public:
+    // returns NULL if recording is not enabled
+    static MfxOmxRecorder* Create(const char* name);
+    // writes end record and closes the file
+    ~MfxOmxRecorder(void);
+
+    // functions below return record to be committed or NULL if recording stopped
+    MfxOmxRecordHeader* BeginCommand(OMX_COMMANDTYPE cmd, OMX_U32 param);
+    MfxOmxRecordHeader* BeginStruct(MfxOmxRecordType type, OMX_INDEXTYPE index, OMX_PTR pStructure);
+    MfxOmxRecordHeader* BeginBuffer(MfxOmxRecordType type, OMX_U32 port, OMX_U32 size, OMX_BUFFERHEADERTYPE* pBuffer);
+    MfxOmxRecordHeader* BeginEmptyThisBuffer(OMX_BUFFERHEADERTYPE* pBuffer);
+
+    // sets buffer header returned by Use/AllocateBuffer
+    void SetBuffer(MfxOmxRecordHeader* pRecord, OMX_BUFFERHEADERTYPE* pBuffer);
+    // completes record with result of the call and queues it for writing
+    void Commit(MfxOmxRecordHeader* pRecord, OMX_ERRORTYPE result);
+
+    void RecordExtensionIndex(OMX_STRING name, OMX_INDEXTYPE index, OMX_ERRORTYPE result);
+
+protected: // functions
+    MfxOmxRecorder(FILE* file, bool bPayloads);
+
+    MfxOmxRecordHeader* Begin(MfxOmxRecordType type, mfxU32 size);
+
+protected: // variables
+    FILE* m_pFile;
+    bool m_bPayloads;
+    mfxU64 m_nStartTime;
+    std::atomic<bool> m_bStopped;
+
+private:
+    MFX_OMX_CLASS_NO_COPY(MfxOmxRecorder)
+};
+
+#endif // #ifndef __MFX_OMX_RECORDER_H__
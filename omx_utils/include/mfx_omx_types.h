@@ -183,12 +183,17 @@ union MfxOmxExtBuffer
 
 #define MFX_OMX_ENCODE_EXTBUF_MAX_NUM MFX_OMX_MAX(MFX_OMX_ENCODE_VIDEOPARAM_EXTBUF_MAX_NUM, MFX_OMX_ENCODE_CTRL_EXTBUF_MAX_NUM)
 
+template <typename T>
+class MfxOmxObjectPool;
+
 template<typename T, size_t N>
 struct MfxOmxParamsWrapper: public T
 {
     mfxExtBuffer* ext_buf_ptrs[N];
     MfxOmxExtBuffer ext_buf[N];
     mfxPayload* payload;
+    // pool the object is returned to, NULL for objects on heap; not copied
+    MfxOmxObjectPool<MfxOmxParamsWrapper>* pool;
     struct
     {
         bool enabled;
@@ -201,6 +206,7 @@ struct MfxOmxParamsWrapper: public T
 
         memset(static_cast<T*>(this), 0, sizeof(T));
         payload = NULL;
+        pool = NULL;
         if (!N) return;
 
         MFX_OMX_ZERO_MEMORY(ext_buf_ptrs);
@@ -213,7 +219,21 @@ struct MfxOmxParamsWrapper: public T
             ext_buf_ptrs[i] = (mfxExtBuffer*)&ext_buf[i];
         }
     }
-    MfxOmxParamsWrapper(const MfxOmxParamsWrapper& ref)
+    /** Brings the object back to the just constructed state in place. Buffers
+     * in ext_buf are left as is: they are zeroed on enabling and are not
+     * accessed while disabled.
+     */
+    void Reset()
+    {
+        memset(static_cast<T*>(this), 0, sizeof(T));
+        payload = NULL;
+        if (!N) return;
+
+        MFX_OMX_ZERO_MEMORY(ext_buf_idxmap);
+        this->ExtParam = ext_buf_ptrs;
+    }
+    MfxOmxParamsWrapper(const MfxOmxParamsWrapper& ref):
+        pool(NULL)
     {
         *this = ref; // call to operator=
     }
@@ -222,13 +242,26 @@ struct MfxOmxParamsWrapper: public T
         T* dst = this;
         const T* src = &ref;
 
+        if (this == &ref) return *this;
+
         *dst = *src;
         payload = ref.payload;
         if (!N) return *this;
 
         MFX_OMX_ZERO_MEMORY(ext_buf_ptrs);
-        std::copy(std::begin(ref.ext_buf), std::end(ref.ext_buf), std::begin(ext_buf));
         std::copy(std::begin(ref.ext_buf_idxmap), std::end(ref.ext_buf_idxmap), std::begin(ext_buf_idxmap));
+        // Only enabled buffers are copied and only up to their real size:
+        // the union is as big as the biggest buffer (ROI) while most enabled
+        // buffers are much smaller. Other slots are zeroed on enabling.
+        for (size_t i = 0; i < MFX_OMX_ENCODE_EXTBUF_MAX_NUM; ++i)
+        {
+            if (!ext_buf_idxmap[i].enabled) continue;
+
+            int idx = ext_buf_idxmap[i].idx;
+            if ((idx < 0) || ((size_t)idx >= N)) continue;
+
+            memcpy(&ext_buf[idx], &ref.ext_buf[idx], getExtBufferCopySize(ref.ext_buf[idx]));
+        }
 
         this->ExtParam = ext_buf_ptrs;
         for (size_t i = 0; i < N; ++i)
@@ -237,7 +270,8 @@ struct MfxOmxParamsWrapper: public T
         }
         return *this;
     }
-    MfxOmxParamsWrapper(const T& ref)
+    MfxOmxParamsWrapper(const T& ref):
+        pool(NULL)
     {
         *this = ref; // call to operator=
     }
@@ -261,6 +295,29 @@ struct MfxOmxParamsWrapper: public T
         }
         return *this;
     }
+    /** Function returns number of bytes copied by operator= from this object */
+    size_t getCopySize() const
+    {
+        size_t size = sizeof(T);
+        if (!N) return size;
+
+        for (size_t i = 0; i < MFX_OMX_ENCODE_EXTBUF_MAX_NUM; ++i)
+        {
+            if (!ext_buf_idxmap[i].enabled) continue;
+
+            int idx = ext_buf_idxmap[i].idx;
+            if ((idx < 0) || ((size_t)idx >= N)) continue;
+
+            size += getExtBufferCopySize(ext_buf[idx]);
+        }
+        return size;
+    }
+    static size_t getExtBufferCopySize(const MfxOmxExtBuffer& buffer)
+    {
+        size_t size = buffer.header.BufferSz;
+        if (!size || (size > sizeof(MfxOmxExtBuffer))) size = sizeof(MfxOmxExtBuffer);
+        return size;
+    }
     void ResetExtParams()
     {
         this->NumExtParam = 0;
@@ -352,27 +409,26 @@ struct MfxOmxParamsWrapper: public T
     }
 
 protected:
-    int getEnabledMapIdx(mfxU32 bufferid) const
+    /** Returns fixed slot of the buffer in ext_buf_idxmap. Slots are known at
+     * compile time, so lookups with constant ids fold to a constant and others
+     * are a single switch instead of a search.
+     */
+    static constexpr int getEnabledMapIdx(mfxU32 bufferid)
     {
-        int idx = 0;
         if (!N) return -1;
 
-        std::array<mfxU32, 8> mfxExtbufIds = {{
-            MFX_EXTBUFF_CODING_OPTION,
-            MFX_EXTBUFF_CODING_OPTION2,
-            MFX_EXTBUFF_CODING_OPTION3,
-            MFX_EXTBUFF_ENCODER_RESET_OPTION,
-            MFX_EXTBUFF_AVC_TEMPORAL_LAYERS,
-            MFX_EXTBUFF_VP9_PARAM,
-            MFX_EXTBUFF_VIDEO_SIGNAL_INFO,
-            MFX_EXTBUFF_ENCODER_ROI,
-        }};
-        auto extBufIdIt = std::find(mfxExtbufIds.begin(), mfxExtbufIds.end(), bufferid);
-        if (extBufIdIt != mfxExtbufIds.end())
-            idx = std::distance(mfxExtbufIds.begin(), extBufIdIt);
-
-        if (idx >= MFX_OMX_ENCODE_EXTBUF_MAX_NUM) return -1;
-        return idx;
+        switch (bufferid)
+        {
+          case MFX_EXTBUFF_CODING_OPTION:        return 0;
+          case MFX_EXTBUFF_CODING_OPTION2:       return 1;
+          case MFX_EXTBUFF_CODING_OPTION3:       return 2;
+          case MFX_EXTBUFF_ENCODER_RESET_OPTION: return 3;
+          case MFX_EXTBUFF_AVC_TEMPORAL_LAYERS:  return 4;
+          case MFX_EXTBUFF_VP9_PARAM:            return 5;
+          case MFX_EXTBUFF_VIDEO_SIGNAL_INFO:    return 6;
+          case MFX_EXTBUFF_ENCODER_ROI:          return 7;
+          default:                               return -1;
+        };
     }
 };
 
@@ -391,6 +447,8 @@ struct MfxOmxInputConfig
     bool bCodecInitialized;
     MfxOmxVideoParamsWrapper* mfxparams;
     MfxOmxEncodeCtrlWrapper* control;
+    // MFX_CODINGOPTION_ON/OFF to keep/remove headers of the requested IDR frame, 0 - as configured
+    mfxU16 nIdrHeaders;
 };
 
 /*------------------------------------------------------------------------------*/
@@ -498,6 +556,8 @@ enum
     MFX_OMX_COMPONENT_FLAGS_NONE = 0x0,
     MFX_OMX_COMPONENT_FLAGS_DUMP_INPUT = 0x01,
     MFX_OMX_COMPONENT_FLAGS_DUMP_OUTPUT = 0x02,
+    MFX_OMX_COMPONENT_FLAGS_DPB_SIZED_SURFACES = 0x04,
+    MFX_OMX_COMPONENT_FLAGS_CALLBACK_THREAD = 0x08,
 };
 
 // implementation specific functions
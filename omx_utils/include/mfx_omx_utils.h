@@ -21,6 +21,7 @@
 #ifndef __MFX_OMX_UTILS_H__
 #define __MFX_OMX_UTILS_H__
 
+#include <atomic>
 #include <vector>
 #include "mfx_omx_types.h"
 #include "mfx_omx_vm.h"
@@ -165,6 +166,9 @@ extern size_t mfx_omx_dump(
     const void *ptr, size_t size, size_t nmemb,
     FILE *stream);
 
+// writes queued dump data of the file and closes it
+extern void mfx_omx_dump_close(FILE *stream);
+
 extern void mfx_omx_dump_YUV_from_NV12_data(
     FILE* f, mfxFrameData * pData, mfxFrameInfo* info, mfxU32 p);
 
@@ -268,7 +272,8 @@ private:
 /*------------------------------------------------------------------------------*/
 
 template <typename T>
-MfxOmxRing<T>::MfxOmxRing(void)
+MfxOmxRing<T>::MfxOmxRing(void):
+    m_mutex("ring")
 {
     m_ring_size = 0;
     m_ring = NULL;
@@ -370,11 +375,242 @@ T* MfxOmxRing<T>::Get(T* item, T& nil_item)
 template <typename T>
 mfxU32 MfxOmxRing<T>::GetItemsCount(void)
 {
+    MfxOmxAutoLock lock(m_mutex);
     return m_items_count;
 }
 
 /*------------------------------------------------------------------------------*/
 
+/* Bounded ring which may be used by several producers and consumers without
+ * locks. Each cell keeps sequence number which tells whether cell is ready for
+ * writing or reading on the current lap. Size is rounded up to power of 2.
+ */
+template <typename T>
+class MfxOmxLockFreeRing
+{
+public:
+    MfxOmxLockFreeRing(mfxU32 size);
+    ~MfxOmxLockFreeRing(void);
+    bool Add(const T& item); // returns false if ring is full
+    bool Get(T& item); // returns false if ring is empty
+    inline mfxU32 GetSize(void) { return m_mask + 1; }
+protected:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T item;
+    };
+    Cell* m_ring;
+    size_t m_mask;
+    std::atomic<size_t> m_write_pos;
+    std::atomic<size_t> m_read_pos;
+private:
+    MFX_OMX_CLASS_NO_COPY(MfxOmxLockFreeRing)
+};
+
+/*------------------------------------------------------------------------------*/
+
+template <typename T>
+MfxOmxLockFreeRing<T>::MfxOmxLockFreeRing(mfxU32 size)
+{
+    size_t ring_size = 2;
+    while (ring_size < size) ring_size <<= 1;
+
+    m_ring = NULL;
+    m_mask = 0;
+    MFX_OMX_NEW(m_ring, Cell[ring_size]);
+    if (m_ring)
+    {
+        m_mask = ring_size - 1;
+        for (size_t i = 0; i < ring_size; ++i)
+        {
+            m_ring[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    m_write_pos.store(0, std::memory_order_relaxed);
+    m_read_pos.store(0, std::memory_order_relaxed);
+}
+
+/*------------------------------------------------------------------------------*/
+
+template <typename T>
+MfxOmxLockFreeRing<T>::~MfxOmxLockFreeRing(void)
+{
+    if (m_ring) delete[] m_ring;
+}
+
+/*------------------------------------------------------------------------------*/
+
+template <typename T>
+bool MfxOmxLockFreeRing<T>::Add(const T& item)
+{
+    if (!m_ring) return false;
+
+    size_t pos = m_write_pos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell* cell = &m_ring[pos & m_mask];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+        if (!diff)
+        {
+            if (m_write_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                cell->item = item;
+                cell->sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0) return false; // cell was not read on previous lap
+        else pos = m_write_pos.load(std::memory_order_relaxed);
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+template <typename T>
+bool MfxOmxLockFreeRing<T>::Get(T& item)
+{
+    if (!m_ring) return false;
+
+    size_t pos = m_read_pos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell* cell = &m_ring[pos & m_mask];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+
+        if (!diff)
+        {
+            if (m_read_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                item = cell->item;
+                cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0) return false; // cell was not written on this lap
+        else pos = m_read_pos.load(std::memory_order_relaxed);
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+/* Keeps released objects for reuse instead of returning them to the heap.
+ * Up to capacity objects are kept, objects released above it are deleted.
+ * Released objects are cleared with T::Reset().
+ */
+template <typename T>
+class MfxOmxObjectPool
+{
+public:
+    MfxOmxObjectPool(void);
+    ~MfxOmxObjectPool(void);
+    void Reserve(mfxI32 count); // changes capacity by count and preallocates objects
+    T* Get(bool* pbAllocated = NULL); // pbAllocated tells whether object was allocated on heap
+    void Put(T* obj);
+    inline mfxU32 GetAllocationsCount(void) { MfxOmxAutoLock lock(m_mutex); return m_nAllocations; }
+    inline mfxU32 GetCapacity(void) { MfxOmxAutoLock lock(m_mutex); return m_nCapacity; }
+protected:
+    std::vector<T*> m_free;
+    mfxU32 m_nCapacity;
+    mfxU32 m_nAllocations; // allocations done because pool was empty
+    MfxOmxMutex m_mutex;
+private:
+    MFX_OMX_CLASS_NO_COPY(MfxOmxObjectPool)
+};
+
+/*------------------------------------------------------------------------------*/
+
+template <typename T>
+MfxOmxObjectPool<T>::MfxOmxObjectPool(void):
+    m_mutex("object_pool")
+{
+    m_nCapacity = 0;
+    m_nAllocations = 0;
+}
+
+/*------------------------------------------------------------------------------*/
+
+template <typename T>
+MfxOmxObjectPool<T>::~MfxOmxObjectPool(void)
+{
+    for (size_t i = 0; i < m_free.size(); ++i)
+    {
+        MFX_OMX_DELETE(m_free[i]);
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+template <typename T>
+void MfxOmxObjectPool<T>::Reserve(mfxI32 count)
+{
+    MfxOmxAutoLock lock(m_mutex);
+
+    m_nCapacity = ((mfxI32)m_nCapacity + count > 0)? m_nCapacity + count: 0;
+    MFX_OMX_TRY_AND_CATCH(m_free.reserve(m_nCapacity), return);
+
+    while (m_free.size() < m_nCapacity)
+    {
+        T* obj = NULL;
+
+        MFX_OMX_NEW(obj, T);
+        if (!obj) break;
+        m_free.push_back(obj);
+    }
+    while (m_free.size() > m_nCapacity)
+    {
+        delete m_free.back();
+        m_free.pop_back();
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+template <typename T>
+T* MfxOmxObjectPool<T>::Get(bool* pbAllocated)
+{
+    MfxOmxAutoLock lock(m_mutex);
+    T* obj = NULL;
+    bool bAllocated = false;
+
+    if (!m_free.empty())
+    {
+        obj = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        MFX_OMX_NEW(obj, T);
+        if (obj)
+        {
+            ++m_nAllocations;
+            bAllocated = true;
+        }
+    }
+    if (pbAllocated) *pbAllocated = bAllocated;
+    return obj;
+}
+
+/*------------------------------------------------------------------------------*/
+
+template <typename T>
+void MfxOmxObjectPool<T>::Put(T* obj)
+{
+    if (!obj) return;
+
+    obj->Reset();
+
+    MfxOmxAutoLock lock(m_mutex);
+    // vector memory is reserved for capacity, so push_back does not allocate
+    if (m_free.size() < m_nCapacity) m_free.push_back(obj);
+    else delete obj;
+}
+
+/*------------------------------------------------------------------------------*/
+
 template<class T> inline T * Begin(std::vector<T> & t) { return &*t.begin(); }
 
 template<class T> inline T * End(std::vector<T> & t) { return &*t.begin() + t.size(); }
@@ -383,6 +619,18 @@ template<class T> inline void Zero(std::vector<T> & vec)   { memset(&vec[0], 0,
 
 /*------------------------------------------------------------------------------*/
 
+typedef MfxOmxObjectPool<MfxOmxEncodeCtrlWrapper> MfxOmxEncodeCtrlPool;
+
+/* Per-frame encode controls are taken from the pool of the encoder which
+ * sizes it to the frames it keeps in flight, so steady state encoding does
+ * not allocate them on heap. With NULL pool control is allocated on heap.
+ */
+extern MfxOmxEncodeCtrlWrapper* mfx_omx_get_encode_ctrl(MfxOmxEncodeCtrlPool* pool);
+/* Frees control payload and returns control to its pool or deletes it, ctrl is set to NULL. */
+extern void mfx_omx_put_encode_ctrl(MfxOmxEncodeCtrlWrapper*& ctrl);
+
+/*------------------------------------------------------------------------------*/
+
 class MfxOmxInputConfigAggregator: public MfxOmxInputConfig
 {
 public:
@@ -392,7 +640,7 @@ public:
     }
     ~MfxOmxInputConfigAggregator()
     {
-        MFX_OMX_DELETE(control);
+        mfx_omx_put_encode_ctrl(control);
         MFX_OMX_DELETE(mfxparams);
     }
     MfxOmxInputConfigAggregator& operator+=(MfxOmxInputConfig& new_config)
@@ -413,7 +661,9 @@ public:
                 control->QP = qp;
                 control->FrameType = frameType;
 
-                MFX_OMX_DELETE(new_config.control);
+                // payload is now owned by the aggregated control
+                new_config.control->payload = NULL;
+                mfx_omx_put_encode_ctrl(new_config.control);
             }
             else
             {
@@ -425,6 +675,10 @@ public:
             MFX_OMX_DELETE(mfxparams);
             mfxparams = new_config.mfxparams;
         }
+        if (new_config.nIdrHeaders)
+        {
+            nIdrHeaders = new_config.nIdrHeaders;
+        }
         return *this;
     }
     MfxOmxInputConfig release()
@@ -433,8 +687,10 @@ public:
 
         config.control = control;
         config.mfxparams = mfxparams;
+        config.nIdrHeaders = nIdrHeaders;
         control = NULL;
         mfxparams = NULL;
+        nIdrHeaders = 0;
         config.bCodecInitialized = false;
 
         return config;
@@ -459,6 +715,31 @@ struct NalUnit
 
 extern NalUnit GetNalUnit(mfxU8 * begin, mfxU8 * end);
 
+/* Converts Annex B byte stream to NAL units prefixed with their big endian
+ * length of lengthSize (1, 2 or 4) bytes in place. Data may grow if start codes
+ * are shorter than length prefix, so maxLength bytes should be available.
+ */
+extern mfxStatus mfx_omx_convert_to_length_prefixed(
+    mfxU8* data, mfxU32& length, mfxU32 maxLength, mfxU32 lengthSize);
+/* Builds avcC (AVC) or hvcC (HEVC) record from Annex B parameter sets. On input
+ * recordSize is size of record buffer, on output - size of the record.
+ */
+extern mfxStatus mfx_omx_make_codec_config_record(
+    mfxU32 codecId, mfxU8* data, mfxU32 length, mfxU32 lengthSize,
+    const mfxFrameInfo& info, mfxU8* record, mfxU32& recordSize);
+/* Converts NAL units prefixed with big endian length of lengthSize bytes to
+ * Annex B byte stream with 4 bytes start codes written to out. With NULL out
+ * only checks the prefixes. outLength is set to size of converted data.
+ */
+extern mfxStatus mfx_omx_convert_to_start_codes(
+    const mfxU8* data, mfxU32 length, mfxU32 lengthSize, mfxU8* out, mfxU32& outLength);
+/* Checks avcC (AVC) or hvcC (HEVC) record and converts its parameter sets to
+ * Annex B byte stream written to out (with NULL out only checks the record).
+ * Returns size of converted data and NAL unit length size signaled in the record.
+ */
+extern mfxStatus mfx_omx_convert_config_record_to_start_codes(
+    mfxU32 codecId, const mfxU8* data, mfxU32 length, mfxU8* out, mfxU32& outLength, mfxU32& lengthSize);
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
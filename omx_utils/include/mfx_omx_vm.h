@@ -21,6 +21,7 @@
 #ifndef __MFX_OMX_VM_H__
 #define __MFX_OMX_VM_H__
 
+#include <atomic>
 #include <thread>
 #include "mfx_omx_types.h"
 
@@ -40,6 +41,9 @@ extern void* mfx_so_get_addr(mfx_omx_so_handle handle, const char *func_name);
 
 extern mfxU32 mfx_omx_get_cpu_num(void);
 
+/* returns monotonic time in microseconds */
+extern mfxU64 mfx_omx_get_time_us(void);
+
 /*------------------------------------------------------------------------------*/
 
 #ifdef __cplusplus
@@ -48,10 +52,20 @@ extern mfxU32 mfx_omx_get_cpu_num(void);
 
 /*------------------------------------------------------------------------------*/
 
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+struct MfxOmxLockStats;
+#endif
+
+/* Names given to the synchronization objects below (string literals) group
+ * their statistics in MFX_OMX_LOCK_STATS builds and are ignored otherwise.
+ */
+
+/*------------------------------------------------------------------------------*/
+
 class MfxOmxMutex
 {
 public:
-    MfxOmxMutex(void);
+    MfxOmxMutex(const char* name = NULL);
     ~MfxOmxMutex(void);
 
     mfxStatus Lock(void);
@@ -60,6 +74,11 @@ public:
 
 private: // variables
     pthread_mutex_t m_mutex;
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    MfxOmxLockStats* m_pStats;
+    // time the mutex was taken, ns
+    mfxU64 m_nLockTime;
+#endif
 
 private: // functions
     MFX_OMX_CLASS_NO_COPY(MfxOmxMutex)
@@ -86,10 +105,15 @@ private: // functions
 
 /*------------------------------------------------------------------------------*/
 
+/* Events and semaphores are futex based: Signal, Post and Wait which does not
+ * need to block are done by atomic operations only, system calls are made to
+ * sleep and to wake threads sleeping on the object. Wait functions return 0
+ * on success and ETIMEDOUT on timeout.
+ */
 class MfxOmxEvent
 {
 public:
-    MfxOmxEvent(bool manual, bool state);
+    MfxOmxEvent(bool manual, bool state, const char* name = NULL);
     ~MfxOmxEvent(void);
 
     int Signal(void);
@@ -97,10 +121,18 @@ public:
     int Wait(void);
     int TimedWait(mfxU32 msec);
 private:
+    // takes the signaled state if there is one, the state is kept for manual events
+    inline bool TryWait(void);
+    int SlowWait(const struct timespec* deadline);
+
     bool m_manual;
-    bool m_state;
-    pthread_cond_t m_event;
-    pthread_mutex_t m_mutex;
+    // futex word: 1 - signaled, 0 - not
+    std::atomic<int> m_state;
+    // threads in SlowWait, Signal makes system call only if there are some
+    std::atomic<int> m_waiters;
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    MfxOmxLockStats* m_pStats;
+#endif
 
 private: // functions
     MFX_OMX_CLASS_NO_COPY(MfxOmxEvent)
@@ -111,17 +143,26 @@ private: // functions
 class MfxOmxSemaphore
 {
 public:
-    MfxOmxSemaphore(mfxU32 count = 0);
+    MfxOmxSemaphore(mfxU32 count = 0, const char* name = NULL);
     ~MfxOmxSemaphore(void);
 
     int Post(void);
     int Wait(void);
     int Wait(mfxU32 timeout);
+    // takes the semaphore if its count is not zero, never blocks
+    bool Try(void);
 //    void Reset(void);
 private:
-    mfxU32 m_count;
-    pthread_cond_t m_semaphore;
-    pthread_mutex_t m_mutex;
+    inline bool TryWait(void);
+    int SlowWait(const struct timespec* deadline);
+
+    // futex word
+    std::atomic<int> m_count;
+    // threads in SlowWait, Post makes system call only if there are some
+    std::atomic<int> m_waiters;
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    MfxOmxLockStats* m_pStats;
+#endif
 
 private: // functions
     MFX_OMX_CLASS_NO_COPY(MfxOmxSemaphore)
@@ -74,7 +74,7 @@ void MfxOmxComponentManager::SetDefaultConfiguration() noexcept
     component.maxLimit = mMaxResourcesNum;
     component.currentLimit = 0;
 
-    mLock.lock();
+    mLock.Lock();
     for(unsigned int cIndex(1); cIndex < numOfCodecs; ++cIndex )
     {
         component.codecInfo.codecType = static_cast<CodecType_e>(cIndex);
@@ -91,7 +91,7 @@ void MfxOmxComponentManager::SetDefaultConfiguration() noexcept
             mResources.push_back(component);
         }
     }
-    mLock.unlock();
+    mLock.Unlock();
 }
 
 bool MfxOmxComponentManager::IsResourceAvailable()
@@ -127,7 +127,7 @@ bool MfxOmxComponentManager::LoadConfiguration(const std::string& configFilePath
     MFX_OMX_AUTO_TRACE_FUNC();
     using namespace tinyxml2;
 
-    mLock.lock();
+    mLock.Lock();
     mResources.clear();
 
     XMLDocument document;
@@ -183,14 +183,14 @@ bool MfxOmxComponentManager::LoadConfiguration(const std::string& configFilePath
           element = element->NextSiblingElement("Codec");
       }
     }
-    mLock.unlock();
+    mLock.Unlock();
     return true;
 }
 
 bool MfxOmxComponentManager::CheckComponent(CodecInfo currResource)
 {
     MFX_OMX_AUTO_TRACE_FUNC();
-    mLock.lock();
+    mLock.Lock();
 
     if(!IsResourceExist(currResource))
     {
@@ -210,7 +210,7 @@ bool MfxOmxComponentManager::CheckComponent(CodecInfo currResource)
     }
     resource->currentLimit++;
 
-    mLock.unlock();
+    mLock.Unlock();
     return true;
 }
 
@@ -293,10 +293,10 @@ void MfxOmxComponentManager::UpdateComponentTable(OMX_COMPONENTTYPE* pComponent)
     // This is a w/a to set default frame rate as 30 in case it is not set from framework.
     else { currResource.frameRate = 30; }
 
-    mLock.lock();
+    mLock.Lock();
     mActiveResources.push_back(std::move(currResource));
     mCurrNumOfComponents++;
-    mLock.unlock();
+    mLock.Unlock();
 }
 
 #endif //#ifdef MFX_RESOURCES_LIMIT
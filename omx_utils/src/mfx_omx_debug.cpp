@@ -27,7 +27,8 @@
 
 /*------------------------------------------------------------------------------*/
 
-#if MFX_OMX_DEBUG == MFX_OMX_YES
+// binary trace backend is implemented in mfx_omx_trace_ring.cpp
+#if (MFX_OMX_DEBUG == MFX_OMX_YES) && (MFX_OMX_DEBUG_TRACE_RING != MFX_OMX_YES)
 
 /*------------------------------------------------------------------------------*/
 
@@ -281,7 +282,7 @@ void mfx_omx_trace::printf_msg(const char* msg)
 
 /*------------------------------------------------------------------------------*/
 
-#endif // #if MFX_OMX_DEBUG == MFX_OMX_YES
+#endif // #if (MFX_OMX_DEBUG == MFX_OMX_YES) && (MFX_OMX_DEBUG_TRACE_RING != MFX_OMX_YES)
 
 /*------------------------------------------------------------------------------*/
 
@@ -19,6 +19,7 @@
 // SOFTWARE.
 
 #include "mfx_omx_dev.h"
+#include "mfx_omx_dev_mock.h"
 
 #ifdef LIBVA_SUPPORT
 #include "mfx_omx_dev_android.h"
@@ -32,7 +33,9 @@ MfxOmxDev* mfx_omx_create_dev(void)
     MfxOmxDev* pDev = NULL;
     mfxStatus sts = MFX_ERR_NONE;
 
-#ifdef LIBVA_SUPPORT
+#if MFX_OMX_MOCK_BACKEND == MFX_OMX_YES
+    MFX_OMX_NEW(pDev, MfxOmxDevMock(sts));
+#elif defined(LIBVA_SUPPORT)
     MFX_OMX_NEW(pDev, MfxOmxDevAndroid(sts));
 #endif
 
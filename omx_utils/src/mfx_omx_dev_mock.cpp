@@ -0,0 +1,253 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mfx_omx_dev_mock.h"
+
+#if MFX_OMX_MOCK_BACKEND == MFX_OMX_YES
+
+/*------------------------------------------------------------------------------*/
+
+#undef MFX_OMX_MODULE_NAME
+#define MFX_OMX_MODULE_NAME "mfx_omx_dev_mock"
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxMockFrameAllocator::MfxOmxMockFrameAllocator(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxMockFrameAllocator::~MfxOmxMockFrameAllocator(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockFrameAllocator::AllocImpl(mfxFrameAllocRequest *request, mfxFrameAllocResponse *response)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    mfxStatus mfx_res = MFX_ERR_NONE;
+    mfxU16 width = (mfxU16)(MFX_OMX_MEM_ALIGN(request->Info.Width, 32));
+    mfxU16 height = (mfxU16)(MFX_OMX_MEM_ALIGN(request->Info.Height, 32));
+    mfxU32 pitch = 0, size = 0;
+    mfxMemId* mids = NULL;
+    mfxU16 i = 0;
+
+    switch (request->Info.FourCC)
+    {
+    case MFX_FOURCC_NV12:
+        pitch = width;
+        size = pitch * height * 3 / 2;
+        break;
+    case MFX_FOURCC_P010:
+        pitch = width * 2;
+        size = pitch * height * 3 / 2;
+        break;
+    case MFX_FOURCC_RGB4:
+        pitch = width * 4;
+        size = pitch * height;
+        break;
+    default:
+        mfx_res = MFX_ERR_UNSUPPORTED;
+        break;
+    }
+
+    if (MFX_ERR_NONE == mfx_res)
+    {
+        mids = (mfxMemId*)calloc(request->NumFrameSuggested, sizeof(mfxMemId));
+        if (!mids) mfx_res = MFX_ERR_MEMORY_ALLOC;
+    }
+    for (i = 0; (MFX_ERR_NONE == mfx_res) && (i < request->NumFrameSuggested); ++i)
+    {
+        Frame* pFrame = NULL;
+
+        MFX_OMX_NEW(pFrame, Frame);
+        if (pFrame)
+        {
+            pFrame->pData = (mfxU8*)malloc(size);
+            pFrame->fourcc = request->Info.FourCC;
+            pFrame->width = width;
+            pFrame->height = height;
+            pFrame->pitch = pitch;
+            mids[i] = pFrame;
+        }
+        if (!pFrame || !pFrame->pData) mfx_res = MFX_ERR_MEMORY_ALLOC;
+    }
+    if (MFX_ERR_NONE == mfx_res)
+    {
+        response->mids = mids;
+        response->NumFrameActual = request->NumFrameSuggested;
+    }
+    else if (mids)
+    {
+        mfxFrameAllocResponse partial;
+        MFX_OMX_ZERO_MEMORY(partial);
+        partial.mids = mids;
+        partial.NumFrameActual = i;
+        ReleaseResponse(&partial);
+    }
+    MFX_OMX_AUTO_TRACE_I32(mfx_res);
+    return mfx_res;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockFrameAllocator::ReleaseResponse(mfxFrameAllocResponse *response)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    if (!response) return MFX_ERR_NULL_PTR;
+
+    if (response->mids)
+    {
+        for (mfxU32 i = 0; i < response->NumFrameActual; ++i)
+        {
+            Frame* pFrame = (Frame*)response->mids[i];
+            if (pFrame) MFX_OMX_FREE(pFrame->pData);
+            MFX_OMX_DELETE(pFrame);
+        }
+        MFX_OMX_FREE(response->mids);
+    }
+    response->NumFrameActual = 0;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockFrameAllocator::LockFrame(mfxMemId mid, mfxFrameData *ptr)
+{
+    Frame* pFrame = (Frame*)mid;
+
+    if (!pFrame || !ptr) return MFX_ERR_NULL_PTR;
+
+    mfxU8* pData = pFrame->pData;
+    switch (pFrame->fourcc)
+    {
+    case MFX_FOURCC_NV12:
+    case MFX_FOURCC_P010:
+        ptr->Y = pData;
+        ptr->UV = pData + pFrame->pitch * pFrame->height;
+        ptr->U = ptr->UV;
+        ptr->V = ptr->UV + ((MFX_FOURCC_P010 == pFrame->fourcc) ? 2 : 1);
+        break;
+    case MFX_FOURCC_RGB4:
+        ptr->B = pData;
+        ptr->G = pData + 1;
+        ptr->R = pData + 2;
+        ptr->A = pData + 3;
+        break;
+    default:
+        return MFX_ERR_LOCK_MEMORY;
+    }
+    ptr->PitchHigh = (mfxU16)(pFrame->pitch >> 16);
+    ptr->PitchLow = (mfxU16)(pFrame->pitch & 0xFFFF);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockFrameAllocator::UnlockFrame(mfxMemId mid, mfxFrameData *ptr)
+{
+    MFX_OMX_UNUSED(mid);
+    if (ptr)
+    {
+        ptr->Y = ptr->U = ptr->V = ptr->A = NULL;
+        ptr->PitchHigh = ptr->PitchLow = 0;
+    }
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockFrameAllocator::GetFrameHDL(mfxMemId mid, mfxHDL *handle)
+{
+    if (!handle) return MFX_ERR_NULL_PTR;
+    *handle = mid;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxDevMock::MfxOmxDevMock(mfxStatus &sts):
+    m_bInitialized(false),
+    m_pFrameAllocator(NULL)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    sts = MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxDevMock::~MfxOmxDevMock(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    DevClose();
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxDevMock::DevInit(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    mfxStatus mfx_res = MFX_ERR_NONE;
+
+    if (m_bInitialized) mfx_res = MFX_ERR_UNKNOWN;
+    else
+    {
+        MFX_OMX_NEW(m_pFrameAllocator, MfxOmxMockFrameAllocator);
+        if (m_pFrameAllocator) m_bInitialized = true;
+        else mfx_res = MFX_ERR_MEMORY_ALLOC;
+    }
+    MFX_OMX_AUTO_TRACE_I32(mfx_res);
+    return mfx_res;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxDevMock::DevClose(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    if (m_bInitialized)
+    {
+        MFX_OMX_DELETE(m_pFrameAllocator);
+        m_bInitialized = false;
+    }
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxDevMock::InitMfxSession(MFXVideoSession* session)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    mfxStatus mfx_res = MFX_ERR_NONE;
+
+    if (!session) mfx_res = MFX_ERR_NULL_PTR;
+    if (MFX_ERR_NONE == mfx_res)
+    {
+        mfx_res = session->SetFrameAllocator(m_pFrameAllocator);
+    }
+    MFX_OMX_AUTO_TRACE_I32(mfx_res);
+    return mfx_res;
+}
+
+#endif // #if MFX_OMX_MOCK_BACKEND == MFX_OMX_YES
@@ -0,0 +1,236 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <chrono>
+
+#include "mfx_omx_dump_writer.h"
+
+/*------------------------------------------------------------------------------*/
+
+#undef MFX_OMX_MODULE_NAME
+#define MFX_OMX_MODULE_NAME "mfx_omx_dump_writer"
+
+/*------------------------------------------------------------------------------*/
+
+unsigned int MfxOmxDumpWriter_Thread(void* param)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    unsigned int res = 0;
+    MfxOmxDumpWriter* pWriter = (MfxOmxDumpWriter*) param;
+
+    if (pWriter) pWriter->Thread();
+    else res = 1;
+    return res;
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxDumpWriter& mfx_omx_get_dump_writer(void)
+{
+    static MfxOmxDumpWriter writer;
+    return writer;
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxDumpWriter::MfxOmxDumpWriter(mfxU32 budget):
+    m_pWritingFile(NULL),
+    m_mutex("dump_writer"),
+    m_semaphore(0, "dump_writer"),
+    m_pThread(NULL),
+    m_bStop(false),
+    m_nBudget(budget),
+    m_nQueuedBytes(0),
+    m_nWrittenBytes(0),
+    m_nDroppedChunks(0),
+    m_nDroppedBytes(0)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+
+    MFX_OMX_NEW(m_pThread, MfxOmxThread(MfxOmxDumpWriter_Thread, this));
+    if (!m_pThread) MFX_OMX_LOG_ERROR("failed to create dump writer thread, dumps will be written synchronously");
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxDumpWriter::~MfxOmxDumpWriter(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+
+    if (m_pThread)
+    {
+        {
+            MfxOmxAutoLock lock(m_mutex);
+            m_bStop = true;
+        }
+        m_semaphore.Post();
+        m_pThread->Wait();
+        MFX_OMX_DELETE(m_pThread);
+    }
+    MFX_OMX_LOG_INFO("Dumps: written %lld bytes, dropped %d chunks (%lld bytes)",
+                     m_nWrittenBytes, m_nDroppedChunks, m_nDroppedBytes);
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxU8* MfxOmxDumpWriter::GetBuffer(mfxU32 size)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    mfxU8* buffer = NULL;
+
+    {
+        MfxOmxAutoLock lock(m_mutex);
+
+        if (m_nQueuedBytes + size > m_nBudget)
+        {
+            ++m_nDroppedChunks;
+            m_nDroppedBytes += size;
+            return NULL;
+        }
+        m_nQueuedBytes += size;
+    }
+    buffer = (mfxU8*)malloc(size);
+    if (!buffer)
+    {
+        MfxOmxAutoLock lock(m_mutex);
+
+        m_nQueuedBytes -= size;
+        ++m_nDroppedChunks;
+        m_nDroppedBytes += size;
+    }
+    return buffer;
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxDumpWriter::Commit(FILE* file, mfxU8* buffer, mfxU32 size)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+
+    if (!buffer) return;
+    if (!m_pThread)
+    {
+        fwrite(buffer, 1, size, file);
+        fflush(file);
+        {
+            MfxOmxAutoLock lock(m_mutex);
+            m_nQueuedBytes -= size;
+            m_nWrittenBytes += size;
+        }
+        free(buffer);
+        return;
+    }
+
+    Chunk chunk = { file, buffer, size };
+    {
+        MfxOmxAutoLock lock(m_mutex);
+        m_Chunks.push_back(chunk);
+    }
+    m_semaphore.Post();
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxDumpWriter::Write(FILE* file, const void* data, mfxU32 size)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+
+    if (!file || !data || !size) return false;
+
+    mfxU8* buffer = GetBuffer(size);
+    if (!buffer) return false;
+
+    memcpy(buffer, data, size);
+    Commit(file, buffer, size);
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxDumpWriter::Close(FILE* file)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+
+    if (!file) return;
+
+    for (;;)
+    {
+        bool bPending = false;
+        {
+            MfxOmxAutoLock lock(m_mutex);
+
+            bPending = (file == m_pWritingFile);
+            for (size_t i = 0; !bPending && (i < m_Chunks.size()); ++i)
+            {
+                bPending = (file == m_Chunks[i].file);
+            }
+        }
+        if (!bPending) break;
+        // closing is rare, so simple polling is enough
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    fclose(file);
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxDumpWriter::Thread(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    Chunk chunk;
+
+    for (;;)
+    {
+        m_semaphore.Wait();
+        {
+            MfxOmxAutoLock lock(m_mutex);
+
+            if (m_Chunks.empty())
+            {
+                if (m_bStop) break;
+                continue;
+            }
+            chunk = m_Chunks.front();
+            m_Chunks.pop_front();
+            m_pWritingFile = chunk.file;
+        }
+
+        fwrite(chunk.data, 1, chunk.size, chunk.file);
+        free(chunk.data);
+
+        bool bLast = true;
+        {
+            MfxOmxAutoLock lock(m_mutex);
+
+            m_nQueuedBytes -= chunk.size;
+            m_nWrittenBytes += chunk.size;
+            for (size_t i = 0; bLast && (i < m_Chunks.size()); ++i)
+            {
+                bLast = (chunk.file != m_Chunks[i].file);
+            }
+        }
+        // data reach the file when there is nothing more to write to it
+        if (bLast) fflush(chunk.file);
+        {
+            MfxOmxAutoLock lock(m_mutex);
+            m_pWritingFile = NULL;
+        }
+    }
+}
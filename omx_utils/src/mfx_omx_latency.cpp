@@ -0,0 +1,247 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mfx_omx_latency.h"
+
+/*------------------------------------------------------------------------------*/
+
+#undef MFX_OMX_MODULE_NAME
+#define MFX_OMX_MODULE_NAME "mfx_omx_latency"
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxLatencyHistogram::MfxOmxLatencyHistogram(void)
+{
+    Reset();
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxLatencyHistogram::Reset(void)
+{
+    for (mfxU32 i = 0; i < BUCKETS_NUM; ++i)
+    {
+        m_Buckets[i].store(0, std::memory_order_relaxed);
+    }
+    m_nCount.store(0, std::memory_order_relaxed);
+    m_nSum.store(0, std::memory_order_relaxed);
+    m_nMin.store((mfxU64)-1, std::memory_order_relaxed);
+    m_nMax.store(0, std::memory_order_relaxed);
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxU32 MfxOmxLatencyHistogram::GetBucket(mfxU64 value)
+{
+    if (value < 2 * SUB_BUCKETS) return (mfxU32)value;
+    if (value > 0xFFFFFFFF) value = 0xFFFFFFFF;
+
+    mfxU32 msb = 0;
+    for (mfxU64 v = value; v > 1; v >>= 1) ++msb;
+
+    return (msb - 3) * SUB_BUCKETS + (mfxU32)((value >> (msb - 4)) & (SUB_BUCKETS - 1));
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxU64 MfxOmxLatencyHistogram::GetBucketValue(mfxU32 bucket)
+{
+    if (bucket < 2 * SUB_BUCKETS) return bucket;
+
+    mfxU32 msb = bucket / SUB_BUCKETS + 3;
+    return (mfxU64)(SUB_BUCKETS + bucket % SUB_BUCKETS) << (msb - 4);
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxLatencyHistogram::Record(mfxU64 value)
+{
+    m_Buckets[GetBucket(value)].fetch_add(1, std::memory_order_relaxed);
+    m_nCount.fetch_add(1, std::memory_order_relaxed);
+    m_nSum.fetch_add(value, std::memory_order_relaxed);
+
+    mfxU64 min = m_nMin.load(std::memory_order_relaxed);
+    while ((value < min) && !m_nMin.compare_exchange_weak(min, value, std::memory_order_relaxed));
+
+    mfxU64 max = m_nMax.load(std::memory_order_relaxed);
+    while ((value > max) && !m_nMax.compare_exchange_weak(max, value, std::memory_order_relaxed));
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxU64 MfxOmxLatencyHistogram::GetMean(void) const
+{
+    mfxU32 count = GetCount();
+    return count ? m_nSum.load(std::memory_order_relaxed) / count : 0;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxU64 MfxOmxLatencyHistogram::GetMin(void) const
+{
+    return GetCount() ? m_nMin.load(std::memory_order_relaxed) : 0;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxU64 MfxOmxLatencyHistogram::GetPercentile(mfxU32 percentile) const
+{
+    mfxU64 count = GetCount();
+    if (!count) return 0;
+
+    // rank of the value, counting from 1
+    mfxU64 rank = MFX_OMX_MAX((count * MFX_OMX_MIN(percentile, 100) + 99) / 100, 1);
+    mfxU64 sum = 0;
+    for (mfxU32 i = 0; i < BUCKETS_NUM; ++i)
+    {
+        sum += m_Buckets[i].load(std::memory_order_relaxed);
+        if (sum >= rank) return GetBucketValue(i);
+    }
+    return GetMax();
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxLatencyTracker::MfxOmxLatencyTracker(void):
+    m_nDroppedFrames(0)
+{
+    Reset();
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxLatencyTracker::Reset(void)
+{
+    for (mfxU32 i = 0; i < SLOTS_NUM; ++i)
+    {
+        m_Slots[i].key.store(0, std::memory_order_relaxed);
+        for (mfxU32 j = 0; j < MFX_OMX_LATENCY_POINT_NUM; ++j)
+        {
+            m_Slots[i].times[j].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxU32 MfxOmxLatencyTracker::GetSlotIndex(mfxU64 timeStamp)
+{
+    // Fibonacci hashing: time stamps of adjacent frames differ by a constant
+    // step which would map them to few slots if taken modulo slots number
+    return (mfxU32)((timeStamp * 0x9E3779B97F4A7C15ULL) >> (64 - SLOTS_BITS));
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxLatencyTracker::Slot* MfxOmxLatencyTracker::FindSlot(mfxU64 timeStamp, mfxU64& key)
+{
+    // time stamps may lose 1 tick on conversion between OMX and MFX units
+    const mfxU64 timeStamps[] = { timeStamp, timeStamp - 1, timeStamp + 1 };
+
+    for (mfxU32 i = 0; i < MFX_OMX_GET_ARRAY_SIZE(timeStamps); ++i)
+    {
+        if (MFX_OMX_TIME_STAMP_INVALID == timeStamps[i]) continue;
+
+        Slot* pSlot = &m_Slots[GetSlotIndex(timeStamps[i])];
+        key = timeStamps[i] + 1;
+        if (pSlot->key.load(std::memory_order_acquire) == key) return pSlot;
+    }
+    return NULL;
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxLatencyTracker::Mark(MfxOmxLatencyPoint point, mfxU64 timeStamp, mfxU64 time)
+{
+    if (MFX_OMX_TIME_STAMP_INVALID == timeStamp) return;
+    if (!time) time = mfx_omx_get_time_us();
+
+    mfxU64 key = 0;
+    Slot* pSlot = FindSlot(timeStamp, key);
+    if (!pSlot)
+    {
+        // only the first point may start frame tracking
+        if (MFX_OMX_LATENCY_POINT_INPUT != point) return;
+
+        pSlot = &m_Slots[GetSlotIndex(timeStamp)];
+        key = timeStamp + 1;
+        if (pSlot->key.exchange(0, std::memory_order_acq_rel)) ++m_nDroppedFrames;
+        for (mfxU32 i = 0; i < MFX_OMX_LATENCY_POINT_NUM; ++i)
+        {
+            pSlot->times[i].store(0, std::memory_order_relaxed);
+        }
+        pSlot->key.store(key, std::memory_order_release);
+    }
+    // several input buffers or decode calls may carry the same frame, first one counts
+    mfxU64 unset = 0;
+    pSlot->times[point].compare_exchange_strong(unset, time, std::memory_order_acq_rel);
+
+    mfxU64 times[MFX_OMX_LATENCY_POINT_NUM];
+    for (mfxU32 i = 0; i < MFX_OMX_LATENCY_POINT_NUM; ++i)
+    {
+        times[i] = pSlot->times[i].load(std::memory_order_acquire);
+    }
+    // sync and output may be marked at once by different threads, the one freeing the slot records
+    if (times[MFX_OMX_LATENCY_POINT_SYNC] && times[MFX_OMX_LATENCY_POINT_OUTPUT] &&
+        pSlot->key.compare_exchange_strong(key, 0, std::memory_order_acq_rel))
+    {
+        Record(times);
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxLatencyTracker::Record(const mfxU64* times)
+{
+    mfxU64 input = times[MFX_OMX_LATENCY_POINT_INPUT];
+    mfxU64 parsed = times[MFX_OMX_LATENCY_POINT_PARSED];
+    mfxU64 submit = times[MFX_OMX_LATENCY_POINT_SUBMIT];
+    mfxU64 sync = times[MFX_OMX_LATENCY_POINT_SYNC];
+    mfxU64 output = times[MFX_OMX_LATENCY_POINT_OUTPUT];
+
+    // output may be returned before sync time is marked by the same thread
+    if (output < sync) output = sync;
+
+    if (parsed && (parsed >= input)) m_Histograms[MFX_OMX_LATENCY_STAGE_PARSE].Record(parsed - input);
+    if (!parsed) parsed = input;
+    if (submit && (submit >= parsed)) m_Histograms[MFX_OMX_LATENCY_STAGE_QUEUE].Record(submit - parsed);
+    if (submit && (sync >= submit)) m_Histograms[MFX_OMX_LATENCY_STAGE_GPU].Record(sync - submit);
+    m_Histograms[MFX_OMX_LATENCY_STAGE_OUTPUT].Record(output - sync);
+    if (output >= input) m_Histograms[MFX_OMX_LATENCY_STAGE_TOTAL].Record(output - input);
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxLatencyTracker::Dump(const char* name) const
+{
+    static const char* stages[MFX_OMX_LATENCY_STAGE_NUM] = { "parse", "queue", "gpu", "output", "total" };
+
+    for (mfxU32 i = 0; i < MFX_OMX_LATENCY_STAGE_NUM; ++i)
+    {
+        const MfxOmxLatencyHistogram& h = m_Histograms[i];
+        if (!h.GetCount()) continue;
+
+        MFX_OMX_LOG_INFO("%s latency %s: frames %d, mean %lld us, min %lld us, p50 %lld us, p90 %lld us, p99 %lld us, max %lld us",
+                         name, stages[i], h.GetCount(), h.GetMean(), h.GetMin(),
+                         h.GetPercentile(50), h.GetPercentile(90), h.GetPercentile(99), h.GetMax());
+    }
+    mfxU32 dropped = m_nDroppedFrames.load(std::memory_order_relaxed);
+    if (dropped) MFX_OMX_LOG_INFO("%s latency: %d frames were not tracked till output", name, dropped);
+}
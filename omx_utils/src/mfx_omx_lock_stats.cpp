@@ -0,0 +1,194 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mfx_omx_utils.h"
+#include "mfx_omx_lock_stats.h"
+
+#include <cutils/properties.h>
+
+/*------------------------------------------------------------------------------*/
+
+#undef MFX_OMX_MODULE_NAME
+#define MFX_OMX_MODULE_NAME "mfx_omx_lock_stats"
+
+/*------------------------------------------------------------------------------*/
+
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+
+// not MfxOmxMutex: locks are registered from its constructor
+static pthread_mutex_t g_LockStatsMutex = PTHREAD_MUTEX_INITIALIZER;
+static mfxU32 g_LockStatsNum = 0;
+
+/*------------------------------------------------------------------------------*/
+
+// table is constructed on first use, locks may be created during static initialization
+static MfxOmxLockStats* mfx_omx_lock_stats_table(void)
+{
+    static MfxOmxLockStats table[MFX_OMX_LOCK_STATS_MAX];
+    return table;
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxLockStats* mfx_omx_lock_stats_get(const char* name, MfxOmxLockKind kind)
+{
+    static const char* unnamed[MFX_OMX_LOCK_KIND_NUM] = { "unnamed mutex", "unnamed event", "unnamed semaphore" };
+    MfxOmxLockStats* table = mfx_omx_lock_stats_table();
+    MfxOmxLockStats* pStats = NULL;
+
+    if (!name) name = unnamed[kind];
+
+    pthread_mutex_lock(&g_LockStatsMutex);
+    for (mfxU32 i = 0; !pStats && (i < g_LockStatsNum); ++i)
+    {
+        if ((kind == table[i].kind) && !strcmp(name, table[i].name)) pStats = &table[i];
+    }
+    if (!pStats && (g_LockStatsNum < MFX_OMX_LOCK_STATS_MAX))
+    {
+        pStats = &table[g_LockStatsNum++];
+        pStats->name = name;
+        pStats->kind = kind;
+    }
+    pthread_mutex_unlock(&g_LockStatsMutex);
+
+    if (pStats) ++pStats->instances;
+    return pStats;
+}
+
+/*------------------------------------------------------------------------------*/
+
+int mfx_omx_lock_stats_mutex_lock(pthread_mutex_t* mutex, MfxOmxLockStats* stats, mfxU64& lockTime)
+{
+    if (!stats) return pthread_mutex_lock(mutex);
+
+    // failed try means somebody holds the mutex
+    if (pthread_mutex_trylock(mutex))
+    {
+        mfxU64 start = mfx_omx_lock_stats_time();
+        int res = pthread_mutex_lock(mutex);
+
+        if (res) return res;
+        lockTime = mfx_omx_lock_stats_time();
+        ++stats->contended;
+        stats->waitTime.Record(lockTime - start);
+    }
+    else lockTime = mfx_omx_lock_stats_time();
+    ++stats->acquisitions;
+    return 0;
+}
+
+/*------------------------------------------------------------------------------*/
+
+int mfx_omx_lock_stats_mutex_trylock(pthread_mutex_t* mutex, MfxOmxLockStats* stats, mfxU64& lockTime)
+{
+    int res = pthread_mutex_trylock(mutex);
+
+    if (!res && stats)
+    {
+        lockTime = mfx_omx_lock_stats_time();
+        ++stats->acquisitions;
+    }
+    return res;
+}
+
+/*------------------------------------------------------------------------------*/
+
+int mfx_omx_lock_stats_mutex_unlock(pthread_mutex_t* mutex, MfxOmxLockStats* stats, mfxU64 lockTime)
+{
+    // lock time is read while the mutex is still held
+    if (stats) stats->holdTime.Record(mfx_omx_lock_stats_time() - lockTime);
+    return pthread_mutex_unlock(mutex);
+}
+
+/*------------------------------------------------------------------------------*/
+
+static void mfx_omx_lock_stats_print(FILE* file, const char* module, const MfxOmxLockStats& s)
+{
+    static const char* kinds[MFX_OMX_LOCK_KIND_NUM] = { "mutex", "event", "semaphore" };
+    char line[512];
+    mfxU64 acquisitions = s.acquisitions.load(std::memory_order_relaxed);
+    mfxU64 contended = s.contended.load(std::memory_order_relaxed);
+    int size = 0;
+
+    size = snprintf(line, sizeof(line),
+                    "%s %s \"%s\": instances %u, acquisitions %llu, contended %llu (%.2f%%)",
+                    module, kinds[s.kind], s.name, s.instances.load(std::memory_order_relaxed),
+                    (unsigned long long)acquisitions, (unsigned long long)contended,
+                    acquisitions ? 100.0 * contended / acquisitions : 0.0);
+    if (s.waitTime.GetCount() && (size > 0) && (size < (int)sizeof(line)))
+    {
+        size += snprintf(line + size, sizeof(line) - size,
+                         ", wait ns: mean %llu, p50 %llu, p90 %llu, p99 %llu, max %llu",
+                         (unsigned long long)s.waitTime.GetMean(), (unsigned long long)s.waitTime.GetPercentile(50),
+                         (unsigned long long)s.waitTime.GetPercentile(90), (unsigned long long)s.waitTime.GetPercentile(99),
+                         (unsigned long long)s.waitTime.GetMax());
+    }
+    if (s.holdTime.GetCount() && (size > 0) && (size < (int)sizeof(line)))
+    {
+        snprintf(line + size, sizeof(line) - size,
+                 ", hold ns: mean %llu, p50 %llu, p90 %llu, p99 %llu, max %llu",
+                 (unsigned long long)s.holdTime.GetMean(), (unsigned long long)s.holdTime.GetPercentile(50),
+                 (unsigned long long)s.holdTime.GetPercentile(90), (unsigned long long)s.holdTime.GetPercentile(99),
+                 (unsigned long long)s.holdTime.GetMax());
+    }
+    MFX_OMX_LOG_INFO("%s", line);
+    if (file) fprintf(file, "%s\n", line);
+}
+
+/*------------------------------------------------------------------------------*/
+
+void mfx_omx_lock_stats_dump(const char* module)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    MfxOmxLockStats* table = mfx_omx_lock_stats_table();
+    char dir[PROPERTY_VALUE_MAX];
+    FILE* file = NULL;
+    mfxU32 num = 0;
+
+    if (!module) module = "unknown";
+    // statistics are cumulative, so each dump replaces the previous one
+    if (property_get(MFX_OMX_LOCK_STATS_DIR_PROPERTY, dir, NULL) > 0)
+    {
+        char filename[MFX_OMX_MAX_PATH];
+
+        snprintf(filename, sizeof(filename), "%s/lock_stats_%d_%s.txt", dir, getpid(), module);
+        file = fopen(filename, "w");
+        if (!file) MFX_OMX_LOG_ERROR("failed to open %s", filename);
+    }
+
+    pthread_mutex_lock(&g_LockStatsMutex);
+    num = g_LockStatsNum;
+    pthread_mutex_unlock(&g_LockStatsMutex);
+
+    for (mfxU32 i = 0; i < num; ++i)
+    {
+        if (table[i].acquisitions.load(std::memory_order_relaxed))
+        {
+            mfx_omx_lock_stats_print(file, module, table[i]);
+        }
+    }
+    if (num == MFX_OMX_LOCK_STATS_MAX)
+    {
+        MFX_OMX_LOG_INFO("%s: lock statistics table is full, some locks were not tracked", module);
+    }
+    if (file) fclose(file);
+}
+
+#endif // #if MFX_OMX_LOCK_STATS == MFX_OMX_YES
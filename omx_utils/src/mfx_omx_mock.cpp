@@ -0,0 +1,924 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/********************************************************************************
+
+Media SDK stand-ins for running components without GPU.
+
+Mocks do not process pixels or parse bitstreams: decoder consumes all data
+given to DecodeFrameAsync and outputs the work surface, encoder writes NAL
+start code and header followed by filler of the target frame size, VPP
+copies frame attributes. Every submission becomes a task on the session
+which completes after a latency drawn from the configured distribution.
+Surfaces stay locked until their task completes, so surface pools see the
+same back pressure as with real hardware.
+
+*********************************************************************************/
+
+#include "mfx_omx_mock.h"
+
+#if MFX_OMX_MOCK_BACKEND == MFX_OMX_YES
+
+#include <algorithm>
+#include <thread>
+#include <stdint.h>
+#include <cutils/properties.h>
+
+/*------------------------------------------------------------------------------*/
+
+#undef MFX_OMX_MODULE_NAME
+#define MFX_OMX_MODULE_NAME "mfx_omx_mock"
+
+/*------------------------------------------------------------------------------*/
+
+#define MFX_OMX_MOCK_DEFAULT_LATENCY 2000 // us
+#define MFX_OMX_MOCK_DEFAULT_FRAME_SIZE 8192 // bytes
+#define MFX_OMX_MOCK_MIN_FRAME_SIZE 16
+
+/*------------------------------------------------------------------------------*/
+
+static mfxU32 mfx_omx_mock_get_property(const char* name, mfxU32 def)
+{
+    char value[PROPERTY_VALUE_MAX];
+
+    if (property_get(name, value, NULL) > 0) return (mfxU32)strtoul(value, NULL, 0);
+    return def;
+}
+
+/*------------------------------------------------------------------------------*/
+
+static MfxOmxMockConfig mfx_omx_mock_load_config(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    MfxOmxMockConfig config;
+    char value[PROPERTY_VALUE_MAX];
+    unsigned int width = 1920, height = 1080;
+
+    config.latency = mfx_omx_mock_get_property("OMX.Intel.mock.latency", MFX_OMX_MOCK_DEFAULT_LATENCY);
+    config.jitter = mfx_omx_mock_get_property("OMX.Intel.mock.jitter", 0);
+    config.distribution = mfx_omx_mock_get_property("OMX.Intel.mock.distribution", MFX_OMX_MOCK_LATENCY_FIXED);
+    config.bOutOfOrder = (0 != mfx_omx_mock_get_property("OMX.Intel.mock.order", 0));
+    config.busyPercent = mfx_omx_mock_get_property("OMX.Intel.mock.busy", 0);
+    if (config.busyPercent > 100) config.busyPercent = 100;
+    config.incompatiblePeriod = mfx_omx_mock_get_property("OMX.Intel.mock.incompatible", 0);
+    config.seed = mfx_omx_mock_get_property("OMX.Intel.mock.seed", 1);
+    config.frameSize = mfx_omx_mock_get_property("OMX.Intel.mock.framesize", MFX_OMX_MOCK_DEFAULT_FRAME_SIZE);
+
+    if (property_get("OMX.Intel.mock.resolution", value, NULL) > 0)
+    {
+        if ((2 != sscanf(value, "%ux%u", &width, &height)) || !width || !height || (width > 8192) || (height > 8192))
+        {
+            MFX_OMX_LOG_ERROR("Invalid mock resolution '%s', using 1920x1080", value);
+            width = 1920;
+            height = 1080;
+        }
+    }
+    config.width = (mfxU16)width;
+    config.height = (mfxU16)height;
+
+    MFX_OMX_LOG_INFO("Mock backend: latency %u us, jitter %u us, distribution %u, out of order %d, busy %u%%, incompatible period %u, seed %u, %ux%u",
+                     config.latency, config.jitter, config.distribution, config.bOutOfOrder,
+                     config.busyPercent, config.incompatiblePeriod, config.seed, width, height);
+    return config;
+}
+
+/*------------------------------------------------------------------------------*/
+
+const MfxOmxMockConfig& mfx_omx_mock_get_config(void)
+{
+    static const MfxOmxMockConfig config = mfx_omx_mock_load_config();
+    return config;
+}
+
+/*------------------------------------------------------------------------------*/
+
+static void mfx_omx_mock_copy_params(mfxVideoParam* pDst, const mfxVideoParam* pSrc)
+{
+    // extended buffers belong to the caller, so they are not copied
+    pDst->AsyncDepth = pSrc->AsyncDepth;
+    pDst->mfx = pSrc->mfx;
+    pDst->IOPattern = pSrc->IOPattern;
+    pDst->Protected = pSrc->Protected;
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxMockSession::MfxOmxMockSession(void):
+    m_Config(mfx_omx_mock_get_config()),
+    m_Implementation(MFX_IMPL_HARDWARE),
+    m_pAllocator(NULL),
+    m_Handle(NULL),
+    m_Random(m_Config.seed),
+    m_nNextTaskId(1)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    MFX_OMX_ZERO_MEMORY(m_Version);
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxMockSession::~MfxOmxMockSession(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    Close();
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockSession::Init(mfxIMPL impl, mfxVersion *ver)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    MFX_OMX_UNUSED(impl);
+
+    if (ver) m_Version = *ver;
+    m_LastReady = std::chrono::steady_clock::now();
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockSession::Close(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    for (std::map<mfxU64, Task>::iterator it = m_Tasks.begin(); it != m_Tasks.end(); ++it)
+    {
+        CompleteTask(it->second);
+    }
+    m_Tasks.clear();
+    m_pAllocator = NULL;
+    m_Handle = NULL;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockSession::QueryIMPL(mfxIMPL *impl)
+{
+    if (!impl) return MFX_ERR_NULL_PTR;
+    // components treat hardware session as a need for device, which is mocked too
+    *impl = m_Implementation;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockSession::QueryVersion(mfxVersion *version)
+{
+    if (!version) return MFX_ERR_NULL_PTR;
+    *version = m_Version;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockSession::SetFrameAllocator(mfxFrameAllocator *allocator)
+{
+    m_pAllocator = allocator;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockSession::SetHandle(mfxHandleType type, mfxHDL hdl)
+{
+    MFX_OMX_UNUSED(type);
+    m_Handle = hdl;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockSession::GetHandle(mfxHandleType type, mfxHDL *hdl)
+{
+    MFX_OMX_UNUSED(type);
+    if (!hdl) return MFX_ERR_NULL_PTR;
+    if (!m_Handle) return MFX_ERR_NOT_FOUND;
+    *hdl = m_Handle;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+bool MfxOmxMockSession::IsDeviceBusy(void)
+{
+    if (!m_Config.busyPercent) return false;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return (m_Random() % 100) < m_Config.busyPercent;
+}
+
+/*------------------------------------------------------------------------------*/
+
+std::chrono::microseconds MfxOmxMockSession::SampleLatency(void)
+{
+    mfxU32 latency = m_Config.latency;
+
+    switch (m_Config.distribution)
+    {
+    case MFX_OMX_MOCK_LATENCY_UNIFORM:
+        {
+            mfxU32 jitter = MFX_OMX_MIN(m_Config.jitter, m_Config.latency);
+            std::uniform_int_distribution<mfxU32> distribution(m_Config.latency - jitter, m_Config.latency + jitter);
+            latency = distribution(m_Random);
+        }
+        break;
+    case MFX_OMX_MOCK_LATENCY_EXPONENTIAL:
+        {
+            mfxU32 offset = MFX_OMX_MIN(m_Config.jitter, m_Config.latency);
+            latency = offset;
+            if (m_Config.latency > offset)
+            {
+                std::exponential_distribution<double> distribution(1.0 / (m_Config.latency - offset));
+                latency += (mfxU32)distribution(m_Random);
+            }
+        }
+        break;
+    default:
+        break;
+    }
+    return std::chrono::microseconds(latency);
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxSyncPoint MfxOmxMockSession::Submit(mfxStatus sts, mfxFrameSurface1* pSurface1, mfxFrameSurface1* pSurface2)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    Task task;
+
+    CompleteReadyTasks(now);
+
+    task.ready = now + SampleLatency();
+    if (!m_Config.bOutOfOrder)
+    {
+        // task can not complete before the previous one
+        if (task.ready < m_LastReady) task.ready = m_LastReady;
+        m_LastReady = task.ready;
+    }
+    task.status = sts;
+    task.pSurfaces[0] = pSurface1;
+    task.pSurfaces[1] = pSurface2;
+    task.bDone = false;
+
+    for (mfxU32 i = 0; i < MFX_OMX_GET_ARRAY_SIZE(task.pSurfaces); ++i)
+    {
+        if (task.pSurfaces[i]) ++task.pSurfaces[i]->Data.Locked;
+    }
+
+    mfxU64 id = m_nNextTaskId++;
+    m_Tasks[id] = task;
+
+    MFX_OMX_AUTO_TRACE_I64(id);
+    return reinterpret_cast<mfxSyncPoint>(static_cast<uintptr_t>(id));
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxMockSession::CompleteTask(Task& task)
+{
+    if (task.bDone) return;
+
+    for (mfxU32 i = 0; i < MFX_OMX_GET_ARRAY_SIZE(task.pSurfaces); ++i)
+    {
+        if (task.pSurfaces[i] && task.pSurfaces[i]->Data.Locked) --task.pSurfaces[i]->Data.Locked;
+        task.pSurfaces[i] = NULL;
+    }
+    task.bDone = true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxMockSession::CompleteReadyTasks(std::chrono::steady_clock::time_point now)
+{
+    for (std::map<mfxU64, Task>::iterator it = m_Tasks.begin(); it != m_Tasks.end(); ++it)
+    {
+        if (it->second.ready <= now) CompleteTask(it->second);
+    }
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockSession::SyncOperation(mfxSyncPoint syncp, mfxU32 wait)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    if (!syncp) return MFX_ERR_NULL_PTR;
+
+    mfxU64 id = static_cast<mfxU64>(reinterpret_cast<uintptr_t>(syncp));
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    std::map<mfxU64, Task>::iterator it = m_Tasks.find(id);
+
+    // synchronized already, components may sync one point several times on device busy
+    if (m_Tasks.end() == it) return MFX_ERR_NONE;
+
+    std::chrono::steady_clock::time_point ready = it->second.ready;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    if ((wait < MFX_OMX_INFINITE) && (now + std::chrono::milliseconds(wait) < ready))
+    {
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+        return MFX_WRN_IN_EXECUTION;
+    }
+
+    lock.unlock();
+    std::this_thread::sleep_until(ready);
+    lock.lock();
+
+    CompleteReadyTasks(std::chrono::steady_clock::now());
+
+    mfxStatus sts = MFX_ERR_NONE;
+    it = m_Tasks.find(id);
+    if (m_Tasks.end() != it)
+    {
+        sts = it->second.status;
+        m_Tasks.erase(it);
+    }
+    MFX_OMX_AUTO_TRACE_I32(sts);
+    return sts;
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxMockDecode::MfxOmxMockDecode(MfxOmxMockSession& session):
+    MFXVideoDECODE((mfxSession)NULL),
+    m_MockSession(session),
+    m_bInitialized(false),
+    m_bIncompatibleReported(false),
+    m_nFrames(0)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    MFX_OMX_ZERO_MEMORY(m_Params);
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxMockDecode::~MfxOmxMockDecode(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    Close();
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockDecode::Query(mfxVideoParam *in, mfxVideoParam *out)
+{
+    if (!out) return MFX_ERR_NULL_PTR;
+    if (in) mfx_omx_mock_copy_params(out, in);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockDecode::DecodeHeader(mfxBitstream *bs, mfxVideoParam *par)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    if (!bs || !par) return MFX_ERR_NULL_PTR;
+    if (!bs->DataLength) return MFX_ERR_MORE_DATA;
+
+    const MfxOmxMockConfig& config = mfx_omx_mock_get_config();
+    mfxFrameInfo& info = par->mfx.FrameInfo;
+
+    MFX_OMX_ZERO_MEMORY(info);
+    info.FourCC = MFX_FOURCC_NV12;
+    info.ChromaFormat = MFX_CHROMAFORMAT_YUV420;
+    info.Width = (mfxU16)(MFX_OMX_MEM_ALIGN(config.width, 16));
+    info.Height = (mfxU16)(MFX_OMX_MEM_ALIGN(config.height, 16));
+    info.CropW = config.width;
+    info.CropH = config.height;
+    info.FrameRateExtN = 30;
+    info.FrameRateExtD = 1;
+    info.AspectRatioW = 1;
+    info.AspectRatioH = 1;
+    info.PicStruct = MFX_PICSTRUCT_PROGRESSIVE;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockDecode::QueryIOSurf(mfxVideoParam *par, mfxFrameAllocRequest *request)
+{
+    if (!par || !request) return MFX_ERR_NULL_PTR;
+
+    MFX_OMX_ZERO_MEMORY(*request);
+    request->Info = par->mfx.FrameInfo;
+    request->NumFrameMin = request->NumFrameSuggested = (mfxU16)(4 + par->AsyncDepth);
+    request->Type = MFX_MEMTYPE_FROM_DECODE |
+        ((par->IOPattern & MFX_IOPATTERN_OUT_VIDEO_MEMORY) ?
+            MFX_MEMTYPE_VIDEO_MEMORY_DECODER_TARGET : MFX_MEMTYPE_SYSTEM_MEMORY);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockDecode::Init(mfxVideoParam *par)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    if (!par) return MFX_ERR_NULL_PTR;
+    if (m_bInitialized) return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    mfx_omx_mock_copy_params(&m_Params, par);
+    m_bInitialized = true;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockDecode::Reset(mfxVideoParam *par)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    if (!par) return MFX_ERR_NULL_PTR;
+    if (!m_bInitialized) return MFX_ERR_NOT_INITIALIZED;
+
+    mfx_omx_mock_copy_params(&m_Params, par);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockDecode::Close(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    if (!m_bInitialized) return MFX_ERR_NOT_INITIALIZED;
+
+    m_bInitialized = false;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockDecode::GetVideoParam(mfxVideoParam *par)
+{
+    if (!par) return MFX_ERR_NULL_PTR;
+    if (!m_bInitialized) return MFX_ERR_NOT_INITIALIZED;
+
+    mfx_omx_mock_copy_params(par, &m_Params);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockDecode::GetDecodeStat(mfxDecodeStat *stat)
+{
+    if (!stat) return MFX_ERR_NULL_PTR;
+
+    MFX_OMX_ZERO_MEMORY(*stat);
+    stat->NumFrame = m_nFrames;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockDecode::GetPayload(mfxU64 *ts, mfxPayload *payload)
+{
+    if (!ts || !payload) return MFX_ERR_NULL_PTR;
+
+    // no SEI in mocked streams
+    payload->NumBit = 0;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockDecode::SetSkipMode(mfxSkipMode mode)
+{
+    MFX_OMX_UNUSED(mode);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockDecode::DecodeFrameAsync(mfxBitstream *bs, mfxFrameSurface1 *surface_work, mfxFrameSurface1 **surface_out, mfxSyncPoint *syncp)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    const MfxOmxMockConfig& config = mfx_omx_mock_get_config();
+
+    if (!surface_out || !syncp) return MFX_ERR_NULL_PTR;
+    if (!m_bInitialized) return MFX_ERR_NOT_INITIALIZED;
+
+    *surface_out = NULL;
+    *syncp = NULL;
+
+    // frames are not buffered, so there is nothing to drain
+    if (!bs || !bs->DataLength) return MFX_ERR_MORE_DATA;
+    if (!surface_work || surface_work->Data.Locked) return MFX_ERR_MORE_SURFACE;
+    if (m_MockSession.IsDeviceBusy()) return MFX_WRN_DEVICE_BUSY;
+
+    if (config.incompatiblePeriod && m_nFrames && !(m_nFrames % config.incompatiblePeriod) && !m_bIncompatibleReported)
+    {
+        m_bIncompatibleReported = true;
+        return MFX_ERR_INCOMPATIBLE_VIDEO_PARAM;
+    }
+    m_bIncompatibleReported = false;
+
+    bs->DataOffset += bs->DataLength;
+    bs->DataLength = 0;
+
+    surface_work->Info.CropX = m_Params.mfx.FrameInfo.CropX;
+    surface_work->Info.CropY = m_Params.mfx.FrameInfo.CropY;
+    surface_work->Info.CropW = m_Params.mfx.FrameInfo.CropW;
+    surface_work->Info.CropH = m_Params.mfx.FrameInfo.CropH;
+    surface_work->Info.PicStruct = MFX_PICSTRUCT_PROGRESSIVE;
+    surface_work->Data.TimeStamp = bs->TimeStamp;
+    surface_work->Data.FrameOrder = m_nFrames++;
+    surface_work->Data.Corrupted = 0;
+
+    *surface_out = surface_work;
+    *syncp = m_MockSession.Submit(MFX_ERR_NONE, surface_work);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxMockEncode::MfxOmxMockEncode(MfxOmxMockSession& session):
+    MFXVideoENCODE((mfxSession)NULL),
+    m_MockSession(session),
+    m_bInitialized(false),
+    m_nFrames(0),
+    m_nResets(0),
+    m_nBytes(0)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    MFX_OMX_ZERO_MEMORY(m_Params);
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxMockEncode::~MfxOmxMockEncode(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    Close();
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockEncode::Query(mfxVideoParam *in, mfxVideoParam *out)
+{
+    if (!out) return MFX_ERR_NULL_PTR;
+    if (in) mfx_omx_mock_copy_params(out, in);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockEncode::QueryIOSurf(mfxVideoParam *par, mfxFrameAllocRequest *request)
+{
+    if (!par || !request) return MFX_ERR_NULL_PTR;
+
+    MFX_OMX_ZERO_MEMORY(*request);
+    request->Info = par->mfx.FrameInfo;
+    request->NumFrameMin = request->NumFrameSuggested = (mfxU16)(1 + par->AsyncDepth);
+    request->Type = MFX_MEMTYPE_FROM_ENCODE | MFX_MEMTYPE_EXTERNAL_FRAME |
+        ((par->IOPattern & MFX_IOPATTERN_IN_VIDEO_MEMORY) ?
+            MFX_MEMTYPE_VIDEO_MEMORY_DECODER_TARGET : MFX_MEMTYPE_SYSTEM_MEMORY);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxU32 MfxOmxMockEncode::GetFrameSize(void)
+{
+    const mfxInfoMFX& mfx = m_Params.mfx;
+    mfxU32 size = mfx_omx_mock_get_config().frameSize;
+
+    if ((MFX_RATECONTROL_CQP != mfx.RateControlMethod) && mfx.TargetKbps &&
+        mfx.FrameInfo.FrameRateExtN && mfx.FrameInfo.FrameRateExtD)
+    {
+        mfxU64 bitrate = (mfxU64)mfx.TargetKbps * MFX_OMX_MAX(mfx.BRCParamMultiplier, 1) * 1000;
+        size = (mfxU32)(bitrate * mfx.FrameInfo.FrameRateExtD / mfx.FrameInfo.FrameRateExtN / 8);
+    }
+    return MFX_OMX_MAX(size, MFX_OMX_MOCK_MIN_FRAME_SIZE);
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockEncode::Init(mfxVideoParam *par)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    if (!par) return MFX_ERR_NULL_PTR;
+    if (m_bInitialized) return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    mfx_omx_mock_copy_params(&m_Params, par);
+    if (!m_Params.mfx.BufferSizeInKB)
+    {
+        // twice the average frame leaves room for key frames
+        mfxU32 multiplier = MFX_OMX_MAX(m_Params.mfx.BRCParamMultiplier, 1);
+        mfxU32 sizeInKB = (2 * GetFrameSize() + 999) / 1000;
+        m_Params.mfx.BufferSizeInKB = (mfxU16)MFX_OMX_MIN((sizeInKB + multiplier - 1) / multiplier, 0xFFFF);
+    }
+    m_nFrames = 0;
+    m_bInitialized = true;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockEncode::Reset(mfxVideoParam *par)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    const MfxOmxMockConfig& config = mfx_omx_mock_get_config();
+
+    if (!par) return MFX_ERR_NULL_PTR;
+    if (!m_bInitialized) return MFX_ERR_NOT_INITIALIZED;
+
+    ++m_nResets;
+    if (config.incompatiblePeriod && !(m_nResets % config.incompatiblePeriod))
+        return MFX_ERR_INCOMPATIBLE_VIDEO_PARAM;
+
+    mfxU16 bufferSize = m_Params.mfx.BufferSizeInKB;
+    mfx_omx_mock_copy_params(&m_Params, par);
+    if (!m_Params.mfx.BufferSizeInKB) m_Params.mfx.BufferSizeInKB = bufferSize;
+    m_nFrames = 0;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockEncode::Close(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    if (!m_bInitialized) return MFX_ERR_NOT_INITIALIZED;
+
+    m_bInitialized = false;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+static mfxStatus mfx_omx_mock_write_nal(mfxU8* pBuf, mfxU16* pBufSize, const mfxU8* pNal, mfxU16 size)
+{
+    if (!pBuf || !pBufSize) return MFX_ERR_NULL_PTR;
+    if (*pBufSize < size) return MFX_ERR_NOT_ENOUGH_BUFFER;
+
+    std::copy(pNal, pNal + size, pBuf);
+    *pBufSize = size;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockEncode::WriteHeaders(mfxExtBuffer* pExtBuf)
+{
+    static const mfxU8 avc_sps[]  = { 0, 0, 0, 1, 0x67, 0x64, 0x00, 0x28, 0xAC, 0x2B, 0x40, 0x3C, 0x01, 0x13, 0xF2, 0xC0, 0x3C, 0x48, 0x9A, 0x80 };
+    static const mfxU8 avc_pps[]  = { 0, 0, 0, 1, 0x68, 0xEE, 0x3C, 0xB0 };
+    static const mfxU8 hevc_vps[] = { 0, 0, 0, 1, 0x40, 0x01, 0x0C, 0x01, 0xFF, 0xFF, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x78, 0x95, 0x98, 0x09 };
+    static const mfxU8 hevc_sps[] = { 0, 0, 0, 1, 0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x78, 0xA0, 0x03, 0xC0, 0x80, 0x10, 0xE5, 0x96, 0x56, 0x69, 0x24, 0xCA, 0xE0 };
+    static const mfxU8 hevc_pps[] = { 0, 0, 0, 1, 0x44, 0x01, 0xC1, 0x72, 0xB4, 0x62, 0x40 };
+    bool bHevc = (MFX_CODEC_HEVC == m_Params.mfx.CodecId);
+    mfxStatus mfx_res = MFX_ERR_NONE;
+
+    if (MFX_EXTBUFF_CODING_OPTION_SPSPPS == pExtBuf->BufferId)
+    {
+        mfxExtCodingOptionSPSPPS* pSpsPps = (mfxExtCodingOptionSPSPPS*)pExtBuf;
+
+        mfx_res = mfx_omx_mock_write_nal(pSpsPps->SPSBuffer, &pSpsPps->SPSBufSize,
+                                         bHevc ? hevc_sps : avc_sps,
+                                         bHevc ? sizeof(hevc_sps) : sizeof(avc_sps));
+        if (MFX_ERR_NONE == mfx_res)
+            mfx_res = mfx_omx_mock_write_nal(pSpsPps->PPSBuffer, &pSpsPps->PPSBufSize,
+                                             bHevc ? hevc_pps : avc_pps,
+                                             bHevc ? sizeof(hevc_pps) : sizeof(avc_pps));
+    }
+    else if (MFX_EXTBUFF_CODING_OPTION_VPS == pExtBuf->BufferId)
+    {
+        mfxExtCodingOptionVPS* pVps = (mfxExtCodingOptionVPS*)pExtBuf;
+
+        if (bHevc) mfx_res = mfx_omx_mock_write_nal(pVps->VPSBuffer, &pVps->VPSBufSize, hevc_vps, sizeof(hevc_vps));
+        else mfx_res = MFX_ERR_UNSUPPORTED;
+    }
+    return mfx_res;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockEncode::GetVideoParam(mfxVideoParam *par)
+{
+    mfxStatus mfx_res = MFX_ERR_NONE;
+
+    if (!par) return MFX_ERR_NULL_PTR;
+    if (!m_bInitialized) return MFX_ERR_NOT_INITIALIZED;
+
+    mfx_omx_mock_copy_params(par, &m_Params);
+    for (mfxU32 i = 0; (MFX_ERR_NONE == mfx_res) && par->ExtParam && (i < par->NumExtParam); ++i)
+    {
+        if (par->ExtParam[i]) mfx_res = WriteHeaders(par->ExtParam[i]);
+    }
+    return mfx_res;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockEncode::GetEncodeStat(mfxEncodeStat *stat)
+{
+    if (!stat) return MFX_ERR_NULL_PTR;
+
+    MFX_OMX_ZERO_MEMORY(*stat);
+    stat->NumFrame = m_nFrames;
+    stat->NumBit = m_nBytes * 8;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockEncode::EncodeFrameAsync(mfxEncodeCtrl *ctrl, mfxFrameSurface1 *surface, mfxBitstream *bs, mfxSyncPoint *syncp)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    if (!bs || !syncp) return MFX_ERR_NULL_PTR;
+    if (!m_bInitialized) return MFX_ERR_NOT_INITIALIZED;
+
+    *syncp = NULL;
+
+    // frames are not buffered, so there is nothing to drain
+    if (!surface) return MFX_ERR_MORE_DATA;
+
+    mfxU32 size = GetFrameSize();
+    if (!bs->Data || (bs->MaxLength < bs->DataOffset + bs->DataLength + size)) return MFX_ERR_NOT_ENOUGH_BUFFER;
+    if (m_MockSession.IsDeviceBusy()) return MFX_WRN_DEVICE_BUSY;
+
+    mfxU16 gop = m_Params.mfx.GopPicSize;
+    bool bIdr = !m_nFrames || (gop && !(m_nFrames % gop)) ||
+                (ctrl && (ctrl->FrameType & MFX_FRAMETYPE_IDR));
+    bool bHevc = (MFX_CODEC_HEVC == m_Params.mfx.CodecId);
+    mfxU8* pData = bs->Data + bs->DataOffset + bs->DataLength;
+    mfxU32 pos = 0;
+
+    pData[pos++] = 0;
+    pData[pos++] = 0;
+    pData[pos++] = 0;
+    pData[pos++] = 1;
+    if (bHevc)
+    {
+        pData[pos++] = bIdr ? 0x26 : 0x02; // IDR_W_RADL : TRAIL_R
+        pData[pos++] = 0x01;
+    }
+    else pData[pos++] = bIdr ? 0x65 : 0x41;
+    // filler which can't emulate start code
+    memset(pData + pos, 0xFF, size - pos);
+
+    bs->DataLength += size;
+    bs->TimeStamp = surface->Data.TimeStamp;
+    bs->DecodeTimeStamp = surface->Data.TimeStamp;
+    bs->FrameType = bIdr ? (MFX_FRAMETYPE_IDR | MFX_FRAMETYPE_I | MFX_FRAMETYPE_REF) :
+                           (MFX_FRAMETYPE_P | MFX_FRAMETYPE_REF);
+    bs->PicStruct = MFX_PICSTRUCT_PROGRESSIVE;
+
+    ++m_nFrames;
+    m_nBytes += size;
+
+    *syncp = m_MockSession.Submit(MFX_ERR_NONE, surface);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxMockVPP::MfxOmxMockVPP(MfxOmxMockSession& session):
+    MFXVideoVPP((mfxSession)NULL),
+    m_MockSession(session),
+    m_bInitialized(false),
+    m_nFrames(0)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    MFX_OMX_ZERO_MEMORY(m_Params);
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxMockVPP::~MfxOmxMockVPP(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    Close();
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockVPP::Query(mfxVideoParam *in, mfxVideoParam *out)
+{
+    if (!out) return MFX_ERR_NULL_PTR;
+    if (in) mfx_omx_mock_copy_params(out, in);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockVPP::QueryIOSurf(mfxVideoParam *par, mfxFrameAllocRequest request[2])
+{
+    if (!par || !request) return MFX_ERR_NULL_PTR;
+
+    MFX_OMX_ZERO_MEMORY(request[0]);
+    MFX_OMX_ZERO_MEMORY(request[1]);
+    request[0].Info = par->vpp.In;
+    request[1].Info = par->vpp.Out;
+    request[0].NumFrameMin = request[0].NumFrameSuggested = (mfxU16)(1 + par->AsyncDepth);
+    request[1].NumFrameMin = request[1].NumFrameSuggested = (mfxU16)(1 + par->AsyncDepth);
+    request[0].Type = MFX_MEMTYPE_FROM_VPPIN | MFX_MEMTYPE_EXTERNAL_FRAME |
+        ((par->IOPattern & MFX_IOPATTERN_IN_VIDEO_MEMORY) ?
+            MFX_MEMTYPE_VIDEO_MEMORY_PROCESSOR_TARGET : MFX_MEMTYPE_SYSTEM_MEMORY);
+    request[1].Type = MFX_MEMTYPE_FROM_VPPOUT | MFX_MEMTYPE_EXTERNAL_FRAME |
+        ((par->IOPattern & MFX_IOPATTERN_OUT_VIDEO_MEMORY) ?
+            MFX_MEMTYPE_VIDEO_MEMORY_PROCESSOR_TARGET : MFX_MEMTYPE_SYSTEM_MEMORY);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockVPP::Init(mfxVideoParam *par)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    if (!par) return MFX_ERR_NULL_PTR;
+    if (m_bInitialized) return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    mfx_omx_mock_copy_params(&m_Params, par);
+    m_bInitialized = true;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockVPP::Reset(mfxVideoParam *par)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    if (!par) return MFX_ERR_NULL_PTR;
+    if (!m_bInitialized) return MFX_ERR_NOT_INITIALIZED;
+
+    mfx_omx_mock_copy_params(&m_Params, par);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockVPP::Close(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    if (!m_bInitialized) return MFX_ERR_NOT_INITIALIZED;
+
+    m_bInitialized = false;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockVPP::GetVideoParam(mfxVideoParam *par)
+{
+    if (!par) return MFX_ERR_NULL_PTR;
+    if (!m_bInitialized) return MFX_ERR_NOT_INITIALIZED;
+
+    mfx_omx_mock_copy_params(par, &m_Params);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockVPP::GetVPPStat(mfxVPPStat *stat)
+{
+    if (!stat) return MFX_ERR_NULL_PTR;
+
+    MFX_OMX_ZERO_MEMORY(*stat);
+    stat->NumFrame = m_nFrames;
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus MfxOmxMockVPP::RunFrameVPPAsync(mfxFrameSurface1 *in, mfxFrameSurface1 *out, mfxExtVppAuxData *aux, mfxSyncPoint *syncp)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    MFX_OMX_UNUSED(aux);
+
+    if (!out || !syncp) return MFX_ERR_NULL_PTR;
+    if (!m_bInitialized) return MFX_ERR_NOT_INITIALIZED;
+
+    *syncp = NULL;
+
+    if (!in) return MFX_ERR_MORE_DATA;
+    if (m_MockSession.IsDeviceBusy()) return MFX_WRN_DEVICE_BUSY;
+
+    out->Data.TimeStamp = in->Data.TimeStamp;
+    out->Data.FrameOrder = in->Data.FrameOrder;
+    out->Info.PicStruct = in->Info.PicStruct;
+    ++m_nFrames;
+
+    *syncp = m_MockSession.Submit(MFX_ERR_NONE, in, out);
+    return MFX_ERR_NONE;
+}
+
+#endif // #if MFX_OMX_MOCK_BACKEND == MFX_OMX_YES
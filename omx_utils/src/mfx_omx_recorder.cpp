@@ -0,0 +1,252 @@
+// Copyright (c) 2011-2018 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <sys/time.h>
+#include <cutils/properties.h>
+
+#include "mfx_omx_recorder.h"
+#include "mfx_omx_dump_writer.h"
+
+/*------------------------------------------------------------------------------*/
+
+#undef MFX_OMX_MODULE_NAME
+#define MFX_OMX_MODULE_NAME "mfx_omx_recorder"
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxRecorder* MfxOmxRecorder::Create(const char* name)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+#if MFX_OMX_DEBUG_DUMP == MFX_OMX_YES
+    static std::atomic<mfxU32> s_nRecordings(0);
+    MfxOmxRecorder* pRecorder = NULL;
+    char dir[PROPERTY_VALUE_MAX];
+    char value[PROPERTY_VALUE_MAX];
+    char filename[MFX_OMX_MAX_PATH];
+    FILE* file = NULL;
+    bool bPayloads = true;
+
+    if (!name || (property_get(MFX_OMX_RECORD_DIR_PROPERTY, dir, NULL) <= 0)) return NULL;
+    if (property_get(MFX_OMX_RECORD_PAYLOADS_PROPERTY, value, NULL) > 0) bPayloads = (0 != atoi(value));
+
+    snprintf(filename, sizeof(filename), "%s/%s_%d_%u.omxrec",
+             dir, name, getpid(), s_nRecordings.fetch_add(1));
+    file = fopen(filename, "wb");
+    if (!file)
+    {
+        MFX_OMX_LOG_ERROR("failed to open %s for recording", filename);
+        return NULL;
+    }
+
+    MFX_OMX_NEW(pRecorder, MfxOmxRecorder(file, bPayloads));
+    if (!pRecorder)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    MfxOmxRecordFileHeader header;
+    struct timeval tv;
+
+    MFX_OMX_ZERO_MEMORY(header);
+    gettimeofday(&tv, NULL);
+    header.magic = MFX_OMX_RECORD_MAGIC;
+    header.version = MFX_OMX_RECORD_VERSION;
+    header.flags = bPayloads ? MFX_OMX_RECORD_FLAG_PAYLOADS : 0;
+    header.startTime = (mfxU64)tv.tv_sec * 1000000 + tv.tv_usec;
+    strncpy(header.component, name, sizeof(header.component) - 1);
+
+    if (!mfx_omx_get_dump_writer().Write(file, &header, sizeof(header)))
+    {
+        MFX_OMX_LOG_ERROR("failed to write header of %s", filename);
+        MFX_OMX_DELETE(pRecorder);
+        return NULL;
+    }
+    MFX_OMX_LOG_INFO("Recording session to %s", filename);
+    return pRecorder;
+#else
+    MFX_OMX_UNUSED(name);
+    return NULL;
+#endif
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxRecorder::MfxOmxRecorder(FILE* file, bool bPayloads):
+    m_pFile(file),
+    m_bPayloads(bPayloads),
+    m_nStartTime(mfx_omx_get_time_us()),
+    m_bStopped(false)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxRecorder::~MfxOmxRecorder(void)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+
+    Commit(Begin(MFX_OMX_RECORD_END, 0), OMX_ErrorNone);
+    mfx_omx_get_dump_writer().Close(m_pFile);
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxRecordHeader* MfxOmxRecorder::Begin(MfxOmxRecordType type, mfxU32 size)
+{
+    MfxOmxRecordHeader* pRecord = NULL;
+
+    if (m_bStopped.load(std::memory_order_relaxed)) return NULL;
+
+    size = MFX_OMX_RECORD_ALIGN(size);
+    pRecord = (MfxOmxRecordHeader*)mfx_omx_get_dump_writer().GetBuffer(sizeof(MfxOmxRecordHeader) + size);
+    if (!pRecord)
+    {
+        if (!m_bStopped.exchange(true))
+        {
+            MFX_OMX_LOG_ERROR("recording stopped: dump writer can't keep up");
+        }
+        return NULL;
+    }
+    memset(pRecord, 0, sizeof(MfxOmxRecordHeader) + size);
+    pRecord->type = type;
+    pRecord->size = size;
+    pRecord->time = mfx_omx_get_time_us() - m_nStartTime;
+    return pRecord;
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxRecorder::Commit(MfxOmxRecordHeader* pRecord, OMX_ERRORTYPE result)
+{
+    if (!pRecord) return;
+
+    pRecord->result = (uint32_t)result;
+    pRecord->duration = (uint32_t)(mfx_omx_get_time_us() - m_nStartTime - pRecord->time);
+    mfx_omx_get_dump_writer().Commit(m_pFile, (mfxU8*)pRecord, sizeof(MfxOmxRecordHeader) + pRecord->size);
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxRecordHeader* MfxOmxRecorder::BeginCommand(OMX_COMMANDTYPE cmd, OMX_U32 param)
+{
+    MfxOmxRecordHeader* pRecord = Begin(MFX_OMX_RECORD_SEND_COMMAND, sizeof(MfxOmxRecordCommand));
+
+    if (pRecord)
+    {
+        MfxOmxRecordCommand* pData = (MfxOmxRecordCommand*)(pRecord + 1);
+
+        pData->cmd = (uint32_t)cmd;
+        pData->param = param;
+    }
+    return pRecord;
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxRecordHeader* MfxOmxRecorder::BeginStruct(MfxOmxRecordType type, OMX_INDEXTYPE index, OMX_PTR pStructure)
+{
+    // all OMX structures start with nSize
+    mfxU32 size = pStructure ? MFX_OMX_MIN(*(OMX_U32*)pStructure, MFX_OMX_RECORD_MAX_STRUCT_SIZE) : 0;
+    MfxOmxRecordHeader* pRecord = Begin(type, sizeof(MfxOmxRecordStruct) + size);
+
+    if (pRecord)
+    {
+        MfxOmxRecordStruct* pData = (MfxOmxRecordStruct*)(pRecord + 1);
+
+        pData->index = (uint32_t)index;
+        pData->size = size;
+        if (size) memcpy(pData + 1, pStructure, size);
+    }
+    return pRecord;
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxRecordHeader* MfxOmxRecorder::BeginBuffer(MfxOmxRecordType type, OMX_U32 port, OMX_U32 size, OMX_BUFFERHEADERTYPE* pBuffer)
+{
+    MfxOmxRecordHeader* pRecord = Begin(type, sizeof(MfxOmxRecordBuffer));
+
+    if (pRecord)
+    {
+        MfxOmxRecordBuffer* pData = (MfxOmxRecordBuffer*)(pRecord + 1);
+
+        pData->id = (uint64_t)(uintptr_t)pBuffer;
+        pData->port = port;
+        pData->size = size;
+    }
+    return pRecord;
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxRecorder::SetBuffer(MfxOmxRecordHeader* pRecord, OMX_BUFFERHEADERTYPE* pBuffer)
+{
+    if (!pRecord) return;
+
+    ((MfxOmxRecordBuffer*)(pRecord + 1))->id = (uint64_t)(uintptr_t)pBuffer;
+}
+
+/*------------------------------------------------------------------------------*/
+
+MfxOmxRecordHeader* MfxOmxRecorder::BeginEmptyThisBuffer(OMX_BUFFERHEADERTYPE* pBuffer)
+{
+    mfxU32 payloadSize = 0;
+
+    if (m_bPayloads && pBuffer && pBuffer->pBuffer &&
+        (pBuffer->nOffset + pBuffer->nFilledLen <= pBuffer->nAllocLen))
+    {
+        payloadSize = pBuffer->nFilledLen;
+    }
+
+    MfxOmxRecordHeader* pRecord = Begin(MFX_OMX_RECORD_EMPTY_THIS_BUFFER, sizeof(MfxOmxRecordEmptyBuffer) + payloadSize);
+
+    if (pRecord && pBuffer)
+    {
+        MfxOmxRecordEmptyBuffer* pData = (MfxOmxRecordEmptyBuffer*)(pRecord + 1);
+
+        pData->id = (uint64_t)(uintptr_t)pBuffer;
+        pData->timeStamp = pBuffer->nTimeStamp;
+        pData->flags = pBuffer->nFlags;
+        pData->filledLen = pBuffer->nFilledLen;
+        pData->payloadSize = payloadSize;
+        if (payloadSize) memcpy(pData + 1, pBuffer->pBuffer + pBuffer->nOffset, payloadSize);
+    }
+    return pRecord;
+}
+
+/*------------------------------------------------------------------------------*/
+
+void MfxOmxRecorder::RecordExtensionIndex(OMX_STRING name, OMX_INDEXTYPE index, OMX_ERRORTYPE result)
+{
+    mfxU32 length = name ? strnlen(name, MFX_OMX_RECORD_NAME_SIZE) : 0;
+    MfxOmxRecordHeader* pRecord = Begin(MFX_OMX_RECORD_GET_EXTENSION_INDEX, sizeof(MfxOmxRecordExtensionIndex) + length);
+
+    if (pRecord)
+    {
+        MfxOmxRecordExtensionIndex* pData = (MfxOmxRecordExtensionIndex*)(pRecord + 1);
+
+        pData->index = (uint32_t)index;
+        pData->length = length;
+        if (length) memcpy(pData + 1, name, length);
+    }
+    Commit(pRecord, result);
+}
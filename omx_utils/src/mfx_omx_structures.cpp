@@ -349,11 +349,7 @@ mfxU16 omx2mfx_brc(OMX_VIDEO_CONTROLRATETYPE omx_brc)
 
 MfxOmxEncodeCtrlWrapper* CreateEncodeCtrlWrapper()
 {
-    MfxOmxEncodeCtrlWrapper* wrap = NULL;
-
-    MFX_OMX_NEW(wrap,
-                MfxOmxEncodeCtrlWrapper);
-    return wrap;
+    return mfx_omx_get_encode_ctrl(NULL);
 }
 
 /*------------------------------------------------------------------------------*/
@@ -550,6 +546,23 @@ OMX_ERRORTYPE omx2mfx_config(
 
 /*------------------------------------------------------------------------------*/
 
+template<>
+OMX_ERRORTYPE omx2mfx_config(
+    MfxOmxEncodeCtrlWrapper& mfxctrl,
+    const OMX_VIDEO_CONFIG_INTEL_IDR_REQUEST& omxparams)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "SetConfig(IDR_REQUEST): bInsertHeaders %d", omxparams.bInsertHeaders);
+
+    mfxctrl.FrameType =
+        MFX_FRAMETYPE_I |
+        MFX_FRAMETYPE_IDR |
+        MFX_FRAMETYPE_REF;
+    return OMX_ErrorNone;
+}
+
+/*------------------------------------------------------------------------------*/
+
 
 template<>
 OMX_ERRORTYPE omx2mfx_config(
@@ -1866,7 +1879,7 @@ OMX_ERRORTYPE omx2mfx_control(
     OMX_ERRORTYPE omx_res = omx2mfx_config(*config.control, *omxparams);
     if (OMX_ErrorNone != omx_res)
     {
-        MFX_OMX_DELETE(config.control);
+        mfx_omx_put_encode_ctrl(config.control);
     }
     return omx_res;
 }
@@ -1957,6 +1970,7 @@ OMX_ERRORTYPE omx2mfx_params(
 DEFINE_TEMPLATE(OMX_VIDEO_CONFIG_USERDATA);
 DEFINE_TEMPLATE(OMX_VIDEO_CONFIG_DIRTY_RECT);
 DEFINE_TEMPLATE(OMX_CONFIG_INTRAREFRESHVOPTYPE);
+DEFINE_TEMPLATE(OMX_VIDEO_CONFIG_INTEL_IDR_REQUEST);
 DEFINE_TEMPLATE(OMX_CONFIG_DUMMYFRAME);
 
 /*------------------------------------------------------------------------------*/
@@ -1978,7 +1992,7 @@ OMX_ERRORTYPE omx2mfx_config(
     return OMX_ErrorNone;
 
   error:
-    MFX_OMX_DELETE(config.control);
+    mfx_omx_put_encode_ctrl(config.control);
     MFX_OMX_DELETE(config.mfxparams);
     return omx_res;
 }
@@ -1995,6 +2009,7 @@ OMX_ERRORTYPE omx2mfx_config(
 
 INSTANTIATE(OMX_CONFIG_FRAMERATETYPE);
 INSTANTIATE(OMX_CONFIG_INTRAREFRESHVOPTYPE);
+INSTANTIATE(OMX_VIDEO_CONFIG_INTEL_IDR_REQUEST);
 INSTANTIATE(OMX_CONFIG_DUMMYFRAME);
 INSTANTIATE(OMX_CONFIG_NUMSLICE);
 INSTANTIATE(OMX_CONFIG_BITRATELIMITOFF);
@@ -0,0 +1,431 @@
+// Copyright (c) 2011-2019 Intel Corporation
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/********************************************************************************
+
+Binary trace backend for MFX_OMX_AUTO_TRACE_* macros.
+
+Each trace point (module, function, task) is registered once and gets an id
+which keeps trace point category in the upper byte. Every thread writes fixed
+size records into its own ring buffer without locking: writer is the only
+thread modifying the ring, old records are overwritten when ring is full.
+Rings of finished threads are kept for export and reused only when their
+number exceeds MFX_OMX_TRACE_RINGS_MAX.
+
+Records are converted to Chrome trace event format (loadable by
+chrome://tracing and Perfetto UI) by mfx_omx_trace_export. Export does not
+stop writers, so few latest records of running threads may be inconsistent.
+
+*********************************************************************************/
+
+#include "mfx_omx_utils.h"
+
+#include <mutex>
+#include <cutils/properties.h>
+#include <sys/syscall.h>
+
+/*------------------------------------------------------------------------------*/
+
+#undef MFX_OMX_MODULE_NAME
+#define MFX_OMX_MODULE_NAME "mfx_omx_trace_ring"
+
+/*------------------------------------------------------------------------------*/
+
+#if (MFX_OMX_DEBUG == MFX_OMX_YES) && (MFX_OMX_DEBUG_TRACE_RING == MFX_OMX_YES)
+
+/*------------------------------------------------------------------------------*/
+
+#define MFX_OMX_TRACE_RECORDS_NUM 16384 // should be power of 2
+#define MFX_OMX_TRACE_RINGS_MAX 64
+
+#define MFX_OMX_TRACE_ID_CATEGORY(_id) ((_id) >> 24)
+#define MFX_OMX_TRACE_ID_INDEX(_id) (((_id) & 0xFFFFFF) - 1)
+
+enum MfxOmxTraceRecordType
+{
+    MFX_OMX_TRACE_BEGIN,
+    MFX_OMX_TRACE_END,
+    MFX_OMX_TRACE_MSG,
+    MFX_OMX_TRACE_I32,
+    MFX_OMX_TRACE_U32,
+    MFX_OMX_TRACE_I64,
+    MFX_OMX_TRACE_F64,
+    MFX_OMX_TRACE_P,
+    MFX_OMX_TRACE_S
+};
+
+struct MfxOmxTraceRecord
+{
+    mfxU64 time; // in ns
+    mfxU32 id;
+    mfxU32 type;
+    const char* name; // string literal given to the trace macro
+    union
+    {
+        mfxI64 i64;
+        mfxU64 u64;
+        mfxF64 f64;
+        char str[16]; // strings are truncated
+    } value;
+};
+
+struct MfxOmxTraceRing
+{
+    MfxOmxTraceRecord records[MFX_OMX_TRACE_RECORDS_NUM];
+    std::atomic<mfxU64> written;
+    pid_t tid;
+    bool bActive; // owning thread is alive
+};
+
+struct MfxOmxTracePoint
+{
+    const char* modulename;
+    const char* function;
+    const char* taskname;
+};
+
+struct MfxOmxTraceRegistry
+{
+    // not MfxOmxMutex to stay independent of anything which may be traced itself
+    std::mutex mutex;
+    std::vector<MfxOmxTracePoint> points;
+    std::vector<MfxOmxTraceRing*> rings;
+};
+
+/*------------------------------------------------------------------------------*/
+
+mfxU32 g_OmxTraceMask = (mfxU32)-1;
+
+// registry is never destroyed: rings may be released by thread_local destructors
+// after static objects are gone
+static MfxOmxTraceRegistry& mfx_omx_trace_registry(void)
+{
+    static MfxOmxTraceRegistry* registry = new MfxOmxTraceRegistry;
+    return *registry;
+}
+
+/*------------------------------------------------------------------------------*/
+
+static mfxU32 mfx_omx_trace_category(const char* modulename)
+{
+    if (!strcmp(modulename, "mfx_omx_core") || !strcmp(modulename, "mfx_omx_component_manager"))
+        return MFX_OMX_TRACE_CATEGORY_CORE;
+    if (strstr(modulename, "component") || strstr(modulename, "ports") || strstr(modulename, "vpp"))
+        return MFX_OMX_TRACE_CATEGORY_COMPONENTS;
+    if (strstr(modulename, "_bst_") || strstr(modulename, "_srf_"))
+        return MFX_OMX_TRACE_CATEGORY_BUFFERS;
+    return MFX_OMX_TRACE_CATEGORY_UTILS;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxU32 mfx_omx_trace_register(const char* modulename, const char* function, const char* taskname)
+{
+    MfxOmxTraceRegistry& registry = mfx_omx_trace_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    if (registry.points.empty())
+    {
+        char value[PROPERTY_VALUE_MAX];
+        if (property_get("OMX.Intel.trace.mask", value, NULL) > 0)
+        {
+            g_OmxTraceMask = (mfxU32)strtoul(value, NULL, 16);
+        }
+    }
+
+    MfxOmxTracePoint point = { modulename, function, taskname };
+    registry.points.push_back(point);
+
+    return (mfx_omx_trace_category(modulename) << 24) | (mfxU32)registry.points.size();
+}
+
+/*------------------------------------------------------------------------------*/
+
+class MfxOmxTraceRingHolder
+{
+public:
+    MfxOmxTraceRingHolder(void): m_pRing(NULL) {}
+    ~MfxOmxTraceRingHolder(void)
+    {
+        if (m_pRing)
+        {
+            MfxOmxTraceRegistry& registry = mfx_omx_trace_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+
+            m_pRing->bActive = false;
+        }
+    }
+
+    MfxOmxTraceRing* GetRing(void)
+    {
+        if (!m_pRing) m_pRing = AcquireRing();
+        return m_pRing;
+    }
+
+protected:
+    static MfxOmxTraceRing* AcquireRing(void)
+    {
+        MfxOmxTraceRegistry& registry = mfx_omx_trace_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        MfxOmxTraceRing* pRing = NULL;
+
+        if (registry.rings.size() >= MFX_OMX_TRACE_RINGS_MAX)
+        {
+            for (size_t i = 0; i < registry.rings.size(); ++i)
+            {
+                if (!registry.rings[i]->bActive)
+                {
+                    pRing = registry.rings[i];
+                    break;
+                }
+            }
+        }
+        if (!pRing)
+        {
+            MFX_OMX_NEW(pRing, MfxOmxTraceRing);
+            if (!pRing) return NULL;
+            registry.rings.push_back(pRing);
+        }
+        pRing->written.store(0, std::memory_order_relaxed);
+        pRing->tid = (pid_t)syscall(SYS_gettid);
+        pRing->bActive = true;
+        return pRing;
+    }
+
+    MfxOmxTraceRing* m_pRing;
+};
+
+static thread_local MfxOmxTraceRingHolder t_TraceRing;
+
+/*------------------------------------------------------------------------------*/
+
+static inline MfxOmxTraceRecord* mfx_omx_trace_begin_record(MfxOmxTraceRing*& pRing, mfxU32 id, mfxU32 type, const char* name)
+{
+    pRing = t_TraceRing.GetRing();
+    if (!pRing) return NULL;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    MfxOmxTraceRecord* pRecord = &pRing->records[pRing->written.load(std::memory_order_relaxed) & (MFX_OMX_TRACE_RECORDS_NUM - 1)];
+    pRecord->time = (mfxU64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    pRecord->id = id;
+    pRecord->type = type;
+    pRecord->name = name;
+    pRecord->value.u64 = 0;
+    return pRecord;
+}
+
+static inline void mfx_omx_trace_end_record(MfxOmxTraceRing* pRing)
+{
+    pRing->written.store(pRing->written.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+static void mfx_omx_trace_write(mfxU32 id, mfxU32 type, const char* name, mfxU64 value)
+{
+    if (!id || !(MFX_OMX_TRACE_ID_CATEGORY(id) & g_OmxTraceMask)) return;
+
+    MfxOmxTraceRing* pRing = NULL;
+    MfxOmxTraceRecord* pRecord = mfx_omx_trace_begin_record(pRing, id, type, name);
+    if (!pRecord) return;
+
+    pRecord->value.u64 = value;
+    mfx_omx_trace_end_record(pRing);
+}
+
+static void mfx_omx_trace_write_s(mfxU32 id, mfxU32 type, const char* name, const char* value)
+{
+    if (!id || !(MFX_OMX_TRACE_ID_CATEGORY(id) & g_OmxTraceMask)) return;
+
+    MfxOmxTraceRing* pRing = NULL;
+    MfxOmxTraceRecord* pRecord = mfx_omx_trace_begin_record(pRing, id, type, name);
+    if (!pRecord) return;
+
+    if (value) strncpy(pRecord->value.str, value, sizeof(pRecord->value.str) - 1);
+    mfx_omx_trace_end_record(pRing);
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfx_omx_trace::mfx_omx_trace(mfxU32 _id)
+{
+    id = (MFX_OMX_TRACE_ID_CATEGORY(_id) & g_OmxTraceMask) ? _id : 0;
+    mfx_omx_trace_write(id, MFX_OMX_TRACE_BEGIN, NULL, 0);
+}
+
+mfx_omx_trace::~mfx_omx_trace(void)
+{
+    mfx_omx_trace_write(id, MFX_OMX_TRACE_END, NULL, 0);
+}
+
+void mfx_omx_trace::printf_msg(const char* msg)
+{
+    mfx_omx_trace_write_s(id, MFX_OMX_TRACE_MSG, NULL, msg);
+}
+
+void mfx_omx_trace::printf_i32(const char* name, mfxI32 value)
+{
+    mfx_omx_trace_write(id, MFX_OMX_TRACE_I32, name, (mfxU64)(mfxI64)value);
+}
+
+void mfx_omx_trace::printf_u32(const char* name, mfxU32 value)
+{
+    mfx_omx_trace_write(id, MFX_OMX_TRACE_U32, name, value);
+}
+
+void mfx_omx_trace::printf_i64(const char* name, mfxI64 value)
+{
+    mfx_omx_trace_write(id, MFX_OMX_TRACE_I64, name, (mfxU64)value);
+}
+
+void mfx_omx_trace::printf_f64(const char* name, mfxF64 value)
+{
+    mfxU64 bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    mfx_omx_trace_write(id, MFX_OMX_TRACE_F64, name, bits);
+}
+
+void mfx_omx_trace::printf_p(const char* name, void* value)
+{
+    mfx_omx_trace_write(id, MFX_OMX_TRACE_P, name, (mfxU64)(uintptr_t)value);
+}
+
+void mfx_omx_trace::printf_s(const char* name, const char* value)
+{
+    mfx_omx_trace_write_s(id, MFX_OMX_TRACE_S, name, value);
+}
+
+/*------------------------------------------------------------------------------*/
+
+static void mfx_omx_trace_print_string(FILE* file, const char* str)
+{
+    fputc('"', file);
+    for (; str && *str; ++str)
+    {
+        if ('"' == *str || '\\' == *str) fprintf(file, "\\%c", *str);
+        else if ((unsigned char)*str < 0x20) fprintf(file, "\\u%04x", *str);
+        else fputc(*str, file);
+    }
+    fputc('"', file);
+}
+
+/*------------------------------------------------------------------------------*/
+
+static void mfx_omx_trace_print_record(FILE* file, const MfxOmxTracePoint& point, const MfxOmxTraceRecord& record, pid_t pid, pid_t tid)
+{
+    static const char* categories[] = { "core", "components", "buffers", "utils" };
+    const char* category = "unknown";
+    char str[sizeof(record.value.str)];
+
+    for (mfxU32 i = 0; i < MFX_OMX_GET_ARRAY_SIZE(categories); ++i)
+    {
+        if (MFX_OMX_TRACE_ID_CATEGORY(record.id) & (1 << i)) category = categories[i];
+    }
+
+    fprintf(file, "{\"name\":\"%s%s%s\",\"cat\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%llu.%03llu,",
+            point.function, point.taskname ? ": " : "", point.taskname ? point.taskname : "",
+            category, pid, tid,
+            (unsigned long long)(record.time / 1000), (unsigned long long)(record.time % 1000));
+
+    switch (record.type)
+    {
+    case MFX_OMX_TRACE_BEGIN:
+        fprintf(file, "\"ph\":\"B\",\"args\":{\"module\":\"%s\"}}", point.modulename);
+        return;
+    case MFX_OMX_TRACE_END:
+        fprintf(file, "\"ph\":\"E\"}");
+        return;
+    default:
+        break;
+    }
+
+    fprintf(file, "\"ph\":\"i\",\"s\":\"t\",\"args\":{");
+    mfx_omx_trace_print_string(file, (MFX_OMX_TRACE_MSG == record.type) ? "msg" : record.name);
+    fputc(':', file);
+    switch (record.type)
+    {
+    case MFX_OMX_TRACE_I32:
+    case MFX_OMX_TRACE_I64:
+        fprintf(file, "%lld", (long long)record.value.i64);
+        break;
+    case MFX_OMX_TRACE_U32:
+        fprintf(file, "\"0x%x\"", (mfxU32)record.value.u64);
+        break;
+    case MFX_OMX_TRACE_F64:
+        fprintf(file, "%f", record.value.f64);
+        break;
+    case MFX_OMX_TRACE_P:
+        fprintf(file, "\"0x%llx\"", (unsigned long long)record.value.u64);
+        break;
+    default: // strings
+        memcpy(str, record.value.str, sizeof(str));
+        str[sizeof(str) - 1] = '\0';
+        mfx_omx_trace_print_string(file, str);
+        break;
+    }
+    fprintf(file, "}}");
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus mfx_omx_trace_export(const char* filename)
+{
+    MfxOmxTraceRegistry& registry = mfx_omx_trace_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    bool bFirst = true;
+
+    if (!filename) return MFX_ERR_NULL_PTR;
+
+    FILE* file = fopen(filename, "w");
+    if (!file)
+    {
+        MFX_OMX_LOG_ERROR("failed to open %s", filename);
+        return MFX_ERR_UNKNOWN;
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (size_t r = 0; r < registry.rings.size(); ++r)
+    {
+        const MfxOmxTraceRing* pRing = registry.rings[r];
+        mfxU64 written = pRing->written.load(std::memory_order_acquire);
+        mfxU64 first = (written > MFX_OMX_TRACE_RECORDS_NUM) ? written - MFX_OMX_TRACE_RECORDS_NUM : 0;
+
+        for (mfxU64 i = first; i < written; ++i)
+        {
+            const MfxOmxTraceRecord& record = pRing->records[i & (MFX_OMX_TRACE_RECORDS_NUM - 1)];
+            mfxU32 index = MFX_OMX_TRACE_ID_INDEX(record.id);
+
+            if (index >= registry.points.size()) continue;
+
+            if (!bFirst) fprintf(file, ",\n");
+            mfx_omx_trace_print_record(file, registry.points[index], record, getpid(), pRing->tid);
+            bFirst = false;
+        }
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(file);
+
+    MFX_OMX_LOG_INFO("trace of %d threads exported to %s", (int)registry.rings.size(), filename);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+#endif // #if (MFX_OMX_DEBUG == MFX_OMX_YES) && (MFX_OMX_DEBUG_TRACE_RING == MFX_OMX_YES)
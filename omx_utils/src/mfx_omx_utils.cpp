@@ -19,6 +19,7 @@
 // SOFTWARE.
 
 #include "mfx_omx_utils.h"
+#include "mfx_omx_dump_writer.h"
 
 /*------------------------------------------------------------------------------*/
 
@@ -56,6 +57,339 @@ NalUnit GetNalUnit(mfxU8 * begin, mfxU8 * end)
 
 /*------------------------------------------------------------------------------*/
 
+mfxStatus mfx_omx_convert_to_length_prefixed(
+    mfxU8* data, mfxU32& length, mfxU32 maxLength, mfxU32 lengthSize)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    mfxU8* end = data + length;
+    mfxU32 outSize = 0, shift = 0;
+
+    if (!data) return MFX_ERR_NULL_PTR;
+    if ((1 != lengthSize) && (2 != lengthSize) && (4 != lengthSize)) return MFX_ERR_UNSUPPORTED;
+
+    // Conversion is done in place from the beginning of data. Each prefix and
+    // NAL unit should not overwrite NAL units which are not yet read, so data is
+    // moved forward if some start codes are shorter than the prefix.
+    for (NalUnit nalu = GetNalUnit(data, end); nalu != NalUnit(); nalu = GetNalUnit(nalu.end, end))
+    {
+        mfxU32 startCodeSize = nalu.numZero + 1;
+        mfxU32 nalSize = (nalu.end - nalu.begin) - startCodeSize;
+        mfxU32 readPos = (nalu.begin - data) + startCodeSize;
+
+        if ((lengthSize < 4) && (nalSize >> (8 * lengthSize))) return MFX_ERR_UNSUPPORTED;
+        if (outSize + lengthSize > readPos + shift) shift = outSize + lengthSize - readPos;
+        outSize += lengthSize + nalSize;
+    }
+    if (shift)
+    {
+        if (length + shift > maxLength) return MFX_ERR_NOT_ENOUGH_BUFFER;
+        memmove(data + shift, data, length);
+    }
+
+    mfxU8* dst = data;
+    end = data + shift + length;
+    for (NalUnit nalu = GetNalUnit(data + shift, end); nalu != NalUnit(); nalu = GetNalUnit(nalu.end, end))
+    {
+        mfxU8* payload = nalu.begin + nalu.numZero + 1;
+        mfxU32 nalSize = nalu.end - payload;
+
+        if (dst + lengthSize != payload) memmove(dst + lengthSize, payload, nalSize);
+        for (mfxU32 i = 0; i < lengthSize; ++i)
+        {
+            dst[i] = (mfxU8)(nalSize >> (8 * (lengthSize - 1 - i)));
+        }
+        dst += lengthSize + nalSize;
+    }
+    length = dst - data;
+
+    MFX_OMX_AUTO_TRACE_I32(length);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+/* Copies NAL unit bytes removing emulation prevention bytes. */
+static mfxU32 mfx_omx_unescape_nal(const mfxU8* src, mfxU32 srcSize, mfxU8* dst, mfxU32 dstSize)
+{
+    mfxU32 zeros = 0, size = 0;
+
+    for (mfxU32 i = 0; (i < srcSize) && (size < dstSize); ++i)
+    {
+        if ((zeros >= 2) && (0x03 == src[i]))
+        {
+            zeros = 0;
+            continue;
+        }
+        zeros = src[i]? 0: zeros + 1;
+        dst[size++] = src[i];
+    }
+    return size;
+}
+
+/*------------------------------------------------------------------------------*/
+
+struct MfxOmxRecordWriter
+{
+    MfxOmxRecordWriter(mfxU8* data, mfxU32 size) : begin(data), cur(data), end(data + size) {}
+
+    void put8(mfxU32 value)  { if (cur < end) *cur = (mfxU8)value; ++cur; }
+    void put16(mfxU32 value) { put8(value >> 8); put8(value); }
+    void put(const mfxU8* data, mfxU32 size) { for (mfxU32 i = 0; i < size; ++i) put8(data[i]); }
+    bool overflow(void) { return cur > end; }
+    mfxU32 size(void) { return cur - begin; }
+
+    mfxU8* begin;
+    mfxU8* cur;
+    mfxU8* end;
+};
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus mfx_omx_make_codec_config_record(
+    mfxU32 codecId, mfxU8* data, mfxU32 length, mfxU32 lengthSize,
+    const mfxFrameInfo& info, mfxU8* record, mfxU32& recordSize)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    // parameter sets by type: VPS, SPS, PPS
+    const mfxU32 MAX_PS_NUM = 4;
+    mfxU8* ps[3][MAX_PS_NUM] = {};
+    mfxU32 psSize[3][MAX_PS_NUM] = {};
+    mfxU32 psNum[3] = {};
+    bool bHevc = (MFX_CODEC_HEVC == codecId);
+
+    if (!data || !record) return MFX_ERR_NULL_PTR;
+    if ((MFX_CODEC_AVC != codecId) && !bHevc) return MFX_ERR_UNSUPPORTED;
+    if ((1 != lengthSize) && (2 != lengthSize) && (4 != lengthSize)) return MFX_ERR_UNSUPPORTED;
+
+    mfxU8* end = data + length;
+    for (NalUnit nalu = GetNalUnit(data, end); nalu != NalUnit(); nalu = GetNalUnit(nalu.end, end))
+    {
+        mfxU8* payload = nalu.begin + nalu.numZero + 1;
+        mfxU8 type = bHevc ? (payload[0] & 0x7E) >> 1 : payload[0] & 0x1F;
+        int idx = -1;
+
+        if (bHevc) idx = (32 == type)? 0: (33 == type)? 1: (34 == type)? 2: -1;
+        else idx = (7 == type)? 1: (8 == type)? 2: -1;
+
+        if ((idx >= 0) && (psNum[idx] < MAX_PS_NUM))
+        {
+            ps[idx][psNum[idx]] = payload;
+            psSize[idx][psNum[idx]] = nalu.end - payload;
+            ++psNum[idx];
+        }
+    }
+    if (!psNum[1] || !psNum[2] || (bHevc && !psNum[0])) return MFX_ERR_NOT_FOUND;
+
+    mfxU32 chromaFormat = info.ChromaFormat;
+    mfxU32 bitDepthLuma = info.BitDepthLuma? info.BitDepthLuma: 8;
+    mfxU32 bitDepthChroma = info.BitDepthChroma? info.BitDepthChroma: bitDepthLuma;
+    MfxOmxRecordWriter writer(record, recordSize);
+
+    if (bHevc)
+    {
+        // VPS: 2 bytes of NAL header, 4 bytes of VPS fields, then profile_tier_level
+        // general part: profile byte, 4 bytes of compatibility flags, 6 bytes
+        // of constraint flags and level, exactly as hvcC wants them
+        mfxU8 vps[18] = {};
+        if (mfx_omx_unescape_nal(ps[0][0], psSize[0][0], vps, sizeof(vps)) < sizeof(vps)) return MFX_ERR_NOT_FOUND;
+
+        mfxU32 numTemporalLayers = ((vps[3] >> 1) & 0x7) + 1;
+        mfxU32 temporalIdNested = vps[3] & 0x1;
+
+        writer.put8(1); // configurationVersion
+        writer.put(vps + 6, 12);
+        writer.put16(0xF000); // min_spatial_segmentation_idc
+        writer.put8(0xFC);    // parallelismType
+        writer.put8(0xFC | chromaFormat);
+        writer.put8(0xF8 | (bitDepthLuma - 8));
+        writer.put8(0xF8 | (bitDepthChroma - 8));
+        writer.put16(0);      // avgFrameRate
+        writer.put8((numTemporalLayers << 3) | (temporalIdNested << 2) | (lengthSize - 1));
+        writer.put8(3);       // numOfArrays
+        for (mfxU32 i = 0; i < 3; ++i)
+        {
+            writer.put8(0x80 | (32 + i)); // array_completeness, NAL_unit_type
+            writer.put16(psNum[i]);
+            for (mfxU32 j = 0; j < psNum[i]; ++j)
+            {
+                writer.put16(psSize[i][j]);
+                writer.put(ps[i][j], psSize[i][j]);
+            }
+        }
+    }
+    else
+    {
+        if (psSize[1][0] < 4) return MFX_ERR_NOT_FOUND;
+
+        mfxU8 profile = ps[1][0][1];
+
+        writer.put8(1);     // configurationVersion
+        writer.put(ps[1][0] + 1, 3); // profile, compatibility, level
+        writer.put8(0xFC | (lengthSize - 1));
+        writer.put8(0xE0 | psNum[1]);
+        for (mfxU32 j = 0; j < psNum[1]; ++j)
+        {
+            writer.put16(psSize[1][j]);
+            writer.put(ps[1][j], psSize[1][j]);
+        }
+        writer.put8(psNum[2]);
+        for (mfxU32 j = 0; j < psNum[2]; ++j)
+        {
+            writer.put16(psSize[2][j]);
+            writer.put(ps[2][j], psSize[2][j]);
+        }
+        if ((100 == profile) || (110 == profile) || (122 == profile) || (144 == profile))
+        {
+            writer.put8(0xFC | chromaFormat);
+            writer.put8(0xF8 | (bitDepthLuma - 8));
+            writer.put8(0xF8 | (bitDepthChroma - 8));
+            writer.put8(0); // numOfSequenceParameterSetExt
+        }
+    }
+    if (writer.overflow()) return MFX_ERR_NOT_ENOUGH_BUFFER;
+    recordSize = writer.size();
+
+    MFX_OMX_AUTO_TRACE_I32(recordSize);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+static inline mfxU32 mfx_omx_read_be(const mfxU8* data, mfxU32 size)
+{
+    mfxU32 value = 0;
+    for (mfxU32 i = 0; i < size; ++i) value = (value << 8) | data[i];
+    return value;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus mfx_omx_convert_to_start_codes(
+    const mfxU8* data, mfxU32 length, mfxU32 lengthSize, mfxU8* out, mfxU32& outLength)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    mfxU32 pos = 0;
+
+    if (!data) return MFX_ERR_NULL_PTR;
+    if ((1 != lengthSize) && (2 != lengthSize) && (4 != lengthSize)) return MFX_ERR_UNSUPPORTED;
+
+    outLength = 0;
+    while (pos < length)
+    {
+        if (lengthSize > length - pos) return MFX_ERR_UNDEFINED_BEHAVIOR;
+        mfxU32 nalSize = mfx_omx_read_be(data + pos, lengthSize);
+        pos += lengthSize;
+        if (nalSize > length - pos) return MFX_ERR_UNDEFINED_BEHAVIOR;
+        if (!nalSize) continue;
+
+        if (out)
+        {
+            mfxU8* dst = out + outLength;
+            dst[0] = 0; dst[1] = 0; dst[2] = 0; dst[3] = 1;
+            std::copy(data + pos, data + pos + nalSize, dst + 4);
+        }
+        outLength += 4 + nalSize;
+        pos += nalSize;
+    }
+    MFX_OMX_AUTO_TRACE_I32(outLength);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
+/* Reads num NAL units of the given type each prefixed with 2 bytes length and
+ * appends them with start codes to out (if it is not NULL).
+ */
+static bool mfx_omx_read_record_nal_units(
+    bool bHevc, mfxU32 type, mfxU32 num,
+    const mfxU8* data, mfxU32 length, mfxU32& pos, mfxU8* out, mfxU32& outLength)
+{
+    for (mfxU32 i = 0; i < num; ++i)
+    {
+        if (2 > length - pos) return false;
+        mfxU32 nalSize = mfx_omx_read_be(data + pos, 2);
+        pos += 2;
+        if ((nalSize < (bHevc ? 2u : 1u)) || (nalSize > length - pos)) return false;
+
+        mfxU32 nalType = bHevc ? ((data[pos] >> 1) & 0x3F) : (data[pos] & 0x1F);
+        if (nalType != type) return false;
+
+        if (out)
+        {
+            mfxU8* dst = out + outLength;
+            dst[0] = 0; dst[1] = 0; dst[2] = 0; dst[3] = 1;
+            std::copy(data + pos, data + pos + nalSize, dst + 4);
+        }
+        outLength += 4 + nalSize;
+        pos += nalSize;
+    }
+    return true;
+}
+
+/*------------------------------------------------------------------------------*/
+
+mfxStatus mfx_omx_convert_config_record_to_start_codes(
+    mfxU32 codecId, const mfxU8* data, mfxU32 length, mfxU8* out, mfxU32& outLength, mfxU32& lengthSize)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    bool bHevc = (MFX_CODEC_HEVC == codecId);
+    bool bValid = true;
+    mfxU32 pos = 0;
+
+    if (!data) return MFX_ERR_NULL_PTR;
+    if ((MFX_CODEC_AVC != codecId) && !bHevc) return MFX_ERR_UNSUPPORTED;
+    // configurationVersion
+    if ((length < (bHevc ? 23u : 7u)) || (1 != data[0])) return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    outLength = 0;
+    if (bHevc)
+    {
+        static const mfxU32 NAL_UT_SPS = 33;
+        bool bFoundSps = false;
+
+        lengthSize = (data[21] & 0x3) + 1;
+        mfxU32 numOfArrays = data[22];
+        pos = 23;
+        for (mfxU32 i = 0; bValid && (i < numOfArrays); ++i)
+        {
+            if (3 > length - pos) bValid = false;
+            else
+            {
+                mfxU32 type = data[pos] & 0x3F;
+                mfxU32 numNalus = mfx_omx_read_be(data + pos + 1, 2);
+                pos += 3;
+                bValid = mfx_omx_read_record_nal_units(bHevc, type, numNalus, data, length, pos, out, outLength);
+                if (NAL_UT_SPS == type) bFoundSps = bFoundSps || numNalus;
+            }
+        }
+        bValid = bValid && bFoundSps;
+    }
+    else
+    {
+        static const mfxU32 NAL_UT_SPS = 7, NAL_UT_PPS = 8;
+
+        lengthSize = (data[4] & 0x3) + 1;
+        mfxU32 numOfSps = data[5] & 0x1F;
+        pos = 6;
+        bValid = numOfSps &&
+                 mfx_omx_read_record_nal_units(bHevc, NAL_UT_SPS, numOfSps, data, length, pos, out, outLength);
+        if (bValid)
+        {
+            // profile specific extension may follow PPS
+            mfxU32 numOfPps = (pos < length) ? data[pos++] : 0;
+            bValid = numOfPps &&
+                     mfx_omx_read_record_nal_units(bHevc, NAL_UT_PPS, numOfPps, data, length, pos, out, outLength);
+        }
+    }
+    if (!bValid || (3 == lengthSize)) return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    MFX_OMX_AUTO_TRACE_I32(outLength);
+    MFX_OMX_AUTO_TRACE_I32(lengthSize);
+    return MFX_ERR_NONE;
+}
+
+/*------------------------------------------------------------------------------*/
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -76,8 +410,7 @@ size_t mfx_omx_dump(const void *ptr, size_t size, size_t nmemb, FILE *stream)
 #if MFX_OMX_DEBUG_DUMP == MFX_OMX_YES
     if (stream)
     {
-       ret = fwrite(ptr, size, nmemb, stream);
-       fflush(stream);
+        if (mfx_omx_get_dump_writer().Write(stream, ptr, (mfxU32)(size * nmemb))) ret = nmemb;
     }
 #else
     MFX_OMX_UNUSED(ptr);
@@ -90,6 +423,18 @@ size_t mfx_omx_dump(const void *ptr, size_t size, size_t nmemb, FILE *stream)
 
 /*------------------------------------------------------------------------------*/
 
+void mfx_omx_dump_close(FILE* stream)
+{
+    if (!stream) return;
+#if MFX_OMX_DEBUG_DUMP == MFX_OMX_YES
+    mfx_omx_get_dump_writer().Close(stream);
+#else
+    fclose(stream);
+#endif
+}
+
+/*------------------------------------------------------------------------------*/
+
 void mfx_omx_dump_YUV_from_NV12_data(FILE* f, mfxFrameData* pData, mfxFrameInfo* info, mfxU32 p)
 {
     MFX_OMX_AUTO_TRACE_FUNC();
@@ -103,19 +448,24 @@ void mfx_omx_dump_YUV_from_NV12_data(FILE* f, mfxFrameData* pData, mfxFrameInfo*
         cy = info->CropY;
         cw = info->CropW;
         ch = info->CropH;
+
+        MfxOmxDumpWriter& writer = mfx_omx_get_dump_writer();
+        mfxU32 size = cw*ch + 2*(cw/2)*(ch/2);
+        mfxU8* buffer = writer.GetBuffer(size);
+        mfxU8* dst = buffer;
+
+        if (!buffer) return;
         // dumping Y
-        for (i = 0; i < ch; ++i)
+        for (i = 0; i < ch; ++i, dst += cw)
         {
-            fwrite(pData->Y + cx + (cy + i)*p, 1, cw, f);
+            memcpy(dst, pData->Y + cx + (cy + i)*p, cw);
         }
-        fflush(f);
         // dumping U
         for (i = 0; i < ch/2; ++i)
         for (j = 0; j < cw/2; ++j)
         {
-            fwrite(pData->U + p*i + 2*j, 1, 1, f);
+            *dst++ = pData->U[p*i + 2*j];
         }
-        fflush(f);
         // dumping V
         if (!pData->V)
         {
@@ -124,9 +474,9 @@ void mfx_omx_dump_YUV_from_NV12_data(FILE* f, mfxFrameData* pData, mfxFrameInfo*
         for (i = 0; i < ch/2; ++i)
         for (j = 0; j < cw/2; ++j)
         {
-            fwrite(pData->V + p*i + 2*j, 1, 1, f);
+            *dst++ = pData->V[p*i + 2*j];
         }
-        fflush(f);
+        writer.Commit(f, buffer, size);
     }
 #else
     MFX_OMX_UNUSED(f);
@@ -149,19 +499,25 @@ void mfx_omx_dump_YUV_from_P010_data(FILE* f, mfxFrameData * pData, mfxFrameInfo
         mfxI32 crop_x = pInfo->CropX << 1; // sample - two bytes
         mfxI32 crop_y = pInfo->CropY >> 1;
         mfxU32 pitch = pData->PitchLow + ((mfxU32)pData->PitchHigh << 16);
+        mfxU32 row = pInfo->CropW * 2;
+
+        MfxOmxDumpWriter& writer = mfx_omx_get_dump_writer();
+        mfxU32 size = row * (pInfo->CropH + pInfo->CropH / 2);
+        mfxU8* buffer = writer.GetBuffer(size);
+        mfxU8* dst = buffer;
 
-        for (i = 0; i < pInfo->CropH; i++)
+        if (!buffer) return;
+        for (i = 0; i < pInfo->CropH; i++, dst += row)
         {
-            fwrite(pData->Y + (pInfo->CropY * pitch + crop_x)+ i * pitch, 1, pInfo->CropW * 2, f);
+            memcpy(dst, pData->Y + (pInfo->CropY * pitch + crop_x)+ i * pitch, row);
         }
-        fflush(f);
 
         crop_y >>= 1;
-        for (i = 0; i < pInfo->CropH / 2; i++)
+        for (i = 0; i < pInfo->CropH / 2; i++, dst += row)
         {
-            fwrite(pData->UV + (crop_y*pitch + crop_x) + i * pitch, 1, pInfo->CropW * 2, f);
+            memcpy(dst, pData->UV + (crop_y*pitch + crop_x) + i * pitch, row);
         }
-        fflush(f);
+        writer.Commit(f, buffer, size);
     }
 #else
     MFX_OMX_UNUSED(f);
@@ -194,11 +550,16 @@ void mfx_omx_dump_RGB_from_RGB4_data(FILE* f, mfxFrameData* pData, mfxFrameInfo*
         ptr = MFX_OMX_MIN( MFX_OMX_MIN(pData->R, pData->G), pData->B);
         ptr = ptr + pInfo->CropX + pInfo->CropY * pitch;
 
+        MfxOmxDumpWriter& writer = mfx_omx_get_dump_writer();
+        mfxU32 size = 4 * w * h;
+        mfxU8* buffer = writer.GetBuffer(size);
+
+        if (!buffer) return;
         for(i = 0; i < h; i++)
         {
-            fwrite(ptr + i * pitch, 1, 4*w, f);
+            memcpy(buffer + i * 4 * w, ptr + i * pitch, 4*w);
         }
-        fflush(f);
+        writer.Commit(f, buffer, size);
     }
 #else
     MFX_OMX_UNUSED(f);
@@ -358,6 +719,62 @@ mfxStatus mfx_omx_get_metadatabuffer_info(mfxU8* data, mfxU32 size, MetadataBuff
     return mfx_res;
 }
 
+/*------------------------------------------------------------------------------*/
+
+MfxOmxEncodeCtrlWrapper* mfx_omx_get_encode_ctrl(MfxOmxEncodeCtrlPool* pool)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    MfxOmxEncodeCtrlWrapper* ctrl = NULL;
+
+    if (pool)
+    {
+        bool bAllocated = false;
+
+        ctrl = pool->Get(&bAllocated);
+        if (ctrl) ctrl->pool = pool;
+        if (bAllocated)
+        {
+            // before the encoder reserves controls allocations are expected, after
+            // that the pool is sized to cover all controls in flight
+            if (pool->GetCapacity())
+            {
+                MFX_OMX_LOG_ERROR("Encode ctrl pool is exhausted, allocated on heap (%d times)",
+                                  pool->GetAllocationsCount());
+            }
+            else
+            {
+                MFX_OMX_LOG_INFO_IF(g_OmxLogLevel, "Encode ctrl pool is empty, allocated on heap (%d times)",
+                                    pool->GetAllocationsCount());
+            }
+        }
+    }
+    else
+    {
+        MFX_OMX_NEW(ctrl, MfxOmxEncodeCtrlWrapper);
+    }
+    MFX_OMX_AUTO_TRACE_P(ctrl);
+    return ctrl;
+}
+
+/*------------------------------------------------------------------------------*/
+
+void mfx_omx_put_encode_ctrl(MfxOmxEncodeCtrlWrapper*& ctrl)
+{
+    MFX_OMX_AUTO_TRACE_FUNC();
+    if (!ctrl) return;
+
+    if (ctrl->payload) // free payload data
+    {
+        MFX_OMX_DELETE(ctrl->payload->Data);
+        MFX_OMX_DELETE(ctrl->payload);
+    }
+    if (ctrl->pool) ctrl->pool->Put(ctrl);
+    else MFX_OMX_DELETE(ctrl);
+    ctrl = NULL;
+}
+
+/*------------------------------------------------------------------------------*/
+
 bool operator ==(NalUnit const & left, NalUnit const & right)
 {
     return left.begin == right.begin && left.end == right.end;
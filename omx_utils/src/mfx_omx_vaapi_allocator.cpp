@@ -132,6 +132,7 @@ MfxOmxVaapiFrameAllocator::MfxOmxVaapiFrameAllocator()
     , m_pGralloc(NULL)
     , m_MIDs(NULL)
     , m_numMIDs(0)
+    , m_mutex("vaapi_allocator")
 {
 }
 
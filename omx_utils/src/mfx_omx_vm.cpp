@@ -19,7 +19,13 @@
 // SOFTWARE.
 
 #include "mfx_omx_utils.h"
+#include "mfx_omx_lock_stats.h"
 #include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 /*------------------------------------------------------------------------------*/
 
@@ -98,6 +104,16 @@ mfxU32 mfx_omx_get_cpu_num(void)
 
 /*------------------------------------------------------------------------------*/
 
+mfxU64 mfx_omx_get_time_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (mfxU64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*------------------------------------------------------------------------------*/
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -106,10 +122,16 @@ mfxU32 mfx_omx_get_cpu_num(void)
 /*                              M U T E X E S                                   */
 /*------------------------------------------------------------------------------*/
 
-MfxOmxMutex::MfxOmxMutex(void)
+MfxOmxMutex::MfxOmxMutex(const char* name)
 {
     int res = pthread_mutex_init(&m_mutex, NULL);
     MFX_OMX_THROW_IF(res, std::bad_alloc());
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    m_pStats = mfx_omx_lock_stats_get(name, MFX_OMX_LOCK_MUTEX);
+    m_nLockTime = 0;
+#else
+    MFX_OMX_UNUSED(name);
+#endif
 }
 
 /*------------------------------------------------------------------------------*/
@@ -123,21 +145,33 @@ MfxOmxMutex::~MfxOmxMutex(void)
 
 mfxStatus MfxOmxMutex::Lock(void)
 {
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    return (mfx_omx_lock_stats_mutex_lock(&m_mutex, m_pStats, m_nLockTime))? MFX_ERR_UNKNOWN: MFX_ERR_NONE;
+#else
     return (pthread_mutex_lock(&m_mutex))? MFX_ERR_UNKNOWN: MFX_ERR_NONE;
+#endif
 }
 
 /*------------------------------------------------------------------------------*/
 
 mfxStatus MfxOmxMutex::Unlock(void)
 {
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    return (mfx_omx_lock_stats_mutex_unlock(&m_mutex, m_pStats, m_nLockTime))? MFX_ERR_UNKNOWN: MFX_ERR_NONE;
+#else
     return (pthread_mutex_unlock(&m_mutex))? MFX_ERR_UNKNOWN: MFX_ERR_NONE;
+#endif
 }
 
 /*------------------------------------------------------------------------------*/
 
 bool MfxOmxMutex::Try(void)
 {
-    return (pthread_mutex_trylock(&m_mutex))? false: true;
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    return !mfx_omx_lock_stats_mutex_trylock(&m_mutex, m_pStats, m_nLockTime);
+#else
+    return !pthread_mutex_trylock(&m_mutex);
+#endif
 }
 
 /*------------------------------------------------------------------------------*/
@@ -187,211 +221,269 @@ mfxStatus MfxOmxAutoLock::Unlock(void)
 }
 
 /*------------------------------------------------------------------------------*/
-/*                              E V E N T S                                     */
+/*                              F U T E X E S                                   */
 /*------------------------------------------------------------------------------*/
 
-MfxOmxEvent::MfxOmxEvent(bool manual, bool state)
+static inline int* mfx_omx_futex_word(std::atomic<int>* word)
 {
-    m_manual = manual;
-    m_state = state;
+    static_assert(sizeof(std::atomic<int>) == sizeof(int), "futex word should be plain int");
+    return reinterpret_cast<int*>(word);
+}
+
+/*------------------------------------------------------------------------------*/
 
-    int res = pthread_cond_init(&m_event, NULL);
-    if (!res)
+// absolute CLOCK_MONOTONIC time msec milliseconds from now
+static void mfx_omx_futex_deadline(mfxU32 msec, struct timespec& deadline)
+{
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += msec / 1000;
+    deadline.tv_nsec += (long)(msec % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000)
     {
-        res = pthread_mutex_init(&m_mutex, NULL);
-        if (res)
-        {
-            pthread_cond_destroy(&m_event);
-        }
+        ++deadline.tv_sec;
+        deadline.tv_nsec -= 1000000000;
     }
-    MFX_OMX_THROW_IF(res, std::bad_alloc());
+}
+
+/*------------------------------------------------------------------------------*/
+
+// sleeps while word has given value; 0 means the caller should check the word again
+static int mfx_omx_futex_wait(std::atomic<int>* word, int value, const struct timespec* deadline)
+{
+    // bitset variant of wait takes absolute timeout, so retries do not shift the deadline
+    if (syscall(SYS_futex, mfx_omx_futex_word(word), FUTEX_WAIT_BITSET_PRIVATE,
+                value, deadline, NULL, FUTEX_BITSET_MATCH_ANY))
+    {
+        // EAGAIN: value changed before sleeping, EINTR: interrupted by a signal handler
+        if ((EAGAIN == errno) || (EINTR == errno)) return 0;
+        return errno;
+    }
+    return 0;
+}
+
+/*------------------------------------------------------------------------------*/
+
+static int mfx_omx_futex_wake(std::atomic<int>* word, int count)
+{
+    if (syscall(SYS_futex, mfx_omx_futex_word(word), FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0) < 0)
+        return errno;
+    return 0;
+}
+
+/*------------------------------------------------------------------------------*/
+/*                              E V E N T S                                     */
+/*------------------------------------------------------------------------------*/
+
+MfxOmxEvent::MfxOmxEvent(bool manual, bool state, const char* name):
+    m_manual(manual),
+    m_state(state ? 1 : 0),
+    m_waiters(0)
+{
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    m_pStats = mfx_omx_lock_stats_get(name, MFX_OMX_LOCK_EVENT);
+#else
+    MFX_OMX_UNUSED(name);
+#endif
 }
 
 /*------------------------------------------------------------------------------*/
 
 MfxOmxEvent::~MfxOmxEvent(void)
 {
-    pthread_cond_destroy(&m_event);
-    pthread_mutex_destroy(&m_mutex);
 }
 
 /*------------------------------------------------------------------------------*/
 
 int MfxOmxEvent::Signal(void)
 {
-    int res = 0;
-    res = pthread_mutex_lock(&m_mutex);
-    if (!res)
-    {
-        if (!m_state)
-        {
-            m_state = true;
-            if (m_manual) VM_CHECK(res, pthread_cond_broadcast(&m_event))
-            else VM_CHECK(res, pthread_cond_signal(&m_event))
-        }
-        VM_CHECK(res, pthread_mutex_unlock(&m_mutex));
-    }
-    return res;
+    // sequentially consistent store and load pair with the ones in SlowWait:
+    // either the waiter sees the state or Signal sees the waiter
+    m_state.store(1);
+    if (!m_waiters.load()) return 0;
+    return mfx_omx_futex_wake(&m_state, m_manual ? INT_MAX : 1);
 }
 
 /*------------------------------------------------------------------------------*/
 
 int MfxOmxEvent::Reset(void)
 {
-    int res = 0;
-    res = pthread_mutex_lock(&m_mutex);
-    if (!res)
-    {
-        if (m_state) m_state = false;
-        res = pthread_mutex_unlock(&m_mutex);
-    }
-    return res;
+    m_state.store(0);
+    return 0;
 }
 
 /*------------------------------------------------------------------------------*/
 
-int MfxOmxEvent::Wait(void)
+inline bool MfxOmxEvent::TryWait(void)
+{
+    int state = 1;
+
+    if (m_manual) return (1 == m_state.load());
+    return m_state.compare_exchange_strong(state, 0);
+}
+
+/*------------------------------------------------------------------------------*/
+
+int MfxOmxEvent::SlowWait(const struct timespec* deadline)
 {
     int res = 0;
-    res = pthread_mutex_lock(&m_mutex);
-    if (!res)
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    mfxU64 start = m_pStats ? mfx_omx_lock_stats_time() : 0;
+#endif
+
+    ++m_waiters;
+    // auto reset event may be taken by another thread after wake up, then sleep again
+    while (!TryWait())
     {
-        if (!m_state) VM_CHECK(res, pthread_cond_wait(&m_event, &m_mutex));
-        if (!m_manual) m_state = false;
+        res = mfx_omx_futex_wait(&m_state, 0, deadline);
+        if (res) break;
+    }
+    --m_waiters;
 
-        VM_CHECK(res, pthread_mutex_unlock(&m_mutex));
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    if (m_pStats)
+    {
+        ++m_pStats->contended;
+        m_pStats->waitTime.Record(mfx_omx_lock_stats_time() - start);
     }
+#endif
     return res;
 }
 
 /*------------------------------------------------------------------------------*/
 
-int MfxOmxEvent::TimedWait(mfxU32 msec)
+int MfxOmxEvent::Wait(void)
 {
-    int res = 0;
-    if (m_state)
-    {
-        res = pthread_mutex_lock(&m_mutex);
-        if (!res)
-        {
-            if (!m_state)
-            {
-                struct timeval tval;
-                struct timespec tspec;
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    if (m_pStats) ++m_pStats->acquisitions;
+#endif
+    if (TryWait()) return 0;
+    return SlowWait(NULL);
+}
 
-                gettimeofday(&tval, NULL);
-                msec = 1000 * msec + tval.tv_usec;
-                tspec.tv_sec = tval.tv_sec + msec / 1000000;
-                tspec.tv_nsec = (msec % 1000000) * 1000;
-                VM_CHECK(res, pthread_cond_timedwait(&m_event, &m_mutex, &tspec));
-            }
+/*------------------------------------------------------------------------------*/
 
-            if (!m_manual) m_state = false;
+int MfxOmxEvent::TimedWait(mfxU32 msec)
+{
+    struct timespec deadline;
 
-            VM_CHECK(res, pthread_mutex_unlock(&m_mutex));
-        }
-    }
-    return res;
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    if (m_pStats) ++m_pStats->acquisitions;
+#endif
+    if (TryWait()) return 0;
+
+    mfx_omx_futex_deadline(msec, deadline);
+    return SlowWait(&deadline);
 }
 
 /*------------------------------------------------------------------------------*/
 /*                              S E M A P H O R S                               */
 /*------------------------------------------------------------------------------*/
 
-MfxOmxSemaphore::MfxOmxSemaphore(mfxU32 count)
+MfxOmxSemaphore::MfxOmxSemaphore(mfxU32 count, const char* name):
+    m_count((int)count),
+    m_waiters(0)
 {
-    m_count = count;
-
-    int res = pthread_cond_init(&m_semaphore, NULL);
-    if (!res)
-    {
-        res = pthread_mutex_init(&m_mutex, NULL);
-        if (res)
-        {
-            pthread_cond_destroy(&m_semaphore);
-        }
-    }
-    MFX_OMX_THROW_IF(res, std::bad_alloc());
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    m_pStats = mfx_omx_lock_stats_get(name, MFX_OMX_LOCK_SEMAPHORE);
+#else
+    MFX_OMX_UNUSED(name);
+#endif
 }
 
 /*------------------------------------------------------------------------------*/
 
 MfxOmxSemaphore::~MfxOmxSemaphore(void)
 {
-    pthread_cond_destroy(&m_semaphore);
-    pthread_mutex_destroy(&m_mutex);
 }
 
 /*------------------------------------------------------------------------------*/
 
 int MfxOmxSemaphore::Post(void)
 {
-    int res = 0;
-    res = pthread_mutex_lock(&m_mutex);
-    if (!res)
-    {
-        if (0 == m_count++) VM_CHECK(res, pthread_cond_signal(&m_semaphore));
+    // see MfxOmxEvent::Signal on the ordering with SlowWait
+    ++m_count;
+    if (!m_waiters.load()) return 0;
+    return mfx_omx_futex_wake(&m_count, 1);
+}
 
-        VM_CHECK(res, pthread_mutex_unlock(&m_mutex));
+/*------------------------------------------------------------------------------*/
+
+inline bool MfxOmxSemaphore::TryWait(void)
+{
+    int count = m_count.load();
+
+    while (count > 0)
+    {
+        if (m_count.compare_exchange_weak(count, count - 1)) return true;
     }
-    return res;
+    return false;
 }
 
 /*------------------------------------------------------------------------------*/
 
-int MfxOmxSemaphore::Wait(void)
+int MfxOmxSemaphore::SlowWait(const struct timespec* deadline)
 {
     int res = 0;
-    bool bError = false;
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    mfxU64 start = m_pStats ? mfx_omx_lock_stats_time() : 0;
+#endif
 
-    res = pthread_mutex_lock(&m_mutex);
-    if (!res)
+    ++m_waiters;
+    while (!TryWait())
     {
-        if ((0 == m_count) && (0 != pthread_cond_wait(&m_semaphore, &m_mutex)))
-            bError = true;
-        if (!bError) --m_count;
+        res = mfx_omx_futex_wait(&m_count, 0, deadline);
+        if (res) break;
+    }
+    --m_waiters;
 
-        res = pthread_mutex_unlock(&m_mutex);
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    if (m_pStats)
+    {
+        ++m_pStats->contended;
+        m_pStats->waitTime.Record(mfx_omx_lock_stats_time() - start);
     }
+#endif
     return res;
 }
 
 /*------------------------------------------------------------------------------*/
 
+int MfxOmxSemaphore::Wait(void)
+{
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    if (m_pStats) ++m_pStats->acquisitions;
+#endif
+    if (TryWait()) return 0;
+    return SlowWait(NULL);
+}
+
+/*------------------------------------------------------------------------------*/
+
 int MfxOmxSemaphore::Wait(mfxU32 timeout)
 {
+    struct timespec deadline;
+
     if (timeout == 0)
         return Wait();
 
-    int res = 0;
-    bool bError = false;
-    int wait_res = 0;
-
-
-    struct timespec tspec;
-    struct timeval tval;
-    unsigned long long micro_sec;
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    if (m_pStats) ++m_pStats->acquisitions;
+#endif
+    if (TryWait()) return 0;
 
-    gettimeofday(&tval, NULL);
-    micro_sec = 1000 * timeout + tval.tv_usec;
-    tspec.tv_sec = tval.tv_sec + (uint32_t)(micro_sec / 1000000);
-    tspec.tv_nsec = (uint32_t)(micro_sec % 1000000) * 1000;
+    mfx_omx_futex_deadline(timeout, deadline);
+    return SlowWait(&deadline);
+}
 
-    res = pthread_mutex_lock(&m_mutex);
-    if (!res)
-    {
-        if (0 == m_count)
-        {
-            wait_res = pthread_cond_timedwait(&m_semaphore, &m_mutex, &tspec);
-            if (wait_res != 0 && wait_res != ETIMEDOUT)
-                bError = true;
-        }
-        if (!bError) --m_count;
+/*------------------------------------------------------------------------------*/
 
-        res = pthread_mutex_unlock(&m_mutex);
-        res = (wait_res == ETIMEDOUT) ? wait_res : res;
-    }
+bool MfxOmxSemaphore::Try(void)
+{
+    bool res = TryWait();
 
+#if MFX_OMX_LOCK_STATS == MFX_OMX_YES
+    if (res && m_pStats) ++m_pStats->acquisitions;
+#endif
     return res;
 }
 
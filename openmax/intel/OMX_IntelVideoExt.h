@@ -25,6 +25,7 @@
 extern "C" {
 #endif /* __cplusplus */
 
+#include <stddef.h>
 #include <OMX_Core.h>
 
 typedef struct OMX_VIDEO_CONFIG_INTEL_BITRATETYPE {
@@ -327,6 +328,87 @@ typedef struct OMX_VIDEO_PARAM_COLOR_ASPECT {
     OMX_U16 nTransferCharacteristics;
 } OMX_VIDEO_PARAM_COLOR_ASPECT;
 
+// Stages of frame processing for which latency is collected
+typedef enum OMX_VIDEO_INTEL_LATENCY_STAGE {
+    OMX_VIDEO_IntelLatencyParse = 0,   // EmptyThisBuffer -> frame constructor loaded sample (decoders only)
+    OMX_VIDEO_IntelLatencyQueue,       // parsed (or EmptyThisBuffer) -> DecodeFrameAsync/EncodeFrameAsync
+    OMX_VIDEO_IntelLatencyGpu,         // DecodeFrameAsync/EncodeFrameAsync -> SyncOperation completion
+    OMX_VIDEO_IntelLatencyOutput,      // SyncOperation completion -> FillBufferDone
+    OMX_VIDEO_IntelLatencyTotal,       // EmptyThisBuffer -> FillBufferDone
+    OMX_VIDEO_IntelLatencyMax
+} OMX_VIDEO_INTEL_LATENCY_STAGE;
+
+// Get latency statistics of the given stage, all times are in microseconds
+typedef struct OMX_VIDEO_CONFIG_INTEL_LATENCY_STATS {
+    OMX_U32 nSize;
+    OMX_VERSIONTYPE nVersion;
+    OMX_U32 nPortIndex;
+    OMX_VIDEO_INTEL_LATENCY_STAGE eStage; // in
+    OMX_U32 nFrames;
+    OMX_U32 nMean;
+    OMX_U32 nMin;
+    OMX_U32 nMax;
+    OMX_U32 nP50;
+    OMX_U32 nP90;
+    OMX_U32 nP99;
+} OMX_VIDEO_CONFIG_INTEL_LATENCY_STATS;
+
+// Get runtime counters of the component, all counters are accumulated since component creation.
+// Fields are only appended: any nSize not less than the first version is accepted, the component
+// fills the fields which fit into it and reports their version in nStatsVersion.
+typedef struct OMX_VIDEO_CONFIG_INTEL_RUNTIME_STATS {
+    OMX_U32 nSize;
+    OMX_VERSIONTYPE nVersion;
+    OMX_U32 nPortIndex;
+    OMX_U32 nStatsVersion;       // version of the filled fields, see OMX_VIDEO_INTEL_RUNTIME_STATS_VERSION
+    OMX_U32 nInputBuffers;       // buffers accepted thru EmptyThisBuffer
+    OMX_U32 nOutputBuffers;      // buffers returned thru FillBufferDone
+    OMX_U32 nProcessedFrames;    // frames decoded or encoded
+    OMX_U32 nBytesCopied;        // bytes copied by the decoder frame constructor
+    OMX_U32 nBufferReallocs;     // reallocations of the frame constructor buffer
+    OMX_U32 nDeviceBusy;         // MFX_WRN_DEVICE_BUSY returned on frame submission
+    OMX_U32 nResets;             // codec resets (flush, seek)
+    OMX_U32 nReinits;            // codec Close/Init while streaming (resolution or format change)
+    OMX_U32 nErrors;             // errors reported thru OMX_EventError
+    OMX_U32 nSurfacesHeld;       // buffers currently held by the component
+    OMX_U32 nInputQueueDepth;    // input buffers waiting for processing
+    OMX_U32 nOutputQueueDepth;   // output buffers waiting for synchronization
+    // version 2
+    OMX_U32 nDrains;             // waits for all frames in flight to finish
+    OMX_U32 nConfigResets;       // encoder config changes classified as Reset continuing current sequence
+    OMX_U32 nConfigResetsIdr;    // encoder config changes classified as Reset starting new sequence
+    OMX_U32 nConfigReinits;      // encoder config changes which do not fit allocated buffers
+    // version 3
+    OMX_U32 nCallbacks;          // client callbacks delivered by the callback dispatcher
+    OMX_U32 nCallbackMeanTime;   // mean time spent in a client callback, us
+    OMX_U32 nCallbackMaxTime;    // max time spent in a client callback, us
+    OMX_U32 nCallbackQueueWaits; // waits for a free slot in the full callback queue
+} OMX_VIDEO_CONFIG_INTEL_RUNTIME_STATS;
+
+#define OMX_VIDEO_INTEL_RUNTIME_STATS_VERSION 3
+#define OMX_VIDEO_INTEL_RUNTIME_STATS_V1_SIZE offsetof(OMX_VIDEO_CONFIG_INTEL_RUNTIME_STATS, nDrains)
+#define OMX_VIDEO_INTEL_RUNTIME_STATS_V2_SIZE offsetof(OMX_VIDEO_CONFIG_INTEL_RUNTIME_STATS, nCallbacks)
+#define OMX_VIDEO_INTEL_RUNTIME_STATS_V3_SIZE sizeof(OMX_VIDEO_CONFIG_INTEL_RUNTIME_STATS)
+
+// Set async depth of the codec, accepted in loaded state only
+typedef struct OMX_VIDEO_PARAM_INTEL_ASYNC_DEPTH {
+    OMX_U32 nSize;
+    OMX_VERSIONTYPE nVersion;
+    OMX_U32 nPortIndex;
+    OMX_U32 nAsyncDepth;         // 0 - component default, up to OMX_VIDEO_INTEL_MAX_ASYNC_DEPTH
+} OMX_VIDEO_PARAM_INTEL_ASYNC_DEPTH;
+
+#define OMX_VIDEO_INTEL_MAX_ASYNC_DEPTH 16
+
+// Force the next frame to be an IDR frame and select if it carries in-band parameter sets,
+// overrides OMX.google.android.index.prependSPSPPSToIDRFrames for this frame only
+typedef struct OMX_VIDEO_CONFIG_INTEL_IDR_REQUEST {
+    OMX_U32 nSize;
+    OMX_VERSIONTYPE nVersion;
+    OMX_U32 nPortIndex;
+    OMX_BOOL bInsertHeaders;     // keep SPS/PPS (and VPS) in front of the IDR frame
+} OMX_VIDEO_CONFIG_INTEL_IDR_REQUEST;
+
 #define OMX_BUFFERFLAG_TFF 0x00010000
 #define OMX_BUFFERFLAG_BFF 0x00020000
 